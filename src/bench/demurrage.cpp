@@ -0,0 +1,74 @@
+// Copyright (c) 2011-2024 The Freicoin Developers
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of version 3 of the GNU Affero General Public License as published
+// by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <bench/bench.h>
+
+#include <consensus/amount.h>
+#include <random.h>
+
+#include <vector>
+
+static std::vector<CAmount> MakeAmounts(size_t count)
+{
+    FastRandomContext rng(true);
+    std::vector<CAmount> amounts(count);
+    for (auto& amount : amounts) {
+        amount = rng.randrange(MAX_MONEY);
+    }
+    return amounts;
+}
+
+// A distance with many set bits, which is the worst case for the
+// exponentiation ladder.
+static constexpr uint32_t BENCH_DISTANCE{0x3ffff};
+
+static void DemurrageForward(benchmark::Bench& bench)
+{
+    const std::vector<CAmount> amounts{MakeAmounts(1000)};
+    CAmount total{0};
+    bench.batch(amounts.size()).unit("amount").run([&] {
+        for (const CAmount& amount : amounts) {
+            total += TimeAdjustValueForward(amount, BENCH_DISTANCE);
+        }
+    });
+    ankerl::nanobench::doNotOptimizeAway(total);
+}
+
+static void DemurrageForwardCachedFactor(benchmark::Bench& bench)
+{
+    const std::vector<CAmount> amounts{MakeAmounts(1000)};
+    const DemurrageFactor factor{GetDemurrageFactor(BENCH_DISTANCE)};
+    CAmount total{0};
+    bench.batch(amounts.size()).unit("amount").run([&] {
+        for (const CAmount& amount : amounts) {
+            total += TimeAdjustValueForward(amount, factor);
+        }
+    });
+    ankerl::nanobench::doNotOptimizeAway(total);
+}
+
+static void DemurrageForwardBatch(benchmark::Bench& bench)
+{
+    const std::vector<CAmount> amounts{MakeAmounts(1000)};
+    std::vector<CAmount> adjusted;
+    bench.batch(amounts.size()).unit("amount").run([&] {
+        adjusted = amounts;
+        TimeAdjustValuesForward(adjusted, GetDemurrageFactor(BENCH_DISTANCE));
+    });
+    ankerl::nanobench::doNotOptimizeAway(adjusted);
+}
+
+BENCHMARK(DemurrageForward, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DemurrageForwardCachedFactor, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DemurrageForwardBatch, benchmark::PriorityLevel::HIGH);
@@ -34,4 +34,19 @@ static void MerkleRoot(benchmark::Bench& bench)
     });
 }
 
+static void FastMerkleRoot(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    std::vector<uint256> leaves;
+    leaves.resize(9001);
+    for (auto& item : leaves) {
+        item = rng.rand256();
+    }
+    bench.batch(leaves.size()).unit("leaf").run([&] {
+        uint256 hash = ComputeFastMerkleRoot(leaves);
+        leaves[0] = hash;
+    });
+}
+
 BENCHMARK(MerkleRoot, benchmark::PriorityLevel::HIGH);
+BENCHMARK(FastMerkleRoot, benchmark::PriorityLevel::HIGH);
@@ -13,6 +13,7 @@
 // You should have received a copy of the GNU Affero General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <mutex>
 #include <set>
 
@@ -149,8 +150,34 @@ bool GCSFilter::Match(const Element& element) const
 
 bool GCSFilter::MatchAny(const ElementSet& elements) const
 {
-    const std::vector<uint64_t> queries = BuildHashedSet(elements);
-    return MatchInternal(queries.data(), queries.size());
+    if (elements.size() < m_N) {
+        const std::vector<uint64_t> queries = BuildHashedSet(elements);
+        return MatchInternal(queries.data(), queries.size());
+    }
+
+    // With at least as many elements to check as there are in the filter, as
+    // when scanning for a large set of scripts, it is cheaper to decode the
+    // filter once and look each element up in it than to sort the hashes of
+    // all the elements to merge them with it, and the elements after the first
+    // match need not be hashed at all.
+    SpanReader stream{m_encoded};
+    uint64_t N = ReadCompactSize(stream);
+    assert(N == m_N);
+
+    BitStreamReader bitreader{stream};
+    std::vector<uint64_t> values(m_N);
+    uint64_t value = 0;
+    for (uint64_t& v : values) {
+        value += GolombRiceDecode(bitreader, m_params.m_P);
+        v = value;
+    }
+
+    for (const Element& element : elements) {
+        if (std::binary_search(values.begin(), values.end(), HashToRange(element))) {
+            return true;
+        }
+    }
+    return false;
 }
 
 const std::string& BlockFilterTypeName(BlockFilterType filter_type)
@@ -215,6 +242,18 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock& block,
     return elements;
 }
 
+GCSFilter::ElementSet BlockFilterElements(BlockFilterType filter_type, const CBlock& block,
+                                          const CBlockUndo& block_undo)
+{
+    switch (filter_type) {
+    case BlockFilterType::BASIC:
+        return BasicFilterElements(block, block_undo);
+    case BlockFilterType::INVALID:
+        break;
+    }
+    throw std::invalid_argument("unknown filter_type");
+}
+
 BlockFilter::BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
                          std::vector<unsigned char> filter, bool skip_decode_check)
     : m_filter_type(filter_type), m_block_hash(block_hash)
@@ -233,7 +272,18 @@ BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock& block, const
     if (!BuildParams(params)) {
         throw std::invalid_argument("unknown filter_type");
     }
-    m_filter = GCSFilter(params, BasicFilterElements(block, block_undo));
+    m_filter = GCSFilter(params, BlockFilterElements(filter_type, block, block_undo));
+}
+
+BlockFilter::BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
+                         const GCSFilter::ElementSet& elements)
+    : m_filter_type(filter_type), m_block_hash(block_hash)
+{
+    GCSFilter::Params params;
+    if (!BuildParams(params)) {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    m_filter = GCSFilter(params, elements);
 }
 
 bool BlockFilter::BuildParams(GCSFilter::Params& params) const
@@ -118,6 +118,13 @@ const std::set<BlockFilterType>& AllBlockFilterTypes();
 /** Get a comma-separated list of known filter type names. */
 const std::string& ListBlockFilterTypes();
 
+/**
+ * Get the elements a filter of the specified type is built from for a block.
+ * Throws std::invalid_argument for an unknown filter type.
+ */
+GCSFilter::ElementSet BlockFilterElements(BlockFilterType filter_type, const CBlock& block,
+                                          const CBlockUndo& block_undo);
+
 /**
  * Complete block filter struct as defined in BIP 157. Serialization matches
  * payload of "cfilter" messages.
@@ -142,6 +149,11 @@ public:
     //! Construct a new BlockFilter of the specified type from a block.
     BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo);
 
+    //! Construct a new BlockFilter of the specified type from the elements of
+    //! a block, as got from BlockFilterElements.
+    BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
+                const GCSFilter::ElementSet& elements);
+
     BlockFilterType GetFilterType() const { return m_filter_type; }
     const uint256& GetBlockHash() const LIFETIMEBOUND { return m_block_hash; }
     const GCSFilter& GetFilter() const LIFETIMEBOUND { return m_filter; }
@@ -30,7 +30,9 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 /**
@@ -219,6 +221,12 @@ public:
     uint32_t nNonce{0};
     AuxProofOfWork m_aux_pow{};
 
+    //! Memoized result of CBlockHeader::GetAuxiliaryHash() for this block's
+    //! header.  Only allocated for merge-mined headers, so that entries
+    //! without auxiliary proof-of-work pay for just the pointer.  Shared
+    //! rather than owned so that CDiskBlockIndex can copy it cheaply.
+    std::shared_ptr<const std::pair<uint256, uint256>> m_aux_hash{};
+
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     int32_t nSequenceId{0};
 
@@ -277,6 +285,22 @@ public:
         return *phashBlock;
     }
 
+    std::pair<uint256, uint256> GetAuxiliaryHash(const Consensus::Params& params) const
+    {
+        if (m_aux_pow.IsNull()) {
+            return {};
+        }
+        if (!m_aux_hash) {
+            return GetBlockHeader().GetAuxiliaryHash(params);
+        }
+        return *m_aux_hash;
+    }
+
+    void SetAuxiliaryHash(const std::pair<uint256, uint256>& aux_hash)
+    {
+        m_aux_hash = std::make_shared<const std::pair<uint256, uint256>>(aux_hash);
+    }
+
     /**
      * Check whether this block's and all previous blocks' transactions have been
      * downloaded (and stored to disk) at some point.
@@ -412,6 +436,13 @@ class CDiskBlockIndex : public CBlockIndex
      **/
     static constexpr int DUMMY_VERSION = 259900;
 
+    /** Entries written with this version or later are followed by the
+     * memoized auxiliary proof-of-work hashes of merge-mined headers, so that
+     * they need not be recomputed when the block index is loaded.  Earlier
+     * releases ignore both the version and the trailing data.
+     **/
+    static constexpr int AUX_HASH_VERSION = 260000;
+
 public:
     uint256 hashPrev;
 
@@ -428,7 +459,7 @@ public:
     template <typename Stream>
     void Serialize(Stream& s) const {
         LOCK(::cs_main);
-        int _nVersion = DUMMY_VERSION;
+        int _nVersion = AUX_HASH_VERSION;
         ::Serialize(s, VARINT_MODE(_nVersion, VarIntMode::NONNEGATIVE_SIGNED));
 
         ::Serialize(s, VARINT_MODE(nHeight, VarIntMode::NONNEGATIVE_SIGNED));
@@ -448,6 +479,12 @@ public:
         CBlockHeader blkhdr;
         blkhdr = GetBlockHeader();
         ::Serialize(s, blkhdr);
+
+        if (!m_aux_pow.IsNull()) {
+            const std::pair<uint256, uint256> aux_hash{m_aux_hash ? *m_aux_hash : std::pair<uint256, uint256>{}};
+            ::Serialize(s, aux_hash.first);
+            ::Serialize(s, aux_hash.second);
+        }
     }
 
     template <typename Stream>
@@ -479,6 +516,16 @@ public:
         nBits          = blkhdr.nBits;
         nNonce         = blkhdr.nNonce;
         m_aux_pow      = blkhdr.m_aux_pow;
+
+        m_aux_hash.reset();
+        if (_nVersion >= AUX_HASH_VERSION && !m_aux_pow.IsNull()) {
+            std::pair<uint256, uint256> aux_hash;
+            ::Unserialize(s, aux_hash.first);
+            ::Unserialize(s, aux_hash.second);
+            if (!aux_hash.first.IsNull()) {
+                SetAuxiliaryHash(aux_hash);
+            }
+        }
     }
 
     uint256 ConstructBlockHash() const
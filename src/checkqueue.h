@@ -21,13 +21,28 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <concepts>
 #include <iterator>
 #include <vector>
 
+/**
+ * A verification that can defer part of its work into a batch shared by all
+ * the verifications a worker runs together.  It provides a Batch type whose
+ * Verify() completes the deferred work, and an operator() taking the batch.
+ */
+template <typename T>
+concept BatchableCheck = std::default_initializable<typename T::Batch> &&
+    requires(T check, typename T::Batch batch) {
+        { check(batch) } -> std::convertible_to<bool>;
+        { batch.Verify() } -> std::convertible_to<bool>;
+    };
+
 /**
  * Queue for verifications that have to be performed.
   * The verifications are represented by a type T, which must provide an
-  * operator(), returning a bool.
+  * operator(), returning a bool.  If T is a BatchableCheck, each batch of
+  * verifications taken by a worker shares one T::Batch, which is verified
+  * once they have all run.
   *
   * One thread (the master) is assumed to push batches of verifications
   * onto the queue, where they are processed by N-1 worker threads. When
@@ -126,9 +141,18 @@ private:
                 fOk = fAllOk;
             }
             // execute work
-            for (T& check : vChecks)
+            if constexpr (BatchableCheck<T>) {
+                typename T::Batch batch;
+                for (T& check : vChecks)
+                    if (fOk)
+                        fOk = check(batch);
                 if (fOk)
-                    fOk = check();
+                    fOk = batch.Verify();
+            } else {
+                for (T& check : vChecks)
+                    if (fOk)
+                        fOk = check();
+            }
             vChecks.clear();
         } while (true);
     }
@@ -18,8 +18,13 @@
 #include <consensus/consensus.h>
 #include <logging.h>
 #include <random.h>
+#include <util/thread.h>
 #include <util/trace.h>
 
+#include <bit>
+#include <cstring>
+#include <new>
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
@@ -27,6 +32,18 @@ BlockFinalTxEntry CCoinsView::GetFinalTx() const { return BlockFinalTxEntry(); }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const BlockFinalTxEntry &final_tx, bool erase) { return false; }
 std::unique_ptr<CCoinsViewCursor> CCoinsView::Cursor() const { return nullptr; }
 
+std::vector<std::optional<Coin>> CCoinsView::GetCoins(Span<const COutPoint> outpoints) const
+{
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        Coin coin;
+        if (GetCoin(outpoints[i], coin)) {
+            coins[i] = std::move(coin);
+        }
+    }
+    return coins;
+}
+
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
 {
     Coin coin;
@@ -44,13 +61,184 @@ bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock,
 std::unique_ptr<CCoinsViewCursor> CCoinsViewBacked::Cursor() const { return base->Cursor(); }
 size_t CCoinsViewBacked::EstimateSize() const { return base->EstimateSize(); }
 
+//! Chunk i of CCoinsMap entry storage holds 1 << (FIRST_CHUNK_BITS + i) entries, up to 1 << MAX_CHUNK_BITS.
+static constexpr uint32_t FIRST_CHUNK_BITS{3};
+static constexpr uint32_t MAX_CHUNK_BITS{14};
+//! Number of entries in the chunks before the first full-sized one.
+static constexpr uint32_t GROWING_CHUNK_ENTRIES{(uint32_t{1} << MAX_CHUNK_BITS) - (uint32_t{1} << FIRST_CHUNK_BITS)};
+static constexpr uint32_t MIN_INDEX_BITS{4};
+static constexpr uint32_t MAX_INDEX_BITS{31};
+
+//! Return the first entry number stored in a chunk.
+static size_t ChunkStart(size_t chunk)
+{
+    if (chunk <= MAX_CHUNK_BITS - FIRST_CHUNK_BITS) {
+        return (size_t{1} << (FIRST_CHUNK_BITS + chunk)) - (size_t{1} << FIRST_CHUNK_BITS);
+    }
+    return GROWING_CHUNK_ENTRIES + ((chunk - (MAX_CHUNK_BITS - FIRST_CHUNK_BITS)) << MAX_CHUNK_BITS);
+}
+
+static size_t ChunkSize(size_t chunk)
+{
+    return size_t{1} << std::min<size_t>(FIRST_CHUNK_BITS + chunk, MAX_CHUNK_BITS);
+}
+
+//! The CCoinsMap index is grown before it becomes more than 3/4 full.
+static size_t MaxIndexLoad(uint32_t index_bits)
+{
+    return index_bits ? (size_t{3} << index_bits) / 4 : 0;
+}
+
+CCoinsMap::value_type* CCoinsMap::EntryPtr(uint32_t entry) const
+{
+    size_t chunk, offset;
+    if (entry < GROWING_CHUNK_ENTRIES) {
+        // Chunk c starts at entry (1 << (FIRST_CHUNK_BITS + c)) - (1 << FIRST_CHUNK_BITS).
+        const uint32_t biased{entry + (uint32_t{1} << FIRST_CHUNK_BITS)};
+        const uint32_t top{static_cast<uint32_t>(std::bit_width(biased)) - 1};
+        chunk = top - FIRST_CHUNK_BITS;
+        offset = biased - (uint32_t{1} << top);
+    } else {
+        const uint32_t rest{entry - GROWING_CHUNK_ENTRIES};
+        chunk = (MAX_CHUNK_BITS - FIRST_CHUNK_BITS) + (rest >> MAX_CHUNK_BITS);
+        offset = rest & ((uint32_t{1} << MAX_CHUNK_BITS) - 1);
+    }
+    return std::launder(reinterpret_cast<value_type*>(m_chunks[chunk][offset].data));
+}
+
+uint32_t CCoinsMap::NextLive(uint32_t pos) const
+{
+    while (pos < m_allocated) {
+        const uint64_t bits{m_live[pos >> 6] >> (pos & 63)};
+        if (bits) return std::min<uint32_t>(pos + std::countr_zero(bits), m_allocated);
+        pos = (pos | 63) + 1;
+    }
+    return m_allocated;
+}
+
+uint32_t CCoinsMap::Lookup(const COutPoint& key, uint32_t hash) const
+{
+    if (m_size == 0) return NO_ENTRY;
+    const uint32_t mask{(uint32_t{1} << m_index_bits) - 1};
+    const uint32_t fragment{hash & ~mask};
+    for (uint32_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        const uint32_t word{m_index[slot]};
+        if (word == EMPTY_SLOT) return NO_ENTRY;
+        if ((word & ~mask) != fragment) continue;
+        const uint32_t entry{word & mask};
+        if (EntryPtr(entry)->first == key) return entry;
+    }
+}
+
+uint32_t CCoinsMap::AllocateEntry()
+{
+    if (m_size + size_t{1} > MaxIndexLoad(m_index_bits)) {
+        Rehash(std::max(m_index_bits + 1, MIN_INDEX_BITS));
+    }
+    if (m_free != NO_ENTRY) {
+        const uint32_t entry{m_free};
+        std::memcpy(&m_free, EntryPtr(entry), sizeof(m_free));
+        return entry;
+    }
+    // Every entry number handed out is in use, so m_allocated <= m_size, and
+    // entry numbers stay below 3/4 of the index size.
+    const uint32_t entry{m_allocated};
+    if (entry == ChunkStart(m_chunks.size())) {
+        m_chunks.emplace_back(new EntryStorage[ChunkSize(m_chunks.size())]);
+    }
+    if ((entry & 63) == 0) m_live.push_back(0);
+    ++m_allocated;
+    return entry;
+}
+
+void CCoinsMap::FreeEntry(uint32_t entry)
+{
+    std::memcpy(EntryPtr(entry), &m_free, sizeof(m_free));
+    m_free = entry;
+}
+
+void CCoinsMap::LinkEntry(uint32_t entry)
+{
+    const uint32_t hash{EntryPtr(entry)->m_hash};
+    const uint32_t mask{(uint32_t{1} << m_index_bits) - 1};
+    uint32_t slot = hash & mask;
+    while (m_index[slot] != EMPTY_SLOT) slot = (slot + 1) & mask;
+    m_index[slot] = (hash & ~mask) | entry;
+    m_live[entry >> 6] |= uint64_t{1} << (entry & 63);
+    ++m_size;
+}
+
+void CCoinsMap::Rehash(uint32_t index_bits)
+{
+    assert(index_bits <= MAX_INDEX_BITS);
+    m_index.assign(size_t{1} << index_bits, EMPTY_SLOT);
+    m_index_bits = index_bits;
+    const uint32_t size{m_size};
+    m_size = 0;
+    for (uint32_t entry = NextLive(0); entry < m_allocated; entry = NextLive(entry + 1)) {
+        LinkEntry(entry);
+    }
+    assert(m_size == size);
+}
+
+CCoinsMap::iterator CCoinsMap::erase(const_iterator it)
+{
+    const uint32_t entry{it.m_pos};
+    value_type* value{EntryPtr(entry)};
+    const uint32_t mask{(uint32_t{1} << m_index_bits) - 1};
+    const uint32_t word{(value->m_hash & ~mask) | entry};
+    uint32_t hole = value->m_hash & mask;
+    while (m_index[hole] != word) hole = (hole + 1) & mask;
+    // Shift back any following slots of the probe sequence which may not be
+    // reachable anymore from their home slot once this one is emptied.
+    for (uint32_t slot = (hole + 1) & mask; m_index[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+        const uint32_t home = EntryPtr(m_index[slot] & mask)->m_hash & mask;
+        // The slot stays put if its home is cyclically within (hole, slot].
+        if (((slot - home) & mask) < ((slot - hole) & mask)) continue;
+        m_index[hole] = m_index[slot];
+        hole = slot;
+    }
+    m_index[hole] = EMPTY_SLOT;
+    value->~value_type();
+    m_live[entry >> 6] &= ~(uint64_t{1} << (entry & 63));
+    FreeEntry(entry);
+    --m_size;
+    return {this, NextLive(entry + 1)};
+}
+
+void CCoinsMap::clear()
+{
+    for (uint32_t entry = NextLive(0); entry < m_allocated; entry = NextLive(entry + 1)) {
+        EntryPtr(entry)->~value_type();
+    }
+    m_chunks.clear();
+    m_chunks.shrink_to_fit();
+    m_live.clear();
+    m_live.shrink_to_fit();
+    m_index.clear();
+    m_index.shrink_to_fit();
+    m_index_bits = 0;
+    m_allocated = 0;
+    m_size = 0;
+    m_free = NO_ENTRY;
+}
+
+size_t CCoinsMap::DynamicMemoryUsage() const
+{
+    size_t usage{memusage::DynamicUsage(m_chunks) + memusage::DynamicUsage(m_live) + memusage::DynamicUsage(m_index)};
+    for (size_t chunk = 0; chunk < m_chunks.size(); ++chunk) {
+        usage += memusage::MallocUsage(ChunkSize(chunk) * sizeof(EntryStorage));
+    }
+    return usage;
+}
+
 CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn, bool deterministic) :
-    CCoinsViewBacked(baseIn), m_deterministic(deterministic),
-    cacheCoins(0, SaltedOutpointHasher(/*deterministic=*/deterministic), CCoinsMap::key_equal{}, &m_cache_coins_memory_resource)
+    CCoinsViewBacked(baseIn),
+    cacheCoins(SaltedOutpointHasher(/*deterministic=*/deterministic))
 {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
-    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+    return cacheCoins.DynamicMemoryUsage() + cachedCoinsUsage;
 }
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
@@ -60,7 +248,7 @@ CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
-    CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    CCoinsMap::iterator ret = cacheCoins.try_emplace(outpoint, std::move(tmp)).first;
     if (ret->second.coin.IsSpent()) {
         // The parent only has an empty entry for this outpoint; we can consider our
         // version as fresh.
@@ -79,12 +267,40 @@ bool CCoinsViewCache::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return false;
 }
 
+std::vector<std::optional<Coin>> CCoinsViewCache::GetCoins(Span<const COutPoint> outpoints) const
+{
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<COutPoint> misses;
+    std::vector<size_t> miss_positions;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (const auto it{cacheCoins.find(outpoints[i])}; it != cacheCoins.end()) {
+            if (!it->second.coin.IsSpent()) coins[i] = it->second.coin;
+        } else {
+            misses.push_back(outpoints[i]);
+            miss_positions.push_back(i);
+        }
+    }
+    if (misses.empty()) return coins;
+
+    std::vector<std::optional<Coin>> fetched{base->GetCoins(misses)};
+    for (size_t j = 0; j < misses.size(); ++j) {
+        if (!fetched[j]) continue;
+        // The same outpoint may have been asked for more than once.
+        auto [it, inserted] = cacheCoins.try_emplace(misses[j], std::move(*fetched[j]));
+        if (inserted) {
+            cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+        }
+        coins[miss_positions[j]] = it->second.coin;
+    }
+    return coins;
+}
+
 void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possible_overwrite) {
     assert(!coin.IsSpent());
     if (coin.out.scriptPubKey.IsUnspendable()) return;
     CCoinsMap::iterator it;
     bool inserted;
-    std::tie(it, inserted) = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::tuple<>());
+    std::tie(it, inserted) = cacheCoins.try_emplace(outpoint);
     bool fresh = false;
     if (!inserted) {
         cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
@@ -122,10 +338,15 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
 
 void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin) {
     cachedCoinsUsage += coin.DynamicMemoryUsage();
-    cacheCoins.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(std::move(outpoint)),
-        std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
+    cacheCoins.try_emplace(std::move(outpoint), std::move(coin), CCoinsCacheEntry::DIRTY);
+}
+
+void CCoinsViewCache::InsertFetchedCoin(COutPoint&& outpoint, Coin&& coin) {
+    assert(!coin.IsSpent());
+    auto [it, inserted] = cacheCoins.try_emplace(std::move(outpoint), std::move(coin));
+    if (inserted) {
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
 }
 
 void AddCoins(CCoinsViewCache& cache, const CTransaction &tx, int nHeight, bool check_for_overwrite) {
@@ -356,16 +577,14 @@ void CCoinsViewCache::ReallocateCache()
 {
     // Cache should be empty when we're calling this.
     assert(cacheCoins.size() == 0);
-    cacheCoins.~CCoinsMap();
-    m_cache_coins_memory_resource.~CCoinsMapMemoryResource();
-    ::new (&m_cache_coins_memory_resource) CCoinsMapMemoryResource{};
-    ::new (&cacheCoins) CCoinsMap{0, SaltedOutpointHasher{/*deterministic=*/m_deterministic}, CCoinsMap::key_equal{}, &m_cache_coins_memory_resource};
+    cacheCoins.clear();
 }
 
 void CCoinsViewCache::SanityCheck() const
 {
     size_t recomputed_usage = 0;
-    for (const auto& [_, entry] : cacheCoins) {
+    for (const auto& item : cacheCoins) {
+        const CCoinsCacheEntry& entry{item.second};
         unsigned attr = 0;
         if (entry.flags & CCoinsCacheEntry::DIRTY) attr |= 1;
         if (entry.flags & CCoinsCacheEntry::FRESH) attr |= 2;
@@ -415,6 +634,103 @@ bool CCoinsViewErrorCatcher::GetCoin(const COutPoint &outpoint, Coin &coin) cons
     return ExecuteBackedWrapper([&]() { return CCoinsViewBacked::GetCoin(outpoint, coin); }, m_err_callbacks);
 }
 
+std::vector<std::optional<Coin>> CCoinsViewErrorCatcher::GetCoins(Span<const COutPoint> outpoints) const {
+    std::vector<std::optional<Coin>> coins;
+    ExecuteBackedWrapper([&]() { coins = base->GetCoins(outpoints); return true; }, m_err_callbacks);
+    return coins;
+}
+
 bool CCoinsViewErrorCatcher::HaveCoin(const COutPoint &outpoint) const {
     return ExecuteBackedWrapper([&]() { return CCoinsViewBacked::HaveCoin(outpoint); }, m_err_callbacks);
 }
+
+bool CCoinsViewBackgroundFlush::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    if (const auto it{m_frozen.find(outpoint)}; it != m_frozen.end()) {
+        if (it->second.coin.IsSpent()) return false;
+        coin = it->second.coin;
+        return true;
+    }
+    return base->GetCoin(outpoint, coin);
+}
+
+std::vector<std::optional<Coin>> CCoinsViewBackgroundFlush::GetCoins(Span<const COutPoint> outpoints) const
+{
+    if (m_frozen.empty()) return base->GetCoins(outpoints);
+
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<COutPoint> misses;
+    std::vector<size_t> miss_positions;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (const auto it{m_frozen.find(outpoints[i])}; it != m_frozen.end()) {
+            if (!it->second.coin.IsSpent()) coins[i] = it->second.coin;
+        } else {
+            misses.push_back(outpoints[i]);
+            miss_positions.push_back(i);
+        }
+    }
+    if (misses.empty()) return coins;
+
+    std::vector<std::optional<Coin>> fetched{base->GetCoins(misses)};
+    for (size_t j = 0; j < misses.size(); ++j) {
+        coins[miss_positions[j]] = std::move(fetched[j]);
+    }
+    return coins;
+}
+
+bool CCoinsViewBackgroundFlush::HaveCoin(const COutPoint& outpoint) const
+{
+    if (const auto it{m_frozen.find(outpoint)}; it != m_frozen.end()) {
+        return !it->second.coin.IsSpent();
+    }
+    return base->HaveCoin(outpoint);
+}
+
+uint256 CCoinsViewBackgroundFlush::GetBestBlock() const
+{
+    // The base view's best block only changes at the end of a write.
+    return m_writer.joinable() ? m_frozen_block : base->GetBestBlock();
+}
+
+BlockFinalTxEntry CCoinsViewBackgroundFlush::GetFinalTx() const
+{
+    return m_writer.joinable() ? m_frozen_final_tx : base->GetFinalTx();
+}
+
+bool CCoinsViewBackgroundFlush::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const BlockFinalTxEntry& final_tx, bool erase)
+{
+    const bool background{std::exchange(m_write_next_in_background, false)};
+    if (!Wait()) return false;
+    if (!background) return base->BatchWrite(mapCoins, hashBlock, final_tx, erase);
+
+    for (auto it = mapCoins.begin(); it != mapCoins.end(); it = erase ? mapCoins.erase(it) : std::next(it)) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) continue;
+        // The base view only looks at the DIRTY flag, and there is at most
+        // one entry per outpoint in mapCoins, so every entry is new to us.
+        Coin coin{erase ? std::move(it->second.coin) : it->second.coin};
+        m_frozen.try_emplace(it->first, std::move(coin), CCoinsCacheEntry::DIRTY);
+    }
+    m_frozen_block = hashBlock;
+    m_frozen_final_tx = final_tx;
+    m_writing.store(true, std::memory_order_release);
+    m_writer = std::thread(&util::TraceThread, "coinsflush", [this] {
+        try {
+            m_write_ok = base->BatchWrite(m_frozen, m_frozen_block, m_frozen_final_tx, /*erase=*/false);
+        } catch (const std::runtime_error& e) {
+            LogPrintf("Error writing to database: %s\n", e.what());
+            m_write_ok = false;
+        }
+        m_writing.store(false, std::memory_order_release);
+    });
+    return true;
+}
+
+bool CCoinsViewBackgroundFlush::Wait()
+{
+    if (!m_writer.joinable()) return true;
+    m_writer.join();
+    m_frozen.clear();
+    const bool ok{m_write_ok};
+    m_write_ok = true;
+    return ok;
+}
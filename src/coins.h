@@ -22,16 +22,24 @@
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
-#include <support/allocators/pool.h>
+#include <span.h>
 #include <uint256.h>
 #include <util/hasher.h>
 
 #include <assert.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
-#include <unordered_map>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -206,21 +214,194 @@ struct BlockFinalTxEntry
 };
 
 /**
- * PoolAllocator's MAX_BLOCK_SIZE_BYTES parameter here uses sizeof the data, and adds the size
- * of 4 pointers. We do not know the exact node size used in the std::unordered_node implementation
- * because it is implementation defined. Most implementations have an overhead of 1 or 2 pointers,
- * so nodes can be connected in a linked list, and in some cases the hash value is stored as well.
- * Using an additional sizeof(void*)*4 for MAX_BLOCK_SIZE_BYTES should thus be sufficient so that
- * all implementations can allocate the nodes from the PoolAllocator.
+ * An entry of a CCoinsMap, which like the std::pair of a std::unordered_map
+ * holds the key as `first` and the cache entry as `second`.  The low 32 bits
+ * of the key's hash are kept in what would otherwise be padding between the
+ * two, so that the map can move the entry within its index without hashing
+ * the key again.
  */
-using CCoinsMap = std::unordered_map<COutPoint,
-                                     CCoinsCacheEntry,
-                                     SaltedOutpointHasher,
-                                     std::equal_to<COutPoint>,
-                                     PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
-                                                   sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
+class CCoinsMapEntry
+{
+    friend class CCoinsMap;
+
+    template <typename K, typename... Args>
+    CCoinsMapEntry(K&& key, uint32_t hash, Args&&... args)
+        : first(std::forward<K>(key)), m_hash(hash), second(std::forward<Args>(args)...) {}
+
+public:
+    const COutPoint first;
+
+private:
+    const uint32_t m_hash;
+
+public:
+    CCoinsCacheEntry second;
+};
 
-using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
+/**
+ * The map of outpoints to cache entries held by a CCoinsViewCache.
+ *
+ * Entries are stored in place in chunks of geometrically increasing size,
+ * which are never moved.  Erased entries are put on a free list and reused by
+ * later insertions, so that references and iterators to an entry remain valid
+ * until that entry is erased, even across insertions.
+ *
+ * Entries are located through an open-addressing index with linear probing.
+ * Each 32-bit index slot holds an entry number, and the bits not needed for
+ * the entry number hold the bits of the key's hash above those which select
+ * its home slot, so that most probes for other keys are rejected without
+ * touching their entries.  Erasure shifts the following slots of a probe
+ * sequence back instead of leaving tombstones.  Growing the index, and
+ * finding the home slots of the slots shifted by an erasure, use the hash
+ * stored in each entry rather than hashing its key again.
+ *
+ * Compared to a std::unordered_map this saves the per-node allocation, list
+ * pointer and bucket array, and iteration (as done by BatchWrite when looking
+ * for DIRTY entries) is a walk over contiguous memory in roughly insertion
+ * order.  Only the subset of the std::unordered_map interface used for the
+ * coins cache is provided.
+ */
+class CCoinsMap
+{
+public:
+    using key_type = COutPoint;
+    using mapped_type = CCoinsCacheEntry;
+    using value_type = CCoinsMapEntry;
+    using size_type = size_t;
+    using hasher = SaltedOutpointHasher;
+    using key_equal = std::equal_to<COutPoint>;
+
+private:
+    template <bool IsConst>
+    class Iterator
+    {
+        friend class CCoinsMap;
+        template <bool> friend class Iterator;
+
+        using Map = std::conditional_t<IsConst, const CCoinsMap, CCoinsMap>;
+        Map* m_map{nullptr};
+        uint32_t m_pos{0};
+
+        Iterator(Map* map, uint32_t pos) : m_map(map), m_pos(pos) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = CCoinsMap::value_type;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+        template <bool C = IsConst, std::enable_if_t<C, int> = 0>
+        Iterator(const Iterator<false>& other) : m_map(other.m_map), m_pos(other.m_pos) {}
+
+        reference operator*() const { return *m_map->EntryPtr(m_pos); }
+        pointer operator->() const { return m_map->EntryPtr(m_pos); }
+        Iterator& operator++() { m_pos = m_map->NextLive(m_pos + 1); return *this; }
+        Iterator operator++(int) { Iterator ret{*this}; ++*this; return ret; }
+        template <bool C>
+        bool operator==(const Iterator<C>& other) const { return m_pos == other.m_pos; }
+    };
+
+    //! Uninitialized storage for one entry.
+    struct alignas(value_type) EntryStorage {
+        unsigned char data[sizeof(value_type)];
+    };
+
+    static constexpr uint32_t EMPTY_SLOT{std::numeric_limits<uint32_t>::max()};
+    static constexpr uint32_t NO_ENTRY{std::numeric_limits<uint32_t>::max()};
+
+    hasher m_hasher;
+    //! Entry storage.  Chunk i holds 1 << (FIRST_CHUNK_BITS + i) entries, up
+    //! to 1 << MAX_CHUNK_BITS (see coins.cpp).
+    std::vector<std::unique_ptr<EntryStorage[]>> m_chunks;
+    //! One bit per allocated entry number, set if the entry is constructed.
+    std::vector<uint64_t> m_live;
+    //! The index, a power of two in size, with each slot either EMPTY_SLOT or
+    //! the entry's stored hash with its low m_index_bits bits (which select
+    //! its home slot) replaced by the entry number.
+    std::vector<uint32_t> m_index;
+    uint32_t m_index_bits{0};
+    //! Number of entry numbers handed out, constructed or on the free list.
+    uint32_t m_allocated{0};
+    //! Number of constructed entries.
+    uint32_t m_size{0};
+    //! Head of the list of erased entry numbers, linked through their storage.
+    uint32_t m_free{NO_ENTRY};
+
+    value_type* EntryPtr(uint32_t entry) const;
+    bool IsLive(uint32_t entry) const { return (m_live[entry >> 6] >> (entry & 63)) & 1; }
+    //! Return the first constructed entry number at or after pos, or m_allocated.
+    uint32_t NextLive(uint32_t pos) const;
+    //! Return the entry number holding key, or NO_ENTRY.
+    uint32_t Lookup(const COutPoint& key, uint32_t hash) const;
+    //! Return an entry number with storage for a new entry, growing the index
+    //! if necessary so that it can take one more entry.
+    uint32_t AllocateEntry();
+    //! Return the storage of an unconstructed entry to the free list.
+    void FreeEntry(uint32_t entry);
+    //! Add a newly constructed entry to the index.
+    void LinkEntry(uint32_t entry);
+    void Rehash(uint32_t index_bits);
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit CCoinsMap(const hasher& hash = hasher{}) : m_hasher(hash) {}
+    ~CCoinsMap() { clear(); }
+
+    CCoinsMap(const CCoinsMap&) = delete;
+    CCoinsMap& operator=(const CCoinsMap&) = delete;
+
+    iterator begin() { return {this, NextLive(0)}; }
+    iterator end() { return {this, m_allocated}; }
+    const_iterator begin() const { return {this, NextLive(0)}; }
+    const_iterator end() const { return {this, m_allocated}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator find(const COutPoint& key)
+    {
+        const uint32_t entry{Lookup(key, static_cast<uint32_t>(m_hasher(key)))};
+        return entry == NO_ENTRY ? end() : iterator{this, entry};
+    }
+    const_iterator find(const COutPoint& key) const
+    {
+        const uint32_t entry{Lookup(key, static_cast<uint32_t>(m_hasher(key)))};
+        return entry == NO_ENTRY ? end() : const_iterator{this, entry};
+    }
+    size_t count(const COutPoint& key) const { return find(key) != end(); }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        const uint32_t hash{static_cast<uint32_t>(m_hasher(key))};
+        if (const uint32_t entry{Lookup(key, hash)}; entry != NO_ENTRY) {
+            return {iterator{this, entry}, false};
+        }
+        const uint32_t entry{AllocateEntry()};
+        try {
+            ::new (static_cast<void*>(EntryPtr(entry))) value_type(std::forward<K>(key), hash, std::forward<Args>(args)...);
+        } catch (...) {
+            FreeEntry(entry);
+            throw;
+        }
+        LinkEntry(entry);
+        return {iterator{this, entry}, true};
+    }
+    template <typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value) { return try_emplace(std::forward<K>(key), std::forward<V>(value)); }
+    CCoinsCacheEntry& operator[](const COutPoint& key) { return try_emplace(key).first->second; }
+
+    //! Erase an entry, returning an iterator to the next one.
+    iterator erase(const_iterator it);
+    //! Destroy all entries and release all memory.
+    void clear();
+
+    size_t DynamicMemoryUsage() const;
+};
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -251,6 +432,15 @@ public:
      */
     virtual bool GetCoin(const COutPoint &outpoint, Coin &coin) const;
 
+    /** Retrieve the Coins for several outpoints at once.  For each outpoint,
+     *  the result holds the unspent coin, or std::nullopt if there is none.
+     *  The default calls GetCoin for each outpoint.  Views which can serve a
+     *  batch more cheaply, such as the database reading its keys in order,
+     *  override this.  CCoinsViewBacked does not pass batches on to its base,
+     *  so that subclasses which only override GetCoin see every lookup.
+     */
+    virtual std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const;
+
     //! Just check whether a given outpoint is unspent.
     virtual bool HaveCoin(const COutPoint &outpoint) const;
 
@@ -303,9 +493,6 @@ public:
 /** CCoinsView that adds a memory cache for transactions to another CCoinsView */
 class CCoinsViewCache : public CCoinsViewBacked
 {
-private:
-    const bool m_deterministic;
-
 protected:
     /**
      * Make mutable so that we can "fill the cache" even from Get-methods
@@ -313,7 +500,6 @@ protected:
      */
     mutable std::optional<uint256> hashBlock;
     mutable std::optional<BlockFinalTxEntry> finalTxEntry;
-    mutable CCoinsMapMemoryResource m_cache_coins_memory_resource{};
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
@@ -329,6 +515,9 @@ public:
 
     // Standard CCoinsView methods
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    //! Serves cache hits, and fetches all misses from the base view in one
+    //! batch, adding the coins found to the cache as GetCoin would.
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     void SetBestBlock(const uint256 &hashBlock);
@@ -373,6 +562,14 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin);
 
+    /**
+     * Add an unspent coin which was read from the base view, exactly as if it
+     * had been fetched on a cache miss.  Nothing is done if the outpoint is
+     * already cached.  This allows coins to be read from the base view on
+     * other threads, ahead of their use.
+     */
+    void InsertFetchedCoin(COutPoint&& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -422,11 +619,8 @@ public:
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
-    //! Force a reallocation of the cache map. This is required when downsizing
-    //! the cache because the map's allocator may be hanging onto a lot of
-    //! memory despite having called .clear().
-    //!
-    //! See: https://stackoverflow.com/questions/42114044/how-to-release-unordered-map-memory
+    //! Release the memory held by the (empty) cache map. This is required when
+    //! downsizing the cache, as the map otherwise keeps its storage for reuse.
     void ReallocateCache();
 
     //! Run an internal sanity check on the cache data structure. */
@@ -471,6 +665,7 @@ public:
     }
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
 
 private:
@@ -479,4 +674,58 @@ private:
 
 };
 
+/**
+ * A view which can write the coins flushed into it to its base view in the
+ * background.
+ *
+ * After WriteNextInBackground(), the next BatchWrite takes the DIRTY entries
+ * of the flushed map into a frozen map of its own and hands them to a writer
+ * thread, returning as soon as the flushed map has been emptied.  Reads are
+ * served from the frozen map, without modifying it, and otherwise from the
+ * base view, which therefore must allow reads concurrent with a BatchWrite (as
+ * CCoinsViewDB does).  At most one write is in flight: the next BatchWrite, or
+ * Wait(), blocks until the previous write has finished.  Other BatchWrites
+ * pass straight through to the base view once any background write is done.
+ *
+ * Except for IsWriting(), the methods of this class are not thread-safe and
+ * must be serialized by the caller, as for any other view.
+ */
+class CCoinsViewBackgroundFlush final : public CCoinsViewBacked
+{
+private:
+    bool m_write_next_in_background{false};
+    //! The entries being written, with the block they bring the base view to.
+    CCoinsMap m_frozen;
+    uint256 m_frozen_block;
+    BlockFinalTxEntry m_frozen_final_tx;
+    std::thread m_writer;
+    std::atomic<bool> m_writing{false};
+    //! Result of the last write, valid once m_writer is joined.
+    bool m_write_ok{true};
+
+public:
+    explicit CCoinsViewBackgroundFlush(CCoinsView* view) : CCoinsViewBacked(view) {}
+    ~CCoinsViewBackgroundFlush() { Wait(); }
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
+    bool HaveCoin(const COutPoint& outpoint) const override;
+    uint256 GetBestBlock() const override;
+    BlockFinalTxEntry GetFinalTx() const override;
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const BlockFinalTxEntry& final_tx, bool erase = true) override;
+
+    //! Have the next BatchWrite return before its entries are written.
+    void WriteNextInBackground() { m_write_next_in_background = true; }
+
+    //! Whether a background write has been started and is not yet finished.
+    bool IsWriting() const { return m_writing.load(std::memory_order_acquire); }
+
+    /**
+     * Wait for any background write to finish, and release its entries.
+     *
+     * @returns false if the write failed.  This is reported once.
+     */
+    bool Wait();
+};
+
 #endif // FREICOIN_COINS_H
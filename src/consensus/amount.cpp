@@ -25,26 +25,19 @@
  ** enables running bitcoin regression tests unmodified. */
 bool disable_time_adjust = DEFAULT_DISABLE_TIME_ADJUST;
 
-CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance)
+DemurrageFactor GetDemurrageFactor(uint32_t distance)
 {
-    /* If we're in bitcoin unit test compatibility mode, return our
-     * input unmodified, with no demurrage adjustment. */
-    if (disable_time_adjust)
-        return initial_value;
-
-    /* We accept a signed initial_value as input, but perform
-     * demurrage calculations on that value's absolute magnitude. */
-    const int sign = (initial_value > 0) - (initial_value < 0);
-    const uint64_t value = std::abs(initial_value);
+    DemurrageFactor factor;
 
     /* The demurrage rate for an offset of 0 blocks, which is 1.0
      * exactly, has no representation in 0.64 fixed point. */
     if (distance == 0)
-        return initial_value;
+        return factor;
+    factor.identity = false;
     /* A distance of 2^26 blocks and beyond are sufficient to decay
-     * even MAX_MONEY to zero. */
+     * even MAX_MONEY to zero, which is what a rate of zero does. */
     if (distance >= ((uint32_t)1<<26))
-        return 0;
+        return factor;
 
     /* This array of pre-generated constants is an exponentiation
      * ladder of properly calculated 64-bit fixed point demurrage
@@ -58,7 +51,7 @@ CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance)
      * distance of 1<<26 (the would-be 27th entry) would cause even
      * MAX_MONEY (2^53 - 1) to decay to zero. If we are given a
      * distance value greater than or equal to (1<<26), we simply
-     * return 0LL. */
+     * return a rate of zero. */
     static std::array<uint32_t, 2*26> k32 = {
         0xfffff000, 0x00000000, /* 2^0 = 1 */
         0xffffe000, 0x01000000, /* 2^1 = 2 */
@@ -89,8 +82,9 @@ CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance)
     };
 
     /* Overflow sensitive fixed point multiply-and-accumulate methods
-     * which are used both for the exponentiation to calcuate the
-     * demurrage rate, and the final multiply at the end. */
+     * which are used for the exponentiation to calculate the
+     * demurrage rate.  Applying the rate to a value is done
+     * separately, by ApplyDemurrageRate() below. */
     uint64_t sum=0, overflow=0;
     auto shift32 = [&]() {
         sum = (overflow << 32) + (sum >> 32);
@@ -165,17 +159,45 @@ CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance)
         }
     }
 
+    factor.rate = (static_cast<uint64_t>(w[0]) << 32) | w[1];
+    return factor;
+}
+
+/* Multiply the magnitude of a value by a 0.64 fixed-point demurrage
+ * rate.  This is the final step of TimeAdjustValueForward(), shared
+ * by the single-value and batched interfaces so that the two always
+ * produce bit-identical results. */
+static inline CAmount ApplyDemurrageRate(const CAmount& initial_value, uint64_t rate)
+{
+    /* We accept a signed initial_value as input, but perform
+     * demurrage calculations on that value's absolute magnitude. */
+    const int sign = (initial_value > 0) - (initial_value < 0);
+    const uint64_t value = std::abs(initial_value);
+
+    /* Overflow sensitive fixed point multiply-and-accumulate, as
+     * above. */
+    uint64_t sum=0, overflow=0;
+    auto shift32 = [&]() {
+        sum = (overflow << 32) + (sum >> 32);
+        overflow = 0;
+    };
+    auto term = [&](uint64_t val) {
+        overflow += (sum + val) < sum;
+        sum += val;
+    };
+
     /* We now perform an approximately similar multiplication of the
      * final calculated demurrage factor by the passed in value. */
+    const uint64_t w0 = rate >> 32;
+    const uint64_t w1 = static_cast<uint32_t>(rate);
     const uint64_t v0 = value >> 32;
     const uint64_t v1 = static_cast<uint32_t>(value);
 
-    overflow = 0;
-    sum = (w[1] * v1) >> 32;
-    term(w[1] * v0);
-    term(w[0] * v1);
+    sum = (w1 * v1) >> 32;
+    term(w1 * v0);
+    term(w0 * v1);
     shift32();
-    term(w[0] * v0);
+    term(w0 * v0);
 
     /* Debugging check: having the overflow bit set at this point
      * would indicate that the demurrage calculation has resulted in
@@ -195,6 +217,40 @@ CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance)
     return sign * CAmount(static_cast<int64_t>(sum));
 }
 
+CAmount TimeAdjustValueForward(const CAmount& initial_value, const DemurrageFactor& factor)
+{
+    /* If we're in bitcoin unit test compatibility mode, or the factor
+     * is exactly 1.0, return our input unmodified. */
+    if (disable_time_adjust || factor.identity)
+        return initial_value;
+
+    return ApplyDemurrageRate(initial_value, factor.rate);
+}
+
+CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance)
+{
+    /* If we're in bitcoin unit test compatibility mode, return our
+     * input unmodified, with no demurrage adjustment. */
+    if (disable_time_adjust)
+        return initial_value;
+
+    return TimeAdjustValueForward(initial_value, GetDemurrageFactor(distance));
+}
+
+void TimeAdjustValuesForward(Span<CAmount> values, const DemurrageFactor& factor)
+{
+    if (disable_time_adjust || factor.identity)
+        return;
+
+    /* The rate is loop invariant and the per-value multiply has no
+     * data-dependent branches, so this is a single tight pass over
+     * the input which the compiler is free to unroll or vectorize. */
+    const uint64_t rate = factor.rate;
+    for (CAmount& value : values) {
+        value = ApplyDemurrageRate(value, rate);
+    }
+}
+
 CAmount TimeAdjustValueReverse(const CAmount& initial_value, uint32_t distance)
 {
     /* If we're in bitcoin unit test compatibility mode, return our
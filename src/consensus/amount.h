@@ -17,6 +17,8 @@
 #ifndef FREICOIN_CONSENSUS_AMOUNT_H
 #define FREICOIN_CONSENSUS_AMOUNT_H
 
+#include <span.h>
+
 #include <cstdint>
 
 /** Amount in kria (Can be negative) */
@@ -49,6 +51,23 @@ CAmount TimeAdjustValueForward(const CAmount& initial_value, uint32_t distance);
 CAmount TimeAdjustValueReverse(const CAmount& initial_value, uint32_t distance);
 CAmount GetTimeAdjustedValue(const CAmount& initial_value, int relative_depth);
 
+/** The aggregate demurrage rate over a fixed number of blocks, as a
+ ** 0.64 fixed-point fraction.  Computing the rate is the expensive
+ ** part of TimeAdjustValueForward(), so callers which adjust many
+ ** values by the same distance should compute it once with
+ ** GetDemurrageFactor() and reuse it.  A distance of zero (a rate of
+ ** exactly 1.0, which has no 0.64 fixed-point representation) is
+ ** flagged as the identity. */
+struct DemurrageFactor {
+    uint64_t rate{0};
+    bool identity{true};
+};
+DemurrageFactor GetDemurrageFactor(uint32_t distance);
+CAmount TimeAdjustValueForward(const CAmount& initial_value, const DemurrageFactor& factor);
+/** Adjust every value in place by the same factor.  Bit-identical to
+ ** calling TimeAdjustValueForward() on each value in turn. */
+void TimeAdjustValuesForward(Span<CAmount> values, const DemurrageFactor& factor);
+
 /** Convert between demurrage currency and inflationary scrip. */
 CAmount FreicoinToScrip(const CAmount& freicoin, uint32_t height);
 CAmount ScripToFreicoin(const CAmount& scrip, uint32_t height);
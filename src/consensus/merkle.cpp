@@ -86,6 +86,10 @@ uint256 MerkleHash_Sha256Midstate(const uint256& left, const uint256& right) {
     return parent;
 }
 
+void MerkleHashes_Sha256Midstate(uint256* parents, const uint256* children, size_t count) {
+    SHA256Midstate64(parents[0].begin(), children[0].begin(), _MidstateIV, count);
+}
+
 /* This implements a constant-space merkle root/path calculator, limited to 2^32 leaves. */
 static void MerkleComputation(const std::vector<uint256>& leaves, uint256* proot, bool* pmutated, uint32_t branchpos, std::vector<uint256>* pbranch, merklecomputationopts flags) {
     if (pbranch) pbranch->clear();
@@ -266,9 +270,136 @@ uint256 ComputeFastMerkleRoot(const std::vector<uint256>& leaves) {
     if (leaves.empty()) {
         return HashWriter{}.GetHash();
     }
-    uint256 hash;
-    MerkleComputation(leaves, &hash, nullptr, -1, nullptr, MERKLE_COMPUTATION_FAST);
-    return hash;
+    /* The fast Merkle tree can be computed one level at a time: adjacent
+     * pairs are hashed together, and an odd hash at the end of a level is
+     * carried up to the next level unchanged.  This gives the same tree as
+     * MerkleComputation, but lets each level be hashed in a single batch. */
+    std::vector<uint256> hashes(leaves);
+    while (hashes.size() > 1) {
+        const size_t pairs = hashes.size() / 2;
+        MerkleHashes_Sha256Midstate(hashes.data(), hashes.data(), pairs);
+        if (hashes.size() & 1) {
+            hashes[pairs] = hashes.back();
+        }
+        hashes.resize(hashes.size() - pairs);
+    }
+    return hashes[0];
+}
+
+CachedMerkleTree::CachedMerkleTree(std::vector<uint256> leaves, Type type) : m_type(type)
+{
+    if (leaves.empty()) {
+        return;
+    }
+    m_levels.push_back(std::move(leaves));
+    while (m_levels.back().size() > 1) {
+        const std::vector<uint256>& level = m_levels.back();
+        std::vector<uint256> parents(level.size() / 2);
+        // Hash the complete pairs of each level in a single batch.
+        if (m_type == Type::FAST) {
+            MerkleHashes_Sha256Midstate(parents.data(), level.data(), parents.size());
+        } else {
+            SHA256D64(parents[0].begin(), level[0].begin(), parents.size());
+        }
+        if (level.size() & 1) {
+            parents.push_back(HashUnpaired(level.back()));
+        }
+        m_levels.push_back(std::move(parents));
+    }
+}
+
+uint256 CachedMerkleTree::HashPair(const uint256& left, const uint256& right) const
+{
+    return m_type == Type::FAST ? MerkleHash_Sha256Midstate(left, right) : MerkleHash_Hash256(left, right);
+}
+
+uint256 CachedMerkleTree::HashUnpaired(const uint256& node) const
+{
+    // Satoshi trees hash an unpaired node with itself, whereas fast trees
+    // carry it up to the next level as-is.
+    return m_type == Type::FAST ? node : MerkleHash_Hash256(node, node);
+}
+
+void CachedMerkleTree::UpdateParent(size_t level, size_t pos)
+{
+    const std::vector<uint256>& nodes = m_levels[level];
+    const size_t left = pos & ~size_t{1};
+    const uint256 hash = left + 1 < nodes.size() ? HashPair(nodes[left], nodes[left + 1]) : HashUnpaired(nodes[left]);
+    if (level + 1 == m_levels.size()) {
+        m_levels.emplace_back();
+    }
+    std::vector<uint256>& parents = m_levels[level + 1];
+    if (parents.size() <= pos / 2) {
+        parents.resize(pos / 2 + 1);
+    }
+    parents[pos / 2] = hash;
+}
+
+void CachedMerkleTree::SetLeaf(size_t pos, const uint256& hash)
+{
+    assert(pos < size());
+    m_levels[0][pos] = hash;
+    for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+        UpdateParent(level, pos);
+        pos /= 2;
+    }
+}
+
+void CachedMerkleTree::Append(const uint256& hash)
+{
+    if (m_levels.empty()) {
+        m_levels.emplace_back();
+    }
+    m_levels[0].push_back(hash);
+    size_t pos = m_levels[0].size() - 1;
+    for (size_t level = 0; m_levels[level].size() > 1; ++level) {
+        UpdateParent(level, pos);
+        pos /= 2;
+    }
+}
+
+uint256 CachedMerkleTree::GetRoot() const
+{
+    if (m_levels.empty()) {
+        return m_type == Type::FAST ? HashWriter{}.GetHash() : uint256();
+    }
+    return m_levels.back()[0];
+}
+
+std::vector<uint256> CachedMerkleTree::GetBranch(uint32_t position) const
+{
+    std::vector<uint256> branch;
+    if (position >= size()) {
+        return branch;
+    }
+    for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+        const std::vector<uint256>& nodes = m_levels[level];
+        const size_t sibling = position ^ 1;
+        if (sibling < nodes.size()) {
+            branch.push_back(nodes[sibling]);
+        } else if (m_type == Type::SATOSHI) {
+            // The node is hashed with itself.
+            branch.push_back(nodes[position]);
+        }
+        position >>= 1;
+    }
+    return branch;
+}
+
+std::pair<std::vector<uint256>, std::pair<uint32_t, uint32_t> > CachedMerkleTree::GetStableBranch(uint32_t position) const
+{
+    std::vector<uint256> branch;
+    if (position < size()) {
+        uint32_t pos = position;
+        for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+            // Unlike GetBranch, a node hashed with itself is left out.
+            if ((pos ^ 1) < m_levels[level].size()) {
+                branch.push_back(m_levels[level][pos ^ 1]);
+            }
+            pos >>= 1;
+        }
+    }
+    return {branch, ComputeMerklePathAndMask(branch.size(), position)};
 }
 
 std::pair<uint32_t, uint32_t> ComputeMerklePathAndMask(uint32_t branchlen, uint32_t position)
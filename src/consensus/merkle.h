@@ -23,6 +23,9 @@
 
 uint256 MerkleHash_Hash256(const uint256& left, const uint256& right);
 uint256 MerkleHash_Sha256Midstate(const uint256& left, const uint256& right);
+/* Batched MerkleHash_Sha256Midstate: parents[i] is the hash of children[2*i]
+ * and children[2*i+1], for i < count.  parents may alias children. */
+void MerkleHashes_Sha256Midstate(uint256* parents, const uint256* children, size_t count);
 
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
 std::vector<uint256> ComputeMerkleBranch(const std::vector<uint256>& leaves, uint32_t position);
@@ -148,6 +151,53 @@ uint256 ComputeFastMerkleRoot(const std::vector<uint256>& leaves);
 std::pair<std::vector<uint256>, uint32_t> ComputeFastMerkleBranch(const std::vector<uint256>& leaves, uint32_t position);
 uint256 ComputeFastMerkleRootFromBranch(const uint256& leaf, const std::vector<uint256>& branch, uint32_t path, bool* invalid = nullptr);
 
+/*
+ * A Merkle tree which keeps every level of inner hashes, so that replacing or
+ * appending a leaf only rehashes the O(log n) nodes along its path to the
+ * root, and roots and branches can be read off without rehashing the tree.
+ *
+ * SATOSHI trees are hashed with double-SHA256 and duplicate the final hash of
+ * an odd-sized level, as with ComputeMerkleRoot.  Their branches are those of
+ * ComputeMerkleBranch, and GetStableBranch gives those of
+ * ComputeStableMerkleBranch.  FAST trees are hashed with
+ * MerkleHash_Sha256Midstate and carry the final hash of an odd-sized level up
+ * unchanged, as with ComputeFastMerkleRoot, and their branches are those of
+ * ComputeFastMerkleBranch.
+ */
+class CachedMerkleTree
+{
+public:
+    enum class Type { SATOSHI, FAST };
+
+private:
+    Type m_type;
+    //! m_levels[0] holds the leaves and m_levels.back() the root, if any.
+    std::vector<std::vector<uint256>> m_levels;
+
+    uint256 HashPair(const uint256& left, const uint256& right) const;
+    uint256 HashUnpaired(const uint256& node) const;
+    //! Recompute the parent of the node at the given level and position.
+    void UpdateParent(size_t level, size_t pos);
+
+public:
+    explicit CachedMerkleTree(Type type = Type::SATOSHI) : m_type(type) {}
+    CachedMerkleTree(std::vector<uint256> leaves, Type type = Type::SATOSHI);
+
+    Type GetType() const { return m_type; }
+    size_t size() const { return m_levels.empty() ? 0 : m_levels[0].size(); }
+    bool empty() const { return size() == 0; }
+    const uint256& GetLeaf(size_t pos) const { return m_levels[0][pos]; }
+
+    void SetLeaf(size_t pos, const uint256& hash);
+    void Append(const uint256& hash);
+
+    //! As ComputeMerkleRoot or ComputeFastMerkleRoot, without mutation checks.
+    uint256 GetRoot() const;
+    std::vector<uint256> GetBranch(uint32_t position) const;
+    //! Only meaningful for SATOSHI trees.
+    std::pair<std::vector<uint256>, std::pair<uint32_t, uint32_t> > GetStableBranch(uint32_t position) const;
+};
+
 struct MerkleMapNode {
     //! The number of prefix bits in common among all keys in this subtree, and
     //! therefore the number of branches 'skipped.'
@@ -140,7 +140,8 @@ unsigned int GetLegacySigOpCount(const CTransaction& tx)
     return nSigOps;
 }
 
-unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& inputs)
+template <typename GetCoin>
+static unsigned int GetP2SHSigOpCountImpl(const CTransaction& tx, GetCoin get_coin)
 {
     if (tx.IsCoinBase())
         return 0;
@@ -148,7 +149,7 @@ unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& in
     unsigned int nSigOps = 0;
     for (unsigned int i = 0; i < tx.vin.size(); i++)
     {
-        const Coin& coin = inputs.AccessCoin(tx.vin[i].prevout);
+        const Coin& coin = get_coin(i);
         assert(!coin.IsSpent());
         const CTxOut &prevout = coin.out;
         if (prevout.scriptPubKey.IsPayToScriptHash())
@@ -157,7 +158,19 @@ unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& in
     return nSigOps;
 }
 
-int64_t GetTransactionSigOpCost(const CTransaction& tx, const CCoinsViewCache& inputs, uint32_t flags)
+unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& inputs)
+{
+    return GetP2SHSigOpCountImpl(tx, [&](unsigned int i) -> const Coin& { return inputs.AccessCoin(tx.vin[i].prevout); });
+}
+
+unsigned int GetP2SHSigOpCount(const CTransaction& tx, const std::vector<Coin>& spent_coins)
+{
+    assert(tx.IsCoinBase() || spent_coins.size() == tx.vin.size());
+    return GetP2SHSigOpCountImpl(tx, [&](unsigned int i) -> const Coin& { return spent_coins[i]; });
+}
+
+template <typename Inputs>
+static int64_t GetTransactionSigOpCostImpl(const CTransaction& tx, const Inputs& inputs, uint32_t flags)
 {
     int64_t nSigOps = GetLegacySigOpCount(tx) * WITNESS_SCALE_FACTOR;
 
@@ -170,18 +183,22 @@ int64_t GetTransactionSigOpCost(const CTransaction& tx, const CCoinsViewCache& i
     return nSigOps;
 }
 
-bool Consensus::CheckTxInputs(const CTransaction& tx, TxValidationState& state, const CCoinsViewCache& inputs, const Consensus::Params& params, int per_input_adjustment, int nSpendHeight, Consensus::RuleSet rules, CAmount& txfee)
+int64_t GetTransactionSigOpCost(const CTransaction& tx, const CCoinsViewCache& inputs, uint32_t flags)
 {
-    // are the actual inputs available?
-    if (!inputs.HaveInputs(tx)) {
-        return state.Invalid(TxValidationResult::TX_MISSING_INPUTS, "bad-txns-inputs-missingorspent",
-                         strprintf("%s: inputs missing/spent", __func__));
-    }
+    return GetTransactionSigOpCostImpl(tx, inputs, flags);
+}
 
+int64_t GetTransactionSigOpCost(const CTransaction& tx, const std::vector<Coin>& spent_coins, uint32_t flags)
+{
+    return GetTransactionSigOpCostImpl(tx, spent_coins, flags);
+}
+
+template <typename GetCoin>
+static bool CheckTxInputValues(const CTransaction& tx, TxValidationState& state, GetCoin get_coin, const Consensus::Params& params, int per_input_adjustment, int nSpendHeight, Consensus::RuleSet rules, CAmount& txfee)
+{
     CAmount nValueIn = 0;
     for (unsigned int i = 0; i < tx.vin.size(); ++i) {
-        const COutPoint &prevout = tx.vin[i].prevout;
-        const Coin& coin = inputs.AccessCoin(prevout);
+        const Coin& coin = get_coin(i);
         assert(!coin.IsSpent());
 
         // If prev is coinbase, check that it's matured
@@ -220,3 +237,20 @@ bool Consensus::CheckTxInputs(const CTransaction& tx, TxValidationState& state,
     txfee = txfee_aux;
     return true;
 }
+
+bool Consensus::CheckTxInputs(const CTransaction& tx, TxValidationState& state, const CCoinsViewCache& inputs, const Consensus::Params& params, int per_input_adjustment, int nSpendHeight, Consensus::RuleSet rules, CAmount& txfee)
+{
+    // are the actual inputs available?
+    if (!inputs.HaveInputs(tx)) {
+        return state.Invalid(TxValidationResult::TX_MISSING_INPUTS, "bad-txns-inputs-missingorspent",
+                         strprintf("%s: inputs missing/spent", __func__));
+    }
+
+    return CheckTxInputValues(tx, state, [&](unsigned int i) -> const Coin& { return inputs.AccessCoin(tx.vin[i].prevout); }, params, per_input_adjustment, nSpendHeight, rules, txfee);
+}
+
+bool Consensus::CheckTxInputs(const CTransaction& tx, TxValidationState& state, const std::vector<Coin>& spent_coins, const Consensus::Params& params, int per_input_adjustment, int nSpendHeight, Consensus::RuleSet rules, CAmount& txfee)
+{
+    assert(spent_coins.size() == tx.vin.size());
+    return CheckTxInputValues(tx, state, [&](unsigned int i) -> const Coin& { return spent_coins[i]; }, params, per_input_adjustment, nSpendHeight, rules, txfee);
+}
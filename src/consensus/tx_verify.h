@@ -25,6 +25,7 @@
 
 class CBlockIndex;
 class CCoinsViewCache;
+class Coin;
 class CTransaction;
 class TxValidationState;
 
@@ -38,6 +39,13 @@ namespace Consensus {
  * Preconditions: tx.IsCoinBase() is false.
  */
 [[nodiscard]] bool CheckTxInputs(const CTransaction& tx, TxValidationState& state, const CCoinsViewCache& inputs, const Consensus::Params& params, int per_input_adjustment, int nSpendHeight, RuleSet rules, CAmount& txfee);
+/**
+ * As above, but checked against the coins spent by the transaction, in the
+ * order of its inputs, rather than those in a view.  This is used to check
+ * transactions whose inputs have already been spent in the view, e.g. from
+ * their undo data.
+ */
+[[nodiscard]] bool CheckTxInputs(const CTransaction& tx, TxValidationState& state, const std::vector<Coin>& spent_coins, const Consensus::Params& params, int per_input_adjustment, int nSpendHeight, RuleSet rules, CAmount& txfee);
 } // namespace Consensus
 
 /** Auxiliary functions for transaction validation (ideally should not be exposed) */
@@ -57,6 +65,7 @@ unsigned int GetLegacySigOpCount(const CTransaction& tx);
  * @see CTransaction::FetchInputs
  */
 unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& mapInputs);
+unsigned int GetP2SHSigOpCount(const CTransaction& tx, const std::vector<Coin>& spent_coins);
 
 /**
  * Compute total signature operation cost of a transaction.
@@ -66,6 +75,7 @@ unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& ma
  * @return Total signature operation cost of tx
  */
 int64_t GetTransactionSigOpCost(const CTransaction& tx, const CCoinsViewCache& inputs, uint32_t flags);
+int64_t GetTransactionSigOpCost(const CTransaction& tx, const std::vector<Coin>& spent_coins, uint32_t flags);
 
 /**
  * Check if transaction is final and can be included in a block with the
@@ -46,11 +46,13 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 namespace sha256d64_sse41
 {
 void Transform_4way(unsigned char* out, const unsigned char* in);
+void TransformMidstate_4way(unsigned char* out, const unsigned char* in, const uint32_t* iv);
 }
 
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
+void TransformMidstate_8way(unsigned char* out, const unsigned char* in, const uint32_t* iv);
 }
 
 namespace sha256d64_x86_shani
@@ -451,6 +453,7 @@ void TransformD64(unsigned char* out, const unsigned char* in)
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
 typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+typedef void (*TransformMidstateType)(unsigned char*, const unsigned char*, const uint32_t*);
 
 template<TransformType tr>
 void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
@@ -496,6 +499,25 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformMidstateType TransformMidstate_4way = nullptr;
+TransformMidstateType TransformMidstate_8way = nullptr;
+
+/** Single-block compression of one 64-byte input from the given state, using
+ *  whichever 1-way transform was detected. */
+void TransformMidstate(unsigned char* out, const unsigned char* in, const uint32_t* iv)
+{
+    uint32_t s[8];
+    std::copy(iv, iv + 8, s);
+    Transform(s, in, 1);
+    WriteBE32(out + 0, s[0]);
+    WriteBE32(out + 4, s[1]);
+    WriteBE32(out + 8, s[2]);
+    WriteBE32(out + 12, s[3]);
+    WriteBE32(out + 16, s[4]);
+    WriteBE32(out + 20, s[5]);
+    WriteBE32(out + 24, s[6]);
+    WriteBE32(out + 28, s[7]);
+}
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -579,6 +601,36 @@ bool SelfTest() {
         if (!std::equal(out, out + 256, result_d64)) return false;
     }
 
+    // Expected midstates for each of the 8 64-byte messages compressed from a
+    // non-standard initial state, computed with the 1-way Transform tested above.
+    unsigned char result_midstate[256];
+    for (size_t i = 0; i < 8; ++i) {
+        uint32_t state[8];
+        std::copy(result[8], result[8] + 8, state);
+        Transform(state, data + 1 + 64 * i, 1);
+        for (size_t j = 0; j < 8; ++j) {
+            WriteBE32(result_midstate + 32 * i + 4 * j, state[j]);
+        }
+    }
+
+    // Test TransformMidstate
+    TransformMidstate(out, data + 1, result[8]);
+    if (!std::equal(out, out + 32, result_midstate)) return false;
+
+    // Test TransformMidstate_4way, if available.
+    if (TransformMidstate_4way) {
+        unsigned char out[128];
+        TransformMidstate_4way(out, data + 1, result[8]);
+        if (!std::equal(out, out + 128, result_midstate)) return false;
+    }
+
+    // Test TransformMidstate_8way, if available.
+    if (TransformMidstate_8way) {
+        unsigned char out[256];
+        TransformMidstate_8way(out, data + 1, result[8]);
+        if (!std::equal(out, out + 256, result_midstate)) return false;
+    }
+
     return true;
 }
 
@@ -604,6 +656,8 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
     TransformD64_2way = nullptr;
     TransformD64_4way = nullptr;
     TransformD64_8way = nullptr;
+    TransformMidstate_4way = nullptr;
+    TransformMidstate_8way = nullptr;
 
 #if !defined(DISABLE_OPTIMIZED_SHA256)
 #if defined(HAVE_GETCPUID)
@@ -653,6 +707,7 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
 #endif
 #if defined(ENABLE_SSE41)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformMidstate_4way = sha256d64_sse41::TransformMidstate_4way;
         ret += ",sse41(4way)";
 #endif
     }
@@ -660,6 +715,7 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
 #if defined(ENABLE_AVX2)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformMidstate_8way = sha256d64_avx2::TransformMidstate_8way;
         ret += ",avx2(8way)";
     }
 #endif
@@ -826,3 +882,33 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+void SHA256Midstate64(unsigned char* out, const unsigned char* in, const unsigned char iv[CSHA256::OUTPUT_SIZE], size_t blocks)
+{
+    uint32_t s[8];
+    for (int i = 0; i < 8; ++i) {
+        s[i] = ReadBE32(iv + 4 * i);
+    }
+    if (TransformMidstate_8way) {
+        while (blocks >= 8) {
+            TransformMidstate_8way(out, in, s);
+            out += 256;
+            in += 512;
+            blocks -= 8;
+        }
+    }
+    if (TransformMidstate_4way) {
+        while (blocks >= 4) {
+            TransformMidstate_4way(out, in, s);
+            out += 128;
+            in += 256;
+            blocks -= 4;
+        }
+    }
+    while (blocks) {
+        TransformMidstate(out, in, s);
+        out += 32;
+        in += 64;
+        --blocks;
+    }
+}
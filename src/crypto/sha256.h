@@ -64,4 +64,14 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute multiple single-block SHA256 compressions of 64-byte blobs, each
+ *  starting from the same initial state and without any padding, and return
+ *  the resulting midstates (as CSHA256::Midstate() would).
+ *  output:  pointer to a blocks*32 byte output buffer
+ *  input:   pointer to a blocks*64 byte input buffer
+ *  iv:      the 32-byte initial state, serialized as for CSHA256(iv)
+ *  blocks:  the number of midstates to compute.
+ */
+void SHA256Midstate64(unsigned char* output, const unsigned char* input, const unsigned char iv[CSHA256::OUTPUT_SIZE], size_t blocks);
+
 #endif // FREICOIN_CRYPTO_SHA256_H
@@ -25,7 +25,9 @@
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
@@ -38,6 +40,9 @@
  *
  * 2. @ref cache is a cache which is performant in memory usage and lookup speed. It
  * is lockfree for erase operations. Elements are lazily erased on the next insert.
+ *
+ * 3. @ref sharded_cache is a thread-safe cache made of independently locked
+ * @ref cache shards, which also counts its hits, misses and evictions.
  */
 namespace CuckooCache
 {
@@ -406,8 +411,9 @@ public:
      * @post one of the following: All previously inserted elements and e are
      * now in the table, one previously inserted element is evicted from the
      * table, the entry attempted to be inserted is evicted.
+     * @returns false if an element was evicted, true otherwise
      */
-    inline void insert(Element e)
+    inline bool insert(Element e)
     {
         epoch_check();
         uint32_t last_loc = invalid();
@@ -419,7 +425,7 @@ public:
             if (table[loc] == e) {
                 please_keep(loc);
                 epoch_flags[loc] = last_epoch;
-                return;
+                return true;
             }
         for (uint8_t depth = 0; depth < depth_limit; ++depth) {
             // First try to insert to an empty slot, if one exists
@@ -429,7 +435,7 @@ public:
                 table[loc] = std::move(e);
                 please_keep(loc);
                 epoch_flags[loc] = last_epoch;
-                return;
+                return true;
             }
             /** Swap with the element at the location that was
             * not the last one looked at. Example:
@@ -455,6 +461,7 @@ public:
             // Recompute the locs -- unfortunately happens one too many times!
             locs = compute_hashes(e);
         }
+        return false;
     }
 
     /** contains iterates through the hash locations for a given element
@@ -496,6 +503,116 @@ public:
         return false;
     }
 };
+
+/** Counters kept by sharded_cache. */
+struct cache_stats {
+    //! Number of contains() calls which found, or did not find, the element.
+    uint64_t hits{0};
+    uint64_t misses{0};
+    //! Number of insert() calls, and how many of them evicted an element.
+    uint64_t inserts{0};
+    uint64_t evictions{0};
+};
+
+/**
+ * sharded_cache splits a @ref cache into 2^shard_bits independent caches,
+ * each behind its own reader/writer lock, so that it may be used from many
+ * threads at once without the inserts of one thread stalling the lookups and
+ * inserts of all others.
+ *
+ * An element's shard is given by the low bits of its first hash.  The cache
+ * maps a hash onto a table slot by its high bits, so the slots of the
+ * elements of one shard remain spread over that shard's whole table.
+ *
+ * Unlike @ref cache, all methods are thread-safe.
+ *
+ * @tparam shard_bits log2 of the number of shards
+ */
+template <typename Element, typename Hash, uint8_t shard_bits>
+class sharded_cache
+{
+private:
+    static constexpr size_t SHARDS{size_t{1} << shard_bits};
+
+    struct alignas(64) shard {
+        mutable std::shared_mutex mutex;
+        cache<Element, Hash> table;
+        mutable std::atomic<uint64_t> hits{0};
+        mutable std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> inserts{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+
+    std::array<shard, SHARDS> shards;
+    const Hash hash_function;
+
+    shard& shard_for(const Element& e) { return shards[hash_function.template operator()<0>(e) & (SHARDS - 1)]; }
+    const shard& shard_for(const Element& e) const { return shards[hash_function.template operator()<0>(e) & (SHARDS - 1)]; }
+
+public:
+    sharded_cache() : shards(), hash_function() {}
+
+    /** setup_bytes divides bytes evenly between the shards, see
+     * @ref cache::setup_bytes.  It should only be called once, before the
+     * cache is used.
+     *
+     * @returns A pair of the total maximum number of elements storable and
+     * their approximate size in bytes, or std::nullopt if the size requested
+     * is too large.
+     */
+    std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t bytes)
+    {
+        uint64_t num_elems{0};
+        size_t approx_size_bytes{0};
+        for (shard& s : shards) {
+            const auto setup_results{s.table.setup_bytes(bytes / SHARDS)};
+            if (!setup_results) return std::nullopt;
+            num_elems += setup_results->first;
+            approx_size_bytes += setup_results->second;
+        }
+        if (num_elems > std::numeric_limits<uint32_t>::max()) return std::nullopt;
+        return std::make_pair(static_cast<uint32_t>(num_elems), approx_size_bytes);
+    }
+
+    /** See @ref cache::insert. */
+    void insert(Element e)
+    {
+        shard& s{shard_for(e)};
+        bool evicted;
+        {
+            std::unique_lock<std::shared_mutex> lock(s.mutex);
+            evicted = !s.table.insert(std::move(e));
+        }
+        s.inserts.fetch_add(1, std::memory_order_relaxed);
+        if (evicted) s.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** See @ref cache::contains. */
+    bool contains(const Element& e, const bool erase) const
+    {
+        const shard& s{shard_for(e)};
+        bool found;
+        {
+            std::shared_lock<std::shared_mutex> lock(s.mutex);
+            found = s.table.contains(e, erase);
+        }
+        (found ? s.hits : s.misses).fetch_add(1, std::memory_order_relaxed);
+        return found;
+    }
+
+    /** @returns the counters summed over all shards */
+    cache_stats stats() const
+    {
+        cache_stats ret;
+        for (const shard& s : shards) {
+            ret.hits += s.hits.load(std::memory_order_relaxed);
+            ret.misses += s.misses.load(std::memory_order_relaxed);
+            ret.inserts += s.inserts.load(std::memory_order_relaxed);
+            ret.evictions += s.evictions.load(std::memory_order_relaxed);
+        }
+        return ret;
+    }
+};
 } // namespace CuckooCache
 
 #endif // FREICOIN_CUCKOOCACHE_H
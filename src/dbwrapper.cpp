@@ -20,12 +20,17 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <sync.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/strencodings.h>
+#include <util/time.h>
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <chrono>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
@@ -40,7 +45,9 @@
 #include <leveldb/status.h>
 #include <leveldb/write_batch.h>
 #include <memory>
+#include <numeric>
 #include <optional>
+#include <set>
 #include <utility>
 
 static auto CharCast(const std::byte* data) { return reinterpret_cast<const char*>(data); }
@@ -206,6 +213,74 @@ void CDBBatch::EraseImpl(Span<const std::byte> key)
     size_estimate += 2 + (slKey.size() > 127) + slKey.size();
 }
 
+/** Lock-free counters behind DBOpStats. Relaxed ordering is enough, as each
+ * counter is only ever read as an approximate snapshot. */
+struct DBOpCounters {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> found{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> time_ns{0};
+    std::array<std::atomic<uint64_t>, DB_LATENCY_BUCKETS> latency{};
+
+    void Record(bool was_found, size_t num_bytes, std::chrono::nanoseconds elapsed)
+    {
+        const uint64_t ns = std::max<int64_t>(elapsed.count(), 0);
+        const size_t bucket = std::min<size_t>(std::bit_width(ns / 1000), DB_LATENCY_BUCKETS - 1);
+        count.fetch_add(1, std::memory_order_relaxed);
+        if (was_found) found.fetch_add(1, std::memory_order_relaxed);
+        if (num_bytes) bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+        time_ns.fetch_add(ns, std::memory_order_relaxed);
+        latency[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DBOpStats Snapshot() const
+    {
+        DBOpStats stats;
+        stats.count = count.load(std::memory_order_relaxed);
+        stats.found = found.load(std::memory_order_relaxed);
+        stats.bytes = bytes.load(std::memory_order_relaxed);
+        stats.time_ns = time_ns.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < DB_LATENCY_BUCKETS; ++i) {
+            stats.latency[i] = latency[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+};
+
+/** Operation statistics of a CDBWrapper. Lookup counters are allocated on
+ * first use of a leading key byte, as a database only uses a handful of the
+ * possible prefixes. */
+struct DBStatsContext {
+    using LookupCounters = std::array<DBOpCounters, DB_LOOKUP_KINDS>;
+
+    std::array<std::atomic<LookupCounters*>, 256> lookups{};
+    DBOpCounters write_batch;
+
+    DBStatsContext() = default;
+    DBStatsContext(const DBStatsContext&) = delete;
+    DBStatsContext& operator=(const DBStatsContext&) = delete;
+
+    ~DBStatsContext()
+    {
+        for (auto& counters : lookups) {
+            delete counters.load();
+        }
+    }
+
+    void RecordLookup(DBLookup kind, Span<const std::byte> key, bool was_found, size_t num_bytes, std::chrono::nanoseconds elapsed)
+    {
+        auto& slot = lookups[key.empty() ? 0 : uint8_t(key[0])];
+        LookupCounters* counters = slot.load(std::memory_order_acquire);
+        if (!counters) {
+            auto fresh = std::make_unique<LookupCounters>();
+            if (slot.compare_exchange_strong(counters, fresh.get(), std::memory_order_acq_rel)) {
+                counters = fresh.release();
+            }
+        }
+        (*counters)[size_t(kind)].Record(was_found, num_bytes, elapsed);
+    }
+};
+
 struct LevelDBContext {
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -227,8 +302,18 @@ struct LevelDBContext {
 
     //! the database itself
     leveldb::DB* pdb;
+
+    //! capacity of options.block_cache, which leveldb does not report
+    size_t block_cache_size;
+
+    //! operation counters, see CDBWrapper::GetStats
+    DBStatsContext stats;
 };
 
+/** All open databases, so that their statistics can be reported. */
+static GlobalMutex g_dbwrappers_mutex;
+static std::set<const CDBWrapper*> g_dbwrappers GUARDED_BY(g_dbwrappers_mutex);
+
 CDBWrapper::CDBWrapper(const DBParams& params)
     : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
 {
@@ -238,6 +323,7 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     DBContext().iteroptions.fill_cache = false;
     DBContext().syncoptions.sync = true;
     DBContext().options = GetOptions(params.cache_bytes);
+    DBContext().block_cache_size = params.cache_bytes / 2;
     DBContext().options.create_if_missing = true;
     if (params.memory_only) {
         DBContext().penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -283,10 +369,17 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", fs::PathToString(params.path), HexStr(obfuscate_key));
+
+    LOCK(g_dbwrappers_mutex);
+    g_dbwrappers.insert(this);
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(g_dbwrappers_mutex);
+        g_dbwrappers.erase(this);
+    }
     delete DBContext().pdb;
     DBContext().pdb = nullptr;
     delete DBContext().options.filter_policy;
@@ -306,8 +399,10 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
     if (log_memory) {
         mem_before = DynamicMemoryUsage() / 1024.0 / 1024;
     }
+    const auto start{SteadyClock::now()};
     leveldb::Status status = DBContext().pdb->Write(fSync ? DBContext().syncoptions : DBContext().writeoptions, &batch.m_impl_batch->batch);
     HandleError(status);
+    DBContext().stats.write_batch.Record(/*was_found=*/false, batch.SizeEstimate(), SteadyClock::now() - start);
     if (log_memory) {
         double mem_after = DynamicMemoryUsage() / 1024.0 / 1024;
         LogPrint(BCLog::LEVELDB, "WriteBatch memory usage: db=%s, before=%.1fMiB, after=%.1fMiB\n",
@@ -327,6 +422,39 @@ size_t CDBWrapper::DynamicMemoryUsage() const
     return parsed.value();
 }
 
+DBStats CDBWrapper::GetStats() const
+{
+    DBStats stats;
+    stats.path = m_path;
+    stats.memory_only = m_is_memory;
+    stats.memory_usage = DynamicMemoryUsage();
+    if (const leveldb::Cache* cache = DBContext().options.block_cache) {
+        stats.block_cache_size = DBContext().block_cache_size;
+        stats.block_cache_usage = cache->TotalCharge();
+    }
+    stats.write_batch = DBContext().stats.write_batch.Snapshot();
+    for (size_t prefix = 0; prefix < DBContext().stats.lookups.size(); ++prefix) {
+        const auto* counters = DBContext().stats.lookups[prefix].load(std::memory_order_acquire);
+        if (!counters) continue;
+        auto& entry = stats.lookups[uint8_t(prefix)];
+        for (size_t kind = 0; kind < DB_LOOKUP_KINDS; ++kind) {
+            entry[kind] = (*counters)[kind].Snapshot();
+        }
+    }
+    return stats;
+}
+
+std::vector<DBStats> GetAllDBStats()
+{
+    LOCK(g_dbwrappers_mutex);
+    std::vector<DBStats> ret;
+    ret.reserve(g_dbwrappers.size());
+    for (const CDBWrapper* db : g_dbwrappers) {
+        ret.push_back(db->GetStats());
+    }
+    return ret;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -350,7 +478,9 @@ std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
     std::string strValue;
+    const auto start{SteadyClock::now()};
     leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
+    DBContext().stats.RecordLookup(DBLookup::READ, key, status.ok(), strValue.size(), SteadyClock::now() - start);
     if (!status.ok()) {
         if (status.IsNotFound())
             return std::nullopt;
@@ -360,12 +490,49 @@ std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
     return strValue;
 }
 
+std::vector<std::optional<std::string>> CDBWrapper::ReadManyImpl(Span<const Span<const std::byte>> keys) const
+{
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    // leveldb's default comparator orders keys as unsigned byte strings.
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::lexicographical_compare(keys[a].begin(), keys[a].end(), keys[b].begin(), keys[b].end());
+    });
+
+    struct SnapshotHolder {
+        leveldb::DB* const db;
+        const leveldb::Snapshot* const snapshot;
+        ~SnapshotHolder() { db->ReleaseSnapshot(snapshot); }
+    } holder{DBContext().pdb, DBContext().pdb->GetSnapshot()};
+    leveldb::ReadOptions options{DBContext().readoptions};
+    options.snapshot = holder.snapshot;
+
+    std::vector<std::optional<std::string>> values(keys.size());
+    for (const size_t i : order) {
+        leveldb::Slice slKey(CharCast(keys[i].data()), keys[i].size());
+        std::string strValue;
+        const auto start{SteadyClock::now()};
+        leveldb::Status status = DBContext().pdb->Get(options, slKey, &strValue);
+        DBContext().stats.RecordLookup(DBLookup::READ, keys[i], status.ok(), strValue.size(), SteadyClock::now() - start);
+        if (!status.ok()) {
+            if (status.IsNotFound())
+                continue;
+            LogPrintf("LevelDB read failure: %s\n", status.ToString());
+            HandleError(status);
+        }
+        values[i] = std::move(strValue);
+    }
+    return values;
+}
+
 bool CDBWrapper::ExistsImpl(Span<const std::byte> key) const
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
 
     std::string strValue;
+    const auto start{SteadyClock::now()};
     leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
+    DBContext().stats.RecordLookup(DBLookup::EXISTS, key, status.ok(), strValue.size(), SteadyClock::now() - start);
     if (!status.ok()) {
         if (status.IsNotFound())
             return false;
@@ -401,7 +568,7 @@ struct CDBIterator::IteratorImpl {
 CDBIterator::CDBIterator(const CDBWrapper& _parent, std::unique_ptr<IteratorImpl> _piter) : parent(_parent),
                                                                                             m_impl_iter(std::move(_piter)) {}
 
-CDBIterator* CDBWrapper::NewIterator()
+CDBIterator* CDBWrapper::NewIterator() const
 {
     return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(DBContext().iteroptions))};
 }
@@ -409,7 +576,10 @@ CDBIterator* CDBWrapper::NewIterator()
 void CDBIterator::SeekImpl(Span<const std::byte> key)
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
+    const auto start{SteadyClock::now()};
     m_impl_iter->iter->Seek(slKey);
+    const bool found{m_impl_iter->iter->Valid()};
+    parent.DBContext().stats.RecordLookup(DBLookup::SEEK, key, found, found ? m_impl_iter->iter->value().size() : 0, SteadyClock::now() - start);
 }
 
 Span<const std::byte> CDBIterator::GetKeyImpl() const
@@ -23,8 +23,11 @@
 #include <util/check.h>
 #include <util/fs.h>
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <map>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -57,6 +60,51 @@ struct DBParams {
     DBOptions options{};
 };
 
+//! Number of buckets in the latency histograms kept by CDBWrapper. Bucket 0
+//! counts operations which took less than a microsecond, bucket i > 0 those
+//! which took [2^(i-1), 2^i) microseconds, and the last bucket also counts
+//! everything slower than that.
+static constexpr size_t DB_LATENCY_BUCKETS{24};
+
+//! Kinds of key lookup which CDBWrapper keeps statistics on, per leading key
+//! byte.
+enum class DBLookup : uint8_t {
+    READ,
+    EXISTS,
+    SEEK,
+};
+static constexpr size_t DB_LOOKUP_KINDS{3};
+
+//! Counters for one kind of database operation.
+struct DBOpStats {
+    //! Number of operations performed.
+    uint64_t count{0};
+    //! Number of lookups which found an entry. Unused for batch writes.
+    uint64_t found{0};
+    //! Bytes of values read, or estimated bytes of batches written.
+    uint64_t bytes{0};
+    //! Total time spent in the operations, in nanoseconds.
+    uint64_t time_ns{0};
+    //! Latency histogram, see DB_LATENCY_BUCKETS.
+    std::array<uint64_t, DB_LATENCY_BUCKETS> latency{};
+};
+
+//! A snapshot of the statistics kept by a CDBWrapper.
+struct DBStats {
+    //! Location of the database, as given in DBParams.
+    fs::path path;
+    bool memory_only{false};
+    //! Approximate memory usage of leveldb, see CDBWrapper::DynamicMemoryUsage.
+    size_t memory_usage{0};
+    //! Capacity and current charge of leveldb's block cache, in bytes.
+    size_t block_cache_size{0};
+    size_t block_cache_usage{0};
+    DBOpStats write_batch;
+    //! Lookup statistics indexed by DBLookup, per leading byte of the
+    //! serialized key. Only key bytes which have been looked up are present.
+    std::map<uint8_t, std::array<DBOpStats, DB_LOOKUP_KINDS>> lookups;
+};
+
 class dbwrapper_error : public std::runtime_error
 {
 public:
@@ -79,6 +127,9 @@ const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w);
 
 bool DestroyDB(const std::string& path_str);
 
+/** Return a snapshot of the statistics of every open CDBWrapper. */
+std::vector<DBStats> GetAllDBStats();
+
 /** Batch of changes queued to be written to a CDBWrapper */
 class CDBBatch
 {
@@ -202,6 +253,7 @@ struct LevelDBContext;
 
 class CDBWrapper
 {
+    friend class CDBIterator;
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
 private:
     //! holds all leveldb-specific fields of this class
@@ -228,6 +280,7 @@ private:
     bool m_is_memory;
 
     std::optional<std::string> ReadImpl(Span<const std::byte> key) const;
+    std::vector<std::optional<std::string>> ReadManyImpl(Span<const Span<const std::byte>> keys) const;
     bool ExistsImpl(Span<const std::byte> key) const;
     size_t EstimateSizeImpl(Span<const std::byte> key1, Span<const std::byte> key2) const;
     auto& DBContext() const LIFETIMEBOUND { return *Assert(m_db_context); }
@@ -259,6 +312,41 @@ public:
         return true;
     }
 
+    /**
+     * Read the values of several keys from a single snapshot of the database.
+     * The lookups are made in the order of the serialized keys, so that runs
+     * of nearby keys are served from the same table blocks instead of being
+     * scattered across the database.
+     *
+     * @returns for each key, the value read, or std::nullopt if the key was
+     *          not found or its value could not be deserialized.
+     */
+    template <typename V, typename K>
+    std::vector<std::optional<V>> ReadMany(Span<K> keys) const
+    {
+        std::vector<DataStream> ssKeys(keys.size());
+        std::vector<Span<const std::byte>> key_spans;
+        key_spans.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ssKeys[i].reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+            ssKeys[i] << keys[i];
+            key_spans.emplace_back(ssKeys[i]);
+        }
+        std::vector<std::optional<std::string>> strValues{ReadManyImpl(key_spans)};
+        std::vector<std::optional<V>> values(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!strValues[i]) continue;
+            try {
+                DataStream ssValue{MakeByteSpan(*strValues[i])};
+                ssValue.Xor(obfuscate_key);
+                ssValue >> values[i].emplace();
+            } catch (const std::exception&) {
+                values[i].reset();
+            }
+        }
+        return values;
+    }
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
@@ -297,7 +385,10 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
-    CDBIterator* NewIterator();
+    //! Get a snapshot of the operation counters and latency histograms.
+    DBStats GetStats() const;
+
+    CDBIterator* NewIterator() const;
 
     /**
      * Return true if the database managed by this class contains no entries.
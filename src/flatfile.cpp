@@ -21,6 +21,13 @@
 #include <tinyformat.h>
 #include <util/fs_helpers.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 FlatFileSeq::FlatFileSeq(fs::path dir, const char* prefix, size_t chunk_size) :
     m_dir(std::move(dir)),
     m_prefix(prefix),
@@ -31,6 +38,13 @@ FlatFileSeq::FlatFileSeq(fs::path dir, const char* prefix, size_t chunk_size) :
     }
 }
 
+MappedFlatFile::~MappedFlatFile()
+{
+#ifndef WIN32
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
 std::string FlatFilePos::ToString() const
 {
     return strprintf("FlatFilePos(nFile=%i, nPos=%i)", nFile, nPos);
@@ -63,6 +77,36 @@ FILE* FlatFileSeq::Open(const FlatFilePos& pos, bool read_only)
     return file;
 }
 
+std::shared_ptr<const MappedFlatFile> FlatFileSeq::Map(const FlatFilePos& pos) const
+{
+#ifdef WIN32
+    return nullptr;
+#else
+    // Block files could exhaust the address space of 32-bit systems.
+    if (sizeof(void*) < 8 || pos.IsNull()) {
+        return nullptr;
+    }
+    fs::path path = FileName(pos);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LogPrintf("Unable to open file %s\n", fs::PathToString(path));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        LogPrintf("Unable to map file %s\n", fs::PathToString(path));
+        return nullptr;
+    }
+    return std::make_shared<const MappedFlatFile>(static_cast<const uint8_t*>(addr), static_cast<size_t>(st.st_size));
+#endif
+}
+
 size_t FlatFileSeq::Allocate(const FlatFilePos& pos, size_t add_size, bool& out_of_space)
 {
     out_of_space = false;
@@ -17,9 +17,12 @@
 #ifndef FREICOIN_FLATFILE_H
 #define FREICOIN_FLATFILE_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include <serialize.h>
+#include <span.h>
 #include <util/fs.h>
 
 struct FlatFilePos
@@ -49,6 +52,28 @@ struct FlatFilePos
     std::string ToString() const;
 };
 
+/**
+ * A read-only memory mapping of a whole file in a FlatFileSeq.  Data is read
+ * straight out of the page cache, and spans into it remain valid for as long
+ * as the mapping lives, even if the file is deleted in the meantime.
+ */
+class MappedFlatFile
+{
+private:
+    const uint8_t* const m_data;
+    const size_t m_size;
+
+public:
+    MappedFlatFile(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+    ~MappedFlatFile();
+
+    MappedFlatFile(const MappedFlatFile&) = delete;
+    MappedFlatFile& operator=(const MappedFlatFile&) = delete;
+
+    Span<const uint8_t> data() const { return {m_data, m_size}; }
+    size_t size() const { return m_size; }
+};
+
 /**
  * FlatFileSeq represents a sequence of numbered files storing raw data. This class facilitates
  * access to and efficient management of these files.
@@ -76,6 +101,15 @@ public:
     /** Open a handle to the file at the given position. */
     FILE* Open(const FlatFilePos& pos, bool read_only = false);
 
+    /**
+     * Map the whole file at the given position into memory, read-only.  Data
+     * appended to the file afterwards is not covered by the mapping.
+     *
+     * @return The mapping, or nullptr if the file is empty or cannot be mapped,
+     *         including on platforms where mapping is not supported.
+     */
+    std::shared_ptr<const MappedFlatFile> Map(const FlatFilePos& pos) const;
+
     /**
      * Allocate additional space in a file after the given starting position. The amount allocated
      * will be the minimum multiple of the sequence chunk size greater than add_size.
@@ -666,13 +666,36 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
     assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, strReply.data(), strReply.size());
+    SendReply(nStatus);
+}
+
+void HTTPRequest::WriteReply(int nStatus, Span<const uint8_t> reply, std::shared_ptr<const void> owner)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    // The buffer refers to reply in place, holding a reference to its owner
+    // until libevent is done with it.
+    auto owner_ref = new std::shared_ptr<const void>(std::move(owner));
+    const auto release = [](const void*, size_t, void* extra) {
+        delete static_cast<std::shared_ptr<const void>*>(extra);
+    };
+    if (evbuffer_add_reference(evb, reply.data(), reply.size(), release, owner_ref) != 0) {
+        delete owner_ref;
+        evbuffer_add(evb, reply.data(), reply.size());
+    }
+    SendReply(nStatus);
+}
+
+void HTTPRequest::SendReply(int nStatus)
+{
     if (m_interrupt) {
         WriteHeader("Connection", "close");
     }
     // Send event to main http thread to send reply message
-    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
-    assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
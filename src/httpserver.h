@@ -16,11 +16,14 @@
 #ifndef FREICOIN_HTTPSERVER_H
 #define FREICOIN_HTTPSERVER_H
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 
 #include <netbase.h>
+#include <span.h>
 
 namespace util {
 class SignalInterrupt;
@@ -86,6 +89,9 @@ private:
     const util::SignalInterrupt& m_interrupt;
     bool replySent;
 
+    /** Hand the request back to the main thread to send the reply. */
+    void SendReply(int nStatus);
+
 public:
     explicit HTTPRequest(struct evhttp_request* req, const util::SignalInterrupt& interrupt, bool replySent = false);
     ~HTTPRequest();
@@ -151,6 +157,12 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+    /**
+     * Write HTTP reply, with a body that is sent without being copied.
+     * reply must stay valid for as long as owner is alive, which will be until
+     * the reply has been sent.
+     */
+    void WriteReply(int nStatus, Span<const uint8_t> reply, std::shared_ptr<const void> owner);
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -20,6 +20,7 @@
 #include <kernel/chain.h>
 #include <logging.h>
 #include <node/abort.h>
+#include <node/blockprefetch.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/database_args.h>
@@ -30,6 +31,7 @@
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -38,10 +40,15 @@ constexpr uint8_t DB_BEST_BLOCK{'B'};
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
 
-template <typename... Args>
-void BaseIndex::FatalErrorf(const char* fmt, const Args&... args)
+void BaseIndex::FatalError(const std::string& message)
 {
-    auto message = tfm::format(fmt, args...);
+    // Only the first error is reported as the reason for shutting down, as
+    // any later ones, such as a sync thread failing to append a block after a
+    // subclass reported why, follow from it.
+    if (m_fatal_error.exchange(true)) {
+        LogPrintf("%s\n", message);
+        return;
+    }
     node::AbortNode(m_chain->context()->shutdown, m_chain->context()->exit_status, message);
 }
 
@@ -136,6 +143,89 @@ bool BaseIndex::Init()
     return true;
 }
 
+IndexSyncCoordinator::IndexSyncCoordinator(const node::BlockManager& blockman, bool read_undo, int window)
+    : m_blockman{blockman}, m_read_undo{read_undo}, m_window{window}
+{
+}
+
+IndexSyncCoordinator::~IndexSyncCoordinator() = default;
+
+void IndexSyncCoordinator::Register(const BaseIndex& index, int height)
+{
+    auto prefetcher{std::make_unique<node::BlockPrefetcher>(m_blockman, m_read_undo)};
+    {
+        LOCK(m_mutex);
+        m_readers[&index] = Reader{height, std::move(prefetcher)};
+    }
+    m_cv.notify_all();
+}
+
+void IndexSyncCoordinator::Unregister(const BaseIndex& index)
+{
+    std::unique_ptr<node::BlockPrefetcher> prefetcher;
+    {
+        LOCK(m_mutex);
+        const auto it{m_readers.find(&index)};
+        if (it == m_readers.end()) return;
+        prefetcher = std::move(it->second.prefetcher);
+        m_readers.erase(it);
+    }
+    m_cv.notify_all();
+}
+
+node::BlockPrefetcher::Result IndexSyncCoordinator::Take(const BaseIndex& index, const CBlockIndex& block, const CBlockIndex& target,
+                                                         const CThreadInterrupt& interrupt)
+{
+    node::BlockPrefetcher::Result result;
+    WAIT_LOCK(m_mutex, lock);
+    Reader& reader{m_readers.at(&index)};
+    while (true) {
+        if (interrupt) return {};
+
+        // Wait for an index which this one is in lockstep with, being within
+        // the window ahead of it, if this block would take it further ahead.
+        const bool too_far_ahead{std::any_of(m_readers.begin(), m_readers.end(), [&](const auto& other) {
+            const int height{other.second.height};
+            return height >= reader.height - m_window && height < block.nHeight - m_window;
+        })};
+        const auto it{m_blocks.find(&block)};
+        if (too_far_ahead || (it == m_blocks.end() && m_reading.count(&block))) {
+            m_cv.wait_for(lock, 100ms);
+            continue;
+        }
+        if (it != m_blocks.end()) {
+            result = it->second;
+            break;
+        }
+
+        // Nobody has read this block yet, so read it here, reading the blocks
+        // after it ahead for this index.
+        m_reading.insert(&block);
+        node::BlockPrefetcher& prefetcher{*reader.prefetcher};
+        {
+            REVERSE_LOCK(lock);
+            WITH_LOCK(::cs_main, prefetcher.ReadAhead(block.pprev, target));
+            result = prefetcher.Take(block);
+        }
+        m_reading.erase(&block);
+        if (result.block) m_blocks.emplace(&block, result);
+        break;
+    }
+
+    // Drop the blocks which no index within the window behind them has yet
+    // to get to.
+    reader.height = block.nHeight;
+    std::erase_if(m_blocks, [&](const auto& entry) {
+        const int block_height{entry.first->nHeight};
+        return std::none_of(m_readers.begin(), m_readers.end(), [&](const auto& other) {
+            const int height{other.second.height};
+            return height < block_height && height >= block_height - m_window - 1;
+        });
+    });
+    m_cv.notify_all();
+    return result;
+}
+
 static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     AssertLockHeld(cs_main);
@@ -156,6 +246,8 @@ void BaseIndex::ThreadSync()
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
+        IndexSyncCoordinator& coordinator{*Assert(m_sync_coordinator)};
+        const CBlockIndex* target;
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
         while (true) {
@@ -186,6 +278,7 @@ void BaseIndex::ThreadSync()
                     return;
                 }
                 pindex = pindex_next;
+                target = m_chainstate->m_chain.Tip();
             }
 
             auto current_time{std::chrono::steady_clock::now()};
@@ -202,14 +295,20 @@ void BaseIndex::ThreadSync()
                 Commit();
             }
 
-            CBlock block;
+            const auto [block, block_undo]{coordinator.Take(*this, *pindex, *target, m_interrupt)};
+            if (!block && m_interrupt) {
+                // Interrupted while waiting for other indexes to catch up.
+                pindex = pindex->pprev;
+                continue;
+            }
             interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            if (!block) {
                 FatalErrorf("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             } else {
-                block_info.data = &block;
+                block_info.data = block.get();
+                block_info.undo_data = block_undo.get();
             }
             if (!CustomAppend(block_info)) {
                 FatalErrorf("%s: Failed to write block %s to index database",
@@ -402,9 +501,36 @@ void BaseIndex::Interrupt()
 
 bool BaseIndex::StartBackgroundSync()
 {
-    if (!m_init) throw std::logic_error("Error: Cannot start a non-initialized index");
+    return StartBackgroundSync(std::vector<BaseIndex*>{this});
+}
+
+bool BaseIndex::StartBackgroundSync(const std::vector<BaseIndex*>& indexes)
+{
+    if (indexes.empty()) return true;
+    for (const BaseIndex* index : indexes) {
+        if (!index->m_init) throw std::logic_error("Error: Cannot start a non-initialized index");
+    }
 
-    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] { ThreadSync(); });
+    // Indexes which are already in sync only need to be started, but the
+    // others share one coordinator, registered with all of them before any
+    // start so that none runs ahead of the rest.
+    const bool read_undo{std::any_of(indexes.begin(), indexes.end(), [](const BaseIndex* index) { return !index->m_synced && index->AppendsUndoData(); })};
+    const auto coordinator{std::make_shared<IndexSyncCoordinator>(indexes.front()->m_chainstate->m_blockman, read_undo)};
+    for (BaseIndex* index : indexes) {
+        if (index->m_synced) continue;
+        const CBlockIndex* best_block{index->m_best_block_index.load()};
+        coordinator->Register(*index, best_block ? best_block->nHeight : -1);
+        index->m_sync_coordinator = coordinator;
+    }
+    for (BaseIndex* index : indexes) {
+        index->m_thread_sync = std::thread(&util::TraceThread, index->GetName(), [index] {
+            index->ThreadSync();
+            if (index->m_sync_coordinator) {
+                index->m_sync_coordinator->Unregister(*index);
+                index->m_sync_coordinator.reset();
+            }
+        });
+    }
     return true;
 }
 
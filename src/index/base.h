@@ -18,11 +18,20 @@
 
 #include <dbwrapper.h>
 #include <interfaces/chain.h>
+#include <node/blockprefetch.h>
+#include <sync.h>
+#include <tinyformat.h>
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
+class BaseIndex;
 class CBlock;
 class CBlockIndex;
 class Chainstate;
@@ -30,6 +39,9 @@ class ChainstateManager;
 namespace interfaces {
 class Chain;
 } // namespace interfaces
+namespace node {
+class BlockManager;
+} // namespace node
 
 struct IndexSummary {
     std::string name;
@@ -38,6 +50,59 @@ struct IndexSummary {
     uint256 best_block_hash;
 };
 
+/**
+ * Hands out blocks to indexes which are syncing at the same time, so that an
+ * index which is near another reuses the blocks, and undo data, it has read
+ * rather than reading them again.  The indexes process the blocks
+ * concurrently, each on its own sync thread, and each reads the blocks it is
+ * the first to get to with its own read-ahead.  Indexes within a window of
+ * blocks of each other are kept in lockstep: one which would get more than
+ * the window ahead of another waits for it, so that the blocks it has read are
+ * still held when the other gets to them.  An index further behind than that,
+ * such as one syncing from genesis while another is near the tip, is not
+ * waited for, until it catches up.
+ */
+class IndexSyncCoordinator
+{
+public:
+    IndexSyncCoordinator(const node::BlockManager& blockman, bool read_undo,
+                         int window = node::DEFAULT_BLOCK_PREFETCH_DEPTH);
+    ~IndexSyncCoordinator();
+
+    /// Add an index, which has processed the blocks up to the given height.
+    void Register(const BaseIndex& index, int height) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// Remove an index, which the others then no longer wait for.
+    void Unregister(const BaseIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Get the next block for an index to process, on the way to target.
+    /// Returns a null block if the block could not be read, or if the index
+    /// was interrupted while waiting for the others.
+    node::BlockPrefetcher::Result Take(const BaseIndex& index, const CBlockIndex& block, const CBlockIndex& target,
+                                       const CThreadInterrupt& interrupt)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex, !::cs_main);
+
+private:
+    struct Reader {
+        //! The height of the last block processed by the index.
+        int height;
+        //! Reads blocks ahead of the index, when it is the first to get to
+        //! them.  Only used from the index's own sync thread.
+        std::unique_ptr<node::BlockPrefetcher> prefetcher;
+    };
+
+    const node::BlockManager& m_blockman;
+    const bool m_read_undo;
+    const int m_window;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<const BaseIndex*, Reader> m_readers GUARDED_BY(m_mutex);
+    //! Blocks which have been read and which an index within the window
+    //! behind them has yet to get to.
+    std::map<const CBlockIndex*, node::BlockPrefetcher::Result> m_blocks GUARDED_BY(m_mutex);
+    //! Blocks which are being read.
+    std::set<const CBlockIndex*> m_reading GUARDED_BY(m_mutex);
+};
+
 /**
  * Base class for indices of blockchain data. This implements
  * CValidationInterface and ensures blocks are indexed sequentially according
@@ -86,8 +151,14 @@ private:
     /// The last block in the chain that the index is in sync with.
     std::atomic<const CBlockIndex*> m_best_block_index{nullptr};
 
+    /// Whether a fatal error has been reported for the index.
+    std::atomic<bool> m_fatal_error{false};
+
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
+    /// Where the sync thread gets blocks from, which may be shared with other
+    /// indexes syncing at the same time.
+    std::shared_ptr<IndexSyncCoordinator> m_sync_coordinator;
 
     /// Sync the index with the block index starting from the current best block.
     /// Intended to be run in its own thread, m_thread_sync, and can be
@@ -111,10 +182,16 @@ private:
 
     virtual bool AllowPrune() const = 0;
 
-    template <typename... Args>
-    void FatalErrorf(const char* fmt, const Args&... args);
+    /// Whether CustomAppend uses the block's undo data, which is then read
+    /// ahead along with the block while syncing.
+    virtual bool AppendsUndoData() const { return false; }
 
 protected:
+    /// Shut down the node because of an error in the index.
+    void FatalError(const std::string& message);
+    template <typename... Args>
+    void FatalErrorf(const char* fmt, const Args&... args) { FatalError(tfm::format(fmt, args...)); }
+
     std::unique_ptr<interfaces::Chain> m_chain;
     Chainstate* m_chainstate{nullptr};
     const std::string m_name;
@@ -139,6 +216,10 @@ protected:
 
     virtual DB& GetDB() const = 0;
 
+    /// Whether the index is in sync, so that blocks are appended as they are
+    /// connected rather than by the sync thread.
+    bool IsSynced() const { return m_synced; }
+
     /// Update the internal best block index as well as the prune lock.
     void SetBestBlockIndex(const CBlockIndex* block);
 
@@ -166,6 +247,10 @@ public:
     /// Starts the initial sync process.
     [[nodiscard]] bool StartBackgroundSync();
 
+    /// Starts the initial sync process of several indexes together, reading
+    /// each block once for all of them.
+    [[nodiscard]] static bool StartBackgroundSync(const std::vector<BaseIndex*>& indexes);
+
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
 
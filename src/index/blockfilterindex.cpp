@@ -13,17 +13,26 @@
 // You should have received a copy of the GNU Affero General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <optional>
+#include <thread>
 
 #include <clientversion.h>
 #include <common/args.h>
+#include <common/system.h>
 #include <dbwrapper.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <logging.h>
 #include <node/blockstorage.h>
+#include <sync.h>
+#include <tinyformat.h>
 #include <undo.h>
 #include <util/fs_helpers.h>
+#include <util/threadnames.h>
 #include <validation.h>
 
 /* The index database stores three items for each block: the disk location of the encoded filter,
@@ -108,6 +117,111 @@ struct DBHashKey {
 
 static std::map<BlockFilterType, BlockFilterIndex> g_filter_indexes;
 
+/** The number of blocks whose filters may be built ahead of being written while syncing. */
+static constexpr size_t FILTER_BUILD_WINDOW{64};
+/** The most threads building filters while syncing. */
+static constexpr int MAX_FILTER_BUILD_THREADS{4};
+
+class BlockFilterIndex::FilterBuilder
+{
+public:
+    //! A block's filter, built or to be built from the block's elements.
+    struct Job {
+        int height;
+        uint256 block_hash;
+        uint256 prev_hash;
+        GCSFilter::ElementSet elements;
+        std::optional<BlockFilter> filter;
+        bool started{false};
+    };
+
+    FilterBuilder(BlockFilterType filter_type, int threads) : m_filter_type{filter_type}
+    {
+        m_threads.reserve(threads);
+        for (int n = 0; n < threads; ++n) {
+            m_threads.emplace_back([this, n]() {
+                util::ThreadRename(strprintf("fltrbuild.%i", n));
+                Loop();
+            });
+        }
+    }
+
+    ~FilterBuilder()
+    {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_work_cv.notify_all();
+        for (std::thread& t : m_threads) {
+            t.join();
+        }
+    }
+
+    FilterBuilder(const FilterBuilder&) = delete;
+    FilterBuilder& operator=(const FilterBuilder&) = delete;
+
+    void Add(const interfaces::BlockInfo& block, GCSFilter::ElementSet elements) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        auto job{std::make_shared<Job>()};
+        job->height = block.height;
+        job->block_hash = block.hash;
+        if (block.prev_hash) job->prev_hash = *block.prev_hash;
+        job->elements = std::move(elements);
+        WITH_LOCK(m_mutex, m_jobs.push_back(std::move(job)));
+        m_work_cv.notify_one();
+    }
+
+    /**
+     * Take the oldest job if its filter has been built, or, if there are more
+     * than keep jobs, once it has been.  Returns null otherwise.
+     */
+    std::shared_ptr<Job> TakeFront(size_t keep) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        if (m_jobs.empty()) return nullptr;
+        if (!m_jobs.front()->filter) {
+            if (m_jobs.size() <= keep) return nullptr;
+            m_done_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_jobs.front()->filter.has_value(); });
+        }
+        auto job{std::move(m_jobs.front())};
+        m_jobs.pop_front();
+        return job;
+    }
+
+private:
+    const BlockFilterType m_filter_type;
+
+    Mutex m_mutex;
+    //! Signalled when a job is added, or on shutdown.
+    std::condition_variable m_work_cv;
+    //! Signalled when a filter has been built.
+    std::condition_variable m_done_cv;
+    //! Jobs not yet taken, in chain order.
+    std::deque<std::shared_ptr<Job>> m_jobs GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_work_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                    if (m_stop) return true;
+                    const auto it{std::find_if(m_jobs.begin(), m_jobs.end(), [](const auto& j) { return !j->started; })};
+                    if (it == m_jobs.end()) return false;
+                    job = *it;
+                    return true;
+                });
+                if (m_stop) return;
+                job->started = true;
+            }
+            BlockFilter filter(m_filter_type, job->block_hash, job->elements);
+            WITH_LOCK(m_mutex, job->filter = std::move(filter); job->elements.clear());
+            m_done_cv.notify_all();
+        }
+    }
+};
+
 BlockFilterIndex::BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, BlockFilterType filter_type,
                                    size_t n_cache_size, bool f_memory, bool f_wipe)
     : BaseIndex(std::move(chain), BlockFilterTypeName(filter_type) + " block filter index")
@@ -123,6 +237,8 @@ BlockFilterIndex::BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, Blo
     m_filter_fileseq = std::make_unique<FlatFileSeq>(std::move(path), "fltr", FLTR_FILE_CHUNK_SIZE);
 }
 
+BlockFilterIndex::~BlockFilterIndex() = default;
+
 bool BlockFilterIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
 {
     if (!m_db->Read(DB_FILTER_POS, m_next_filter_pos)) {
@@ -143,6 +259,10 @@ bool BlockFilterIndex::CustomInit(const std::optional<interfaces::BlockKey>& blo
 
 bool BlockFilterIndex::CustomCommit(CDBBatch& batch)
 {
+    // Write out the filters for all the blocks appended so far before
+    // committing to them.
+    if (!WriteBuiltFilters(0)) return false;
+
     const FlatFilePos& pos = m_next_filter_pos;
 
     // Flush current filter file to disk.
@@ -229,42 +349,80 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
     CBlockUndo block_undo;
-    uint256 prev_header;
+    const CBlockUndo* undo_data{&block_undo};
 
-    if (block.height > 0) {
+    if (block.undo_data) {
+        undo_data = block.undo_data;
+    } else if (block.height > 0) {
         // pindex variable gives indexing code access to node internals. It
         // will be removed in upcoming commit
         const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
         if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
             return false;
         }
+    }
+
+    const uint256 prev_hash{block.prev_hash ? *block.prev_hash : uint256{}};
+    if (IsSynced()) {
+        // Anything built while syncing was written out on the last commit.
+        m_builder.reset();
+        return WriteFilter(block.height, prev_hash, BlockFilter(m_filter_type, *Assert(block.data), *undo_data));
+    }
+
+    // While syncing, the filters for several blocks are built at once on
+    // other threads, and written out as they are finished, in order.
+    if (!m_builder) {
+        m_builder = std::make_unique<FilterBuilder>(m_filter_type, std::clamp(GetNumCores() - 1, 1, MAX_FILTER_BUILD_THREADS));
+    }
+    m_builder->Add(block, BlockFilterElements(m_filter_type, *Assert(block.data), *undo_data));
+    return WriteBuiltFilters(FILTER_BUILD_WINDOW);
+}
+
+bool BlockFilterIndex::WriteBuiltFilters(size_t keep)
+{
+    if (!m_builder) return true;
+    while (const auto job{m_builder->TakeFront(keep)}) {
+        // The filter is written out after the index has moved on, possibly
+        // past its block in a commit, so a failure is fatal here, and put
+        // down to the block it was for rather than the one being processed.
+        if (!WriteFilter(job->height, job->prev_hash, *job->filter)) {
+            FatalErrorf("%s: Failed to write filter for block %s at height %d to index database",
+                        __func__, job->block_hash.ToString(), job->height);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BlockFilterIndex::WriteFilter(int height, const uint256& prev_hash, const BlockFilter& filter)
+{
+    uint256 prev_header;
+
+    if (height > 0) {
 
         std::pair<uint256, DBVal> read_out;
-        if (!m_db->Read(DBHeightKey(block.height - 1), read_out)) {
+        if (!m_db->Read(DBHeightKey(height - 1), read_out)) {
             return false;
         }
 
-        uint256 expected_block_hash = *Assert(block.prev_hash);
-        if (read_out.first != expected_block_hash) {
+        if (read_out.first != prev_hash) {
             return error("%s: previous block header belongs to unexpected block %s; expected %s",
-                         __func__, read_out.first.ToString(), expected_block_hash.ToString());
+                         __func__, read_out.first.ToString(), prev_hash.ToString());
         }
 
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
-
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
 
     std::pair<uint256, DBVal> value;
-    value.first = block.hash;
+    value.first = filter.GetBlockHash();
     value.second.hash = filter.GetHash();
     value.second.header = filter.ComputeHeader(prev_header);
     value.second.pos = m_next_filter_pos;
 
-    if (!m_db->Write(DBHeightKey(block.height), value)) {
+    if (!m_db->Write(DBHeightKey(height), value)) {
         return false;
     }
 
@@ -300,6 +458,8 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 
 bool BlockFilterIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
 {
+    if (!WriteBuiltFilters(0)) return false;
+
     CDBBatch batch(*m_db);
     std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
 
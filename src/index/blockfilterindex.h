@@ -23,6 +23,7 @@
 #include <index/base.h>
 #include <util/hasher.h>
 
+#include <memory>
 #include <unordered_map>
 
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
@@ -49,12 +50,27 @@ private:
     bool ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const;
     size_t WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter);
 
+    /** Write a block's filter and its header, which follows on from the one at the height before. */
+    bool WriteFilter(int height, const uint256& prev_hash, const BlockFilter& filter);
+
+    /** Builds filters ahead on other threads while the index is syncing. */
+    class FilterBuilder;
+    std::unique_ptr<FilterBuilder> m_builder;
+
+    /**
+     * Write out the filters which have been built, in order, waiting for them
+     * to be built until no more than keep are left to write.
+     */
+    bool WriteBuiltFilters(size_t keep);
+
     Mutex m_cs_headers_cache;
     /** cache of block hash to filter header, to avoid disk access when responding to getcfcheckpt. */
     std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
 
     bool AllowPrune() const override { return true; }
 
+    bool AppendsUndoData() const override { return true; }
+
 protected:
     bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
 
@@ -70,6 +86,7 @@ public:
     /** Constructs the index, which becomes available to be queried. */
     explicit BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, BlockFilterType filter_type,
                               size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    ~BlockFilterIndex() override;
 
     BlockFilterType GetFilterType() const { return m_filter_type; }
 
@@ -55,6 +55,8 @@ private:
 
     bool AllowPrune() const override { return true; }
 
+    bool AppendsUndoData() const override { return true; }
+
 protected:
     bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
 
@@ -17,44 +17,290 @@
 
 #include <clientversion.h>
 #include <common/args.h>
+#include <compat/endian.h>
+#include <crypto/siphash.h>
 #include <index/disktxpos.h>
 #include <logging.h>
 #include <node/blockstorage.h>
+#include <random.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <tuple>
+
+/* Indexes built before the compact format store the disk location of each
+ * transaction under [DB_TXINDEX, txid].
+ *
+ * The compact format records the place of each transaction, by height and
+ * position in the block, as an empty record under [DB_TXINDEX_TX, short id,
+ * height, position], where the short id is a SipHash of the txid salted with
+ * the keys stored under DB_TXINDEX_FORMAT.  Appending a block's transactions
+ * is then a write of new keys, with no read, and the places of the
+ * transactions with a short id, usually one, are found by seeking to its
+ * first key.  Under [DB_TXINDEX_BLOCK, height]
+ * it stores the disk location of the block at that height on the chain the
+ * index is in sync with, along with the sizes of its transactions, from which
+ * their offsets follow.  When blocks are disconnected these records are moved
+ * under [DB_TXINDEX_STALE_BLOCK, height, block hash] so that the transactions
+ * in them can still be found.
+ *
+ * Short ids, heights and positions are big-endian so that records for nearby
+ * heights, and lookups done in short id order, are near each other in the
+ * database, and the keys for a short id sort together.
+ */
 constexpr uint8_t DB_TXINDEX{'t'};
+constexpr uint8_t DB_TXINDEX_FORMAT{'F'};
+constexpr uint8_t DB_TXINDEX_TX{'s'};
+constexpr uint8_t DB_TXINDEX_BLOCK{'b'};
+constexpr uint8_t DB_TXINDEX_STALE_BLOCK{'o'};
 
 std::unique_ptr<TxIndex> g_txindex;
 
+namespace {
+
+struct DBFormat {
+    uint64_t k0;
+    uint64_t k1;
+
+    SERIALIZE_METHODS(DBFormat, obj) { READWRITE(obj.k0, obj.k1); }
+};
+
+struct DBTxKey {
+    uint8_t prefix{DB_TXINDEX_TX};
+    uint64_t short_id{0};
+    int height{0};
+    uint32_t index{0};
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        const uint64_t be{htobe64_internal(short_id)};
+        s.write(AsBytes(Span{&be, 1}));
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, index);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = ser_readdata8(s);
+        uint64_t be;
+        s.read(AsWritableBytes(Span{&be, 1}));
+        short_id = be64toh_internal(be);
+        height = ser_readdata32be(s);
+        index = ser_readdata32be(s);
+    }
+};
+
+struct DBBlockKey {
+    uint8_t prefix;
+    int height;
+    //! Only for stale blocks.
+    uint256 hash;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        ser_writedata32be(s, height);
+        if (prefix == DB_TXINDEX_STALE_BLOCK) s << hash;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = ser_readdata8(s);
+        height = ser_readdata32be(s);
+        if (prefix == DB_TXINDEX_STALE_BLOCK) s >> hash;
+    }
+};
+
+struct DBBlockTxs {
+    uint256 hash;
+    FlatFilePos pos;
+    std::vector<uint32_t> tx_sizes;
+
+    SERIALIZE_METHODS(DBBlockTxs, obj) { READWRITE(obj.hash, obj.pos, Using<VectorFormatter<VarIntFormatter<VarIntMode::DEFAULT>>>(obj.tx_sizes)); }
+
+    //! The disk location of the transaction at the given position in the block.
+    CDiskTxPos TxPos(uint32_t index) const
+    {
+        const uint32_t offset{std::accumulate(tx_sizes.begin(), tx_sizes.begin() + index, uint32_t(GetSizeOfCompactSize(tx_sizes.size())))};
+        return CDiskTxPos(pos, offset);
+    }
+};
+
+} // namespace
 
 /** Access to the txindex database (indexes/txindex/) */
 class TxIndex::DB : public BaseIndex::DB
 {
+private:
+    //! The short id salt, if the index is in the compact format.  Fixed when
+    //! the database is opened, so it can be read without locking while the
+    //! index is being (re)initialized.
+    const std::optional<DBFormat> m_format;
+
+    /// Find out which format the index is in, setting up the compact format
+    /// for a new index.
+    std::optional<DBFormat> LoadFormat();
+
+    uint64_t ShortId(const uint256& txid) const { return SipHashUint256(m_format->k0, m_format->k1, txid); }
+
 public:
     explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
 
-    /// Read the disk location of the transaction data with the given hash. Returns false if the
-    /// transaction hash is not indexed.
-    bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
+    bool IsCompact() const { return m_format.has_value(); }
 
-    /// Write a batch of transaction positions to the DB.
-    [[nodiscard]] bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
+    /// Read the disk locations the transactions with the given hashes may be
+    /// at, in blocks on the indexed chain, or, if stale is set, in blocks
+    /// which have been disconnected from it.  If matched is given, it is set
+    /// for each transaction the index has a place for, whether or not that
+    /// place is in a block on the indexed chain.
+    void ReadTxPos(Span<const uint256> txids, std::vector<std::vector<CDiskTxPos>>& positions, bool stale,
+                   std::vector<bool>* matched = nullptr) const;
+
+    /// Write the positions of a block's transactions to the DB.
+    [[nodiscard]] bool WriteBlockTxs(const interfaces::BlockInfo& block);
+
+    /// Move the records for the blocks above new_height up to current_height
+    /// aside, as their transactions are no longer on the indexed chain.
+    [[nodiscard]] bool MoveStaleBlocks(int current_height, int new_height);
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
-    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe),
+    m_format{LoadFormat()}
 {}
 
-bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
+std::optional<DBFormat> TxIndex::DB::LoadFormat()
 {
-    return Read(std::make_pair(DB_TXINDEX, txid), pos);
+    DBFormat format;
+    if (Read(DB_TXINDEX_FORMAT, format)) return format;
+
+    // An index which has not recorded a best block has nothing in it yet.
+    CBlockLocator locator;
+    if (!ReadBestBlock(locator) || locator.IsNull()) {
+        format.k0 = GetRand<uint64_t>();
+        format.k1 = GetRand<uint64_t>();
+        Write(DB_TXINDEX_FORMAT, format, /*fSync=*/true);
+        return format;
+    }
+
+    LogPrintf("txindex is in the legacy format; remove %s and restart to rebuild it in the compact format\n",
+              fs::PathToString(gArgs.GetDataDirNet() / "indexes" / "txindex"));
+    return std::nullopt;
 }
 
-bool TxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos)
+void TxIndex::DB::ReadTxPos(Span<const uint256> txids, std::vector<std::vector<CDiskTxPos>>& positions, bool stale,
+                            std::vector<bool>* matched) const
 {
+    positions.assign(txids.size(), {});
+    if (matched) matched->assign(txids.size(), false);
+
+    if (!m_format) {
+        if (stale) return;
+        std::vector<size_t> order(txids.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return txids[a] < txids[b]; });
+        for (size_t i : order) {
+            CDiskTxPos pos;
+            if (Read(std::make_pair(DB_TXINDEX, txids[i]), pos)) positions[i].push_back(pos);
+        }
+        if (matched) {
+            for (size_t i = 0; i < txids.size(); ++i) (*matched)[i] = !positions[i].empty();
+        }
+        return;
+    }
+
+    // Look the transactions up in short id order, then each block they are
+    // in once.
+    std::vector<std::pair<uint64_t, size_t>> short_ids;
+    short_ids.reserve(txids.size());
+    for (size_t i = 0; i < txids.size(); ++i) {
+        short_ids.emplace_back(ShortId(txids[i]), i);
+    }
+    std::sort(short_ids.begin(), short_ids.end());
+
+    std::vector<std::vector<std::pair<int, uint32_t>>> locs(txids.size());
+    std::map<int, std::vector<DBBlockTxs>> blocks;
+    std::unique_ptr<CDBIterator> tx_it{NewIterator()};
+    for (const auto& [short_id, i] : short_ids) {
+        for (tx_it->Seek(DBTxKey{.short_id = short_id}); tx_it->Valid(); tx_it->Next()) {
+            DBTxKey key;
+            if (!tx_it->GetKey(key) || key.prefix != DB_TXINDEX_TX || key.short_id != short_id) break;
+            locs[i].emplace_back(key.height, key.index);
+            blocks.try_emplace(key.height);
+        }
+        if (matched) (*matched)[i] = !locs[i].empty();
+    }
+    for (auto& [height, height_blocks] : blocks) {
+        if (!stale) {
+            DBBlockTxs block_txs;
+            if (Read(DBBlockKey{DB_TXINDEX_BLOCK, height, {}}, block_txs)) height_blocks.push_back(std::move(block_txs));
+            continue;
+        }
+        std::unique_ptr<CDBIterator> it{NewIterator()};
+        for (it->Seek(DBBlockKey{DB_TXINDEX_STALE_BLOCK, height, {}}); it->Valid(); it->Next()) {
+            DBBlockKey key;
+            DBBlockTxs block_txs;
+            if (!it->GetKey(key) || key.prefix != DB_TXINDEX_STALE_BLOCK || key.height != height) break;
+            if (it->GetValue(block_txs)) height_blocks.push_back(std::move(block_txs));
+        }
+    }
+
+    for (size_t i = 0; i < txids.size(); ++i) {
+        for (const auto& [height, index] : locs[i]) {
+            for (const DBBlockTxs& block_txs : blocks[height]) {
+                if (index < block_txs.tx_sizes.size()) positions[i].push_back(block_txs.TxPos(index));
+            }
+        }
+    }
+}
+
+bool TxIndex::DB::WriteBlockTxs(const interfaces::BlockInfo& block)
+{
+    assert(block.data);
     CDBBatch batch(*this);
-    for (const auto& tuple : v_pos) {
-        batch.Write(std::make_pair(DB_TXINDEX, tuple.first), tuple.second);
+
+    if (!m_format) {
+        CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
+        for (const auto& tx : block.data->vtx) {
+            batch.Write(std::make_pair(DB_TXINDEX, tx->GetHash()), pos);
+            pos.nTxOffset += ::GetSerializeSize(TX_WITH_WITNESS(*tx));
+        }
+        return WriteBatch(batch);
+    }
+
+    DBBlockTxs block_txs;
+    block_txs.hash = block.hash;
+    block_txs.pos = FlatFilePos(block.file_number, block.data_pos);
+    block_txs.tx_sizes.reserve(block.data->vtx.size());
+
+    for (uint32_t index = 0; index < block.data->vtx.size(); ++index) {
+        const CTransaction& tx{*block.data->vtx[index]};
+        block_txs.tx_sizes.push_back(::GetSerializeSize(TX_WITH_WITNESS(tx)));
+        batch.Write(DBTxKey{.short_id = ShortId(tx.GetHash()), .height = block.height, .index = index}, uint8_t{0});
+    }
+    batch.Write(DBBlockKey{DB_TXINDEX_BLOCK, block.height, {}}, block_txs);
+    return WriteBatch(batch);
+}
+
+bool TxIndex::DB::MoveStaleBlocks(int current_height, int new_height)
+{
+    if (!m_format) return true;
+
+    CDBBatch batch(*this);
+    for (int height = new_height + 1; height <= current_height; ++height) {
+        const DBBlockKey key{DB_TXINDEX_BLOCK, height, {}};
+        DBBlockTxs block_txs;
+        if (!Read(key, block_txs)) continue;
+        batch.Write(DBBlockKey{DB_TXINDEX_STALE_BLOCK, height, block_txs.hash}, block_txs);
+        batch.Erase(key);
     }
     return WriteBatch(batch);
 }
@@ -70,43 +316,121 @@ bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
     // Exclude genesis block transaction because outputs are not spendable.
     if (block.height == 0) return true;
 
-    assert(block.data);
-    CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
-    vPos.reserve(block.data->vtx.size());
-    for (const auto& tx : block.data->vtx) {
-        vPos.emplace_back(tx->GetHash(), pos);
-        pos.nTxOffset += ::GetSerializeSize(TX_WITH_WITNESS(*tx));
-    }
-    return m_db->WriteTxs(vPos);
+    return m_db->WriteBlockTxs(block);
+}
+
+bool TxIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    return m_db->MoveStaleBlocks(current_tip.height, new_tip.height);
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
-    CDiskTxPos postx;
-    if (!m_db->ReadTxPos(tx_hash, postx)) {
-        return false;
+    std::vector<uint256> block_hashes;
+    std::vector<CTransactionRef> txs;
+    FindTxs({&tx_hash, 1}, block_hashes, txs);
+    if (!txs[0]) return false;
+    block_hash = block_hashes[0];
+    tx = std::move(txs[0]);
+    return true;
+}
+
+void TxIndex::FindTxs(Span<const uint256> tx_hashes, std::vector<uint256>& block_hashes, std::vector<CTransactionRef>& txs) const
+{
+    block_hashes.assign(tx_hashes.size(), uint256{});
+    txs.assign(tx_hashes.size(), nullptr);
+
+    std::vector<std::vector<CDiskTxPos>> positions;
+    std::vector<bool> matched;
+    m_db->ReadTxPos(tx_hashes, positions, /*stale=*/false, &matched);
+    ReadTxsFromDisk(tx_hashes, positions, block_hashes, txs);
+    if (!m_db->IsCompact()) return;
+
+    // Transactions which the index has a place for but which were not found
+    // on the indexed chain may be in blocks which have since been
+    // disconnected from it, whether the chain is now shorter than the place's
+    // height, or the block which replaced it has fewer transactions, or a
+    // different one at that position.
+    std::vector<size_t> missing;
+    std::vector<uint256> missing_hashes;
+    for (size_t i = 0; i < tx_hashes.size(); ++i) {
+        if (txs[i] || !matched[i]) continue;
+        missing.push_back(i);
+        missing_hashes.push_back(tx_hashes[i]);
+    }
+    if (missing.empty()) return;
+    std::vector<uint256> missing_block_hashes;
+    std::vector<CTransactionRef> missing_txs;
+    m_db->ReadTxPos(missing_hashes, positions, /*stale=*/true);
+    ReadTxsFromDisk(missing_hashes, positions, missing_block_hashes, missing_txs);
+    for (size_t j = 0; j < missing.size(); ++j) {
+        block_hashes[missing[j]] = missing_block_hashes[j];
+        txs[missing[j]] = std::move(missing_txs[j]);
     }
+}
+
+void TxIndex::ReadTxsFromDisk(Span<const uint256> tx_hashes, const std::vector<std::vector<CDiskTxPos>>& positions,
+                              std::vector<uint256>& block_hashes, std::vector<CTransactionRef>& txs) const
+{
+    block_hashes.resize(tx_hashes.size());
+    txs.resize(tx_hashes.size());
 
-    AutoFile file{m_chainstate->m_blockman.OpenBlockFile(postx, true)};
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
+    // Read the transactions in the order they are on disk, each block file
+    // and block header once.
+    std::vector<std::pair<CDiskTxPos, size_t>> reads;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        for (const CDiskTxPos& pos : positions[i]) reads.emplace_back(pos, i);
     }
-    CBlockHeader header;
-    try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
+    std::sort(reads.begin(), reads.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.first.nFile, a.first.nPos, a.first.nTxOffset) < std::tie(b.first.nFile, b.first.nPos, b.first.nTxOffset);
+    });
+
+    for (auto file_begin{reads.begin()}; file_begin != reads.end();) {
+        const auto file_end{std::find_if(file_begin, reads.end(), [&](const auto& read) { return read.first.nFile != file_begin->first.nFile; })};
+        AutoFile file{m_chainstate->m_blockman.OpenBlockFile(file_begin->first, true)};
+        if (file.IsNull()) {
+            LogPrintf("%s: OpenBlockFile failed\n", __func__);
+            file_begin = file_end;
+            continue;
+        }
+        std::optional<unsigned int> block_pos;
+        long body_pos{0};
+        uint256 block_hash;
+        for (; file_begin != file_end; ++file_begin) {
+            const auto& [pos, i]{*file_begin};
+            if (txs[i]) continue;
+            try {
+                if (block_pos != pos.nPos) {
+                    block_pos.reset();
+                    if (fseek(file.Get(), pos.nPos, SEEK_SET)) {
+                        LogPrintf("%s: fseek(...) failed\n", __func__);
+                        continue;
+                    }
+                    CBlockHeader header;
+                    file >> header;
+                    block_hash = header.GetHash();
+                    body_pos = ftell(file.Get());
+                    block_pos = pos.nPos;
+                }
+                if (fseek(file.Get(), body_pos + pos.nTxOffset, SEEK_SET)) {
+                    LogPrintf("%s: fseek(...) failed\n", __func__);
+                    continue;
+                }
+                CTransactionRef tx;
+                file >> TX_WITH_WITNESS(tx);
+                if (tx->GetHash() != tx_hashes[i]) {
+                    // A different transaction with the same short id, or one
+                    // in a block which has replaced the one it was in.
+                    continue;
+                }
+                block_hashes[i] = block_hash;
+                txs[i] = std::move(tx);
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+                block_pos.reset();
+            }
         }
-        file >> TX_WITH_WITNESS(tx);
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-    }
-    if (tx->GetHash() != tx_hash) {
-        return error("%s: txid mismatch", __func__);
     }
-    block_hash = header.GetHash();
-    return true;
 }
@@ -17,13 +17,23 @@
 #define FREICOIN_INDEX_TXINDEX_H
 
 #include <index/base.h>
+#include <span.h>
+
+#include <vector>
+
+struct CDiskTxPos;
 
 static constexpr bool DEFAULT_TXINDEX{false};
 
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
- * The index is written to a LevelDB database and records the filesystem
- * location of each transaction by transaction hash.
+ * The index is written to a LevelDB database and records where each
+ * transaction is by a short, salted hash of the transaction hash: the height
+ * of the block it is in and its position in the block.  For each height the
+ * filesystem location of the block and the sizes of its transactions are
+ * recorded once.  Indexes built before this format record the filesystem
+ * location of each transaction by transaction hash, and are still read and
+ * kept up to date in that format.
  */
 class TxIndex final : public BaseIndex
 {
@@ -35,9 +45,16 @@ private:
 
     bool AllowPrune() const override { return false; }
 
+    /// Read the transactions with the given hashes from where they may be
+    /// on disk, reading those in the same block file in order.
+    void ReadTxsFromDisk(Span<const uint256> tx_hashes, const std::vector<std::vector<CDiskTxPos>>& positions,
+                         std::vector<uint256>& block_hashes, std::vector<CTransactionRef>& txs) const;
+
 protected:
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
     BaseIndex::DB& GetDB() const override;
 
 public:
@@ -54,6 +71,14 @@ public:
     /// @param[out]  tx  The transaction itself.
     /// @return  true if transaction is found, false otherwise
     bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Look up many transactions by hash, reading the index for them in key
+    /// order and each block, and block file, that they are in once.
+    ///
+    /// @param[in]   tx_hashes  The hashes of the transactions to be returned.
+    /// @param[out]  block_hashes  The hashes of the blocks the transactions are found in.
+    /// @param[out]  txs  The transactions, in the same order as tx_hashes, null for those not found.
+    void FindTxs(Span<const uint256> tx_hashes, std::vector<uint256>& block_hashes, std::vector<CTransactionRef>& txs) const;
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
@@ -483,6 +483,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-backgroundflush", strprintf("Write routine flushes of the coins cache to disk in the background, while block validation continues. This may temporarily use up to twice the memory of -dbcache (default: %u)", DEFAULT_BACKGROUND_FLUSH), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-fastprune", "Use smaller block files and lower minimum prune height for testing purposes", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
 #if HAVE_SYSTEM
@@ -686,6 +687,9 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-stratumallowip=<ip>", "Allow Stratum work requests from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::STRATUM);
     argsman.AddArg("-defaultminingaddress=<addr>", "Set the default mining address for the stratum server, used if the miner authenticates with a blank username. (Conflicts with -stratumwallet option)", ArgsManager::ALLOW_ANY, OptionsCategory::STRATUM);
     argsman.AddArg("-miningmindiff=<n>", strprintf("Set the minimum difficulty for stratum clients (default: %u)", DEFAULT_MINING_DIFFICULTY), ArgsManager::ALLOW_ANY, OptionsCategory::STRATUM);
+    argsman.AddArg("-stratumthreads=<n>", strprintf("Set the number of threads to service stratum connections (default: %d)", DEFAULT_STRATUM_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::STRATUM);
+    argsman.AddArg("-stratumworkfeedelta=<amt>", strprintf("Push updated work to stratum clients once at least this much in new transaction fees (in %s) has entered the mempool, or 0 to only push new work on new blocks (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_STRATUM_WORK_FEE_DELTA)), ArgsManager::ALLOW_ANY, OptionsCategory::STRATUM);
+    argsman.AddArg("-stratumshareinterval=<n>", strprintf("Raise the share difficulty of each stratum client above -miningmindiff so that it submits a share about once every <n> seconds, or 0 to disable (default: %d)", DEFAULT_STRATUM_SHARE_INTERVAL), ArgsManager::ALLOW_ANY, OptionsCategory::STRATUM);
 
 #if HAVE_DECL_FORK
     argsman.AddArg("-daemon", strprintf("Run in the background as a daemon and accept commands (default: %d)", DEFAULT_DAEMON), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -1563,10 +1567,18 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
             for (auto* index : node.indexes) {
                 index->Interrupt();
                 index->Stop();
-                if (!(index->Init() && index->StartBackgroundSync())) {
+            }
+            std::vector<BaseIndex*> restarted_indexes;
+            for (auto* index : node.indexes) {
+                if (index->Init()) {
+                    restarted_indexes.push_back(index);
+                } else {
                     LogPrintf("[snapshot] WARNING failed to restart index %s on snapshot chain\n", index->GetName());
                 }
             }
+            if (!BaseIndex::StartBackgroundSync(restarted_indexes)) {
+                LogPrintf("[snapshot] WARNING failed to restart indexes on snapshot chain\n");
+            }
         };
 
         node::ChainstateLoadOptions options;
@@ -2030,7 +2042,6 @@ bool StartIndexBackgroundSync(NodeContext& node)
         }
     }
 
-    // Start threads
-    for (auto index : node.indexes) if (!index->StartBackgroundSync()) return false;
-    return true;
+    // Start threads, syncing the indexes together so that each block is read once
+    return BaseIndex::StartBackgroundSync(node.indexes);
 }
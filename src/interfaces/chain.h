@@ -107,6 +107,20 @@ struct BlockInfo {
     BlockInfo(const uint256& hash LIFETIMEBOUND) : hash(hash) {}
 };
 
+//! Interface for reading blocks in chain order, as in a rescan, which reads
+//! the blocks after the one asked for ahead of time.
+class BlockReader
+{
+public:
+    virtual ~BlockReader() {}
+
+    //! Read the data of a block. Returns false, with the CBlock set to null,
+    //! if the block is unknown or its data is unavailable (for example due to
+    //! pruning). If the block is in the active chain, the blocks following it
+    //! are read in the background.
+    virtual bool readBlock(const uint256& hash, CBlock& block) = 0;
+};
+
 //! Interface giving clients (wallet processes, maybe other analysis tools in
 //! the future) ability to access to the chain state, receive notifications,
 //! estimate fees, and submit transactions.
@@ -171,6 +185,9 @@ public:
     //! or contents.
     virtual bool findBlock(const uint256& hash, const FoundBlock& block={}) = 0;
 
+    //! Return a reader for scanning the data of many blocks in chain order.
+    virtual std::unique_ptr<BlockReader> makeBlockReader() = 0;
+
     //! Find first block in the chain with timestamp >= the given time
     //! and height >= than the given height, return false if there is no block
     //! with a high enough timestamp and height. Optionally return block
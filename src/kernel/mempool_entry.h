@@ -71,6 +71,13 @@ struct CompareIteratorByHash {
  * (m_count_with_descendants, nSizeWithDescendants, and nModFeesWithDescendants) for
  * all ancestors of the newly added transaction.
  *
+ * Fees are denominated at the transaction's reference height.  To let the
+ * mempool's sorted indexes compare entries with different reference heights
+ * without performing a demurrage calculation on every comparison, each entry
+ * also caches its fees adjusted to a single mempool-wide normalization height.
+ * These cached values are refreshed whenever the underlying fees change, and
+ * in bulk by the mempool when it moves the normalization height.
+ *
  */
 
 class CTxMemPoolEntry
@@ -116,6 +123,22 @@ private:
     CAmount nModFeesWithAncestors;
     int64_t nSigOpCostWithAncestors;
 
+    // Fees adjusted to the mempool-wide normalization height, for use
+    // as sort keys.
+    int32_t m_normalized_height;
+    CAmount m_normalized_fee;
+    CAmount m_normalized_modified_fee;
+    CAmount m_normalized_mod_fees_with_descendants;
+    CAmount m_normalized_mod_fees_with_ancestors;
+    //! Set on every entry while the mempool moves to a new normalization
+    //! height; see CTxMemPool::MaybeRenormalize().
+    mutable bool m_renormalizing{false};
+
+    CAmount NormalizeValue(CAmount value) const
+    {
+        return GetTimeAdjustedValue(value, m_normalized_height - GetReferenceHeight());
+    }
+
 public:
     CTxMemPoolEntry(const CTransactionRef& tx, CAmount fee,
                     int64_t time, unsigned int entry_height, uint64_t entry_sequence,
@@ -136,9 +159,18 @@ public:
           nModFeesWithDescendants{nFee},
           nSizeWithAncestors{GetTxSize()},
           nModFeesWithAncestors{nFee},
-          nSigOpCostWithAncestors{sigOpCost} {}
+          nSigOpCostWithAncestors{sigOpCost},
+          m_normalized_height{GetReferenceHeight()},
+          m_normalized_fee{nFee},
+          m_normalized_modified_fee{nFee},
+          m_normalized_mod_fees_with_descendants{nFee},
+          m_normalized_mod_fees_with_ancestors{nFee} {}
 
     CTxMemPoolEntry(ExplicitCopyTag, const CTxMemPoolEntry& entry) : CTxMemPoolEntry(entry) {}
+    CTxMemPoolEntry(ExplicitCopyTag, const CTxMemPoolEntry& entry, int32_t normalized_height) : CTxMemPoolEntry(entry)
+    {
+        Normalize(normalized_height);
+    }
     CTxMemPoolEntry& operator=(const CTxMemPoolEntry&) = delete;
     CTxMemPoolEntry(CTxMemPoolEntry&&) = delete;
     CTxMemPoolEntry& operator=(CTxMemPoolEntry&&) = delete;
@@ -172,7 +204,12 @@ public:
         nModFeesWithDescendants = SaturatingAdd(nModFeesWithDescendants, fee_diff);
         nModFeesWithAncestors = SaturatingAdd(nModFeesWithAncestors, fee_diff);
         m_modified_fee = SaturatingAdd(m_modified_fee, fee_diff);
+        m_normalized_modified_fee = NormalizeValue(m_modified_fee);
+        m_normalized_mod_fees_with_descendants = NormalizeValue(nModFeesWithDescendants);
+        m_normalized_mod_fees_with_ancestors = NormalizeValue(nModFeesWithAncestors);
     }
+    // Recomputes the normalized fees relative to a new height.
+    void Normalize(int32_t normalized_height);
 
     // Update the LockPoints after a reorg
     void UpdateLockPoints(const LockPoints& lp) const
@@ -191,6 +228,14 @@ public:
     CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
     int64_t GetSigOpCostWithAncestors() const { return nSigOpCostWithAncestors; }
 
+    int32_t GetNormalizedHeight() const { return m_normalized_height; }
+    CAmount GetNormalizedFee() const { return m_normalized_fee; }
+    CAmount GetNormalizedModifiedFee() const { return m_normalized_modified_fee; }
+    CAmount GetNormalizedModFeesWithDescendants() const { return m_normalized_mod_fees_with_descendants; }
+    CAmount GetNormalizedModFeesWithAncestors() const { return m_normalized_mod_fees_with_ancestors; }
+    bool IsRenormalizing() const { return m_renormalizing; }
+    void SetRenormalizing() const { m_renormalizing = true; }
+
     const Parents& GetMemPoolParentsConst() const { return m_parents; }
     const Children& GetMemPoolChildrenConst() const { return m_children; }
     Parents& GetMemPoolParents() const { return m_parents; }
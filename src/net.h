@@ -140,12 +140,25 @@ struct CSerializedNetMsg {
         CSerializedNetMsg copy;
         copy.data = data;
         copy.m_type = m_type;
+        copy.m_external_owner = m_external_owner;
+        copy.m_external_data = m_external_data;
         return copy;
     }
 
     std::vector<unsigned char> data;
     std::string m_type;
 
+    /** If set, the payload is m_external_data instead of data: read-only memory
+     *  kept alive by this owner, such as a block being served straight out of
+     *  a memory-mapped block file. */
+    std::shared_ptr<const void> m_external_owner;
+    Span<const unsigned char> m_external_data;
+
+    /** The payload of the message. */
+    Span<const unsigned char> Payload() const noexcept { return m_external_owner ? m_external_data : Span{data}; }
+    /** Release the payload, once it has been sent. */
+    void ClearPayload() noexcept;
+
     /** Compute total memory usage of this object (own memory + any dynamic memory). */
     size_t GetMemoryUsage() const noexcept;
 };
@@ -2348,11 +2348,20 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
         // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
-        if (!m_chainman.m_blockman.ReadRawBlockFromDisk(block_data, pindex->GetBlockPos())) {
-            assert(!"cannot load block from disk");
+        if (auto mapped{m_chainman.m_blockman.MapRawBlockFromDisk(pindex->GetBlockPos())}) {
+            // Send it without copying, straight out of the block file mapping
+            CSerializedNetMsg msg;
+            msg.m_type = NetMsgType::BLOCK;
+            msg.m_external_data = mapped->data;
+            msg.m_external_owner = std::move(mapped->file);
+            m_connman.PushMessage(&pfrom, std::move(msg));
+        } else {
+            std::vector<uint8_t> block_data;
+            if (!m_chainman.m_blockman.ReadRawBlockFromDisk(block_data, pindex->GetBlockPos())) {
+                assert(!"cannot load block from disk");
+            }
+            MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{block_data});
         }
-        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{block_data});
         // Don't set pblock as we've sent the block
     } else {
         // Send block from disk
@@ -2539,7 +2548,7 @@ void PeerManagerImpl::SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlo
 bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
 {
     // Do these headers have proof-of-work matching what's claimed?
-    if (!HasValidProofOfWork(headers, consensusParams)) {
+    if (!HasValidProofOfWork(headers, consensusParams, &m_chainman.GetCheckQueue())) {
         Misbehaving(peer, 100, "header with invalid proof of work");
         return false;
     }
@@ -0,0 +1,144 @@
+// Copyright (c) 2011-2024 The Freicoin Developers
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of version 3 of the GNU Affero General Public License as published
+// by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <node/blockprefetch.h>
+
+#include <chain.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <tinyformat.h>
+#include <undo.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+
+namespace node {
+
+BlockPrefetcher::BlockPrefetcher(const BlockManager& blockman, bool read_undo, size_t depth, int threads)
+    : m_blockman{blockman}, m_read_undo{read_undo}, m_depth{depth}
+{
+    m_threads.reserve(threads);
+    for (int n = 0; n < threads; ++n) {
+        m_threads.emplace_back([this, n]() {
+            util::ThreadRename(strprintf("blkprefetch.%i", n));
+            Loop();
+        });
+    }
+}
+
+BlockPrefetcher::~BlockPrefetcher()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_work_cv.notify_all();
+    for (std::thread& t : m_threads) {
+        t.join();
+    }
+}
+
+void BlockPrefetcher::ReadAhead(const CBlockIndex* from, const CBlockIndex& target)
+{
+    AssertLockHeld(::cs_main);
+    const int from_height{from ? from->nHeight : -1};
+    const int end_height{std::min(target.nHeight, from_height + static_cast<int>(m_depth))};
+
+    LOCK(m_mutex);
+    // Keep what is already queued if it carries on from from towards target.
+    while (!m_queue.empty() && m_queue.front()->index->nHeight <= from_height) {
+        m_queue.pop_front();
+    }
+    if (!m_queue.empty() && (m_queue.front()->index->pprev != from ||
+                             target.GetAncestor(m_queue.back()->index->nHeight) != m_queue.back()->index)) {
+        m_queue.clear();
+    }
+
+    bool queued{false};
+    for (int height = m_queue.empty() ? from_height + 1 : m_queue.back()->index->nHeight + 1; height <= end_height; ++height) {
+        const CBlockIndex* index{target.GetAncestor(height)};
+        if (!(index->nStatus & BLOCK_HAVE_DATA)) break;
+        auto entry{std::make_shared<Entry>()};
+        entry->index = index;
+        entry->block_pos = index->GetBlockPos();
+        entry->undo_pos = index->GetUndoPos();
+        m_queue.push_back(std::move(entry));
+        queued = true;
+    }
+    if (queued) m_work_cv.notify_all();
+}
+
+BlockPrefetcher::Result BlockPrefetcher::Take(const CBlockIndex& index)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        WAIT_LOCK(m_mutex, lock);
+        const auto it{std::find_if(m_queue.begin(), m_queue.end(), [&](const auto& e) { return e->index == &index; })};
+        if (it != m_queue.end()) {
+            entry = *it;
+            m_queue.erase(m_queue.begin(), std::next(it));
+            if (entry->started) {
+                m_done_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return entry->done; });
+                return std::move(entry->result);
+            }
+            // Not picked up by a worker yet, so read it here rather than wait.
+            entry->started = true;
+        }
+    }
+    if (!entry) {
+        entry = std::make_shared<Entry>();
+        entry->index = &index;
+        LOCK(::cs_main);
+        entry->block_pos = index.GetBlockPos();
+        entry->undo_pos = index.GetUndoPos();
+    }
+    return Read(*entry);
+}
+
+BlockPrefetcher::Result BlockPrefetcher::Read(const Entry& entry) const
+{
+    Result result;
+    auto block{std::make_shared<CBlock>()};
+    if (m_blockman.ReadBlockFromDisk(*block, *entry.index, entry.block_pos)) {
+        result.block = std::move(block);
+    }
+    if (m_read_undo && entry.index->pprev) {
+        auto undo{std::make_shared<CBlockUndo>()};
+        if (m_blockman.UndoReadFromDisk(*undo, *entry.index, entry.undo_pos)) {
+            result.undo = std::move(undo);
+        }
+    }
+    return result;
+}
+
+void BlockPrefetcher::Loop()
+{
+    while (true) {
+        std::shared_ptr<Entry> entry;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_work_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                if (m_stop) return true;
+                const auto it{std::find_if(m_queue.begin(), m_queue.end(), [](const auto& e) { return !e->started; })};
+                if (it == m_queue.end()) return false;
+                entry = *it;
+                return true;
+            });
+            if (m_stop) return;
+            entry->started = true;
+        }
+        Result result{Read(*entry)};
+        WITH_LOCK(m_mutex, entry->result = std::move(result); entry->done = true);
+        m_done_cv.notify_all();
+    }
+}
+
+} // namespace node
@@ -0,0 +1,117 @@
+// Copyright (c) 2011-2024 The Freicoin Developers
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of version 3 of the GNU Affero General Public License as published
+// by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef FREICOIN_NODE_BLOCKPREFETCH_H
+#define FREICOIN_NODE_BLOCKPREFETCH_H
+
+#include <flatfile.h>
+#include <kernel/cs_main.h>
+#include <sync.h>
+#include <threadsafety.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+class CBlockUndo;
+
+namespace node {
+class BlockManager;
+
+/** The number of blocks read ahead of the block being processed by default */
+static constexpr size_t DEFAULT_BLOCK_PREFETCH_DEPTH{16};
+/** The number of threads reading blocks ahead by default */
+static constexpr int DEFAULT_BLOCK_PREFETCH_THREADS{2};
+
+/**
+ * Reads blocks, and optionally their undo data, on background threads ahead
+ * of a consumer which processes them in chain order, such as an index or
+ * wallet catching up with the chain, so that it does not have to wait on the
+ * disk for each block in turn.
+ *
+ * Before taking each block the consumer calls ReadAhead with the block it
+ * has got to and the block it is heading for, which queues up the blocks
+ * after it to be read.  If the consumer changes course, as on a reorg, the
+ * blocks read ahead are dropped.  Blocks which were not read ahead are read
+ * when they are taken.
+ */
+class BlockPrefetcher
+{
+public:
+    //! A block which has been read, with its undo data if that was asked for.
+    struct Result {
+        //! Null if the block could not be read.
+        std::shared_ptr<const CBlock> block;
+        //! Null if undo data was not asked for or could not be read, and for
+        //! the genesis block, which has none.
+        std::shared_ptr<const CBlockUndo> undo;
+    };
+
+    BlockPrefetcher(const BlockManager& blockman, bool read_undo,
+                    size_t depth = DEFAULT_BLOCK_PREFETCH_DEPTH,
+                    int threads = DEFAULT_BLOCK_PREFETCH_THREADS);
+    ~BlockPrefetcher();
+
+    BlockPrefetcher(const BlockPrefetcher&) = delete;
+    BlockPrefetcher& operator=(const BlockPrefetcher&) = delete;
+
+    /**
+     * Queue up the blocks after from (or from the genesis block, if it is
+     * null) on the way to target to be read, up to the read-ahead depth.
+     * Queued blocks which are not on that path are dropped.
+     */
+    void ReadAhead(const CBlockIndex* from, const CBlockIndex& target)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+    /**
+     * Get a block, waiting for it to be read if it is queued, or reading it
+     * now if it is not.  Blocks queued before it are dropped.
+     */
+    Result Take(const CBlockIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Entry {
+        const CBlockIndex* index;
+        FlatFilePos block_pos;
+        FlatFilePos undo_pos;
+        bool started{false};
+        bool done{false};
+        Result result;
+    };
+
+    const BlockManager& m_blockman;
+    const bool m_read_undo;
+    const size_t m_depth;
+
+    Mutex m_mutex;
+    //! Signalled when blocks are queued, or on shutdown.
+    std::condition_variable m_work_cv;
+    //! Signalled when a block has been read.
+    std::condition_variable m_done_cv;
+    //! Blocks queued to be read, in chain order.
+    std::deque<std::shared_ptr<Entry>> m_queue GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+
+    Result Read(const Entry& entry) const;
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+} // namespace node
+
+#endif // FREICOIN_NODE_BLOCKPREFETCH_H
@@ -140,10 +140,18 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
                 pindexNew->nBits          = diskindex.nBits;
                 pindexNew->nNonce         = diskindex.nNonce;
                 pindexNew->m_aux_pow      = diskindex.m_aux_pow;
+                pindexNew->m_aux_hash     = diskindex.m_aux_hash;
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
 
-                if (!CheckAuxiliaryProofOfWork(pindexNew->GetBlockHeader(), consensusParams) || (!IsProtocolCleanupActive(consensusParams, *pindexNew) && !CheckProofOfWork(pindexNew->GetBlockHeader(), consensusParams))) {
+                // Entries written by earlier versions lack the memoized
+                // auxiliary proof-of-work hashes, which must be recomputed.
+                // These are filled in by BlockManager::LoadBlockIndex().
+                const CBlockHeader header{pindexNew->GetBlockHeader()};
+                const bool aux_pow_valid = !pindexNew->m_aux_hash
+                    ? CheckAuxiliaryProofOfWork(header, consensusParams)
+                    : CheckAuxiliaryProofOfWork(header, *pindexNew->m_aux_hash, consensusParams);
+                if (!aux_pow_valid || (!IsProtocolCleanupActive(consensusParams, *pindexNew) && !CheckProofOfWork(header, consensusParams))) {
                     return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
                 }
 
@@ -212,7 +220,7 @@ const CBlockIndex* BlockManager::LookupBlockIndex(const uint256& hash) const
     return it == m_block_index.end() ? nullptr : &it->second;
 }
 
-CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockIndex*& best_header)
+CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockIndex*& best_header, const std::pair<uint256, uint256>* aux_hash)
 {
     AssertLockHeld(cs_main);
 
@@ -222,6 +230,10 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockInde
     }
     CBlockIndex* pindexNew = &(*mi).second;
 
+    if (!block.m_aux_pow.IsNull()) {
+        pindexNew->SetAuxiliaryHash(aux_hash ? *aux_hash : block.GetAuxiliaryHash(GetConsensus()));
+    }
+
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -448,6 +460,12 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
             return error("%s: block index is non-contiguous, index of height %d missing", __func__, previous_index->nHeight + 1);
         }
         previous_index = pindex;
+        // Memoize the auxiliary proof-of-work hashes of index entries written
+        // by earlier versions, and rewrite them so this only happens once.
+        if (!pindex->m_aux_pow.IsNull() && !pindex->m_aux_hash) {
+            pindex->SetAuxiliaryHash(pindex->GetBlockHeader().GetAuxiliaryHash(GetConsensus()));
+            m_dirty_blockindex.insert(pindex);
+        }
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
 
@@ -710,8 +728,11 @@ bool BlockManager::UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos
 
 bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const
 {
-    const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
+    return UndoReadFromDisk(blockundo, index, WITH_LOCK(::cs_main, return index.GetUndoPos()));
+}
 
+bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index, const FlatFilePos& pos) const
+{
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
@@ -770,6 +791,11 @@ bool BlockManager::FlushBlockFile(int blockfile_num, bool fFinalize, bool finali
         m_opts.notifications.flushError("Flushing block file to disk failed. This is likely the result of an I/O error.");
         success = false;
     }
+    if (fFinalize) {
+        // Finalizing truncates the preallocated space off the end of the
+        // file, so a mapping of it made before now would be too long.
+        WITH_LOCK(m_mapped_block_files_mutex, m_mapped_block_files.remove_if([&](const auto& entry) { return entry.first == blockfile_num; }));
+    }
     // we do not always flush the undo file, as the chain tip may be lagging behind the incoming blocks,
     // e.g. during IBD or a sync after a node going offline
     if (!fFinalize || finalize_undo) {
@@ -818,6 +844,7 @@ void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
     std::error_code ec;
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
+        WITH_LOCK(m_mapped_block_files_mutex, m_mapped_block_files.remove_if([&](const auto& entry) { return entry.first == *it; }));
         const bool removed_blockfile{fs::remove(BlockFileSeq().FileName(pos), ec)};
         const bool removed_undofile{fs::remove(UndoFileSeq().FileName(pos), ec)};
         if (removed_blockfile || removed_undofile) {
@@ -1039,7 +1066,7 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
     return true;
 }
 
-bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const
+bool BlockManager::ReadBlockFromDiskUnchecked(CBlock& block, const FlatFilePos& pos) const
 {
     block.SetNull();
 
@@ -1056,6 +1083,15 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) cons
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
+    return true;
+}
+
+bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const
+{
+    if (!ReadBlockFromDiskUnchecked(block, pos)) {
+        return false;
+    }
+
     // Check the header
     if (!CheckAuxiliaryProofOfWork(block, GetConsensus()) || (!IsProtocolCleanupActive(GetConsensus(), block) && !CheckProofOfWork(block, GetConsensus()))) {
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
@@ -1071,9 +1107,12 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) cons
 
 bool BlockManager::ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const
 {
-    const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    return ReadBlockFromDisk(block, index, WITH_LOCK(cs_main, return index.GetBlockPos()));
+}
 
-    if (!ReadBlockFromDisk(block, block_pos)) {
+bool BlockManager::ReadBlockFromDisk(CBlock& block, const CBlockIndex& index, const FlatFilePos& block_pos) const
+{
+    if (!ReadBlockFromDiskUnchecked(block, block_pos)) {
         return false;
     }
 
@@ -1099,6 +1138,23 @@ bool BlockManager::ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) co
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
                      index.ToString(), block_pos.ToString());
     }
+
+    // Check the header.  The block hash commits to every field which goes
+    // into the auxiliary proof-of-work hashes except the auxiliary
+    // proof-of-work itself, so if that matches the index entry too (as it
+    // almost always will) the hashes memoized in the index can be used.
+    const bool aux_pow_valid = block.m_aux_pow == index.m_aux_pow
+        ? CheckAuxiliaryProofOfWork(block, index.GetAuxiliaryHash(GetConsensus()), GetConsensus())
+        : CheckAuxiliaryProofOfWork(block, GetConsensus());
+    if (!aux_pow_valid || (!IsProtocolCleanupActive(GetConsensus(), block) && !CheckProofOfWork(block, GetConsensus()))) {
+        return error("ReadBlockFromDisk: Errors in block header at %s", block_pos.ToString());
+    }
+
+    // Signet only: check block solution
+    if (GetConsensus().signet_blocks && !CheckSignetBlockSolution(block, GetConsensus())) {
+        return error("ReadBlockFromDisk: Errors in block solution at %s", block_pos.ToString());
+    }
+
     return true;
 }
 
@@ -1137,6 +1193,82 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+std::shared_ptr<const MappedFlatFile> BlockManager::MapBlockFile(const FlatFilePos& pos, size_t min_size) const
+{
+    LOCK(m_mapped_block_files_mutex);
+    auto it{std::find_if(m_mapped_block_files.begin(), m_mapped_block_files.end(), [&](const auto& entry) { return entry.first == pos.nFile; })};
+    if (it != m_mapped_block_files.end()) {
+        if (it->second->size() >= min_size) {
+            m_mapped_block_files.splice(m_mapped_block_files.end(), m_mapped_block_files, it);
+            return it->second;
+        }
+        // The file has grown since it was mapped.
+        m_mapped_block_files.erase(it);
+    }
+    auto file{BlockFileSeq().Map(pos)};
+    if (!file || file->size() < min_size) {
+        return nullptr;
+    }
+    m_mapped_block_files.emplace_back(pos.nFile, file);
+    if (m_mapped_block_files.size() > MAX_MAPPED_BLOCK_FILES) {
+        m_mapped_block_files.pop_front();
+    }
+    return file;
+}
+
+std::optional<MappedBlock> BlockManager::MapRawBlockFromDisk(const FlatFilePos& pos) const
+{
+    if (pos.IsNull() || pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+        return std::nullopt;
+    }
+    auto file{MapBlockFile(pos, pos.nPos)};
+    if (!file) {
+        return std::nullopt;
+    }
+
+    MessageStartChars blk_start;
+    unsigned int blk_size;
+    SpanReader{file->data().subspan(pos.nPos - BLOCK_SERIALIZATION_HEADER_SIZE, BLOCK_SERIALIZATION_HEADER_SIZE)} >> blk_start >> blk_size;
+    if (blk_start != GetParams().MessageStart() || blk_size > MAX_SIZE) {
+        return std::nullopt;
+    }
+    if (file->size() - pos.nPos < blk_size) {
+        file = MapBlockFile(pos, size_t{pos.nPos} + blk_size);
+        if (!file) {
+            return std::nullopt;
+        }
+    }
+    const auto data{file->data().subspan(pos.nPos, blk_size)};
+    return MappedBlock{std::move(file), data};
+}
+
+std::optional<MappedBlock> BlockManager::MapBlockFromDisk(const CBlockIndex& index) const
+{
+    const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    auto mapped{MapRawBlockFromDisk(block_pos)};
+    if (!mapped) {
+        return std::nullopt;
+    }
+
+    // The index entry's header was checked when it was accepted.  If the
+    // header on disk is the same, including its auxiliary proof-of-work (see
+    // ReadBlockFromDisk), it need not be checked again.
+    CBlockHeader header;
+    try {
+        SpanReader{mapped->data} >> header;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+    if (header.GetHash() != index.GetBlockHash() || header.m_aux_pow != index.m_aux_pow) {
+        return std::nullopt;
+    }
+    // The signet solution is in the coinbase, so is not covered by the header.
+    if (GetConsensus().signet_blocks) {
+        return std::nullopt;
+    }
+    return mapped;
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp)
 {
     unsigned int nBlockSize = ::GetSerializeSize(TX_WITH_WITNESS(block));
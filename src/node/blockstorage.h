@@ -25,6 +25,7 @@
 #include <kernel/cs_main.h>
 #include <kernel/messagestartchars.h>
 #include <primitives/block.h>
+#include <span.h>
 #include <streams.h>
 #include <sync.h>
 #include <uint256.h>
@@ -36,6 +37,7 @@
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
 #include <optional>
@@ -87,6 +89,9 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = std::tuple_size_v<MessageStartChars> + sizeof(unsigned int);
 
+/** The number of block files kept memory-mapped for serving raw blocks */
+static constexpr size_t MAX_MAPPED_BLOCK_FILES{64};
+
 extern std::atomic_bool fReindex;
 
 // Because validation code takes pointers to the map's CBlockIndex objects, if
@@ -136,6 +141,15 @@ struct BlockfileCursor {
 
 std::ostream& operator<<(std::ostream& os, const BlockfileCursor& cursor);
 
+/** A serialized block, read in place from a memory-mapped block file. */
+struct MappedBlock {
+    //! The mapping, which keeps data valid.
+    std::shared_ptr<const MappedFlatFile> file;
+    //! The block as serialized on disk, which is with witness data, as for a
+    //! witness block on the wire.
+    Span<const uint8_t> data;
+};
+
 
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
@@ -161,7 +175,8 @@ private:
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /** Return false if block file or undo file flushing fails. */
-    [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo);
+    [[nodiscard]] bool FlushBlockFile(int blockfile_num, bool fFinalize, bool finalize_undo)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_block_files_mutex);
 
     /** Return false if undo file flushing fails. */
     [[nodiscard]] bool FlushUndoFile(int block_file, bool finalize = false);
@@ -175,7 +190,17 @@ private:
 
     AutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
+    mutable Mutex m_mapped_block_files_mutex;
+    //! Memory mappings of recently read block files, least recently used first.
+    mutable std::list<std::pair<int, std::shared_ptr<const MappedFlatFile>>> m_mapped_block_files GUARDED_BY(m_mapped_block_files_mutex);
+    /** Get a mapping of the block file at pos, covering at least its first
+     *  min_size bytes, or nullptr if the file cannot be mapped. */
+    std::shared_ptr<const MappedFlatFile> MapBlockFile(const FlatFilePos& pos, size_t min_size) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_block_files_mutex);
+
     bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const;
+    /** Deserialize a block from disk without checking its proof-of-work. */
+    bool ReadBlockFromDiskUnchecked(CBlock& block, const FlatFilePos& pos) const;
     bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock) const;
 
     /* Calculate the block/rev files to delete based on height specified by user with RPC command pruneblockchain */
@@ -307,7 +332,10 @@ public:
      */
     void ScanAndUnlinkAlreadyPrunedFiles() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
-    CBlockIndex* AddToBlockIndex(const CBlockHeader& block, CBlockIndex*& best_header) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Add a new header to the block index.  If aux_hash is not null, it must
+     *  hold the already computed auxiliary proof-of-work hashes of the header,
+     *  which are memoized in the index entry. */
+    CBlockIndex* AddToBlockIndex(const CBlockHeader& block, CBlockIndex*& best_header, const std::pair<uint256, uint256>* aux_hash = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Create a new block index entry for a given block hash */
     CBlockIndex* InsertBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -369,14 +397,42 @@ public:
     /**
      *  Actually unlink the specified files
      */
-    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const;
+    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_block_files_mutex);
 
     /** Functions for disk access for blocks */
     bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos) const;
     bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
+    /** As above, with the block's position already looked up, so that cs_main
+     *  is not taken. */
+    bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index, const FlatFilePos& block_pos) const;
     bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
 
+    /**
+     * Look up the serialized block at pos in a memory mapping of its block
+     * file, without copying it.  Returns nullopt if the block file cannot be
+     * mapped or the block is not found, in which case ReadRawBlockFromDisk
+     * should be used instead.
+     *
+     * An I/O error while the mapping is read raises SIGBUS instead of failing
+     * the read, so this is only for serving blocks to peers and REST clients.
+     * Reads for validation and indexing must go through ReadBlockFromDisk.
+     */
+    std::optional<MappedBlock> MapRawBlockFromDisk(const FlatFilePos& pos) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_block_files_mutex);
+    /**
+     * As MapRawBlockFromDisk, but only if the data is exactly the
+     * serialization of the block ReadBlockFromDisk would return for the index
+     * entry, with a header matching the entry's.  Otherwise returns nullopt,
+     * and ReadBlockFromDisk should be used instead.
+     */
+    std::optional<MappedBlock> MapBlockFromDisk(const CBlockIndex& index) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_block_files_mutex);
+
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
+    /** As above, with the undo data's position already looked up, so that
+     *  cs_main is not taken. */
+    bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index, const FlatFilePos& undo_pos) const;
 
     void CleanupBlockRevFiles() const;
 };
@@ -35,6 +35,7 @@
 #include <net_processing.h>
 #include <netaddress.h>
 #include <netbase.h>
+#include <node/blockprefetch.h>
 #include <node/blockstorage.h>
 #include <node/coin.h>
 #include <node/context.h>
@@ -74,6 +75,7 @@
 
 #include <boost/signals2/signal.hpp>
 
+using interfaces::BlockReader;
 using interfaces::BlockTip;
 using interfaces::Chain;
 using interfaces::FoundBlock;
@@ -526,6 +528,36 @@ public:
     const CRPCCommand* m_wrapped_command;
 };
 
+class BlockReaderImpl : public BlockReader
+{
+public:
+    explicit BlockReaderImpl(ChainstateManager& chainman)
+        : m_chainman(chainman), m_prefetcher(chainman.m_blockman, /*read_undo=*/false) {}
+    bool readBlock(const uint256& hash, CBlock& block) override
+    {
+        const CBlockIndex* index;
+        {
+            LOCK(::cs_main);
+            index = m_chainman.m_blockman.LookupBlockIndex(hash);
+            if (!index) {
+                block.SetNull();
+                return false;
+            }
+            const CChain& active = m_chainman.ActiveChain();
+            if (active[index->nHeight] == index) m_prefetcher.ReadAhead(index->pprev, *active.Tip());
+        }
+        const auto result{m_prefetcher.Take(*index)};
+        if (!result.block) {
+            block.SetNull();
+            return false;
+        }
+        block = *result.block;
+        return true;
+    }
+    ChainstateManager& m_chainman;
+    BlockPrefetcher m_prefetcher;
+};
+
 class ChainImpl : public Chain
 {
 public:
@@ -584,6 +616,10 @@ public:
         WAIT_LOCK(cs_main, lock);
         return FillBlock(chainman().m_blockman.LookupBlockIndex(hash), block, lock, chainman().ActiveChain(), chainman().m_blockman);
     }
+    std::unique_ptr<BlockReader> makeBlockReader() override
+    {
+        return std::make_unique<BlockReaderImpl>(chainman());
+    }
     bool findFirstBlockWithTimeAndHeight(int64_t min_time, int min_height, const FoundBlock& block) override
     {
         WAIT_LOCK(cs_main, lock);
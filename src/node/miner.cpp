@@ -163,11 +163,12 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     // was a coinbase and if insufficient blocks have occured for it to mature.
     BlockFinalTxEntry final_tx;
     if (m_block_final_state == HAS_BLOCK_FINAL_TX) {
-        final_tx = m_chainstate.CoinsTip().GetFinalTx();
-        if (final_tx.IsNull()) {
+        const auto final_tx_state{m_chainstate.GetFinalTxState()};
+        if (final_tx_state.tip_hash != pindexPrev->GetBlockHash() || final_tx_state.final_tx.IsNull()) {
             // Should never happen
             return nullptr;
         }
+        final_tx = final_tx_state.final_tx;
         // Fetch the unspent outputs of the last block-final tx.  This call
         // should always return results because the prior block-final
         // transaction was the last processed transaction (so none of the
@@ -239,13 +240,27 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblock->nNonce         = 0;
     pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
 
+    std::vector<uint256> leaves;
+    leaves.reserve(pblock->vtx.size());
+    for (const auto& tx : pblock->vtx) {
+        leaves.push_back(tx->GetHash());
+    }
+    pblocktemplate->tx_merkle_tree = CachedMerkleTree(std::move(leaves));
+
     // Use of auxiliary proof-of-work is required after merge mining has
     // activated.  Since interfacing with the auxiliary chain is outside of
     // scope for this code, we generate a minimal auxiliary header.
     if (DeploymentActiveAfter(pindexPrev, m_chainstate.m_chainman, Consensus::DEPLOYMENT_AUXPOW)) {
         // Setup the block header commitment.
         pblock->m_aux_pow.m_commit_version = pblock->nVersion;
-        pblock->m_aux_pow.m_commit_hash_merkle_root = BlockTemplateMerkleRoot(*pblock, nullptr);
+        // This is BlockTemplateMerkleRoot(), reusing the template's tree.
+        CMutableTransaction cb(*pblock->vtx[0]);
+        cb.vin[0].scriptSig = CScript();
+        cb.vin[0].nSequence = 0;
+        CachedMerkleTree& tree = pblocktemplate->tx_merkle_tree;
+        tree.SetLeaf(0, cb.GetHash());
+        pblock->m_aux_pow.m_commit_hash_merkle_root = tree.GetRoot();
+        tree.SetLeaf(0, pblock->vtx[0]->GetHash());
 
         // Setup a fake auxiliary block with a single "transaction" (not an
         // actual transaction as no valid data precedes the midstate).
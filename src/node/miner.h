@@ -17,6 +17,7 @@
 #ifndef FREICOIN_NODE_MINER_H
 #define FREICOIN_NODE_MINER_H
 
+#include <consensus/merkle.h>
 #include <policy/policy.h>
 #include <primitives/block.h>
 #include <txmempool.h>
@@ -49,6 +50,11 @@ struct CBlockTemplate
     std::vector<CAmount> vTxFees;
     std::vector<int64_t> vTxSigOpsCost;
     bool has_block_final_tx;
+    //! Merkle tree of the block's transaction ids, kept so that the Merkle
+    //! root can be updated cheaply when the coinbase or block-final
+    //! transaction is replaced.  Whoever replaces a transaction of the block
+    //! must update the corresponding leaf.
+    CachedMerkleTree tx_merkle_tree;
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -59,18 +65,23 @@ struct CTxMemPoolModifiedEntry {
         iter = entry;
         nSizeWithAncestors = entry->GetSizeWithAncestors();
         nModFeesWithAncestors = entry->GetModFeesWithAncestors();
+        nNormalizedModFeesWithAncestors = entry->GetNormalizedModFeesWithAncestors();
         nSigOpCostWithAncestors = entry->GetSigOpCostWithAncestors();
     }
 
     CAmount GetModifiedFee() const { return iter->GetModifiedFee(); }
     uint64_t GetSizeWithAncestors() const { return nSizeWithAncestors; }
     CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
+    bool IsRenormalizing() const { return iter->IsRenormalizing(); }
+    CAmount GetNormalizedModifiedFee() const { return iter->GetNormalizedModifiedFee(); }
+    CAmount GetNormalizedModFeesWithAncestors() const { return nNormalizedModFeesWithAncestors; }
     size_t GetTxSize() const { return iter->GetTxSize(); }
     const CTransaction& GetTx() const { return iter->GetTx(); }
 
     CTxMemPool::txiter iter;
     uint64_t nSizeWithAncestors;
     CAmount nModFeesWithAncestors;
+    CAmount nNormalizedModFeesWithAncestors;
     int64_t nSigOpCostWithAncestors;
 };
 
@@ -134,6 +145,7 @@ struct update_for_parent_inclusion
     void operator() (CTxMemPoolModifiedEntry &e)
     {
         e.nModFeesWithAncestors -= iter->GetModifiedFee();
+        e.nNormalizedModFeesWithAncestors -= iter->GetNormalizedModifiedFee();
         e.nSizeWithAncestors -= iter->GetTxSize();
         e.nSigOpCostWithAncestors -= iter->GetSigOpCost();
     }
@@ -0,0 +1 @@
+#define BUILD_GIT_COMMIT "273a5a9137e5-dirty"
@@ -444,12 +444,9 @@ bool CheckNextWorkRequiredAux(const CBlockIndex* pindexLast, const CBlockHeader&
     return ((min <= target) && (target <= max));
 }
 
-bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const Consensus::Params& params)
+bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const Consensus::Params& params, std::pair<uint256, uint256>* aux_hash)
 {
     bool mutated = false;
-    bool negative = false;
-    bool overflow = false;
-    arith_uint256 target;
 
     if (block.m_aux_pow.IsNull()) {
         return true;
@@ -459,11 +456,27 @@ bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const Consensus::Param
     // parent chain, presumably bitcoin.  Since this involves a Merkle root
     // calculation, there's a possibility the data is in non-canonical form,
     // and we reject that as a block data mutation.
-    auto aux_hash = block.GetAuxiliaryHash(params, &mutated);
+    auto hashes = block.GetAuxiliaryHash(params, &mutated);
+    if (aux_hash) {
+        *aux_hash = hashes;
+    }
     if (mutated) {
         return false;
     }
 
+    return CheckAuxiliaryProofOfWork(block, hashes, params);
+}
+
+bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const std::pair<uint256, uint256>& aux_hash, const Consensus::Params& params)
+{
+    bool negative = false;
+    bool overflow = false;
+    arith_uint256 target;
+
+    if (block.m_aux_pow.IsNull()) {
+        return true;
+    }
+
     // Calculate the target value for the auxiliary proof-of-work, using
     // the nBits value in our block header, not the auxiliary block.
     target.SetCompact(block.m_aux_pow.m_commit_bits, &negative, &overflow);
@@ -484,7 +497,7 @@ bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const Consensus::Param
     }
 
     // Calculate target for 2nd stage.
-    target = UintToArith256(uint256S("0xffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+    target = ~arith_uint256();
     target >>= bias;
 
     // Check auxiliary proof-of-work (2nd stage)
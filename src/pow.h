@@ -41,8 +41,12 @@ uint32_t CalculateNextWorkRequiredAux(const CBlockIndex* pindexLast, const Conse
  ** twice the targets of the past 12 blocks. */
 bool CheckNextWorkRequiredAux(const CBlockIndex* pindexLast, const CBlockHeader& block, const Consensus::Params&);
 
-/** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
-bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const Consensus::Params&);
+/** Check whether a block hash satisfies the proof-of-work requirement specified by nBits.
+ ** If aux_hash is not null, it receives the computed auxiliary proof-of-work hashes. */
+bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const Consensus::Params&, std::pair<uint256, uint256>* aux_hash = nullptr);
+/** As above, but using previously computed (and non-mutated) auxiliary
+ ** proof-of-work hashes, such as those memoized in CBlockIndex. */
+bool CheckAuxiliaryProofOfWork(const CBlockHeader& block, const std::pair<uint256, uint256>& aux_hash, const Consensus::Params&);
 bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params&);
 
 /**
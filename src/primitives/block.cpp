@@ -110,14 +110,11 @@ std::pair<uint256, uint256> CBlockHeader::GetAuxiliaryHash(const Consensus::Para
 
 uint256 CBlockHeader::GetHash() const
 {
-    CBlockHeader blkhdr;
-    blkhdr.nVersion       = nVersion;
-    blkhdr.hashPrevBlock  = hashPrevBlock;
-    blkhdr.hashMerkleRoot = hashMerkleRoot;
-    blkhdr.nTime          = nTime;
-    blkhdr.nBits          = nBits;
-    blkhdr.nNonce         = nNonce;
-    return (HashWriter{} << blkhdr).GetHash();
+    // Only the native header fields are hashed.  They are written out
+    // directly, which is the same as serializing a copy of the header
+    // without its auxiliary proof-of-work, but without the cost of copying
+    // the auxiliary proof-of-work's branches.
+    return (HashWriter{} << nVersion << hashPrevBlock << hashMerkleRoot << nTime << nBits << nNonce).GetHash();
 }
 
 std::string CBlock::ToString() const
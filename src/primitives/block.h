@@ -291,6 +291,8 @@ public:
     bool IsNull() const {
         return (m_aux_num_txns == 0);
     }
+
+    friend bool operator==(const AuxProofOfWork&, const AuxProofOfWork&) = default;
 };
 
 /** Nodes collect new transactions into a block, hash them into a hash tree,
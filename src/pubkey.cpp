@@ -26,6 +26,7 @@
 #include <uint256.h>
 
 #include <algorithm>
+#include <memory>
 #include <cassert>
 
 namespace {
@@ -236,6 +237,60 @@ bool XOnlyPubKey::VerifySchnorr(const uint256& msg, Span<const unsigned char> si
     return secp256k1_schnorrsig_verify(secp256k1_context_static, sigbytes.data(), msg.begin(), 32, &pubkey);
 }
 
+void SchnorrBatch::Add(const XOnlyPubKey& pubkey, const uint256& msg, Span<const unsigned char> sigbytes)
+{
+    assert(sigbytes.size() == 64);
+    Entry& entry = m_entries.emplace_back();
+    entry.pubkey = pubkey;
+    entry.msg = msg;
+    std::copy(sigbytes.begin(), sigbytes.end(), entry.sig.begin());
+}
+
+bool SchnorrBatch::Verify(size_t* invalid) const
+{
+    // Scratch space for the multi-scalar multiplication.  Larger batches are
+    // split into several multiplications, but gain little from more space.
+    static constexpr size_t SCRATCH_SIZE{1 << 20};
+
+    if (m_entries.empty()) return true;
+
+    std::vector<secp256k1_xonly_pubkey> pubkeys(m_entries.size());
+    std::vector<const secp256k1_xonly_pubkey*> pubkey_ptrs(m_entries.size());
+    std::vector<const unsigned char*> sig_ptrs(m_entries.size());
+    std::vector<const unsigned char*> msg_ptrs(m_entries.size());
+    bool ok = true;
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (!secp256k1_xonly_pubkey_parse(secp256k1_context_static, &pubkeys[i], m_entries[i].pubkey.data())) {
+            ok = false;
+            break;
+        }
+        pubkey_ptrs[i] = &pubkeys[i];
+        sig_ptrs[i] = m_entries[i].sig.data();
+        msg_ptrs[i] = m_entries[i].msg.begin();
+    }
+    if (ok) {
+        // Each thread keeps its scratch space for all the batches it verifies,
+        // rather than allocating one per batch.
+        struct ScratchDeleter {
+            void operator()(secp256k1_scratch_space* scratch) const { secp256k1_scratch_space_destroy(secp256k1_context_static, scratch); }
+        };
+        static thread_local std::unique_ptr<secp256k1_scratch_space, ScratchDeleter> scratch;
+        if (!scratch) scratch.reset(secp256k1_scratch_space_create(secp256k1_context_static, SCRATCH_SIZE));
+        ok = secp256k1_schnorrsig_verify_batch(secp256k1_context_static, scratch.get(), sig_ptrs.data(), msg_ptrs.data(), pubkey_ptrs.data(), m_entries.size());
+    }
+    if (ok) return true;
+
+    // Individual verification is authoritative, so a batch failure is only
+    // reported if one of the signatures is invalid on its own.
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (!m_entries[i].pubkey.VerifySchnorr(m_entries[i].msg, m_entries[i].sig)) {
+            if (invalid) *invalid = i;
+            return false;
+        }
+    }
+    return true;
+}
+
 static const HashWriter HASHER_TAPTWEAK{TaggedHash("TapTweak")};
 
 uint256 XOnlyPubKey::ComputeTapTweakHash(const uint256* merkle_root) const
@@ -23,6 +23,7 @@
 #include <span.h>
 #include <uint256.h>
 
+#include <array>
 #include <cstring>
 #include <optional>
 #include <vector>
@@ -311,6 +312,36 @@ public:
     SERIALIZE_METHODS(XOnlyPubKey, obj) { READWRITE(obj.m_keydata); }
 };
 
+/** BIP340 signatures collected to be verified together with a single
+ *  multi-scalar multiplication.  This costs less per signature than calling
+ *  XOnlyPubKey::VerifySchnorr on each, and more so the larger the batch. */
+class SchnorrBatch
+{
+private:
+    struct Entry {
+        XOnlyPubKey pubkey;
+        uint256 msg;
+        std::array<unsigned char, 64> sig;
+    };
+    std::vector<Entry> m_entries;
+
+public:
+    /** Add a signature to the batch.
+     *
+     * sigbytes must be exactly 64 bytes.
+     */
+    void Add(const XOnlyPubKey& pubkey, const uint256& msg, Span<const unsigned char> sigbytes);
+
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    void clear() { m_entries.clear(); }
+
+    /** Verify every signature in the batch, returning true if all are valid.
+     *  If the batch as a whole fails, the signatures are verified one by one to
+     *  find the culprit, whose position is then stored in *invalid if given. */
+    bool Verify(size_t* invalid = nullptr) const;
+};
+
 /** An ElligatorSwift-encoded public key. */
 struct EllSwiftPubKey
 {
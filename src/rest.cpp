@@ -330,6 +330,20 @@ static bool rest_block(const std::any& context,
         }
     }
 
+    // Serve serialized blocks straight from the block file, if it can be mapped
+    if (rf == RESTResponseFormat::BINARY || rf == RESTResponseFormat::HEX) {
+        if (auto mapped{chainman.m_blockman.MapBlockFromDisk(*pblockindex)}) {
+            if (rf == RESTResponseFormat::BINARY) {
+                req->WriteHeader("Content-Type", "application/octet-stream");
+                req->WriteReply(HTTP_OK, mapped->data, std::move(mapped->file));
+            } else {
+                req->WriteHeader("Content-Type", "text/plain");
+                req->WriteReply(HTTP_OK, HexStr(mapped->data) + "\n");
+            }
+            return true;
+        }
+    }
+
     if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
         return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
@@ -880,11 +894,11 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     uint256 active_hash;
     {
         auto process_utxos = [&vOutPoints, &outs, &hits, &active_height, &active_hash, &chainman](const CCoinsView& view, const CTxMemPool* mempool) EXCLUSIVE_LOCKS_REQUIRED(chainman.GetMutex()) {
-            for (const COutPoint& vOutPoint : vOutPoints) {
-                Coin coin;
-                bool hit = (!mempool || !mempool->isSpent(vOutPoint)) && view.GetCoin(vOutPoint, coin);
+            std::vector<std::optional<Coin>> coins{view.GetCoins(vOutPoints)};
+            for (size_t i = 0; i < vOutPoints.size(); ++i) {
+                bool hit = (!mempool || !mempool->isSpent(vOutPoints[i])) && coins[i];
                 hits.push_back(hit);
-                if (hit) outs.emplace_back(std::move(coin));
+                if (hit) outs.emplace_back(std::move(*coins[i]));
             }
             active_height = chainman.ActiveHeight();
             active_hash = chainman.ActiveTip()->GetBlockHash();
@@ -129,6 +129,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "gettransaction", 2, "verbose" },
     { "getrawtransaction", 1, "verbosity" },
     { "getrawtransaction", 1, "verbose" },
+    { "getrawtransactions", 0, "txids" },
     { "createrawtransaction", 0, "inputs" },
     { "createrawtransaction", 1, "outputs" },
     { "createrawtransaction", 2, "locktime" },
@@ -120,7 +120,8 @@ static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t&
     block.hashMerkleRoot = BlockMerkleRoot(block);
 
     if (!block.m_aux_pow.IsNull()) {
-        while (max_tries > 0 && block.nNonce < std::numeric_limits<uint32_t>::max() && !CheckAuxiliaryProofOfWork(block, chainman.GetConsensus()) && !chainman.m_interrupt) {
+        std::pair<uint256, uint256> aux_hash;
+        while (max_tries > 0 && block.nNonce < std::numeric_limits<uint32_t>::max() && !CheckAuxiliaryProofOfWork(block, chainman.GetConsensus(), &aux_hash) && !chainman.m_interrupt) {
             ++block.m_aux_pow.m_aux_nonce;
             --max_tries;
         }
@@ -130,7 +131,7 @@ static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t&
         if (block.m_aux_pow.m_aux_nonce == std::numeric_limits<uint32_t>::max()) {
             return true;
         }
-        uint256 aux_hash2 = block.GetAuxiliaryHash(chainman.GetConsensus()).second;
+        const uint256& aux_hash2 = aux_hash.second;
         CMutableTransaction cb{*block.vtx[0]};
         cb.vin[0].scriptSig = CScript() << cb.lock_height;
         cb.vin[0].scriptSig.insert(cb.vin[0].scriptSig.end(), aux_hash2.begin(), aux_hash2.end());
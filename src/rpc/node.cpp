@@ -19,6 +19,8 @@
 #endif
 
 #include <chainparams.h>
+#include <common/args.h>
+#include <dbwrapper.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
@@ -34,10 +36,14 @@
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <scheduler.h>
+#include <script/sigcache.h>
 #include <univalue.h>
 #include <util/any.h>
 #include <util/check.h>
+#include <util/fs.h>
+#include <util/strencodings.h>
 #include <util/time.h>
+#include <validation.h>
 
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
@@ -131,6 +137,26 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCCacheInfo(const CuckooCache::cache_stats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    obj.pushKV("inserts", stats.inserts);
+    obj.pushKV("evictions", stats.evictions);
+    return obj;
+}
+
+static std::vector<RPCResult> RPCCacheInfoDoc()
+{
+    return {
+        {RPCResult::Type::NUM, "hits", "Number of lookups which found their entry"},
+        {RPCResult::Type::NUM, "misses", "Number of lookups which did not find their entry"},
+        {RPCResult::Type::NUM, "inserts", "Number of entries inserted"},
+        {RPCResult::Type::NUM, "evictions", "Number of inserts which evicted another entry"},
+    };
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -175,6 +201,8 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "signature_cache", "Counters of the cache of valid signatures", RPCCacheInfoDoc()},
+                            {RPCResult::Type::OBJ, "script_execution_cache", "Counters of the cache of transactions whose scripts are valid", RPCCacheInfoDoc()},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -191,6 +219,8 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("signature_cache", RPCCacheInfo(GetSignatureCacheStats()));
+        obj.pushKV("script_execution_cache", RPCCacheInfo(GetScriptExecutionCacheStats()));
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -205,6 +235,104 @@ static RPCHelpMan getmemoryinfo()
     };
 }
 
+static std::vector<RPCResult> DBOpStatsDoc(const std::string& found_desc)
+{
+    std::vector<RPCResult> doc{
+        {RPCResult::Type::NUM, "count", "Number of operations"},
+    };
+    if (!found_desc.empty()) {
+        doc.push_back({RPCResult::Type::NUM, "found", found_desc});
+    }
+    doc.push_back({RPCResult::Type::NUM, "bytes", found_desc.empty() ? "Estimated number of bytes written" : "Number of value bytes read"});
+    doc.push_back({RPCResult::Type::NUM, "time_us", "Total time spent, in microseconds"});
+    doc.push_back({RPCResult::Type::ARR, "latency", "Latency histogram. Element 0 counts operations which took less than 1 microsecond, element i those which took between 2^(i-1) and 2^i microseconds, and the last element of a full histogram (" + ToString(DB_LATENCY_BUCKETS) + " elements) also everything slower. Trailing empty buckets are omitted.",
+        {{RPCResult::Type::NUM, "", "Number of operations in this bucket"}}});
+    return doc;
+}
+
+static UniValue DBOpStatsToJSON(const DBOpStats& stats, bool lookup)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("count", stats.count);
+    if (lookup) {
+        obj.pushKV("found", stats.found);
+    }
+    obj.pushKV("bytes", stats.bytes);
+    obj.pushKV("time_us", stats.time_ns / 1000);
+    size_t buckets = stats.latency.size();
+    while (buckets > 0 && stats.latency[buckets - 1] == 0) --buckets;
+    UniValue latency(UniValue::VARR);
+    for (size_t i = 0; i < buckets; ++i) {
+        latency.push_back(stats.latency[i]);
+    }
+    obj.pushKV("latency", std::move(latency));
+    return obj;
+}
+
+static RPCHelpMan getdbstats()
+{
+    return RPCHelpMan{"getdbstats",
+                "Returns operation counts and latency histograms of the open leveldb databases, such as the chainstate, the block index and the enabled indexes.\n"
+                "Lookups are broken down by the leading byte of the key, which identifies the kind of record in most databases.\n"
+                "Lookups served from leveldb's block cache or the operating system's page cache typically fall in the low-microsecond buckets.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ_DYN, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "name", "The location of the database, relative to the data directory where possible",
+                        {
+                            {RPCResult::Type::BOOL, "memory_only", "Whether the database is held in memory"},
+                            {RPCResult::Type::NUM, "memory_usage", "Approximate memory usage of leveldb's memtables, in bytes"},
+                            {RPCResult::Type::NUM, "block_cache_size", "Capacity of leveldb's block cache, in bytes"},
+                            {RPCResult::Type::NUM, "block_cache_usage", "Bytes currently held in leveldb's block cache"},
+                            {RPCResult::Type::OBJ, "write_batch", "Batch writes", DBOpStatsDoc("")},
+                            {RPCResult::Type::OBJ_DYN, "lookups", "Lookups by leading key byte",
+                            {
+                                {RPCResult::Type::OBJ, "xx", "The leading key byte, in hex",
+                                {
+                                    {RPCResult::Type::OBJ, "read", "Point reads", DBOpStatsDoc("Number of reads which found an entry")},
+                                    {RPCResult::Type::OBJ, "exists", "Existence checks", DBOpStatsDoc("Number of checks which found an entry")},
+                                    {RPCResult::Type::OBJ, "seek", "Iterator seeks", DBOpStatsDoc("Number of seeks which found an entry at or after the key")},
+                                }},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getdbstats", "")
+            + HelpExampleRpc("getdbstats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const fs::path datadir{EnsureAnyArgsman(request.context).GetDataDirNet()};
+
+    UniValue result(UniValue::VOBJ);
+    for (const DBStats& stats : GetAllDBStats()) {
+        fs::path name{stats.path.lexically_relative(datadir)};
+        if (name.empty() || *name.begin() == "..") name = stats.path;
+
+        UniValue lookups(UniValue::VOBJ);
+        for (const auto& [prefix, kinds] : stats.lookups) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("read", DBOpStatsToJSON(kinds[size_t(DBLookup::READ)], /*lookup=*/true));
+            entry.pushKV("exists", DBOpStatsToJSON(kinds[size_t(DBLookup::EXISTS)], /*lookup=*/true));
+            entry.pushKV("seek", DBOpStatsToJSON(kinds[size_t(DBLookup::SEEK)], /*lookup=*/true));
+            lookups.pushKV(HexStr(Span{&prefix, 1}), std::move(entry));
+        }
+
+        UniValue db(UniValue::VOBJ);
+        db.pushKV("memory_only", stats.memory_only);
+        db.pushKV("memory_usage", uint64_t(stats.memory_usage));
+        db.pushKV("block_cache_size", uint64_t(stats.block_cache_size));
+        db.pushKV("block_cache_usage", uint64_t(stats.block_cache_usage));
+        db.pushKV("write_batch", DBOpStatsToJSON(stats.write_batch, /*lookup=*/false));
+        db.pushKV("lookups", std::move(lookups));
+        result.pushKV(fs::PathToString(name), std::move(db));
+    }
+    return result;
+},
+    };
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (unsigned int i = 0; i < cats.size(); ++i) {
@@ -417,6 +545,7 @@ static RPCHelpMan getindexinfo()
 void RegisterNodeRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
+        {"control", &getdbstats},
         {"control", &getmemoryinfo},
         {"control", &logging},
         {"util", &getindexinfo},
@@ -440,6 +440,102 @@ static RPCHelpMan getrawtransaction()
     };
 }
 
+/** The most transactions getrawtransactions looks up in one call. */
+static constexpr size_t MAX_GETRAWTRANSACTIONS_TXIDS{1000};
+
+static RPCHelpMan getrawtransactions()
+{
+    return RPCHelpMan{
+                "getrawtransactions",
+                "\nReturns many transactions at once, from the mempool or, if -txindex is enabled, any block.\n"
+                "This reads the transaction index and the blocks the transactions are in once for all of them,\n"
+                "rather than once for each transaction as repeated calls to getrawtransaction do.\n",
+                {
+                    {"txids", RPCArg::Type::ARR, RPCArg::Optional::NO, strprintf("The transaction ids, at most %d", MAX_GETRAWTRANSACTIONS_TXIDS),
+                        {
+                            {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "A transaction id"},
+                        },
+                    },
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "The transactions, in the order asked for",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction id asked for"},
+                            {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "The hash of the block the transaction is in, omitted for mempool transactions"},
+                            {RPCResult::Type::STR_HEX, "hex", /*optional=*/true, "The serialized, hex-encoded transaction, omitted if it was not found"},
+                            {RPCResult::Type::STR, "error", /*optional=*/true, "Why the transaction was not found, as getrawtransaction would report it"},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getrawtransactions", "'[\"mytxid\",\"myothertxid\"]'")
+            + HelpExampleRpc("getrawtransactions", "[\"mytxid\",\"myothertxid\"]")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const NodeContext& node = EnsureAnyNodeContext(request.context);
+    const CTxMemPool* mempool{node.mempool.get()};
+
+    const UniValue& txids_param{request.params[0].get_array()};
+    if (txids_param.size() > MAX_GETRAWTRANSACTIONS_TXIDS) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Too many txids: %d, at most %d are allowed", txids_param.size(), MAX_GETRAWTRANSACTIONS_TXIDS));
+    }
+    std::vector<uint256> txids;
+    txids.reserve(txids_param.size());
+    for (size_t i = 0; i < txids_param.size(); ++i) {
+        txids.push_back(ParseHashV(txids_param[i], strprintf("txids[%d]", i)));
+    }
+
+    std::vector<uint256> block_hashes(txids.size());
+    std::vector<CTransactionRef> txs(txids.size());
+    std::vector<uint256> index_txids;
+    std::vector<size_t> index_positions;
+    for (size_t i = 0; i < txids.size(); ++i) {
+        if (mempool) txs[i] = mempool->get(txids[i]);
+        if (!txs[i]) {
+            index_txids.push_back(txids[i]);
+            index_positions.push_back(i);
+        }
+    }
+    bool f_txindex_ready = false;
+    if (g_txindex && !index_txids.empty()) {
+        f_txindex_ready = g_txindex->BlockUntilSyncedToCurrentChain();
+        std::vector<uint256> index_block_hashes;
+        std::vector<CTransactionRef> index_txs;
+        g_txindex->FindTxs(index_txids, index_block_hashes, index_txs);
+        for (size_t j = 0; j < index_positions.size(); ++j) {
+            block_hashes[index_positions[j]] = index_block_hashes[j];
+            txs[index_positions[j]] = std::move(index_txs[j]);
+        }
+    }
+
+    UniValue result(UniValue::VARR);
+    for (size_t i = 0; i < txids.size(); ++i) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("txid", txids[i].GetHex());
+        if (txs[i]) {
+            if (!block_hashes[i].IsNull()) entry.pushKV("blockhash", block_hashes[i].GetHex());
+            entry.pushKV("hex", EncodeHexTx(*txs[i]));
+        } else {
+            std::string errmsg;
+            if (!g_txindex) {
+                errmsg = "No such mempool transaction. Use -txindex or provide a block hash to enable blockchain transaction queries";
+            } else if (!f_txindex_ready) {
+                errmsg = "No such mempool transaction. Blockchain transactions are still in the process of being indexed";
+            } else {
+                errmsg = "No such mempool or blockchain transaction";
+            }
+            entry.pushKV("error", errmsg + ". Use gettransaction for wallet transactions.");
+        }
+        result.push_back(std::move(entry));
+    }
+    return result;
+},
+    };
+}
+
 static RPCHelpMan createrawtransaction()
 {
     return RPCHelpMan{"createrawtransaction",
@@ -1939,6 +2035,7 @@ void RegisterRawTransactionRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"rawtransactions", &getrawtransaction},
+        {"rawtransactions", &getrawtransactions},
         {"rawtransactions", &createrawtransaction},
         {"rawtransactions", &decoderawtransaction},
         {"rawtransactions", &decodescript},
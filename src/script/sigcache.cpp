@@ -25,9 +25,7 @@
 #include <cuckoocache.h>
 
 #include <algorithm>
-#include <mutex>
 #include <optional>
-#include <shared_mutex>
 #include <vector>
 
 namespace {
@@ -42,9 +40,8 @@ private:
      //! Entries are SHA256(nonce || 'E' or 'S' || 31 zero bytes || signature hash || public key || signature):
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    typedef CuckooCache::sharded_cache<uint256, SignatureCacheHasher, VALIDATION_CACHE_SHARD_BITS> map_type;
     map_type setValid;
-    std::shared_mutex cs_sigcache;
 
 public:
     CSignatureCache()
@@ -79,19 +76,21 @@ public:
     bool
     Get(const uint256& entry, const bool erase)
     {
-        std::shared_lock<std::shared_mutex> lock(cs_sigcache);
         return setValid.contains(entry, erase);
     }
 
     void Set(const uint256& entry)
     {
-        std::unique_lock<std::shared_mutex> lock(cs_sigcache);
         setValid.insert(entry);
     }
     std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t n)
     {
         return setValid.setup_bytes(n);
     }
+    CuckooCache::cache_stats stats() const
+    {
+        return setValid.stats();
+    }
 };
 
 /* In previous versions of this code, signatureCache was a local static variable
@@ -116,6 +115,11 @@ bool InitSignatureCache(size_t max_size_bytes)
     return true;
 }
 
+CuckooCache::cache_stats GetSignatureCacheStats()
+{
+    return signatureCache.stats();
+}
+
 bool CachingTransactionSignatureChecker::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
@@ -134,6 +138,11 @@ bool CachingTransactionSignatureChecker::VerifySchnorrSignature(Span<const unsig
     uint256 entry;
     signatureCache.ComputeEntrySchnorr(entry, sighash, sig, pubkey);
     if (signatureCache.Get(entry, !store)) return true;
+    if (m_batch) {
+        // Deferred signatures are not stored, as they are not verified yet.
+        m_batch->Add(pubkey, sighash, sig);
+        return true;
+    }
     if (!TransactionSignatureChecker::VerifySchnorrSignature(sig, pubkey, sighash)) return false;
     if (store) signatureCache.Set(entry);
     return true;
@@ -17,6 +17,7 @@
 #ifndef FREICOIN_SCRIPT_SIGCACHE_H
 #define FREICOIN_SCRIPT_SIGCACHE_H
 
+#include <cuckoocache.h>
 #include <script/interpreter.h>
 #include <span.h>
 #include <util/hasher.h>
@@ -29,15 +30,24 @@
 // more (~32.25 MiB)
 static constexpr size_t DEFAULT_MAX_SIG_CACHE_BYTES{32 << 20};
 
+// The signature and script execution caches are each split into this many
+// (as a power of two) independently locked shards, so that script checks
+// running in parallel rarely wait on each other's cache inserts.
+static constexpr uint8_t VALIDATION_CACHE_SHARD_BITS{5};
+
 class CPubKey;
+class SchnorrBatch;
 
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    //! If set, Schnorr signatures missing from the cache are added to this
+    //! batch and reported as valid; the caller must verify the batch.
+    SchnorrBatch* m_batch;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, int64_t refheightIn, bool storeIn, PrecomputedTransactionData& txdataIn, TxSigCheckOpt opts = TxSigCheckOpt::NONE) : TransactionSignatureChecker(txToIn, nInIn, amountIn, refheightIn, txdataIn, MissingDataBehavior::ASSERT_FAIL, opts), store(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, int64_t refheightIn, bool storeIn, PrecomputedTransactionData& txdataIn, TxSigCheckOpt opts = TxSigCheckOpt::NONE, SchnorrBatch* batch = nullptr) : TransactionSignatureChecker(txToIn, nInIn, amountIn, refheightIn, txdataIn, MissingDataBehavior::ASSERT_FAIL, opts), store(storeIn), m_batch(batch) {}
 
     bool VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
     bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override;
@@ -45,4 +55,6 @@ public:
 
 [[nodiscard]] bool InitSignatureCache(size_t max_size_bytes);
 
+CuckooCache::cache_stats GetSignatureCacheStats();
+
 #endif // FREICOIN_SCRIPT_SIGCACHE_H
@@ -183,6 +183,33 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify(
     const secp256k1_xonly_pubkey *pubkey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(5);
 
+/** Verify a batch of Schnorr signatures on 32-byte messages.
+ *
+ *  All signatures are checked together with a multi-scalar multiplication,
+ *  which is considerably faster than verifying them one by one. The result
+ *  only says whether every signature is valid; to find an invalid one, verify
+ *  them separately with secp256k1_schnorrsig_verify.
+ *
+ *  Returns: 1: all signatures are correct (also when n_sigs is 0)
+ *           0: at least one signature is incorrect
+ *  Args:    ctx: a secp256k1 context object.
+ *       scratch: scratch space for the multi-scalar multiplication. Can be
+ *                NULL, in which case the batch is verified correctly but no
+ *                faster than separately.
+ *  In:    sig64: array of pointers to the 64-byte signatures to verify.
+ *         msg32: array of pointers to the 32-byte messages being verified.
+ *       pubkeys: array of pointers to the x-only public keys to verify with.
+ *        n_sigs: the number of signatures, messages and public keys.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify_batch(
+    const secp256k1_context *ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char * const *sig64,
+    const unsigned char * const *msg32,
+    const secp256k1_xonly_pubkey * const *pubkeys,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1);
+
 #ifdef __cplusplus
 }
 #endif
@@ -276,4 +276,126 @@ int secp256k1_schnorrsig_verify(const secp256k1_context* ctx, const unsigned cha
            secp256k1_fe_equal(&rx, &r.x);
 }
 
+typedef struct {
+    const secp256k1_context *ctx;
+    const unsigned char * const *sig64;
+    const unsigned char * const *msg32;
+    const secp256k1_xonly_pubkey * const *pubkeys;
+    unsigned char seed[32];
+} secp256k1_schnorrsig_batch_data;
+
+static const unsigned char bip340_batch_tag[13] = "BIP0340/batch";
+
+/* Derives the randomizer of the idx'th signature from the hash of the whole
+ * batch. The first signature's randomizer is 1. */
+static void secp256k1_schnorrsig_batch_randomizer(secp256k1_scalar *a, const unsigned char *seed32, size_t idx) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+    unsigned char idx8[8];
+    int i;
+
+    if (idx == 0) {
+        secp256k1_scalar_set_int(a, 1);
+        return;
+    }
+    for (i = 0; i < 8; i++) {
+        idx8[i] = (unsigned char)(((uint64_t)idx) >> (8 * i));
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, idx8, sizeof(idx8));
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(a, buf, NULL);
+}
+
+/* Provides the points of the multi-scalar multiplication on demand, so that
+ * they need not all be held in memory: point 2*i is R_i with scalar -a_i, and
+ * point 2*i+1 is P_i with scalar -a_i*e_i. */
+static int secp256k1_schnorrsig_batch_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_schnorrsig_batch_data *batch = (const secp256k1_schnorrsig_batch_data *)data;
+    const size_t i = idx / 2;
+    const unsigned char *sig = batch->sig64[i];
+    secp256k1_scalar a;
+
+    secp256k1_schnorrsig_batch_randomizer(&a, batch->seed, i);
+    if (idx % 2 == 0) {
+        secp256k1_fe rx;
+        if (!secp256k1_fe_set_b32_limit(&rx, &sig[0])) {
+            return 0;
+        }
+        if (!secp256k1_ge_set_xo_var(pt, &rx, 0)) {
+            return 0;
+        }
+        secp256k1_scalar_negate(sc, &a);
+    } else {
+        secp256k1_scalar e;
+        unsigned char buf[32];
+        if (!secp256k1_xonly_pubkey_load(batch->ctx, pt, batch->pubkeys[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pt->x);
+        secp256k1_schnorrsig_challenge(&e, &sig[0], batch->msg32[i], 32, buf);
+        secp256k1_scalar_mul(&e, &e, &a);
+        secp256k1_scalar_negate(sc, &e);
+    }
+    return 1;
+}
+
+int secp256k1_schnorrsig_verify_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, const unsigned char * const *sig64, const unsigned char * const *msg32, const secp256k1_xonly_pubkey * const *pubkeys, size_t n_sigs) {
+    secp256k1_schnorrsig_batch_data data;
+    secp256k1_sha256 sha;
+    secp256k1_scalar s_sum;
+    secp256k1_gej r;
+    secp256k1_ge pk;
+    unsigned char buf[32];
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(n_sigs == 0 || sig64 != NULL);
+    ARG_CHECK(n_sigs == 0 || msg32 != NULL);
+    ARG_CHECK(n_sigs == 0 || pubkeys != NULL);
+
+    /* The randomizers are derived from a hash of everything in the batch, so
+     * that they cannot be anticipated by whoever chose the signatures. */
+    secp256k1_sha256_initialize_tagged(&sha, bip340_batch_tag, sizeof(bip340_batch_tag));
+    for (i = 0; i < n_sigs; i++) {
+        ARG_CHECK(sig64[i] != NULL);
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pubkeys[i] != NULL);
+        if (!secp256k1_xonly_pubkey_load(ctx, &pk, pubkeys[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pk.x);
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_sha256_write(&sha, msg32[i], 32);
+        secp256k1_sha256_write(&sha, buf, 32);
+    }
+    secp256k1_sha256_finalize(&sha, data.seed);
+    data.ctx = ctx;
+    data.sig64 = sig64;
+    data.msg32 = msg32;
+    data.pubkeys = pubkeys;
+
+    /* Check that sum(a_i*s_i)*G - sum(a_i*R_i) - sum(a_i*e_i*P_i) is the
+     * point at infinity. */
+    secp256k1_scalar_set_int(&s_sum, 0);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_scalar a, s;
+        int overflow;
+
+        secp256k1_scalar_set_b32(&s, &sig64[i][32], &overflow);
+        if (overflow) {
+            return 0;
+        }
+        secp256k1_schnorrsig_batch_randomizer(&a, data.seed, i);
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&s_sum, &s_sum, &s);
+    }
+    if (!secp256k1_ecmult_multi_var(&ctx->error_callback, scratch, &r, &s_sum, secp256k1_schnorrsig_batch_callback, &data, 2 * n_sigs)) {
+        return 0;
+    }
+
+    return secp256k1_gej_is_infinity(&r);
+}
+
 #endif
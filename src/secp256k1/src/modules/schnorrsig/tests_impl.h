@@ -862,12 +862,15 @@ static void test_schnorrsig_sign(void) {
 
 #define N_SIGS 3
 /* Creates N_SIGS valid signatures and verifies them with verify and
- * verify_batch (TODO). Then flips some bits and checks that verification now
+ * verify_batch. Then flips some bits and checks that verification now
  * fails. */
 static void test_schnorrsig_sign_verify(void) {
     unsigned char sk[32];
     unsigned char msg[N_SIGS][32];
     unsigned char sig[N_SIGS][64];
+    const unsigned char *sig_ptr[N_SIGS];
+    const unsigned char *msg_ptr[N_SIGS];
+    const secp256k1_xonly_pubkey *pk_ptr[N_SIGS];
     size_t i;
     secp256k1_keypair keypair;
     secp256k1_xonly_pubkey pk;
@@ -881,30 +884,38 @@ static void test_schnorrsig_sign_verify(void) {
         secp256k1_testrand256(msg[i]);
         CHECK(secp256k1_schnorrsig_sign32(CTX, sig[i], msg[i], &keypair, NULL));
         CHECK(secp256k1_schnorrsig_verify(CTX, sig[i], msg[i], sizeof(msg[i]), &pk));
+        sig_ptr[i] = sig[i];
+        msg_ptr[i] = msg[i];
+        pk_ptr[i] = &pk;
     }
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
 
     {
         /* Flip a few bits in the signature and in the message and check that
-         * verify and verify_batch (TODO) fail */
+         * verify and verify_batch fail */
         size_t sig_idx = secp256k1_testrand_int(N_SIGS);
         size_t byte_idx = secp256k1_testrand_bits(5);
         unsigned char xorbyte = secp256k1_testrand_int(254)+1;
         sig[sig_idx][byte_idx] ^= xorbyte;
         CHECK(!secp256k1_schnorrsig_verify(CTX, sig[sig_idx], msg[sig_idx], sizeof(msg[sig_idx]), &pk));
+        CHECK(!secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
         sig[sig_idx][byte_idx] ^= xorbyte;
 
         byte_idx = secp256k1_testrand_bits(5);
         sig[sig_idx][32+byte_idx] ^= xorbyte;
         CHECK(!secp256k1_schnorrsig_verify(CTX, sig[sig_idx], msg[sig_idx], sizeof(msg[sig_idx]), &pk));
+        CHECK(!secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
         sig[sig_idx][32+byte_idx] ^= xorbyte;
 
         byte_idx = secp256k1_testrand_bits(5);
         msg[sig_idx][byte_idx] ^= xorbyte;
         CHECK(!secp256k1_schnorrsig_verify(CTX, sig[sig_idx], msg[sig_idx], sizeof(msg[sig_idx]), &pk));
+        CHECK(!secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
         msg[sig_idx][byte_idx] ^= xorbyte;
 
         /* Check that above bitflips have been reversed correctly */
         CHECK(secp256k1_schnorrsig_verify(CTX, sig[sig_idx], msg[sig_idx], sizeof(msg[sig_idx]), &pk));
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
     }
 
     /* Test overflowing s */
@@ -941,6 +952,59 @@ static void test_schnorrsig_sign_verify(void) {
 }
 #undef N_SIGS
 
+/* Checks batch verification of signatures under different keys, with scratch
+ * space too small for a single multi-scalar multiplication, and without any. */
+#define N_SIGS 67
+static void test_schnorrsig_verify_batch(void) {
+    unsigned char sk[32];
+    unsigned char msg[N_SIGS][32];
+    unsigned char sig[N_SIGS][64];
+    secp256k1_xonly_pubkey pk[N_SIGS];
+    const unsigned char *sig_ptr[N_SIGS];
+    const unsigned char *msg_ptr[N_SIGS];
+    const secp256k1_xonly_pubkey *pk_ptr[N_SIGS];
+    secp256k1_keypair keypair;
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(CTX, 16 * 1024);
+    size_t i, sig_idx;
+
+    for (i = 0; i < N_SIGS; i++) {
+        secp256k1_testrand256(sk);
+        secp256k1_testrand256(msg[i]);
+        CHECK(secp256k1_keypair_create(CTX, &keypair, sk));
+        CHECK(secp256k1_keypair_xonly_pub(CTX, &pk[i], NULL, &keypair));
+        CHECK(secp256k1_schnorrsig_sign32(CTX, sig[i], msg[i], &keypair, NULL));
+        sig_ptr[i] = sig[i];
+        msg_ptr[i] = msg[i];
+        pk_ptr[i] = &pk[i];
+    }
+
+    /* An empty batch is valid. */
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, NULL, NULL, NULL, 0));
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, 1));
+
+    /* A signature checked against the wrong key invalidates the batch,
+     * wherever it falls in it. */
+    sig_idx = secp256k1_testrand_int(N_SIGS);
+    pk_ptr[sig_idx] = &pk[(sig_idx + 1) % N_SIGS];
+    CHECK(!secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
+    CHECK(!secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
+    pk_ptr[sig_idx] = &pk[sig_idx];
+
+    /* So does swapping the s values of two signatures, even though the sum
+     * of the s values is unchanged. */
+    for (i = 32; i < 64; i++) {
+        unsigned char tmp = sig[0][i];
+        sig[0][i] = sig[N_SIGS - 1][i];
+        sig[N_SIGS - 1][i] = tmp;
+    }
+    CHECK(!secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS));
+
+    secp256k1_scratch_space_destroy(CTX, scratch);
+}
+#undef N_SIGS
+
 static void test_schnorrsig_taproot(void) {
     unsigned char sk[32];
     secp256k1_keypair keypair;
@@ -988,6 +1052,7 @@ static void run_schnorrsig_tests(void) {
         test_schnorrsig_sign();
         test_schnorrsig_sign_verify();
     }
+    test_schnorrsig_verify_batch();
     test_schnorrsig_taproot();
 }
 
@@ -4,6 +4,7 @@
 
 #include <stratum.h>
 
+#include <arith_uint256.h>
 #include <base58.h>
 #include <chainparams.h>
 #include <chainparamsbase.h>
@@ -14,6 +15,7 @@
 #include <crypto/sha256.h>
 #include <deploymentstatus.h>
 #include <httpserver.h>
+#include <kernel/mempool_entry.h>
 #include <key_io.h>
 #include <logging.h>
 #include <netbase.h>
@@ -32,16 +34,28 @@
 #include <uint256.h>
 #include <util/check.h>
 #include <util/hash_type.h> // for BaseHash
+#include <util/moneystr.h>
 #include <util/strencodings.h>
+#include <util/threadnames.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <wallet/miner.h>
 
 #include <univalue.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <bitset>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 #include <boost/algorithm/string.hpp> // for boost::trim
@@ -92,9 +106,15 @@ struct JobId : public std::array<unsigned char, 8> {
 };
 
 struct StratumClient {
+    //! Guards the mutable state of the client.  Each connection has its own
+    //! lock, so that messages from different miners can be processed in
+    //! parallel by the stratum event loop threads.
+    mutable Mutex m_mutex;
+
     //! The return socket used to communicate with the client.
     evutil_socket_t m_socket;
-    //! The libevent event buffer used to send and receive messages.
+    //! The libevent event buffer used to send and receive messages, or
+    //! nullptr once the connection has been closed.
     bufferevent* m_bev;
     //! The return address of the client.
     CService m_from;
@@ -128,6 +148,26 @@ struct StratumClient {
     //! The minimum difficulty the client is willing to work on.
     double m_mindiff;
 
+    //! The difficulty of the work most recently sent to the client, and of
+    //! the work sent before that, which may still be in progress.
+    double m_last_diff;
+    double m_prev_diff;
+    //! The share difficulty chosen by the vardiff controller, or zero if it
+    //! has not yet been adjusted.  See UpdateVarDiff().
+    double m_vardiff;
+    //! The start of the current vardiff retarget period, and the number of
+    //! shares accepted since then.
+    int64_t m_vardiff_start_time;
+    unsigned int m_vardiff_shares;
+
+    //! Number of shares accepted, submitted for work on a previous block, or
+    //! rejected as invalid or below the required difficulty.
+    uint64_t m_shares_accepted;
+    uint64_t m_shares_stale;
+    uint64_t m_shares_rejected;
+    //! Recently accepted shares, for estimating the client's hashrate.
+    ShareLog<128> m_share_log;
+
     //! The bits reserved for the client's use in AsicBoost.
     uint32_t m_version_rolling_mask;
 
@@ -148,8 +188,7 @@ struct StratumClient {
     //! Whether the client supports the "mining.set_extranonce" message.
     bool m_supports_extranonce;
 
-    StratumClient() : m_socket(0), m_bev(0), m_connect_time(GetTime()), m_last_recv_time(0), m_last_work_time(0), m_last_submit_time(0), m_nextid(0), m_subscribed(false), m_authorized(false), m_mindiff(0.0), m_version_rolling_mask(0x00000000), m_last_tip(0), m_second_stage(false), m_send_work(false), m_supports_aux(false), m_supports_extranonce(false) { GenSecret(); }
-    StratumClient(evutil_socket_t socket, bufferevent* bev, CService from) : m_socket(socket), m_bev(bev), m_from(from), m_connect_time(GetTime()), m_last_recv_time(0), m_last_work_time(0), m_last_submit_time(0), m_nextid(0), m_subscribed(false), m_authorized(false), m_mindiff(0.0), m_version_rolling_mask(0x00000000), m_last_tip(0), m_second_stage(false), m_send_work(false), m_supports_aux(false), m_supports_extranonce(false) { GenSecret(); }
+    StratumClient(evutil_socket_t socket, bufferevent* bev, CService from) : m_socket(socket), m_bev(bev), m_from(from), m_connect_time(GetTime()), m_last_recv_time(0), m_last_work_time(0), m_last_submit_time(0), m_nextid(0), m_subscribed(false), m_authorized(false), m_mindiff(0.0), m_last_diff(0.0), m_prev_diff(0.0), m_vardiff(0.0), m_vardiff_start_time(0), m_vardiff_shares(0), m_shares_accepted(0), m_shares_stale(0), m_shares_rejected(0), m_version_rolling_mask(0x00000000), m_last_tip(0), m_second_stage(false), m_send_work(false), m_supports_aux(false), m_supports_extranonce(false) { GenSecret(); }
 
     //! Generate a new random secret for this client.
     void GenSecret();
@@ -194,12 +233,40 @@ struct StratumWork {
     //! Whether the block template uses segwit.
     bool m_is_witness_enabled;
 
+    // The serialization of the block-final transaction is split around its
+    // segwit commitment, so that the transaction's hash can be computed for
+    // any commitment by hashing only the last few SHA-256 blocks.  The hasher
+    // has already consumed everything which precedes the commitment.
+    CSHA256 m_bf_prefix_hasher;
+    std::vector<unsigned char> m_bf_suffix;
+
+    // The segwit commitment depends on the customized coinbase only after
+    // its scriptSig and nSequence are cleared, i.e. on the payout address
+    // but not on the extranonce.  The resulting witness root and right-branch
+    // hash are cached by the hash of that stripped coinbase, so that repeated
+    // work units and shares for the same payout address skip recomputing
+    // them.
+    static constexpr size_t MAX_COMMITMENT_CACHE_SIZE = 4096;
+    mutable Mutex m_commitment_cache_mutex;
+    mutable std::map<uint256, std::pair<uint256, uint256>> m_commitment_cache GUARDED_BY(m_commitment_cache_mutex);
+
     // The cached 2nd-stage auxiliary hash value, if an auxiliary proof-of-work
     // solution has been found.
     std::optional<uint256> m_aux_hash2;
 
     StratumWork() : m_is_witness_enabled(false) {};
     StratumWork(const CTxDestination& coinbase_dest, const node::CBlockTemplate& block_template, bool is_witness_enabled);
+    //! Copies the work template, but not its commitment cache.
+    StratumWork(const StratumWork& other);
+    StratumWork& operator=(const StratumWork&) = delete;
+
+    //! Returns the hash of the template's block-final transaction, with the
+    //! given witness root placed in its segwit commitment.
+    uint256 GetBlockFinalHash(const uint256& witnessroot) const;
+
+    //! Replaces the template's coinbase and, if bf is not null, block-final
+    //! transaction, and updates the block's Merkle root to match.
+    void ReplaceTransactions(CTransactionRef cb, CTransactionRef bf);
 
     //! A more ergonomic way to access the block template.
     CBlock& GetBlock()
@@ -226,7 +293,13 @@ StratumWork::StratumWork(const CTxDestination& coinbase_dest, const node::CBlock
     for (const auto& tx : m_block_template.block.vtx) {
         leaves.push_back(tx->GetHash());
     }
-    m_cb_branch = ComputeMerkleBranch(leaves, 0);
+    // The block assembler provides the template's Merkle tree, which is
+    // kept up to date as the coinbase and block-final transactions change.
+    CachedMerkleTree& tree = m_block_template.tx_merkle_tree;
+    if (tree.size() != leaves.size()) {
+        tree = CachedMerkleTree(leaves);
+    }
+    m_cb_branch = tree.GetBranch(0);
     // If segwit is not active, we're done.  Otherwise...
     if (m_is_witness_enabled) {
         // The final hash in m_cb_branch is the right-hand branch from
@@ -238,7 +311,7 @@ StratumWork::StratumWork(const CTxDestination& coinbase_dest, const node::CBlock
         // hash won't be known ahead of time because it depends on the
         // contents of the coinbase (which depends on both the miner's
         // payout address and the specific extranonce2 used).
-        m_bf_branch = ComputeStableMerkleBranch(leaves, leaves.size()-1).first;
+        m_bf_branch = tree.GetStableBranch(leaves.size()-1).first;
         m_bf_branch.pop_back();
         // To calculate the segwit commitment for the block-final tx,
         // we use a proof from the coinbase's position of the witness
@@ -253,28 +326,109 @@ StratumWork::StratumWork(const CTxDestination& coinbase_dest, const node::CBlock
         }
         std::fill_n(&scriptPubKey[scriptPubKey.size()-37], 33, 0x00);
         leaves.back() = bf.GetHash();
-        m_cb_wit_branch = ComputeFastMerkleBranch(leaves, 0).first;
+        m_cb_wit_branch = CachedMerkleTree(leaves, CachedMerkleTree::Type::FAST).GetBranch(0);
+        // Without witness data, the transaction outputs are the last thing
+        // serialized before the lock-time fields, so the commitment starts
+        // 37 bytes before the end of the serialized outputs.
+        DataStream prefix{};
+        prefix << bf.nVersion << bf.vin << bf.vout;
+        DataStream full{};
+        full << TX_NO_WITNESS(CTransaction(bf));
+        const size_t commit_pos = prefix.size() - 37;
+        m_bf_prefix_hasher.Write(UCharCast(full.data()), commit_pos);
+        m_bf_suffix.assign(UCharCast(full.data()) + commit_pos + 33, UCharCast(full.data()) + full.size());
+        // Make sure the split was done correctly, with a non-zero commitment.
+        const uint256 check_root = leaves.back();
+        std::copy(check_root.begin(), check_root.end(), &scriptPubKey[scriptPubKey.size()-36]);
+        scriptPubKey[scriptPubKey.size()-37] = 0x01;
+        if (GetBlockFinalHash(check_root) != bf.GetHash()) {
+            throw std::runtime_error("Unable to locate segwit commitment within serialized block-final transaction.");
+        }
     }
 };
 
-void UpdateSegwitCommitment(const ChainstateManager& chainman, const StratumWork& current_work, CMutableTransaction& cb, CMutableTransaction& bf, std::vector<uint256>& cb_branch)
+StratumWork::StratumWork(const StratumWork& other)
+    : m_coinbase_dest(other.m_coinbase_dest)
+    , m_block_template(other.m_block_template)
+    , m_cb_wit_branch(other.m_cb_wit_branch)
+    , m_bf_branch(other.m_bf_branch)
+    , m_cb_branch(other.m_cb_branch)
+    , m_is_witness_enabled(other.m_is_witness_enabled)
+    , m_bf_prefix_hasher(other.m_bf_prefix_hasher)
+    , m_bf_suffix(other.m_bf_suffix)
+    , m_aux_hash2(other.m_aux_hash2)
+{
+}
+
+void StratumWork::ReplaceTransactions(CTransactionRef cb, CTransactionRef bf)
+{
+    CBlock& block = GetBlock();
+    CachedMerkleTree& tree = m_block_template.tx_merkle_tree;
+    tree.SetLeaf(0, cb->GetHash());
+    block.vtx[0] = std::move(cb);
+    if (bf) {
+        tree.SetLeaf(block.vtx.size() - 1, bf->GetHash());
+        block.vtx.back() = std::move(bf);
+    }
+    block.hashMerkleRoot = tree.GetRoot();
+}
+
+uint256 StratumWork::GetBlockFinalHash(const uint256& witnessroot) const
+{
+    static const unsigned char marker = 0x01;
+    uint256 hash;
+    CSHA256(m_bf_prefix_hasher)
+        .Write(&marker, 1)
+        .Write(witnessroot.begin(), 32)
+        .Write(m_bf_suffix.data(), m_bf_suffix.size())
+        .Finalize(hash.begin());
+    CSHA256()
+        .Write(hash.begin(), 32)
+        .Finalize(hash.begin());
+    return hash;
+}
+
+void UpdateSegwitCommitment(const ChainstateManager& chainman, const StratumWork& current_work, CMutableTransaction& cb, CMutableTransaction* bf, std::vector<uint256>& cb_branch)
 {
-    // Calculate witnessroot
+    // The commitment doesn't depend on the extranonce.
     CMutableTransaction cb2(cb);
     cb2.vin[0].scriptSig = CScript();
     cb2.vin[0].nSequence = 0;
-    auto witnessroot = ComputeFastMerkleRootFromBranch(cb2.GetHash(), current_work.m_cb_wit_branch, 0, nullptr);
-
-    // Build block-final tx
-    CScript& scriptPubKey = bf.vout.back().scriptPubKey;
-    scriptPubKey[scriptPubKey.size()-37] = 0x01;
-    std::copy(witnessroot.begin(),
-              witnessroot.end(),
-              &scriptPubKey[scriptPubKey.size()-36]);
-
-    // Calculate right-branch
-    auto pathmask = ComputeMerklePathAndMask(current_work.m_bf_branch.size() + 1, current_work.GetBlock().vtx.size() - 1);
-    cb_branch.push_back(ComputeStableMerkleRootFromBranch(bf.GetHash(), current_work.m_bf_branch, pathmask.first, pathmask.second, nullptr));
+    const uint256 cb2_hash = cb2.GetHash();
+
+    std::optional<std::pair<uint256, uint256>> commitment;
+    {
+        LOCK(current_work.m_commitment_cache_mutex);
+        auto it = current_work.m_commitment_cache.find(cb2_hash);
+        if (it != current_work.m_commitment_cache.end()) {
+            commitment = it->second;
+        }
+    }
+    if (!commitment) {
+        // Calculate witnessroot
+        auto witnessroot = ComputeFastMerkleRootFromBranch(cb2_hash, current_work.m_cb_wit_branch, 0, nullptr);
+
+        // Calculate right-branch
+        auto pathmask = ComputeMerklePathAndMask(current_work.m_bf_branch.size() + 1, current_work.GetBlock().vtx.size() - 1);
+        auto rightbranch = ComputeStableMerkleRootFromBranch(current_work.GetBlockFinalHash(witnessroot), current_work.m_bf_branch, pathmask.first, pathmask.second, nullptr);
+
+        commitment = std::make_pair(witnessroot, rightbranch);
+        LOCK(current_work.m_commitment_cache_mutex);
+        if (current_work.m_commitment_cache.size() < StratumWork::MAX_COMMITMENT_CACHE_SIZE) {
+            current_work.m_commitment_cache.emplace(cb2_hash, *commitment);
+        }
+    }
+    cb_branch.push_back(commitment->second);
+
+    // Build block-final tx, if the caller needs it
+    if (bf) {
+        *bf = CMutableTransaction(*current_work.GetBlock().vtx.back());
+        CScript& scriptPubKey = bf->vout.back().scriptPubKey;
+        scriptPubKey[scriptPubKey.size()-37] = 0x01;
+        std::copy(commitment->first.begin(),
+                  commitment->first.end(),
+                  &scriptPubKey[scriptPubKey.size()-36]);
+    }
 }
 
 //! The default address to use for mining rewards if no address is provided.
@@ -282,16 +436,41 @@ void UpdateSegwitCommitment(const ChainstateManager& chainman, const StratumWork
 static CTxDestination g_default_mining_address;
 
 //! The minimum difficulty to use for mining, for DoS protection.  This is
-//! configurable via the -miningmindifficulty option.  As of late 2023, reasonable
+//! configurable via the -miningmindiff option.  As of late 2023, reasonable
 //! values for this are ~1000 for ASIC mining hardware, and ~0.001 for CPU
 //! miners (used primarily for testing).
 static double g_min_difficulty = DEFAULT_MINING_DIFFICULTY;
 
+//! The target number of seconds between shares from each client, used by
+//! the vardiff controller, or zero to disable variable difficulty.  This is
+//! configurable via the -stratumshareinterval option.
+static int64_t g_share_interval = DEFAULT_STRATUM_SHARE_INTERVAL;
+
+//! The vardiff controller retargets after this many shares, or after this
+//! many share intervals have elapsed, whichever comes first.  A single
+//! retarget changes the difficulty by at most VARDIFF_MAX_ADJUSTMENT.
+static constexpr unsigned int VARDIFF_RETARGET_SHARES = 20;
+static constexpr int64_t VARDIFF_RETARGET_INTERVALS = 6;
+static constexpr double VARDIFF_MAX_ADJUSTMENT = 4.0;
+
+//! The period over which hashrate is estimated, in seconds.
+static constexpr int64_t HASHRATE_WINDOW = 600;
+
+//! Share statistics for the server as a whole.  These are updated by the
+//! event loop threads servicing each connection, and so are lock-free.
+static std::atomic<uint64_t> g_shares_accepted{0};
+static std::atomic<uint64_t> g_shares_stale{0};
+static std::atomic<uint64_t> g_shares_rejected{0};
+static ShareLog<4096> g_share_log;
+
 //! The time at which the statum server started, used to calculate uptime.
 static int64_t g_start_time = 0;
 
-//! Critical seciton guarding access to any of the stratum global state
-static RecursiveMutex cs_stratum;
+//! Critical section guarding the registry of stratum connections.  It is
+//! only held long enough to look up or modify the registry itself; the
+//! state of each connection is guarded by StratumClient::m_mutex.  When both
+//! are needed, cs_stratum must be acquired first.
+static Mutex cs_stratum;
 
 //! Reference to the NodeContext for the process
 static node::NodeContext* g_context;
@@ -303,17 +482,86 @@ static std::vector<CSubNet> stratum_allow_subnets;
 static std::map<evconnlistener*, CService> bound_listeners;
 
 //! Active miners connected to us
-static std::map<bufferevent*, StratumClient> subscriptions;
+static std::map<bufferevent*, std::shared_ptr<StratumClient>> subscriptions GUARDED_BY(cs_stratum);
+
+//! Event loops servicing stratum connections, each run by its own thread.
+//! Accepted connections are distributed among them round-robin.  Set once at
+//! startup and torn down at shutdown, so not protected by a lock.
+static std::vector<event_base*> g_stratum_event_bases;
+static std::vector<std::thread> g_stratum_event_threads;
+static std::atomic<size_t> g_stratum_next_event_base{0};
 
 //! Mapping of stratum method names -> handlers
 static std::map<std::string, std::function<UniValue(StratumClient&, const UniValue&)> > stratum_method_dispatch;
 
-//! A mapping of job_id -> work templates
-static std::map<JobId, StratumWork> work_templates;
+//! Critical section serializing updates to the work templates.  Readers do
+//! not need to acquire it; see work_templates.
+static Mutex cs_work;
+
+//! A mapping of job_id -> work templates.  Work templates are never modified
+//! once published.  Instead a modified copy of the mapping is built while
+//! holding cs_work and swapped in with std::atomic_store, so that share
+//! validation can look up its work template with std::atomic_load without
+//! blocking on other connections or on the generation of new work.
+using WorkTemplateMap = std::map<JobId, std::shared_ptr<const StratumWork>>;
+static std::shared_ptr<const WorkTemplateMap> work_templates;
 
 //! The job_id of the first work unit to have its auxiliary proof-of-work solved
 //! for the current block, or std::nullopt if no solution has been returned yet.
-static std::optional<JobId> half_solved_work;
+static std::optional<JobId> half_solved_work GUARDED_BY(cs_work);
+
+//! The chain tip the current work template was built on top of, the job_id
+//! of that template, and the mempool state and time at which it was built.
+static CBlockIndex* g_work_tip GUARDED_BY(cs_work) = nullptr;
+static JobId g_work_job_id GUARDED_BY(cs_work);
+static unsigned int g_work_transactions_updated_last GUARDED_BY(cs_work) = 0;
+static int64_t g_work_last_update_time GUARDED_BY(cs_work) = 0;
+
+//! Returns the published work template with the given job_id, or nullptr if
+//! there is none.
+static std::shared_ptr<const StratumWork> GetWorkTemplate(const JobId& job_id)
+{
+    const std::shared_ptr<const WorkTemplateMap> templates = std::atomic_load(&work_templates);
+    if (!templates) {
+        return nullptr;
+    }
+    auto it = templates->find(job_id);
+    if (it == templates->end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+//! Returns a copy of the currently published work templates, to be modified
+//! and then published with PublishWorkTemplates().
+static WorkTemplateMap CopyWorkTemplates() EXCLUSIVE_LOCKS_REQUIRED(cs_work)
+{
+    const std::shared_ptr<const WorkTemplateMap> templates = std::atomic_load(&work_templates);
+    return templates ? *templates : WorkTemplateMap{};
+}
+
+static void PublishWorkTemplates(WorkTemplateMap templates) EXCLUSIVE_LOCKS_REQUIRED(cs_work)
+{
+    std::atomic_store(&work_templates, std::shared_ptr<const WorkTemplateMap>(std::make_shared<WorkTemplateMap>(std::move(templates))));
+}
+
+//! Cache of serialized "mining.notify" messages, up to but not including the
+//! message id, keyed by job_id, payout address and the clean_jobs flag.  Used
+//! when sending the same work template to many clients at once.
+using NotifyFrameCache = std::map<std::tuple<JobId, CTxDestination, bool>, std::string>;
+
+//! Signals the block watcher thread that new work should be pushed to miners,
+//! either because the chain tip changed or because enough fees have entered
+//! the mempool since the last work template was built.
+static GlobalMutex g_work_push_mutex;
+static std::condition_variable g_work_push_cv;
+static bool g_work_push_new_tip GUARDED_BY(g_work_push_mutex) = false;
+static CAmount g_work_push_fee_delta GUARDED_BY(g_work_push_mutex) = 0;
+
+//! The amount of new transaction fees which must enter the mempool before
+//! updated work is pushed to miners, or zero to only push on new blocks.
+//! Set once at startup, so it doesn't need to be protected by a lock.
+static CAmount g_work_fee_delta_threshold = DEFAULT_STRATUM_WORK_FEE_DELTA;
 
 //! A thread to watch for new blocks and send mining notifications
 static std::thread block_watcher_thread;
@@ -369,14 +617,70 @@ uint256 ParseUInt256(const UniValue& hex, const std::string& name)
 
 static double ClampDifficulty(const StratumClient& client, double diff)
 {
+    const double block_diff = diff;
     if (client.m_mindiff > 0) {
         diff = client.m_mindiff;
     }
+    // The vardiff controller may raise the difficulty to reduce the rate at
+    // which shares are submitted, but never above the difficulty of the
+    // block itself, as that would cause valid blocks to be withheld.
+    if (client.m_vardiff > diff) {
+        diff = std::max(diff, std::min(client.m_vardiff, block_diff));
+    }
     diff = std::max(diff, g_min_difficulty);
     return diff;
 }
 
-static std::string GetExtraNonceRequest(StratumClient& client, const JobId& job_id) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+//! Returns the difficulty of a share with the given proof-of-work hash, on
+//! the same scale as ConvertBitsToDifficulty().
+static double GetShareDifficulty(const uint256& hash)
+{
+    static const arith_uint256 diff1 = arith_uint256().SetCompact(0x1d00ffff);
+    const arith_uint256 value = UintToArith256(hash);
+    if (value == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return diff1.getdouble() / value.getdouble();
+}
+
+/**
+ * Adjusts the client's share difficulty so that it submits shares once every
+ * g_share_interval seconds on average.  Called for each accepted share.  If
+ * the difficulty changes, new work is sent to the client.
+ */
+static void UpdateVarDiff(StratumClient& client, int64_t now) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
+{
+    if (g_share_interval <= 0 || client.m_last_diff <= 0.0) {
+        return;
+    }
+    if (!client.m_vardiff_start_time) {
+        client.m_vardiff_start_time = client.m_last_work_time;
+    }
+    ++client.m_vardiff_shares;
+    const int64_t elapsed = std::max<int64_t>(now - client.m_vardiff_start_time, 1);
+    if (client.m_vardiff_shares < VARDIFF_RETARGET_SHARES && elapsed < VARDIFF_RETARGET_INTERVALS * g_share_interval) {
+        return;
+    }
+    double adjustment = (double)client.m_vardiff_shares * g_share_interval / elapsed;
+    adjustment = std::clamp(adjustment, 1.0 / VARDIFF_MAX_ADJUSTMENT, VARDIFF_MAX_ADJUSTMENT);
+    const double vardiff = client.m_last_diff * adjustment;
+    client.m_vardiff_start_time = now;
+    client.m_vardiff_shares = 0;
+    // Ignore small adjustments, which would only cause extra work updates.
+    if (adjustment > 0.8 && adjustment < 1.25) {
+        return;
+    }
+    // If the difficulty was already held down by ClampDifficulty(), raising
+    // it further would have no effect.
+    if (adjustment > 1.0 && client.m_vardiff > client.m_last_diff) {
+        return;
+    }
+    LogPrint(BCLog::STRATUM, "Adjusting share difficulty for %s from %g to %g\n", client.GetPeer().ToStringAddrPort(), client.m_last_diff, vardiff);
+    client.m_vardiff = vardiff;
+    client.m_send_work = true;
+}
+
+static std::string GetExtraNonceRequest(StratumClient& client, const JobId& job_id) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     std::string ret;
     if (client.m_supports_extranonce) {
@@ -404,7 +708,7 @@ static std::string GetExtraNonceRequest(StratumClient& client, const JobId& job_
     return ret;
 }
 
-void CustomizeWork(const ChainstateManager& chainman, const StratumClient& client, const StratumWork& current_work, const CTxDestination& addr, const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2, CMutableTransaction& cb, CMutableTransaction& bf, std::vector<uint256>& cb_branch) {
+void CustomizeWork(const ChainstateManager& chainman, const StratumClient& client, const StratumWork& current_work, const CTxDestination& addr, const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2, CMutableTransaction& cb, CMutableTransaction* bf, std::vector<uint256>& cb_branch) {
     if (current_work.GetBlock().vtx.empty()) {
         const std::string msg = strprintf("%s: no transactions in block template; unable to submit work", __func__);
         LogPrint(BCLog::STRATUM, "%s\n", msg);
@@ -451,7 +755,6 @@ void CustomizeWork(const ChainstateManager& chainman, const StratumClient& clien
 
     cb_branch = current_work.m_cb_branch;
     if (!current_work.m_aux_hash2 && current_work.m_is_witness_enabled) {
-        bf = CMutableTransaction(*current_work.GetBlock().vtx.back());
         UpdateSegwitCommitment(chainman, current_work, cb, bf, cb_branch);
         LogPrint(BCLog::STRATUM, "Updated segwit commitment in coinbase.\n");
     }
@@ -459,10 +762,10 @@ void CustomizeWork(const ChainstateManager& chainman, const StratumClient& clien
 
 uint256 CustomizeCommitHash(const ChainstateManager& chainman, const StratumClient& client, const CTxDestination& addr, const JobId& job_id, const StratumWork& current_work, const uint256& secret)
 {
-    CMutableTransaction cb, bf;
+    CMutableTransaction cb;
     std::vector<uint256> cb_branch;
     static const std::vector<unsigned char> dummy(4, 0x00); // extranonce2
-    CustomizeWork(chainman, client, current_work, addr, client.ExtraNonce1(job_id), dummy, cb, bf, cb_branch);
+    CustomizeWork(chainman, client, current_work, addr, client.ExtraNonce1(job_id), dummy, cb, nullptr, cb_branch);
 
     CMutableTransaction cb2(cb);
     cb2.vin[0].scriptSig = CScript();
@@ -483,7 +786,12 @@ uint256 CustomizeCommitHash(const ChainstateManager& chainman, const StratumClie
     return hash;
 }
 
-std::string GetWorkUnit(StratumClient& client) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+/**
+ * Make sure the shared work template is current, building a new one if the
+ * chain tip has changed or if the mempool has been updated and the template
+ * is more than a few seconds old.  Returns the job_id of the current work.
+ */
+static JobId RefreshWorkTemplate() EXCLUSIVE_LOCKS_REQUIRED(cs_work)
 {
     if (!g_context) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Error: Node context not found");
@@ -509,17 +817,9 @@ std::string GetWorkUnit(StratumClient& client) EXCLUSIVE_LOCKS_REQUIRED(cs_strat
         throw JSONRPCError(RPC_CLIENT_MEMPOOL_DISABLED, "Error: Mempool disabled or instance not found");
     }
 
-    if (!client.m_authorized && client.m_aux_addr.empty()) {
-        throw JSONRPCError(RPC_INVALID_REQUEST, "Stratum client not authorized.  Use mining.authorize first, with a Freicoin address as the username.");
-    }
-
-    static CBlockIndex* tip = NULL;
-    static JobId job_id;
-    static unsigned int transactions_updated_last = 0;
-    static int64_t last_update_time = 0;
     const CTxMemPool& mempool = *g_context->mempool;
 
-    CBlockIndex *tip_new = tip;
+    CBlockIndex *tip_new = g_work_tip;
     {
         LOCK(g_context->chainman->GetMutex());
         tip_new = g_context->chainman->ActiveChainstate().m_chain.Tip();
@@ -530,16 +830,16 @@ std::string GetWorkUnit(StratumClient& client) EXCLUSIVE_LOCKS_REQUIRED(cs_strat
     // a fake bitcoin block which commits to our Freicoin block.  Then the
     // coinbase is updated to commit to the auxiliary proof-of-work solution and
     // the native proof-of-work is solved.
-    if (half_solved_work && (tip != tip_new || !work_templates.count(*half_solved_work))) {
+    if (half_solved_work && (g_work_tip != tip_new || !GetWorkTemplate(*half_solved_work))) {
         half_solved_work = std::nullopt;
     }
 
     if (half_solved_work) {
-        job_id = *half_solved_work;
+        g_work_job_id = *half_solved_work;
     } else
     // Update the block template if the tip has changed or it's been more than 5
     // seconds and there are new transactions.
-    if (tip != tip_new || (mempool.GetTransactionsUpdated() != transactions_updated_last && (GetTime() - last_update_time) > 5) || !work_templates.count(job_id))
+    if (g_work_tip != tip_new || (mempool.GetTransactionsUpdated() != g_work_transactions_updated_last && (GetTime() - g_work_last_update_time) > 5) || !GetWorkTemplate(g_work_job_id))
     {
         CTxDestination coinbase_dest = g_default_mining_address;
         if (!IsValidDestination(coinbase_dest)) {
@@ -553,53 +853,77 @@ std::string GetWorkUnit(StratumClient& client) EXCLUSIVE_LOCKS_REQUIRED(cs_strat
         if (!new_work) {
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
         }
-        transactions_updated_last = mempool.GetTransactionsUpdated();
-        last_update_time = GetTime();
+        g_work_transactions_updated_last = mempool.GetTransactionsUpdated();
+        g_work_last_update_time = GetTime();
 
         // So that block.GetHash() is correct
-        new_work->block.hashMerkleRoot = BlockMerkleRoot(new_work->block);
+        new_work->block.hashMerkleRoot = new_work->tx_merkle_tree.GetRoot();
 
-        job_id = JobId(new_work->block.GetHash());
-        work_templates[job_id] = StratumWork(coinbase_dest, *new_work, new_work->block.vtx[0]->HasWitness());
-        tip = tip_new;
+        g_work_job_id = JobId(new_work->block.GetHash());
+        WorkTemplateMap templates = CopyWorkTemplates();
+        templates[g_work_job_id] = std::make_shared<const StratumWork>(coinbase_dest, *new_work, new_work->block.vtx[0]->HasWitness());
+        g_work_tip = tip_new;
 
-        LogPrint(BCLog::STRATUM, "New stratum block template (%d total): %s\n", work_templates.size(), HexStr(job_id));
+        LogPrint(BCLog::STRATUM, "New stratum block template (%d total): %s\n", templates.size(), HexStr(g_work_job_id));
 
         // Remove any old templates
         std::vector<JobId> old_job_ids;
         std::optional<JobId> oldest_job_id = std::nullopt;
-        uint32_t oldest_job_nTime = last_update_time;
-        for (const auto& work_template : work_templates) {
+        uint32_t oldest_job_nTime = g_work_last_update_time;
+        for (const auto& work_template : templates) {
             // If, for whatever reason the new work was generated with
             // an old nTime, don't erase it!
-            if (work_template.first == job_id) {
+            if (work_template.first == g_work_job_id) {
                 continue;
             }
             // Build a list of outdated work units to free.
-            if (work_template.second.GetBlock().nTime < (last_update_time - 900)) {
+            if (work_template.second->GetBlock().nTime < (g_work_last_update_time - 900)) {
                 old_job_ids.push_back(work_template.first);
             }
             // Track the oldest work unit, in case we have too much
             // recent work.
-            if (work_template.second.GetBlock().nTime <= oldest_job_nTime) {
+            if (work_template.second->GetBlock().nTime <= oldest_job_nTime) {
                 oldest_job_id = work_template.first;
-                oldest_job_nTime = work_template.second.GetBlock().nTime;
+                oldest_job_nTime = work_template.second->GetBlock().nTime;
             }
         }
         // Remove all outdated work.
         for (const auto& old_job_id : old_job_ids) {
-            work_templates.erase(old_job_id);
-            LogPrint(BCLog::STRATUM, "Removed outdated stratum block template (%d total): %s\n", work_templates.size(), HexStr(old_job_id));
+            templates.erase(old_job_id);
+            LogPrint(BCLog::STRATUM, "Removed outdated stratum block template (%d total): %s\n", templates.size(), HexStr(old_job_id));
         }
         // Remove the oldest work unit if we're still over the maximum
         // number of stored work templates.
-        if (work_templates.size() > 30 && oldest_job_id) {
-            work_templates.erase(*oldest_job_id);
-            LogPrint(BCLog::STRATUM, "Removed oldest stratum block template (%d total): %s\n", work_templates.size(), HexStr(*oldest_job_id));
+        if (templates.size() > 30 && oldest_job_id) {
+            templates.erase(*oldest_job_id);
+            LogPrint(BCLog::STRATUM, "Removed oldest stratum block template (%d total): %s\n", templates.size(), HexStr(*oldest_job_id));
         }
+        // Make the new work available to all connections.
+        PublishWorkTemplates(std::move(templates));
+    }
+
+    return g_work_job_id;
+}
+
+std::string GetWorkUnit(StratumClient& client, NotifyFrameCache* notify_frames) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
+{
+    if (!client.m_authorized && client.m_aux_addr.empty()) {
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Stratum client not authorized.  Use mining.authorize first, with a Freicoin address as the username.");
     }
 
-    StratumWork& current_work = work_templates[job_id];
+    JobId job_id;
+    CBlockIndex* tip;
+    std::shared_ptr<const StratumWork> work;
+    {
+        LOCK(cs_work);
+        job_id = RefreshWorkTemplate();
+        tip = g_work_tip;
+        work = GetWorkTemplate(job_id);
+    }
+    if (!work) {
+        throw std::runtime_error("Current work template not found.");
+    }
+    const StratumWork& current_work = *work;
 
     if (client.m_supports_aux && !current_work.GetBlock().m_aux_pow.IsNull() && !current_work.m_aux_hash2 && !client.m_aux_addr.empty()) {
         const AuxProofOfWork& aux_pow = current_work.GetBlock().m_aux_pow;
@@ -647,6 +971,10 @@ std::string GetWorkUnit(StratumClient& client) EXCLUSIVE_LOCKS_REQUIRED(cs_strat
         tmp_index.nBits = current_work.GetBlock().nBits;
     }
     double diff = ClampDifficulty(client, GetDifficulty(tmp_index));
+    if (diff != client.m_last_diff) {
+        client.m_prev_diff = client.m_last_diff;
+        client.m_last_diff = diff;
+    }
 
     UniValue set_difficulty(UniValue::VOBJ);
     set_difficulty.pushKV("id", client.m_nextid++);
@@ -655,132 +983,162 @@ std::string GetWorkUnit(StratumClient& client) EXCLUSIVE_LOCKS_REQUIRED(cs_strat
     set_difficulty_params.push_back(UniValue(diff));
     set_difficulty.pushKV("params", set_difficulty_params);
 
-    CMutableTransaction cb, bf;
-    std::vector<uint256> cb_branch;
-    {
-        static const std::vector<unsigned char> dummy(4, 0x00); // extranonce2
-        CustomizeWork(*g_context->chainman, client, current_work, client.m_addr, client.ExtraNonce1(job_id), dummy, cb, bf, cb_branch);
-    }
-
-    CBlockHeader blkhdr;
-    if (!current_work.GetBlock().m_aux_pow.IsNull() && !current_work.m_aux_hash2) {
-        // Setup auxiliary proof-of-work
-        const AuxProofOfWork& aux_pow = current_work.GetBlock().m_aux_pow;
+    // The "mining.notify" message depends only on the work template, the
+    // payout address and the clean_jobs flag, so when new work is pushed to
+    // many clients at once the serialized message is built once per address
+    // and reused for everyone mining to it, up to the message id.
+    const bool clean_jobs = (client.m_last_tip != tip)
+                         || (client.m_second_stage != bool(current_work.m_aux_hash2));
+    const std::tuple<JobId, CTxDestination, bool> frame_key{job_id, client.m_addr, clean_jobs};
+    std::string frame;
+    if (notify_frames && notify_frames->count(frame_key)) {
+        frame = notify_frames->at(frame_key);
+    } else {
+        CMutableTransaction cb;
+        std::vector<uint256> cb_branch;
+        {
+            static const std::vector<unsigned char> dummy(4, 0x00); // extranonce2
+            CustomizeWork(*g_context->chainman, client, current_work, client.m_addr, client.ExtraNonce1(job_id), dummy, cb, nullptr, cb_branch);
+        }
 
-        CMutableTransaction cb2(cb);
-        cb2.vin[0].scriptSig = CScript();
-        cb2.vin[0].nSequence = 0;
+        CBlockHeader blkhdr;
+        if (!current_work.GetBlock().m_aux_pow.IsNull() && !current_work.m_aux_hash2) {
+            // Setup auxiliary proof-of-work
+            const AuxProofOfWork& aux_pow = current_work.GetBlock().m_aux_pow;
+
+            CMutableTransaction cb2(cb);
+            cb2.vin[0].scriptSig = CScript();
+            cb2.vin[0].nSequence = 0;
+
+            blkhdr.nVersion = aux_pow.m_commit_version;
+            blkhdr.hashPrevBlock = current_work.GetBlock().hashPrevBlock;
+            blkhdr.hashMerkleRoot = ComputeMerkleRootFromBranch(cb2.GetHash(), cb_branch, 0);
+            blkhdr.nTime = aux_pow.m_commit_time;
+            blkhdr.nBits = aux_pow.m_commit_bits;
+            blkhdr.nNonce = aux_pow.m_commit_nonce;
+            uint256 hash = blkhdr.GetHash();
+
+            {
+                HashWriter secret{};
+                secret << aux_pow.m_secret_lo;
+                secret << aux_pow.m_secret_hi;
+                hash = MerkleHash_Sha256Midstate(hash, secret.GetHash());
+            }
 
-        blkhdr.nVersion = aux_pow.m_commit_version;
-        blkhdr.hashPrevBlock = current_work.GetBlock().hashPrevBlock;
-        blkhdr.hashMerkleRoot = ComputeMerkleRootFromBranch(cb2.GetHash(), cb_branch, 0);
-        blkhdr.nTime = aux_pow.m_commit_time;
-        blkhdr.nBits = aux_pow.m_commit_bits;
-        blkhdr.nNonce = aux_pow.m_commit_nonce;
-        uint256 hash = blkhdr.GetHash();
+            hash = ComputeMerkleMapRootFromBranch(hash, aux_pow.m_commit_branch, Params().GetConsensus().aux_pow_path);
+
+            {
+                CSHA256 midstate(aux_pow.m_midstate_hash.begin(),
+                                 &aux_pow.m_midstate_buffer[0],
+                                 aux_pow.m_midstate_length << 3);
+                // Write the commitment root hash.
+                midstate.Write(hash.begin(), 32);
+                // Write the commitment identifier.
+                static const std::array<unsigned char, 4> id
+                    = { 0x4b, 0x4a, 0x49, 0x48 };
+                midstate.Write(id.data(), 4);
+                // Write the transaction's nLockTime field.
+                DataStream lock_time{};
+                lock_time << aux_pow.m_aux_lock_time;
+                midstate.Write((const unsigned char*)&lock_time[0], lock_time.size());
+                // Double SHA-256.
+                midstate.Finalize(hash.begin());
+                CSHA256()
+                    .Write(hash.begin(), 32)
+                    .Finalize(hash.begin());
+            }
 
-        {
-            HashWriter secret{};
-            secret << aux_pow.m_secret_lo;
-            secret << aux_pow.m_secret_hi;
-            hash = MerkleHash_Sha256Midstate(hash, secret.GetHash());
+            cb_branch.resize(1);
+            cb_branch[0] = hash;
+            blkhdr.nVersion = aux_pow.m_aux_version;
+            blkhdr.hashPrevBlock = aux_pow.m_aux_hash_prev_block;
+            blkhdr.nTime = current_work.GetBlock().nTime;
+            blkhdr.nBits = aux_pow.m_aux_bits;
         }
 
-        hash = ComputeMerkleMapRootFromBranch(hash, aux_pow.m_commit_branch, Params().GetConsensus().aux_pow_path);
+        else {
+            // Setup native proof-of-work
+            blkhdr.nVersion = current_work.GetBlock().nVersion;
+            blkhdr.hashPrevBlock = current_work.GetBlock().hashPrevBlock;
+            blkhdr.nTime = current_work.GetBlock().nTime;
+            blkhdr.nBits = current_work.GetBlock().nBits;
+        }
 
-        {
-            CSHA256 midstate(aux_pow.m_midstate_hash.begin(),
-                             &aux_pow.m_midstate_buffer[0],
-                             aux_pow.m_midstate_length << 3);
-            // Write the commitment root hash.
-            midstate.Write(hash.begin(), 32);
-            // Write the commitment identifier.
-            static const std::array<unsigned char, 4> id
-                = { 0x4b, 0x4a, 0x49, 0x48 };
-            midstate.Write(id.data(), 4);
-            // Write the transaction's nLockTime field.
-            DataStream lock_time{};
-            lock_time << aux_pow.m_aux_lock_time;
-            midstate.Write((const unsigned char*)&lock_time[0], lock_time.size());
-            // Double SHA-256.
-            midstate.Finalize(hash.begin());
-            CSHA256()
-                .Write(hash.begin(), 32)
-                .Finalize(hash.begin());
-        }
-
-        cb_branch.resize(1);
-        cb_branch[0] = hash;
-        blkhdr.nVersion = aux_pow.m_aux_version;
-        blkhdr.hashPrevBlock = aux_pow.m_aux_hash_prev_block;
-        blkhdr.nTime = current_work.GetBlock().nTime;
-        blkhdr.nBits = aux_pow.m_aux_bits;
-    }
+        DataStream ds;
+        ds << TX_NO_WITNESS(CTransaction(cb));
+        if (ds.size() < (4 + 1 + 32 + 4 + 1)) {
+            throw std::runtime_error("Serialized transaction is too small to be parsed.  Is this even a coinbase?");
+        }
+        size_t pos = 4 + 1 + 32 + 4 + 1 + static_cast<size_t>(ds[4+1+32+4]) - (current_work.m_aux_hash2? 32: 0);
+        if (ds.size() < pos) {
+            throw std::runtime_error("Customized coinbase transaction does not contain extranonce field at expected location.");
+        }
+        std::string cb1 = HexStr({&ds[0], pos-4-8});
+        std::string cb2 = HexStr({&ds[pos], ds.size()-pos});
 
-    else {
-        // Setup native proof-of-work
-        blkhdr.nVersion = current_work.GetBlock().nVersion;
-        blkhdr.hashPrevBlock = current_work.GetBlock().hashPrevBlock;
-        blkhdr.nTime = current_work.GetBlock().nTime;
-        blkhdr.nBits = current_work.GetBlock().nBits;
-    }
+        UniValue params(UniValue::VARR);
+        params.push_back(HexStr(job_id));
+        // For reasons of who-the-heck-knows-why, stratum byte-swaps each
+        // 32-bit chunk of the hashPrevBlock.
+        uint256 hashPrevBlock(blkhdr.hashPrevBlock);
+        for (int i = 0; i < 256/32; ++i) {
+            ((uint32_t*)hashPrevBlock.begin())[i] = internal_bswap_32(
+            ((uint32_t*)hashPrevBlock.begin())[i]);
+        }
+        params.push_back(HexStr(hashPrevBlock));
+        params.push_back(cb1);
+        params.push_back(cb2);
 
-    DataStream ds;
-    ds << TX_NO_WITNESS(CTransaction(cb));
-    if (ds.size() < (4 + 1 + 32 + 4 + 1)) {
-        throw std::runtime_error("Serialized transaction is too small to be parsed.  Is this even a coinbase?");
-    }
-    size_t pos = 4 + 1 + 32 + 4 + 1 + static_cast<size_t>(ds[4+1+32+4]) - (current_work.m_aux_hash2? 32: 0);
-    if (ds.size() < pos) {
-        throw std::runtime_error("Customized coinbase transaction does not contain extranonce field at expected location.");
-    }
-    std::string cb1 = HexStr({&ds[0], pos-4-8});
-    std::string cb2 = HexStr({&ds[pos], ds.size()-pos});
+        UniValue branch(UniValue::VARR);
+        for (const auto& hash : cb_branch) {
+            branch.push_back(HexStr(hash));
+        }
+        params.push_back(branch);
 
-    UniValue params(UniValue::VARR);
-    params.push_back(HexStr(job_id));
-    // For reasons of who-the-heck-knows-why, stratum byte-swaps each
-    // 32-bit chunk of the hashPrevBlock.
-    uint256 hashPrevBlock(blkhdr.hashPrevBlock);
-    for (int i = 0; i < 256/32; ++i) {
-        ((uint32_t*)hashPrevBlock.begin())[i] = internal_bswap_32(
-        ((uint32_t*)hashPrevBlock.begin())[i]);
-    }
-    params.push_back(HexStr(hashPrevBlock));
-    params.push_back(cb1);
-    params.push_back(cb2);
+        if (!current_work.m_aux_hash2) {
+            int64_t delta = node::UpdateTime(&blkhdr, Params().GetConsensus(), tip);
+            LogPrint(BCLog::STRATUM, "Updated the timestamp of block template by %d seconds\n", delta);
+        }
 
-    UniValue branch(UniValue::VARR);
-    for (const auto& hash : cb_branch) {
-        branch.push_back(HexStr(hash));
-    }
-    params.push_back(branch);
+        params.push_back(HexInt4(blkhdr.nVersion));
+        params.push_back(HexInt4(blkhdr.nBits));
+        params.push_back(HexInt4(blkhdr.nTime));
+        params.push_back(UniValue(clean_jobs));
 
-    if (!current_work.m_aux_hash2) {
-        int64_t delta = node::UpdateTime(&blkhdr, Params().GetConsensus(), tip);
-        LogPrint(BCLog::STRATUM, "Updated the timestamp of block template by %d seconds\n", delta);
+        frame = "{\"params\":" + params.write() + ",\"id\":";
+        if (notify_frames) {
+            (*notify_frames)[frame_key] = frame;
+        }
     }
-
-    params.push_back(HexInt4(blkhdr.nVersion));
-    params.push_back(HexInt4(blkhdr.nBits));
-    params.push_back(HexInt4(blkhdr.nTime));
-    params.push_back(UniValue((client.m_last_tip != tip)
-                           || (client.m_second_stage != bool(current_work.m_aux_hash2))));
     client.m_last_tip = tip;
     client.m_second_stage = bool(current_work.m_aux_hash2);
 
-    UniValue mining_notify(UniValue::VOBJ);
-    mining_notify.pushKV("params", params);
-    mining_notify.pushKV("id", client.m_nextid++);
-    mining_notify.pushKV("method", "mining.notify");
+    const std::string mining_notify = frame
+        + strprintf("%d", client.m_nextid++)
+        + ",\"method\":\"mining.notify\"}";
 
     client.m_last_work_time = GetTime();
     return GetExtraNonceRequest(client, job_id)
          + set_difficulty.write() + "\n"
-         + mining_notify.write()  + "\n";
+         + mining_notify + "\n";
+}
+
+/**
+ * Publish a work template whose auxiliary proof-of-work has been solved, and
+ * record it as the work to be sent to miners for the rest of the block.
+ */
+static std::shared_ptr<const StratumWork> PublishHalfSolvedWork(const JobId& job_id, StratumWork&& work)
+{
+    auto ret = std::make_shared<const StratumWork>(std::move(work));
+    LOCK(cs_work);
+    WorkTemplateMap templates = CopyWorkTemplates();
+    templates[job_id] = ret;
+    PublishWorkTemplates(std::move(templates));
+    half_solved_work = job_id;
+    return ret;
 }
 
-bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork& current_work, const std::vector<unsigned char>& extranonce1, std::vector<unsigned char> extranonce2, std::optional<uint32_t> nVersion, uint32_t nTime, uint32_t nNonce) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork& current_work, const std::vector<unsigned char>& extranonce1, std::vector<unsigned char> extranonce2, std::optional<uint32_t> nVersion, uint32_t nTime, uint32_t nNonce, double* share_diff = nullptr) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     if (!g_context) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Error: Node context not found when submitting block");
@@ -801,7 +1159,7 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
 
     CMutableTransaction cb, bf;
     std::vector<uint256> cb_branch;
-    CustomizeWork(*g_context->chainman, client, current_work, client.m_addr, extranonce1, extranonce2, cb, bf, cb_branch);
+    CustomizeWork(*g_context->chainman, client, current_work, client.m_addr, extranonce1, extranonce2, cb, &bf, cb_branch);
 
     bool res = false;
     if (!current_work.GetBlock().m_aux_pow.IsNull() && !current_work.m_aux_hash2) {
@@ -828,20 +1186,19 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
         blkhdr.m_aux_pow.m_aux_version = version;
 
         const Consensus::Params& params = Params().GetConsensus();
-        res = CheckAuxiliaryProofOfWork(blkhdr, params);
-        auto aux_hash = blkhdr.GetAuxiliaryHash(params);
+        std::pair<uint256, uint256> aux_hash;
+        res = CheckAuxiliaryProofOfWork(blkhdr, params, &aux_hash);
+        if (share_diff) {
+            // The first-stage target is scaled by the block's bias.
+            *share_diff = std::ldexp(GetShareDifficulty(aux_hash.first), current_work.GetBlock().GetBias());
+        }
         if (res) {
             LogPrintf("GOT AUXILIARY BLOCK!!! by %s: %s, %s\n", EncodeDestination(client.m_addr), aux_hash.first.ToString(), aux_hash.second.ToString());
             blkhdr.hashMerkleRoot = ComputeMerkleRootFromBranch(cb.GetHash(), cb_branch, 0);
             const uint256 first_stage_hash = blkhdr.GetHash();
             JobId new_job_id(first_stage_hash);
-            work_templates[new_job_id] = current_work;
-            StratumWork& new_work = work_templates[new_job_id];
-            new_work.GetBlock().vtx[0] = MakeTransactionRef(std::move(cb));
-            if (new_work.m_is_witness_enabled) {
-                new_work.GetBlock().vtx.back() = MakeTransactionRef(std::move(bf));
-            }
-            new_work.GetBlock().hashMerkleRoot = BlockMerkleRoot(new_work.GetBlock(), nullptr);
+            StratumWork new_work(current_work);
+            new_work.ReplaceTransactions(MakeTransactionRef(std::move(cb)), new_work.m_is_witness_enabled ? MakeTransactionRef(std::move(bf)) : nullptr);
             new_work.m_cb_branch = cb_branch;
             new_work.GetBlock().m_aux_pow.m_commit_hash_merkle_root = blkhdr.m_aux_pow.m_commit_hash_merkle_root;
             new_work.GetBlock().m_aux_pow.m_aux_branch = blkhdr.m_aux_pow.m_aux_branch;
@@ -853,7 +1210,7 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
             if (first_stage_hash != new_work.GetBlock().GetHash()) {
                 throw std::runtime_error("First-stage hash does not match expected value.");
             }
-            half_solved_work = new_job_id;
+            PublishHalfSolvedWork(new_job_id, std::move(new_work));
         } else {
             LogPrintf("NEW AUXILIARY SHARE!!! by %s: %s, %s\n", EncodeDestination(client.m_addr), aux_hash.first.ToString(), aux_hash.second.ToString());
         }
@@ -885,6 +1242,9 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
         const Consensus::Params& params = Params().GetConsensus();
         res = IsProtocolCleanupActive(params, current_work.GetBlock()) || CheckProofOfWork(blkhdr, params);
         uint256 hash = blkhdr.GetHash();
+        if (share_diff) {
+            *share_diff = GetShareDifficulty(hash);
+        }
         if (res) {
             LogPrintf("GOT BLOCK!!! by %s: %s\n", EncodeDestination(client.m_addr), hash.ToString());
             CBlock block(current_work.GetBlock());
@@ -893,7 +1253,9 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
                 block.vtx.back() = MakeTransactionRef(std::move(bf));
             }
             block.nVersion = version;
-            block.hashMerkleRoot = BlockMerkleRoot(block);
+            // The root was already computed from the coinbase's branch,
+            // which covers the replaced block-final transaction as well.
+            block.hashMerkleRoot = blkhdr.hashMerkleRoot;
             block.nTime = nTime;
             block.nNonce = nNonce;
             std::shared_ptr<const CBlock> pblock = std::make_shared<const CBlock>(block);
@@ -925,8 +1287,11 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
 
     if (res) {
         // Remove the half-solved work as it is no longer relevant.
-        if (half_solved_work && *half_solved_work == job_id) {
-            half_solved_work = std::nullopt;
+        {
+            LOCK(cs_work);
+            if (half_solved_work && *half_solved_work == job_id) {
+                half_solved_work = std::nullopt;
+            }
         }
         // Block was accepted, so the chain tip was updated.
         //
@@ -943,7 +1308,7 @@ bool SubmitBlock(StratumClient& client, const JobId& job_id, const StratumWork&
     return res;
 }
 
-bool SubmitAuxiliaryBlock(StratumClient& client, const CTxDestination& addr, const JobId& job_id, const StratumWork& current_work, CBlockHeader& blkhdr) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+bool SubmitAuxiliaryBlock(StratumClient& client, const CTxDestination& addr, const JobId& job_id, const StratumWork& current_work, CBlockHeader& blkhdr) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     if (!g_context) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Error: Node context not found when submitting block");
@@ -954,7 +1319,7 @@ bool SubmitAuxiliaryBlock(StratumClient& client, const CTxDestination& addr, con
     CMutableTransaction cb, bf;
     std::vector<uint256> cb_branch;
     static const std::vector<unsigned char> dummy(4, 0x00); // extranonce2
-    CustomizeWork(*g_context->chainman, client, current_work, addr, client.ExtraNonce1(job_id), dummy, cb, bf, cb_branch);
+    CustomizeWork(*g_context->chainman, client, current_work, addr, client.ExtraNonce1(job_id), dummy, cb, &bf, cb_branch);
 
     CMutableTransaction cb2(cb);
     cb2.vin[0].scriptSig = CScript();
@@ -963,8 +1328,8 @@ bool SubmitAuxiliaryBlock(StratumClient& client, const CTxDestination& addr, con
     blkhdr.m_aux_pow.m_commit_hash_merkle_root = ComputeMerkleRootFromBranch(cb2.GetHash(), cb_branch, 0);
 
     const Consensus::Params& params = Params().GetConsensus();
-    auto aux_hash = blkhdr.GetAuxiliaryHash(params);
-    if (!CheckAuxiliaryProofOfWork(blkhdr, params)) {
+    std::pair<uint256, uint256> aux_hash;
+    if (!CheckAuxiliaryProofOfWork(blkhdr, params, &aux_hash)) {
         LogPrintf("NEW AUXILIARY SHARE!!! by %s: %s, %s\n", EncodeDestination(addr), aux_hash.first.ToString(), aux_hash.second.ToString());
         return false;
     }
@@ -974,13 +1339,8 @@ bool SubmitAuxiliaryBlock(StratumClient& client, const CTxDestination& addr, con
     const uint256 first_stage_hash = blkhdr.GetHash();
 
     JobId new_job_id(first_stage_hash);
-    work_templates[new_job_id] = current_work;
-    StratumWork& new_work = work_templates[new_job_id];
-    new_work.GetBlock().vtx[0] = MakeTransactionRef(std::move(cb));
-    if (new_work.m_is_witness_enabled) {
-        new_work.GetBlock().vtx.back() = MakeTransactionRef(std::move(bf));
-    }
-    new_work.GetBlock().hashMerkleRoot = BlockMerkleRoot(new_work.GetBlock(), nullptr);
+    StratumWork new_work(current_work);
+    new_work.ReplaceTransactions(MakeTransactionRef(std::move(cb)), new_work.m_is_witness_enabled ? MakeTransactionRef(std::move(bf)) : nullptr);
     new_work.m_cb_branch = cb_branch;
     new_work.GetBlock().m_aux_pow = blkhdr.m_aux_pow;
     new_work.GetBlock().nTime = blkhdr.nTime;
@@ -989,13 +1349,13 @@ bool SubmitAuxiliaryBlock(StratumClient& client, const CTxDestination& addr, con
         throw std::runtime_error("First-stage hash does not match expected value.");
     }
 
-    half_solved_work = new_job_id;
+    const std::shared_ptr<const StratumWork> half_solved = PublishHalfSolvedWork(new_job_id, std::move(new_work));
     client.m_send_work = true;
 
-    if (IsProtocolCleanupActive(params, new_work.GetBlock())) {
+    if (IsProtocolCleanupActive(params, half_solved->GetBlock())) {
         LogPrint(BCLog::STRATUM, "Protocol cleanup is active; submitting block directly to the network.\n");
         const std::vector<unsigned char> extranonce2(4, 0x00);
-        return SubmitBlock(client, new_job_id, new_work, client.ExtraNonce1(new_job_id), extranonce2, new_work.GetBlock().nVersion, new_work.GetBlock().nTime, 0);
+        return SubmitBlock(client, new_job_id, *half_solved, client.ExtraNonce1(new_job_id), extranonce2, half_solved->GetBlock().nVersion, half_solved->GetBlock().nTime, 0);
     }
 
     return false;
@@ -1012,7 +1372,7 @@ void BoundParams(const std::string& method, const UniValue& params, size_t min,
     }
 }
 
-UniValue stratum_mining_subscribe(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_subscribe(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.subscribe");
     BoundParams(method, params, 0, 2);
@@ -1062,7 +1422,7 @@ UniValue stratum_mining_subscribe(StratumClient& client, const UniValue& params)
     return ret;
 }
 
-UniValue stratum_mining_authorize(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_authorize(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.authorize");
     BoundParams(method, params, 1, 2);
@@ -1116,7 +1476,7 @@ UniValue stratum_mining_authorize(StratumClient& client, const UniValue& params)
     return true;
 }
 
-UniValue stratum_mining_aux_authorize(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_aux_authorize(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.aux.authorize");
     BoundParams(method, params, 1, 2);
@@ -1151,7 +1511,7 @@ UniValue stratum_mining_aux_authorize(StratumClient& client, const UniValue& par
     return EncodeDestination(addr);
 }
 
-UniValue stratum_mining_aux_deauthorize(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_aux_deauthorize(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.aux.deauthorize");
     BoundParams(method, params, 1, 1);
@@ -1182,7 +1542,7 @@ UniValue stratum_mining_aux_deauthorize(StratumClient& client, const UniValue& p
     return true;
 }
 
-UniValue stratum_mining_configure(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_configure(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.configure");
     BoundParams(method, params, 2, 2);
@@ -1215,50 +1575,119 @@ UniValue stratum_mining_configure(StratumClient& client, const UniValue& params)
     return res;
 }
 
-UniValue stratum_mining_submit(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+//! The outcome of a "mining.submit" request, for share accounting.
+ShareResult ClassifyShare(bool is_stale, bool is_block, double share_diff, double required_diff)
+{
+    // A share which solves a block has already been submitted, and is
+    // credited even if the client's work was for a previous tip.
+    if (is_block) {
+        return ShareResult::ACCEPTED;
+    }
+    if (is_stale) {
+        return ShareResult::STALE;
+    }
+    return share_diff < required_diff ? ShareResult::REJECTED : ShareResult::ACCEPTED;
+}
+
+static void RecordShare(StratumClient& client, ShareResult result, double difficulty, int64_t now) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
+{
+    switch (result) {
+    case ShareResult::ACCEPTED:
+        ++client.m_shares_accepted;
+        ++g_shares_accepted;
+        client.m_share_log.Add(now, difficulty);
+        g_share_log.Add(now, difficulty);
+        UpdateVarDiff(client, now);
+        break;
+    case ShareResult::STALE:
+        ++client.m_shares_stale;
+        ++g_shares_stale;
+        break;
+    case ShareResult::REJECTED:
+        ++client.m_shares_rejected;
+        ++g_shares_rejected;
+        break;
+    }
+}
+
+UniValue stratum_mining_submit(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     // m_last_recv_time was set to the current time when we started processing
     // this message.  We set m_last_submit_time to the current time so we know
     // when the client last submitted a work unit.
     client.m_last_submit_time = client.m_last_recv_time;
+    const int64_t now = client.m_last_recv_time;
 
-    const std::string method("mining.submit");
-    BoundParams(method, params, 5, 7);
-    // First parameter is the client username, which is ignored.
+    std::shared_ptr<const StratumWork> current_work;
+    bool is_stale = false;
+    bool is_block = false;
+    double share_diff = 0.0;
+    try {
+        const std::string method("mining.submit");
+        BoundParams(method, params, 5, 7);
+        // First parameter is the client username, which is ignored.
+
+        JobId job_id(params[1].get_str());
+        current_work = GetWorkTemplate(job_id);
+        if (!current_work) {
+            LogPrint(BCLog::STRATUM, "Received completed share for unknown job_id : %s\n", HexStr(job_id));
+            RecordShare(client, ShareResult::STALE, 0.0, now);
+            return false;
+        }
+        {
+            LOCK(cs_work);
+            is_stale = g_work_tip && current_work->GetBlock().hashPrevBlock != g_work_tip->GetBlockHash();
+        }
 
-    JobId job_id(params[1].get_str());
-    if (!work_templates.count(job_id)) {
-        LogPrint(BCLog::STRATUM, "Received completed share for unknown job_id : %s\n", HexStr(job_id));
-        return false;
-    }
-    StratumWork &current_work = work_templates[job_id];
+        std::vector<unsigned char> extranonce2 = ParseHexV(params[2], "extranonce2");
+        if (extranonce2.size() != 4) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("extranonce2 is wrong length (received %d bytes; expected %d bytes", extranonce2.size(), 4));
+        }
+        uint32_t nTime = ParseHexInt4(params[3], "nTime");
+        uint32_t nNonce = ParseHexInt4(params[4], "nNonce");
+        std::optional<uint32_t> nVersion;
+        if (params.size() > 5) {
+            nVersion = ParseHexInt4(params[5], "nVersion");
+        }
+        std::vector<unsigned char> extranonce1;
+        if (params.size() > 6) {
+            extranonce1 = ParseHexV(params[6], "extranonce1");
+            if (extranonce1.size() != 8) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Expected 8 bytes for extranonce1 field; received %d", extranonce1.size()));
+            }
+        } else {
+            extranonce1 = client.ExtraNonce1(job_id);
+        }
 
-    std::vector<unsigned char> extranonce2 = ParseHexV(params[2], "extranonce2");
-    if (extranonce2.size() != 4) {
-        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("extranonce2 is wrong length (received %d bytes; expected %d bytes", extranonce2.size(), 4));
+        is_block = SubmitBlock(client, job_id, *current_work, extranonce1, extranonce2, nVersion, nTime, nNonce, &share_diff);
+    } catch (...) {
+        RecordShare(client, ShareResult::REJECTED, 0.0, now);
+        throw;
     }
-    uint32_t nTime = ParseHexInt4(params[3], "nTime");
-    uint32_t nNonce = ParseHexInt4(params[4], "nNonce");
-    std::optional<uint32_t> nVersion;
-    if (params.size() > 5) {
-        nVersion = ParseHexInt4(params[5], "nVersion");
+
+    // Work sent before the most recent difficulty change may still be in
+    // progress, so shares meeting the previous difficulty are accepted too.
+    double required_diff = client.m_last_diff;
+    if (client.m_prev_diff > 0.0) {
+        required_diff = std::min(required_diff, client.m_prev_diff);
     }
-    std::vector<unsigned char> extranonce1;
-    if (params.size() > 6) {
-        extranonce1 = ParseHexV(params[6], "extranonce1");
-        if (extranonce1.size() != 8) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Expected 8 bytes for extranonce1 field; received %d", extranonce1.size()));
-        }
-    } else {
-        extranonce1 = client.ExtraNonce1(job_id);
+    switch (ClassifyShare(is_stale, is_block, share_diff, required_diff)) {
+    case ShareResult::STALE:
+        RecordShare(client, ShareResult::STALE, 0.0, now);
+        return false;
+    case ShareResult::REJECTED:
+        LogPrint(BCLog::STRATUM, "Rejecting share from %s with difficulty %g below the required %g\n", client.GetPeer().ToStringAddrPort(), share_diff, required_diff);
+        RecordShare(client, ShareResult::REJECTED, share_diff, now);
+        return false;
+    case ShareResult::ACCEPTED:
+        break;
     }
 
-    SubmitBlock(client, job_id, current_work, extranonce1, extranonce2, nVersion, nTime, nNonce);
-
+    RecordShare(client, ShareResult::ACCEPTED, required_diff, now);
     return true;
 }
 
-UniValue stratum_mining_aux_submit(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_aux_submit(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.aux.submit");
     BoundParams(method, params, 14, 14);
@@ -1282,13 +1711,13 @@ UniValue stratum_mining_aux_submit(StratumClient& client, const UniValue& params
     }
 
     JobId job_id(params[1].get_str());
-    if (!work_templates.count(job_id)) {
+    const std::shared_ptr<const StratumWork> current_work = GetWorkTemplate(job_id);
+    if (!current_work) {
         LogPrint(BCLog::STRATUM, "Received completed auxiliary share for unknown job_id : %s\n", HexStr(job_id));
         return false;
     }
-    StratumWork &current_work = work_templates[job_id];
 
-    CBlockHeader blkhdr(current_work.GetBlock());
+    CBlockHeader blkhdr(current_work->GetBlock());
     AuxProofOfWork& aux_pow = blkhdr.m_aux_pow;
 
     const UniValue& commit_branch = params[2].get_array();
@@ -1366,12 +1795,12 @@ UniValue stratum_mining_aux_submit(StratumClient& client, const UniValue& params
     aux_pow.m_aux_nonce = ParseHexInt4(params[13], "nNonce");
     aux_pow.m_aux_version = ParseHexInt4(params[9], "nVersion");
 
-    SubmitAuxiliaryBlock(client, addr, job_id, current_work, blkhdr);
+    SubmitAuxiliaryBlock(client, addr, job_id, *current_work, blkhdr);
 
     return true;
 }
 
-UniValue stratum_mining_aux_subscribe(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_aux_subscribe(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.aux.subscribe");
     BoundParams(method, params, 0, 0);
@@ -1387,7 +1816,7 @@ UniValue stratum_mining_aux_subscribe(StratumClient& client, const UniValue& par
     return ret;
 }
 
-UniValue stratum_mining_extranonce_subscribe(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(cs_stratum)
+UniValue stratum_mining_extranonce_subscribe(StratumClient& client, const UniValue& params) EXCLUSIVE_LOCKS_REQUIRED(client.m_mutex)
 {
     const std::string method("mining.extranonce.subscribe");
     BoundParams(method, params, 0, 0);
@@ -1400,13 +1829,21 @@ UniValue stratum_mining_extranonce_subscribe(StratumClient& client, const UniVal
 /** Callback to read from a stratum connection. */
 static void stratum_read_cb(bufferevent *bev, void *ctx)
 {
-    LOCK(cs_stratum);
     // Lookup the client record for this connection
-    if (!subscriptions.count(bev)) {
-        LogPrint(BCLog::STRATUM, "Received read notification for unknown stratum connection 0x%x\n", (size_t)bev);
-        return;
+    std::shared_ptr<StratumClient> client_ref;
+    {
+        LOCK(cs_stratum);
+        auto it = subscriptions.find(bev);
+        if (it == subscriptions.end()) {
+            LogPrint(BCLog::STRATUM, "Received read notification for unknown stratum connection 0x%x\n", (size_t)bev);
+            return;
+        }
+        client_ref = it->second;
     }
-    StratumClient& client = subscriptions[bev];
+    StratumClient& client = *client_ref;
+    // Only this connection is locked while the request is processed, so
+    // that other connections can be serviced by other threads.
+    LOCK(client.m_mutex);
     // Get links to the input and output buffers
     evbuffer *input = bufferevent_get_input(bev);
     evbuffer *output = bufferevent_get_output(bev);
@@ -1448,7 +1885,7 @@ static void stratum_read_cb(bufferevent *bev, void *ctx)
             UniValue result = NullUniValue;
             if (stratum_method_dispatch.count(jreq.strMethod)) {
                 // Determine which method to call, and do so.
-                result = stratum_method_dispatch[jreq.strMethod](client, jreq.params);
+                result = stratum_method_dispatch.at(jreq.strMethod)(client, jreq.params);
             } else {
                 // Exception will be caught and converted to JSON-RPC error response.
                 throw JSONRPCError(RPC_METHOD_NOT_FOUND, strprintf("Method '%s' not found", jreq.strMethod));
@@ -1501,7 +1938,7 @@ static void stratum_read_cb(bufferevent *bev, void *ctx)
         } else {
             std::string data;
             try {
-                data = GetWorkUnit(client);
+                data = GetWorkUnit(client, nullptr);
             } catch (const UniValue& objError) {
                 data = JSONRPCReply(NullUniValue, objError, NullUniValue);
             } catch (const std::exception& e) {
@@ -1522,15 +1959,21 @@ static void stratum_read_cb(bufferevent *bev, void *ctx)
 /** Callback to handle unrecoverable errors in a stratum link. */
 static void stratum_event_cb(bufferevent *bev, short what, void *ctx)
 {
-    LOCK(cs_stratum);
-    // Fetch the return address for this connection, for the debug log.
-    std::string from("UNKNOWN");
-    if (!subscriptions.count(bev)) {
-        LogPrint(BCLog::STRATUM, "Received event notification for unknown stratum connection 0x%x\n", (size_t)bev);
-        return;
-    } else {
-        from = subscriptions[bev].GetPeer().ToStringAddrPort();
+    std::shared_ptr<StratumClient> client_ref;
+    {
+        LOCK(cs_stratum);
+        auto it = subscriptions.find(bev);
+        if (it == subscriptions.end()) {
+            LogPrint(BCLog::STRATUM, "Received event notification for unknown stratum connection 0x%x\n", (size_t)bev);
+            return;
+        }
+        client_ref = it->second;
+        if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
+            subscriptions.erase(it);
+        }
     }
+    // Fetch the return address for this connection, for the debug log.
+    std::string from = client_ref->GetPeer().ToStringAddrPort();
     // Report the reason why we are closing the connection.
     if (what & BEV_EVENT_ERROR) {
         LogPrint(BCLog::STRATUM, "Error detected on stratum connection from %s\n", from);
@@ -1542,7 +1985,10 @@ static void stratum_event_cb(bufferevent *bev, short what, void *ctx)
     // disconnect and free its resources.
     if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
         LogPrint(BCLog::STRATUM, "Closing stratum connection from %s\n", from);
-        subscriptions.erase(bev);
+        // The client record may still be referenced by the block watcher
+        // thread, which checks m_bev before sending to the connection.
+        LOCK(client_ref->m_mutex);
+        client_ref->m_bev = nullptr;
         if (bev) {
             bufferevent_free(bev);
             bev = NULL;
@@ -1553,7 +1999,6 @@ static void stratum_event_cb(bufferevent *bev, short what, void *ctx)
 /** Callback to accept a stratum connection. */
 static void stratum_accept_conn_cb(evconnlistener *listener, evutil_socket_t fd, sockaddr *address, int socklen, void *ctx)
 {
-    LOCK(cs_stratum);
     // Parse the return address
     CService from;
     from.SetSockAddr(address);
@@ -1563,11 +2008,13 @@ static void stratum_accept_conn_cb(evconnlistener *listener, evutil_socket_t fd,
         LogPrint(BCLog::STRATUM, "Rejected connection from disallowed subnet: %s\n", from.ToStringAddrPort());
         return;
     }
-    // Should be the same as EventBase(), but let's get it the
-    // official way.
-    event_base *base = evconnlistener_get_base(listener);
-    // Create a buffer for sending/receiving from this connection.
-    bufferevent *bev = bufferevent_socket_new(base, fd, BEV_OPT_CLOSE_ON_FREE);
+    // Assign the connection to one of the stratum event loops.
+    event_base *base = g_stratum_event_bases[g_stratum_next_event_base++ % g_stratum_event_bases.size()];
+    // Create a buffer for sending/receiving from this connection.  Work
+    // updates are written to the connection from the block watcher thread,
+    // so the buffer must be thread-safe.  Callbacks are run without holding
+    // the buffer's lock, so that the client lock is always acquired first.
+    bufferevent *bev = bufferevent_socket_new(base, fd, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS);
     // Disable Nagle's algorithm, so that TCP packets are sent
     // immediately, even if it results in a small packet.
     int one = 1;
@@ -1576,10 +2023,13 @@ static void stratum_accept_conn_cb(evconnlistener *listener, evutil_socket_t fd,
     // from the miner and error handling.  A write callback isn't
     // needed because we're not sending enough data to fill buffers.
     bufferevent_setcb(bev, stratum_read_cb, NULL, stratum_event_cb, (void*)listener);
+    // Record the connection state, before any callbacks can be triggered.
+    {
+        LOCK(cs_stratum);
+        subscriptions[bev] = std::make_shared<StratumClient>(fd, bev, from);
+    }
     // Enable bidirectional communication on the connection.
     bufferevent_enable(bev, EV_READ|EV_WRITE);
-    // Record the connection state
-    subscriptions[bev] = StratumClient(fd, bev, from);
     // Log the connection.
     LogPrint(BCLog::STRATUM, "Accepted stratum connection from %s\n", from.ToStringAddrPort());
 }
@@ -1619,37 +2069,125 @@ static bool StratumBindAddresses(event_base* base, node::NodeContext& node) EXCL
     return !bound_listeners.empty();
 }
 
+/**
+ * Listens for validation events which should cause new work to be pushed to
+ * miners: a new chain tip, or enough transaction fees entering the mempool to
+ * make rebuilding the block template worthwhile.  The notifications are
+ * handled asynchronously by the block watcher thread, so the callbacks only
+ * record the event and return.
+ */
+class StratumWorkNotifier final : public CValidationInterface
+{
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override
+    {
+        if (fInitialDownload) {
+            return;
+        }
+        {
+            LOCK(g_work_push_mutex);
+            g_work_push_new_tip = true;
+            g_work_push_fee_delta = 0;
+        }
+        g_work_push_cv.notify_all();
+    }
+
+    void TransactionAddedToMempool(const NewMempoolTransactionInfo& tx, uint64_t mempool_sequence) override
+    {
+        if (g_work_fee_delta_threshold <= 0) {
+            return;
+        }
+        bool notify = false;
+        {
+            LOCK(g_work_push_mutex);
+            g_work_push_fee_delta += tx.info.m_fee;
+            notify = g_work_push_fee_delta >= g_work_fee_delta_threshold;
+        }
+        if (notify) {
+            g_work_push_cv.notify_all();
+        }
+    }
+};
+
+static std::shared_ptr<StratumWorkNotifier> g_work_notifier;
+
 /** Watches for new blocks and send updated work to miners. */
 static std::atomic<bool> g_shutdown = false;
 void BlockWatcher()
 {
-    std::chrono::steady_clock::time_point checktxtime = std::chrono::steady_clock::now();
-    unsigned int txns_updated_last = 0;
+    std::optional<JobId> last_job_id;
+    bool retry = false;
     while (true) {
+        bool new_tip = false;
         {
-            WAIT_LOCK(g_best_block_mutex, lock);
-            checktxtime += std::chrono::seconds(15);
-            if (g_best_block_cv.wait_until(lock, checktxtime) == std::cv_status::timeout) {
-                // Timeout: Check to see if mempool was updated.
-                unsigned int txns_updated_next = g_context->mempool ? g_context->mempool->GetTransactionsUpdated() : txns_updated_last;
-                if (txns_updated_last == txns_updated_next)
-                    continue;
-                txns_updated_last = txns_updated_next;
+            WAIT_LOCK(g_work_push_mutex, lock);
+            if (retry) {
+                // The last fee-triggered update was rate limited.  Check
+                // again shortly, unless something else happens first.
+                g_work_push_cv.wait_for(lock, std::chrono::seconds(1));
+            } else {
+                g_work_push_cv.wait(lock, [] {
+                    AssertLockHeld(g_work_push_mutex);
+                    return g_shutdown
+                        || g_work_push_new_tip
+                        || (g_work_fee_delta_threshold > 0 && g_work_push_fee_delta >= g_work_fee_delta_threshold);
+                });
             }
+            new_tip = g_work_push_new_tip;
+            g_work_push_new_tip = false;
         }
-
-        LOCK(cs_stratum);
+        retry = false;
 
         if (g_shutdown) {
             break;
         }
 
+        // Build the new work template once, up front, rather than having
+        // the first client to be notified trigger it.
+        JobId job_id;
+        CBlockIndex* tip;
+        try {
+            LOCK(cs_work);
+            job_id = RefreshWorkTemplate();
+            tip = g_work_tip;
+        } catch (const UniValue& objError) {
+            LogPrint(BCLog::STRATUM, "Unable to generate updated stratum work: %s\n", objError.find_value("message").getValStr());
+            continue;
+        } catch (const std::exception& e) {
+            LogPrint(BCLog::STRATUM, "Unable to generate updated stratum work: %s\n", e.what());
+            continue;
+        }
+        if (!new_tip && last_job_id == job_id) {
+            // Mempool fees have changed, but the work template was refreshed
+            // too recently to be rebuilt.  Try again later.
+            retry = true;
+            continue;
+        }
+        last_job_id = job_id;
+        {
+            LOCK(g_work_push_mutex);
+            g_work_push_fee_delta = 0;
+        }
+
         // Either new block, or updated transactions.  Either way,
         // send updated work to miners.
-        for (auto& subscription : subscriptions) {
-            bufferevent* bev = subscription.first;
-            evbuffer *output = bufferevent_get_output(bev);
-            StratumClient& client = subscription.second;
+        std::vector<std::shared_ptr<StratumClient>> clients;
+        {
+            LOCK(cs_stratum);
+            clients.reserve(subscriptions.size());
+            for (const auto& subscription : subscriptions) {
+                clients.push_back(subscription.second);
+            }
+        }
+        NotifyFrameCache notify_frames;
+        for (const auto& client_ref : clients) {
+            StratumClient& client = *client_ref;
+            LOCK(client.m_mutex);
+            // Ignore clients which have disconnected since.
+            if (!client.m_bev) {
+                continue;
+            }
+            evbuffer *output = bufferevent_get_output(client.m_bev);
             // Ignore clients that aren't authorized yet.
             if (!client.m_authorized && client.m_aux_addr.empty()) {
                 continue;
@@ -1660,17 +2198,13 @@ void BlockWatcher()
             // work notification again, moments later.  Due to race conditions
             // there could be more than one miner that have already received an
             // update, however.
-            CBlockIndex* tip = nullptr;
-            if (g_context && g_context->chainman) {
-                tip = g_context->chainman->ActiveChain().Tip();
-            }
-            if (client.m_last_tip == tip) {
+            if (new_tip && client.m_last_tip == tip) {
                 continue;
             }
             // Get new work
             std::string data;
             try {
-                data = GetWorkUnit(client);
+                data = GetWorkUnit(client, &notify_frames);
             } catch (const UniValue& objError) {
                 data = JSONRPCReply(NullUniValue, objError, NullUniValue);
             } catch (const std::exception& e) {
@@ -1688,6 +2222,17 @@ void BlockWatcher()
     }
 }
 
+/** Event dispatcher thread for a subset of the stratum connections */
+static void ThreadStratumEventLoop(event_base* base, int index)
+{
+    util::ThreadRename(strprintf("stratum.%i", index));
+    LogPrint(BCLog::STRATUM, "Entering stratum event loop %d\n", index);
+    // Keep running even when there are no connections assigned to this
+    // event loop yet.  The loop is stopped by StopStratumServer().
+    event_base_loop(base, EVLOOP_NO_EXIT_ON_EMPTY);
+    LogPrint(BCLog::STRATUM, "Exited stratum event loop %d\n", index);
+}
+
 /** Configure the stratum server */
 bool InitStratumServer(node::NodeContext& node)
 {
@@ -1708,16 +2253,22 @@ bool InitStratumServer(node::NodeContext& node)
         }
     }
 
-    std::optional<std::string> mindiff = gArgs.GetArg("-miningmindifficulty");
+    std::optional<std::string> mindiff = gArgs.GetArg("-miningmindiff");
     if (mindiff) {
         double diff = std::stod(*mindiff);
         if (diff < 0.0) {
-            LogPrintf("Invalid -miningmindifficulty=%s: must be non-negative\n", *mindiff);
+            LogPrintf("Invalid -miningmindiff=%s: must be non-negative\n", *mindiff);
             return false;
         }
         g_min_difficulty = diff;
     }
 
+    g_share_interval = gArgs.GetIntArg("-stratumshareinterval", DEFAULT_STRATUM_SHARE_INTERVAL);
+    if (g_share_interval < 0) {
+        LogPrintf("Invalid -stratumshareinterval=%d: must be non-negative\n", g_share_interval);
+        return false;
+    }
+
     if (!InitSubnetAllowList("stratum", stratum_allow_subnets)) {
         LogPrint(BCLog::STRATUM, "Unable to bind stratum server to an endpoint.\n");
         return false;
@@ -1735,6 +2286,20 @@ bool InitStratumServer(node::NodeContext& node)
         return false;
     }
 
+    // Connections are accepted on the HTTP server's event loop, but are then
+    // serviced by one of several stratum event loops, so that requests from
+    // different miners can be processed in parallel.
+    int num_threads = std::max((int)gArgs.GetIntArg("-stratumthreads", DEFAULT_STRATUM_THREADS), 1);
+    LogPrint(BCLog::STRATUM, "Starting stratum server with %d event loop threads\n", num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+        event_base* shard = event_base_new();
+        if (!shard) {
+            LogPrintf("Unable to create event_base object for stratum server.\n");
+            return false;
+        }
+        g_stratum_event_bases.push_back(shard);
+    }
+
     if (!StratumBindAddresses(base, node)) {
         LogPrintf("Unable to bind any endpoint for stratum server\n");
     } else {
@@ -1758,10 +2323,29 @@ bool InitStratumServer(node::NodeContext& node)
     stratum_method_dispatch["mining.extranonce.subscribe"] =
         stratum_mining_extranonce_subscribe;
 
+    std::optional<std::string> workfeedelta = gArgs.GetArg("-stratumworkfeedelta");
+    if (workfeedelta) {
+        std::optional<CAmount> amount = ParseMoney(*workfeedelta);
+        if (!amount || *amount < 0) {
+            LogPrintf("Invalid -stratumworkfeedelta=%s: must be a non-negative amount\n", *workfeedelta);
+            return false;
+        }
+        g_work_fee_delta_threshold = *amount;
+    }
+
+    // Start the threads servicing stratum connections.
+    for (size_t i = 0; i < g_stratum_event_bases.size(); ++i) {
+        g_stratum_event_threads.emplace_back(ThreadStratumEventLoop, g_stratum_event_bases[i], i);
+    }
+
     // Start thread to wait for block notifications and send updated
     // work to miners.
     block_watcher_thread = std::thread(BlockWatcher);
 
+    // Wake the block watcher thread on new blocks and mempool updates.
+    g_work_notifier = std::make_shared<StratumWorkNotifier>();
+    RegisterSharedValidationInterface(g_work_notifier);
+
     return true;
 }
 
@@ -1782,17 +2366,36 @@ void InterruptStratumServer()
 void StopStratumServer()
 {
     g_shutdown = true;
+    /* Stop listening for validation events. */
+    if (g_work_notifier) {
+        UnregisterSharedValidationInterface(g_work_notifier);
+        g_work_notifier.reset();
+    }
     /* Wake up the block watcher thread. */
-    g_best_block_cv.notify_all();
+    {
+        LOCK(g_work_push_mutex);
+        g_work_push_cv.notify_all();
+    }
     if (block_watcher_thread.joinable()) {
         block_watcher_thread.join();
     }
+    /* Stop the event loops servicing stratum connections. */
+    for (event_base* base : g_stratum_event_bases) {
+        event_base_loopbreak(base);
+    }
+    for (auto& thread : g_stratum_event_threads) {
+        thread.join();
+    }
+    g_stratum_event_threads.clear();
     LOCK(cs_stratum);
     /* Release any reserved keys back to the pool. */
     wallet::ReleaseMiningDestinations();
     /* Tear-down active connections. */
     for (const auto& subscription : subscriptions) {
-        LogPrint(BCLog::STRATUM, "Closing stratum server connection to %s due to process termination\n", subscription.second.GetPeer().ToStringAddrPort());
+        StratumClient& client = *subscription.second;
+        LogPrint(BCLog::STRATUM, "Closing stratum server connection to %s due to process termination\n", client.GetPeer().ToStringAddrPort());
+        LOCK(client.m_mutex);
+        client.m_bev = nullptr;
         bufferevent_free(subscription.first);
     }
     subscriptions.clear();
@@ -1802,8 +2405,13 @@ void StopStratumServer()
         evconnlistener_free(binding.first);
     }
     bound_listeners.clear();
+    /* Free the stratum event loops, now that no connections remain. */
+    for (event_base* base : g_stratum_event_bases) {
+        event_base_free(base);
+    }
+    g_stratum_event_bases.clear();
     /* Free any allocated block templates. */
-    work_templates.clear();
+    std::atomic_store(&work_templates, std::shared_ptr<const WorkTemplateMap>());
 }
 
 static RPCHelpMan getstratuminfo() {
@@ -1822,6 +2430,12 @@ static RPCHelpMan getstratuminfo() {
             {RPCResult::Type::ARR, "allowip", /*optional=*/true, "subnets the server is allowed to accept connections from", {
                 {RPCResult::Type::STR, "subnet", "the subnet"},
             }},
+            {RPCResult::Type::OBJ, "shares", /*optional=*/true, "shares submitted to the server since it started", {
+                {RPCResult::Type::NUM, "accepted", "the number of shares accepted"},
+                {RPCResult::Type::NUM, "stale", "the number of shares for expired or outdated work"},
+                {RPCResult::Type::NUM, "rejected", "the number of invalid or low-difficulty shares"},
+                {RPCResult::Type::NUM, "hashrate", "the estimated combined hashrate of all clients over the last 10 minutes, in hashes per second"},
+            }},
             {RPCResult::Type::ARR, "clients", /*optional=*/true, "stratum clients connected to the server", {
                 {RPCResult::Type::OBJ, "", "", {
                     {RPCResult::Type::STR, "netaddr", "the remote address of the client"},
@@ -1834,6 +2448,11 @@ static RPCHelpMan getstratuminfo() {
                     {RPCResult::Type::NUM, "mindiff", /*optional=*/true, "the minimum difficulty the client is willing to accept"},
                     {RPCResult::Type::NUM_TIME, "lastjob", /*optional=*/true, "the time elapsed since the last job was sent to the client, in seconds"},
                     {RPCResult::Type::NUM_TIME, "lastshare", /*optional=*/true, "the time elapsed since the last share was received from the client, in seconds"},
+                    {RPCResult::Type::NUM, "difficulty", /*optional=*/true, "the share difficulty of the most recent job sent to the client"},
+                    {RPCResult::Type::NUM, "accepted", /*optional=*/true, "the number of shares accepted from the client"},
+                    {RPCResult::Type::NUM, "stale", /*optional=*/true, "the number of shares from the client for expired or outdated work"},
+                    {RPCResult::Type::NUM, "rejected", /*optional=*/true, "the number of invalid or low-difficulty shares from the client"},
+                    {RPCResult::Type::NUM, "hashrate", /*optional=*/true, "the estimated hashrate of the client over the last 10 minutes, in hashes per second"},
                 }}
             }}
         }},
@@ -1869,10 +2488,18 @@ static RPCHelpMan getstratuminfo() {
         allowed.push_back(subnet.ToString());
     }
     ret.pushKV("allowip", allowed);
+    // Report share statistics for the server as a whole.
+    UniValue shares(UniValue::VOBJ);
+    shares.pushKV("accepted", g_shares_accepted.load());
+    shares.pushKV("stale", g_shares_stale.load());
+    shares.pushKV("rejected", g_shares_rejected.load());
+    shares.pushKV("hashrate", g_share_log.GetHashrate(now, HASHRATE_WINDOW, g_start_time));
+    ret.pushKV("shares", shares);
     // Report list of connected stratum clients.
     UniValue clients(UniValue::VARR);
     for (const auto& subscription : subscriptions) {
-        const StratumClient& client = subscription.second;
+        const StratumClient& client = *subscription.second;
+        LOCK(client.m_mutex);
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("netaddr", client.GetPeer().ToStringAddrPort());
         obj.pushKV("conntime", now - client.m_connect_time);
@@ -1901,6 +2528,13 @@ static RPCHelpMan getstratuminfo() {
             if (client.m_last_submit_time > 0) {
                 obj.pushKV("lastshare", now - client.m_last_submit_time);
             }
+            if (client.m_last_diff > 0.0) {
+                obj.pushKV("difficulty", client.m_last_diff);
+            }
+            obj.pushKV("accepted", client.m_shares_accepted);
+            obj.pushKV("stale", client.m_shares_stale);
+            obj.pushKV("rejected", client.m_shares_rejected);
+            obj.pushKV("hashrate", client.m_share_log.GetHashrate(now, HASHRATE_WINDOW, client.m_connect_time));
         }
         clients.push_back(obj);
     }
@@ -5,11 +5,103 @@
 #ifndef FREICOIN_STRATUM_H
 #define FREICOIN_STRATUM_H
 
+#include <consensus/amount.h>
 #include <node/context.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
 /** The minimum difficulty for stratum mining clients.  A difficulty setting of 10^3 would take a 1Thps miner ~4 seconds to find a share. */
 const double DEFAULT_MINING_DIFFICULTY = 1e3;
 
+/** The default number of threads servicing stratum connections. */
+const int DEFAULT_STRATUM_THREADS = 4;
+
+/** The amount of new transaction fees which must enter the mempool before updated work is pushed to stratum clients. */
+const CAmount DEFAULT_STRATUM_WORK_FEE_DELTA = COIN / 10;
+
+/** The target number of seconds between shares from each stratum client, used to adjust per-client share difficulty.  Zero disables variable difficulty. */
+const int64_t DEFAULT_STRATUM_SHARE_INTERVAL = 10;
+
+/** The outcome of a share submitted by a stratum client. */
+enum class ShareResult {
+    ACCEPTED, //!< The share met the required difficulty, or solved a block.
+    STALE,    //!< The share was for work on a previous block, or expired work.
+    REJECTED, //!< The share was invalid or below the required difficulty.
+};
+
+/** Decide whether a well-formed share is accepted.  Shares which solve a
+ *  block are accepted even if their work was built on a stale tip. */
+ShareResult ClassifyShare(bool is_stale, bool is_block, double share_diff, double required_diff);
+
+/**
+ * A fixed-size ring buffer of recently accepted shares, used to estimate
+ * hashrate.  Shares may be added from multiple stratum event loop threads
+ * while the log is being read by an RPC thread, without any locking: each
+ * share is packed into a single 64-bit word, its receive time in the upper
+ * half and its difficulty as a float in the lower half, so that readers
+ * never observe a partially written entry.
+ */
+template <size_t N>
+class ShareLog
+{
+    static_assert(N > 0);
+
+    std::array<std::atomic<uint64_t>, N> m_entries{};
+    std::atomic<uint64_t> m_next{0};
+
+public:
+    //! Records a share of the given difficulty, received at the given time.
+    void Add(int64_t time, double difficulty)
+    {
+        const float fdiff = static_cast<float>(difficulty);
+        uint32_t bits;
+        static_assert(sizeof(bits) == sizeof(fdiff));
+        std::memcpy(&bits, &fdiff, sizeof(bits));
+        const uint64_t entry = (static_cast<uint64_t>(static_cast<uint32_t>(time)) << 32) | bits;
+        m_entries[m_next.fetch_add(1, std::memory_order_relaxed) % N].store(entry, std::memory_order_relaxed);
+    }
+
+    /**
+     * Estimates the hashrate, in hashes per second, from the shares received
+     * within the last `window` seconds.  Shares have only been recorded since
+     * `start`, so a shorter period is used if that is more recent.  If the log
+     * has wrapped around within that period, the estimate covers only the
+     * shares still recorded.
+     */
+    double GetHashrate(int64_t now, int64_t window, int64_t start) const
+    {
+        const int64_t period = std::clamp<int64_t>(now - start, 1, window);
+        const uint32_t since = static_cast<uint32_t>(now - period);
+        uint32_t oldest = static_cast<uint32_t>(now);
+        double work = 0.0;
+        size_t count = 0;
+        for (const auto& slot : m_entries) {
+            const uint64_t entry = slot.load(std::memory_order_relaxed);
+            const uint32_t time = static_cast<uint32_t>(entry >> 32);
+            if (!entry || time < since) {
+                continue;
+            }
+            const uint32_t bits = static_cast<uint32_t>(entry);
+            float fdiff;
+            std::memcpy(&fdiff, &bits, sizeof(fdiff));
+            work += fdiff;
+            oldest = std::min(oldest, time);
+            ++count;
+        }
+        if (!count) {
+            return 0.0;
+        }
+        // A full log covers less than the requested period.
+        const int64_t elapsed = (count == N) ? std::max<int64_t>(now - oldest, 1) : period;
+        // A share of difficulty 1 takes 2^32 hashes on average.
+        return work * 4294967296.0 / elapsed;
+    }
+};
+
 /** Configure the stratum server. */
 bool InitStratumServer(node::NodeContext& node);
 
@@ -17,6 +17,7 @@
 #include <policy/feerate.h>
 
 #include <limits>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -31,6 +32,42 @@ BOOST_AUTO_TEST_CASE(MoneyRangeTest)
     BOOST_CHECK_EQUAL(MoneyRange(MAX_MONEY + CAmount(1)), false);
 }
 
+BOOST_AUTO_TEST_CASE(DemurrageFactorTest)
+{
+    // A factor is the identity only for a distance of zero.
+    BOOST_CHECK(GetDemurrageFactor(0).identity);
+    BOOST_CHECK(!GetDemurrageFactor(1).identity);
+    // Distances of 2^26 and beyond decay everything to zero.
+    BOOST_CHECK_EQUAL(GetDemurrageFactor(1U << 26).rate, 0U);
+    BOOST_CHECK_EQUAL(TimeAdjustValueForward(MAX_MONEY, GetDemurrageFactor(1U << 26)), 0);
+    BOOST_CHECK_EQUAL(TimeAdjustValueForward(-MAX_MONEY, GetDemurrageFactor(0xffffffff)), 0);
+
+    const std::vector<CAmount> values{0, 1, -1, 1000, COIN, -50 * COIN, MAX_MONEY, -MAX_MONEY, 1234567890123LL};
+    const std::vector<uint32_t> distances{0, 1, 2, 3, 144, 1000, 52560, 1048575, 1048576, (1U << 26) - 1, 1U << 26, 0xffffffff};
+    for (const uint32_t distance : distances) {
+        const DemurrageFactor factor = GetDemurrageFactor(distance);
+        std::vector<CAmount> batch{values};
+        TimeAdjustValuesForward(batch, factor);
+        for (size_t i = 0; i < values.size(); ++i) {
+            const CAmount expected = TimeAdjustValueForward(values[i], distance);
+            BOOST_CHECK_EQUAL(TimeAdjustValueForward(values[i], factor), expected);
+            BOOST_CHECK_EQUAL(batch[i], expected);
+            if (distance <= uint32_t(std::numeric_limits<int>::max())) {
+                BOOST_CHECK_EQUAL(GetTimeAdjustedValue(values[i], distance), expected);
+            }
+        }
+    }
+
+    // Bitcoin compatibility mode leaves values untouched, even when the
+    // factor was computed before the mode was enabled.
+    const bool old_disable_time_adjust = disable_time_adjust;
+    disable_time_adjust = true;
+    std::vector<CAmount> batch{values};
+    TimeAdjustValuesForward(batch, GetDemurrageFactor(1000));
+    disable_time_adjust = old_disable_time_adjust;
+    BOOST_CHECK(batch == values);
+}
+
 BOOST_AUTO_TEST_CASE(GetFeeTest)
 {
     CFeeRate feeRate, altFeeRate;
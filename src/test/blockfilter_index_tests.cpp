@@ -19,7 +19,10 @@
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <index/blockfilterindex.h>
+#include <index/coinstatsindex.h>
+#include <index/txindex.h>
 #include <interfaces/chain.h>
+#include <kernel/coinstats.h>
 #include <node/miner.h>
 #include <pow.h>
 #include <test/util/blockfilter.h>
@@ -29,6 +32,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <future>
+
 using node::BlockAssembler;
 using node::BlockManager;
 using node::CBlockTemplate;
@@ -313,6 +319,97 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_sync_with_other_indexes, BuildChainTestingSetup)
+{
+    // Sync a filter index together with the other indexes, sharing the block
+    // reads between them.
+    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true);
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    CoinStatsIndex coin_stats_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(filter_index.Init());
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_REQUIRE(coin_stats_index.Init());
+    BOOST_REQUIRE(BaseIndex::StartBackgroundSync({&filter_index, &txindex, &coin_stats_index}));
+
+    IndexWaitSynced(filter_index, *Assert(m_node.shutdown));
+    IndexWaitSynced(txindex, *Assert(m_node.shutdown));
+    IndexWaitSynced(coin_stats_index, *Assert(m_node.shutdown));
+
+    {
+        LOCK(cs_main);
+        uint256 last_header;
+        for (const CBlockIndex* block_index = m_node.chainman->ActiveChain().Genesis();
+             block_index != nullptr;
+             block_index = m_node.chainman->ActiveChain().Next(block_index)) {
+            CheckFilterLookups(filter_index, block_index, last_header, m_node.chainman->m_blockman);
+            BOOST_CHECK(coin_stats_index.LookUpStats(*block_index));
+        }
+    }
+    for (const auto& txn : m_coinbase_txns) {
+        uint256 block_hash;
+        CTransactionRef tx_disk;
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    filter_index.Interrupt();
+    txindex.Interrupt();
+    coin_stats_index.Interrupt();
+    filter_index.Stop();
+    txindex.Stop();
+    coin_stats_index.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(index_sync_coordinator_start_heights, BuildChainTestingSetup)
+{
+    // The coordinator only uses the indexes to tell them apart.
+    TxIndex near_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    TxIndex far_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    TxIndex lagging_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    const auto block_at{[&](int height) { return tip->GetAncestor(height); }};
+
+    constexpr int WINDOW{4};
+    IndexSyncCoordinator coordinator{m_node.chainman->m_blockman, /*read_undo=*/false, WINDOW};
+    CThreadInterrupt interrupt;
+    const auto take{[&](const BaseIndex& index, int height) {
+        return coordinator.Take(index, *block_at(height), *tip, interrupt).block;
+    }};
+    // Take a block on another thread, which is expected to wait.
+    const auto take_async{[&](const BaseIndex& index, int height) {
+        return std::async(std::launch::async, [&, height] { return take(index, height); });
+    }};
+
+    // An index syncing from genesis does not hold back one starting near the
+    // tip, which gets to the tip on its own.
+    coordinator.Register(lagging_index, -1);
+    coordinator.Register(far_index, tip->nHeight - 10);
+    for (int height = tip->nHeight - 9; height <= tip->nHeight; ++height) {
+        auto block{take_async(far_index, height)};
+        BOOST_REQUIRE(block.wait_for(10s) == std::future_status::ready);
+        BOOST_CHECK(block.get());
+    }
+    coordinator.Unregister(far_index);
+
+    // An index starting within the window of another is kept in lockstep with
+    // it, and gets the blocks the other has read.
+    coordinator.Register(near_index, 2);
+    const auto block3{take(near_index, WINDOW - 1)};
+    BOOST_REQUIRE(block3);
+    auto pending4{take_async(near_index, WINDOW)};
+    BOOST_CHECK(pending4.wait_for(300ms) == std::future_status::timeout);
+    BOOST_CHECK(take(lagging_index, 0));
+    BOOST_REQUIRE(pending4.wait_for(10s) == std::future_status::ready);
+    const auto block4{pending4.get()};
+    BOOST_REQUIRE(block4);
+    BOOST_CHECK(take(lagging_index, 1));
+    BOOST_CHECK(take(lagging_index, 2));
+    BOOST_CHECK_EQUAL(take(lagging_index, 3), block3);
+    BOOST_CHECK_EQUAL(take(lagging_index, 4), block4);
+
+    coordinator.Unregister(near_index);
+    coordinator.Unregister(lagging_index);
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
@@ -49,7 +49,14 @@ BOOST_AUTO_TEST_CASE(gcsfilter_test)
         auto insertion = excluded_elements.insert(element);
         BOOST_CHECK(filter.MatchAny(excluded_elements));
         excluded_elements.erase(insertion.first);
+
+        // Check sets both smaller and larger than the filter.
+        BOOST_CHECK(filter.MatchAny({element}));
+        GCSFilter::ElementSet few_elements{element, *excluded_elements.begin()};
+        BOOST_CHECK(filter.MatchAny(few_elements));
     }
+    BOOST_CHECK(!filter.MatchAny({}));
+    BOOST_CHECK(!GCSFilter{}.MatchAny(excluded_elements));
 }
 
 BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
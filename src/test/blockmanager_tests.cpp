@@ -15,19 +15,25 @@
 
 #include <chainparams.h>
 #include <clientversion.h>
+#include <node/blockprefetch.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
 #include <script/solver.h>
 #include <primitives/block.h>
+#include <undo.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <boost/test/unit_test.hpp>
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
 
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::BlockPrefetcher;
 using node::BlockManager;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
@@ -143,6 +149,98 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_block_data_availability, TestChain100Setup)
     BOOST_CHECK(!blockman.CheckBlockDataAvailability(tip, *last_pruned_block));
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_map_block, TestChain100Setup)
+{
+    auto& blockman = m_node.chainman->m_blockman;
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip())};
+    const FlatFilePos pos{WITH_LOCK(::cs_main, return tip->GetBlockPos())};
+
+    const auto mapped{blockman.MapBlockFromDisk(*tip)};
+#ifdef WIN32
+    BOOST_CHECK(!mapped);
+#else
+    if (sizeof(void*) < 8) {
+        BOOST_CHECK(!mapped);
+        return;
+    }
+    BOOST_REQUIRE(mapped);
+
+    // The mapped data is the block as read and serialized.
+    CBlock block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, *tip));
+    DataStream ss_block;
+    ss_block << TX_WITH_WITNESS(block);
+    BOOST_CHECK(std::ranges::equal(MakeUCharSpan(ss_block), mapped->data));
+
+    std::vector<uint8_t> raw_block;
+    BOOST_REQUIRE(blockman.ReadRawBlockFromDisk(raw_block, pos));
+    const auto mapped_raw{blockman.MapRawBlockFromDisk(pos)};
+    BOOST_REQUIRE(mapped_raw);
+    BOOST_CHECK(std::ranges::equal(raw_block, mapped_raw->data));
+    BOOST_CHECK_EQUAL(mapped_raw->file, mapped->file);
+
+    // Positions not at the start of a block are rejected.
+    BOOST_CHECK(!blockman.MapRawBlockFromDisk(FlatFilePos{pos.nFile, pos.nPos + 1}));
+    BOOST_CHECK(!blockman.MapRawBlockFromDisk(FlatFilePos{pos.nFile, 0}));
+
+    // A block is not served raw for an index entry with a different header,
+    // as happens when the auxiliary proof-of-work is missing on disk.
+    const uint256 hash{block.GetHash()};
+    CBlockIndex other{block};
+    other.phashBlock = &hash;
+    WITH_LOCK(::cs_main, other.nFile = pos.nFile; other.nDataPos = pos.nPos; other.nStatus |= BLOCK_HAVE_DATA);
+    BOOST_CHECK(blockman.MapBlockFromDisk(other));
+    other.m_aux_pow.m_commit_nonce ^= 1;
+    BOOST_CHECK(!blockman.MapBlockFromDisk(other));
+#endif
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_prefetch, TestChain100Setup)
+{
+    const auto& blockman = m_node.chainman->m_blockman;
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip())};
+    BlockPrefetcher prefetcher{blockman, /*read_undo=*/true, /*depth=*/8};
+
+    // Read the whole chain in order, as an index catching up would.
+    const CBlockIndex* prev{nullptr};
+    for (int height = 0; height <= tip->nHeight; ++height) {
+        const CBlockIndex* index{tip->GetAncestor(height)};
+        WITH_LOCK(::cs_main, prefetcher.ReadAhead(prev, *tip));
+        const auto [block, undo]{prefetcher.Take(*index)};
+        BOOST_REQUIRE(block);
+        BOOST_CHECK_EQUAL(block->GetHash(), index->GetBlockHash());
+        if (height == 0) {
+            BOOST_CHECK(!undo);
+        } else {
+            CBlockUndo expected_undo;
+            BOOST_REQUIRE(blockman.UndoReadFromDisk(expected_undo, *index));
+            BOOST_REQUIRE(undo);
+            BOOST_CHECK_EQUAL(undo->vtxundo.size(), expected_undo.vtxundo.size());
+            BOOST_CHECK_EQUAL(undo->vtxundo.size() + 1, block->vtx.size());
+        }
+        prev = index;
+    }
+
+    // Blocks which were not read ahead, or are taken out of order, are read
+    // when they are taken.
+    const CBlockIndex* middle{tip->GetAncestor(tip->nHeight / 2)};
+    WITH_LOCK(::cs_main, prefetcher.ReadAhead(nullptr, *tip));
+    auto result{prefetcher.Take(*middle)};
+    BOOST_REQUIRE(result.block);
+    BOOST_CHECK_EQUAL(result.block->GetHash(), middle->GetBlockHash());
+    result = prefetcher.Take(*tip->GetAncestor(1));
+    BOOST_REQUIRE(result.block);
+    BOOST_CHECK_EQUAL(result.block->GetHash(), tip->GetAncestor(1)->GetBlockHash());
+
+    // A reader with no threads of its own reads each block when it is taken.
+    BlockPrefetcher no_threads{blockman, /*read_undo=*/false, /*depth=*/8, /*threads=*/0};
+    WITH_LOCK(::cs_main, no_threads.ReadAhead(middle, *tip));
+    result = no_threads.Take(*tip->GetAncestor(middle->nHeight + 1));
+    BOOST_REQUIRE(result.block);
+    BOOST_CHECK(!result.undo);
+    BOOST_CHECK_EQUAL(result.block->GetHash(), tip->GetAncestor(middle->nHeight + 1)->GetBlockHash());
+}
+
 BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
 {
     KernelNotifications notifications{*Assert(m_node.shutdown), m_node.exit_status};
@@ -146,6 +146,31 @@ struct FrozenCleanupCheck {
     }
 };
 
+struct BatchedCheck {
+    struct Batch {
+        static std::atomic<size_t> n_verified;
+        size_t n_deferred{0};
+        bool fails{false};
+        bool Verify()
+        {
+            n_verified.fetch_add(n_deferred, std::memory_order_relaxed);
+            return !fails;
+        }
+    };
+    bool fails;
+    BatchedCheck(bool _fails) : fails(_fails){};
+    bool operator()() const
+    {
+        return !fails;
+    }
+    bool operator()(Batch& batch) const
+    {
+        ++batch.n_deferred;
+        batch.fails |= fails;
+        return true;
+    }
+};
+
 // Static Allocations
 std::mutex FrozenCleanupCheck::m{};
 std::atomic<uint64_t> FrozenCleanupCheck::nFrozen{0};
@@ -154,6 +179,7 @@ Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
+std::atomic<size_t> BatchedCheck::Batch::n_verified{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
@@ -162,6 +188,10 @@ typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
+typedef CCheckQueue<BatchedCheck> Batched_Queue;
+
+static_assert(BatchableCheck<BatchedCheck>);
+static_assert(!BatchableCheck<FakeCheck>);
 
 
 /** This test case checks that the CCheckQueue works properly
@@ -268,6 +298,28 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure)
     }
 }
 
+// Test that batchable checks are run against a batch, that every batch is
+// verified, and that a failing batch fails the whole queue.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Batched)
+{
+    auto batched_queue = std::make_unique<Batched_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS);
+    for (const bool end_fails : {false, true, false}) {
+        BatchedCheck::Batch::n_verified = 0;
+        CCheckQueueControl<BatchedCheck> control(batched_queue.get());
+        for (size_t i = 0; i < 10; ++i) {
+            std::vector<BatchedCheck> vChecks;
+            vChecks.resize(100, false);
+            if (i == 9) vChecks[99] = end_fails;
+            control.Add(std::move(vChecks));
+        }
+        bool r = control.Wait();
+        BOOST_REQUIRE(r != end_fails);
+        if (!end_fails) {
+            BOOST_REQUIRE_EQUAL(BatchedCheck::Batch::n_verified, 1000U);
+        }
+    }
+}
+
 // Test that unique checks are actually all called individually, rather than
 // just one check being called repeatedly. Test that checks are not called
 // more than once as well
@@ -19,7 +19,6 @@
 #include <clientversion.h>
 #include <coins.h>
 #include <streams.h>
-#include <test/util/poolresourcetester.h>
 #include <test/util/random.h>
 #include <txdb.h>
 #include <uint256.h>
@@ -85,6 +84,21 @@ public:
     }
 };
 
+//! Writes every batch to its base view in the background.
+class CCoinsViewBackgroundFlushTest : public CCoinsViewBacked
+{
+    CCoinsViewBackgroundFlush m_flush_view;
+
+public:
+    explicit CCoinsViewBackgroundFlushTest(CCoinsView* base) : CCoinsViewBacked(&m_flush_view), m_flush_view(base) {}
+
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const BlockFinalTxEntry& final_tx, bool erase = true) override
+    {
+        m_flush_view.WriteNextInBackground();
+        return m_flush_view.BatchWrite(mapCoins, hashBlock, final_tx, erase);
+    }
+};
+
 class CCoinsViewCacheTest : public CCoinsViewCache
 {
 public:
@@ -93,7 +107,7 @@ public:
     void SelfTest() const
     {
         // Manually recompute the dynamic usage of the whole data, and compare it.
-        size_t ret = memusage::DynamicUsage(cacheCoins);
+        size_t ret = cacheCoins.DynamicMemoryUsage();
         size_t count = 0;
         for (const auto& entry : cacheCoins) {
             ret += entry.second.coin.DynamicMemoryUsage();
@@ -294,6 +308,109 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
 
     CCoinsViewDB db_base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
     SimulationTest(&db_base, true);
+
+    CCoinsViewDB flushed_db_base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewBackgroundFlushTest flush_base{&flushed_db_base};
+    SimulationTest(&flush_base, true);
+}
+
+BOOST_AUTO_TEST_CASE(coins_background_flush)
+{
+    CCoinsViewDB db{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewBackgroundFlush flush_view{&db};
+    CCoinsViewCache cache{&flush_view};
+
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 1000; ++i) {
+        outpoints.emplace_back(Txid::FromUint256(InsecureRand256()), i);
+        Coin coin;
+        coin.out.nValue = InsecureRandMoneyAmount();
+        coin.out.scriptPubKey.assign(1, OP_TRUE);
+        coin.nHeight = 1;
+        cache.AddCoin(outpoints.back(), std::move(coin), /*possible_overwrite=*/false);
+    }
+    const uint256 first_block{InsecureRand256()};
+    cache.SetBestBlock(first_block);
+    flush_view.WriteNextInBackground();
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+    // The flushed coins are visible through the view while they are written.
+    BOOST_CHECK(flush_view.GetBestBlock() == first_block);
+    for (const auto& outpoint : outpoints) {
+        BOOST_CHECK(cache.HaveCoin(outpoint));
+    }
+
+    // A second flush waits for the first one before spending a coin.
+    BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+    const uint256 second_block{InsecureRand256()};
+    cache.SetBestBlock(second_block);
+    flush_view.WriteNextInBackground();
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!cache.HaveCoin(outpoints[0]));
+
+    BOOST_CHECK(flush_view.Wait());
+    BOOST_CHECK(!flush_view.IsWriting());
+    BOOST_CHECK(db.GetBestBlock() == second_block);
+    BOOST_CHECK(!db.HaveCoin(outpoints[0]));
+    for (size_t i = 1; i < outpoints.size(); ++i) {
+        BOOST_CHECK(db.HaveCoin(outpoints[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(coins_get_coins)
+{
+    CCoinsViewDB db{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    std::map<COutPoint, Coin> expected;
+    {
+        CCoinsViewCache writer{&db};
+        for (int i = 0; i < 200; ++i) {
+            const COutPoint outpoint{Txid::FromUint256(InsecureRand256()), static_cast<uint32_t>(InsecureRandBits(16))};
+            Coin coin;
+            coin.out.nValue = InsecureRandMoneyAmount();
+            coin.out.scriptPubKey.assign(1 + InsecureRandBits(5), OP_TRUE);
+            coin.nHeight = 1 + InsecureRandBits(20);
+            expected.emplace(outpoint, coin);
+            writer.AddCoin(outpoint, std::move(coin), /*possible_overwrite=*/false);
+        }
+        writer.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(writer.Flush());
+    }
+
+    // Ask for every coin, some twice, interleaved with missing outpoints, and
+    // in an order unrelated to that of the database keys.
+    std::vector<COutPoint> outpoints;
+    for (const auto& [outpoint, coin] : expected) {
+        outpoints.push_back(outpoint);
+        if (InsecureRandBool()) outpoints.push_back(outpoint);
+        if (InsecureRandBool()) outpoints.emplace_back(Txid::FromUint256(InsecureRand256()), 0);
+    }
+    Shuffle(outpoints.begin(), outpoints.end(), g_insecure_rand_ctx);
+
+    const auto check = [&](const std::vector<std::optional<Coin>>& coins) {
+        BOOST_REQUIRE_EQUAL(coins.size(), outpoints.size());
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            const auto it{expected.find(outpoints[i])};
+            BOOST_CHECK_EQUAL(coins[i].has_value(), it != expected.end());
+            if (coins[i] && it != expected.end()) {
+                BOOST_CHECK(coins[i]->out == it->second.out);
+                BOOST_CHECK_EQUAL(coins[i]->nHeight, it->second.nHeight);
+            }
+        }
+    };
+    check(db.GetCoins(outpoints));
+
+    // The cache serves what it holds, and keeps the coins it fetches.
+    CCoinsViewCache cache{&db};
+    const COutPoint& spent{expected.begin()->first};
+    BOOST_CHECK(cache.SpendCoin(spent));
+    expected.erase(spent);
+    check(cache.GetCoins(outpoints));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), expected.size() + 1);
+    for (const auto& [outpoint, coin] : expected) {
+        BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    }
+    cache.SanityCheck();
 }
 
 // Store of all necessary tx and undo data for next test
@@ -634,8 +751,7 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags, const C
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMapMemoryResource resource;
-    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+    CCoinsMap map;
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}, {}));
 }
@@ -1105,29 +1221,62 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
-BOOST_AUTO_TEST_CASE(coins_resource_is_used)
+BOOST_AUTO_TEST_CASE(coins_map_operations)
 {
-    CCoinsMapMemoryResource resource;
-    PoolResourceTester::CheckAllDataAccountedFor(resource);
-
-    {
-        CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
-        BOOST_TEST(memusage::DynamicUsage(map) >= resource.ChunkSizeBytes());
-
-        map.reserve(1000);
-
-        // The resource has preallocated a chunk, so we should have space for at several nodes without the need to allocate anything else.
-        const auto usage_before = memusage::DynamicUsage(map);
+    // The hash stored in each entry fits in padding on common platforms.
+    if constexpr (sizeof(void*) == 8) {
+        BOOST_CHECK_EQUAL(sizeof(CCoinsMap::value_type), (sizeof(std::pair<const COutPoint, CCoinsCacheEntry>)));
+    }
 
-        COutPoint out_point{};
-        for (size_t i = 0; i < 1000; ++i) {
-            out_point.n = i;
-            map[out_point];
+    CCoinsMap map;
+    std::map<COutPoint, uint32_t> expected;
+    std::map<COutPoint, const CCoinsCacheEntry*> addresses;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+
+    for (int round = 0; round < 20000; ++round) {
+        const COutPoint outpoint{Txid::FromUint256(uint256{static_cast<uint8_t>(InsecureRandBits(2))}), static_cast<uint32_t>(InsecureRandRange(2000))};
+        if (InsecureRandBool()) {
+            const uint32_t height = InsecureRandBits(30);
+            auto [it, inserted] = map.try_emplace(outpoint);
+            BOOST_CHECK_EQUAL(inserted, !expected.count(outpoint));
+            if (inserted) {
+                it->second.coin.nHeight = height;
+                expected[outpoint] = height;
+                addresses[outpoint] = &it->second;
+            }
+        } else if (auto it = map.find(outpoint); it != map.end()) {
+            BOOST_CHECK(expected.count(outpoint));
+            map.erase(it);
+            expected.erase(outpoint);
+            addresses.erase(outpoint);
+        } else {
+            BOOST_CHECK(!expected.count(outpoint));
         }
-        BOOST_TEST(usage_before == memusage::DynamicUsage(map));
     }
 
-    PoolResourceTester::CheckAllDataAccountedFor(resource);
+    // Entries never move once inserted.
+    BOOST_CHECK_EQUAL(map.size(), expected.size());
+    for (const auto& [outpoint, height] : expected) {
+        const auto it = map.find(outpoint);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second.coin.nHeight, height);
+        BOOST_CHECK_EQUAL(&it->second, addresses[outpoint]);
+    }
+
+    // Erasing while iterating visits each entry once.
+    size_t visited = 0;
+    const size_t usage = map.DynamicMemoryUsage();
+    BOOST_CHECK(usage > map.size() * sizeof(CCoinsMap::value_type));
+    for (auto it = map.begin(); it != map.end(); ++visited) {
+        BOOST_CHECK_EQUAL(expected.erase(it->first), 1U);
+        it = (visited % 2) ? map.erase(it) : std::next(it);
+    }
+    BOOST_CHECK(expected.empty());
+    BOOST_CHECK_EQUAL(map.DynamicMemoryUsage(), usage);
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK_EQUAL(map.DynamicMemoryUsage(), 0U);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -1087,6 +1087,26 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256midstate64)
+{
+    unsigned char iv[32];
+    for (int j = 0; j < 32; ++j) {
+        iv[j] = InsecureRandBits(8);
+    }
+    for (int i = 0; i <= 32; ++i) {
+        unsigned char in[64 * 32];
+        unsigned char out1[32 * 32], out2[32 * 32];
+        for (int j = 0; j < 64 * i; ++j) {
+            in[j] = InsecureRandBits(8);
+        }
+        for (int j = 0; j < i; ++j) {
+            CSHA256(iv).Write(in + 64 * j, 64).Midstate(out1 + 32 * j, nullptr, nullptr);
+        }
+        SHA256Midstate64(out2, in, iv, i);
+        BOOST_CHECK(memcmp(out1, out2, 32 * i) == 0);
+    }
+}
+
 static void TestSHA3_256(const std::string& input, const std::string& output)
 {
     const auto in_bytes = ParseHex(input);
@@ -381,4 +381,70 @@ BOOST_AUTO_TEST_CASE(cuckoocache_generations)
     test_cache_generations<CuckooCache::cache<uint256, SignatureCacheHasher>>();
 }
 
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_hit_rate_ok)
+{
+    // Sharding must not cost noticeably in hit rate, see cuckoocache_hit_rate_ok.
+    double HitRateThresh = 0.98;
+    size_t megabytes = 4;
+    for (double load = 0.1; load < 2; load *= 2) {
+        double hits = test_cache<CuckooCache::sharded_cache<uint256, SignatureCacheHasher, 5>>(megabytes, load);
+        BOOST_CHECK(normalize_hit_rate(hits, load) > HitRateThresh);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_parallel)
+{
+    SeedInsecureRand(SeedRand::ZEROS);
+    CuckooCache::sharded_cache<uint256, SignatureCacheHasher, 3> set{};
+    const auto setup_results{set.setup_bytes(1 << 20)};
+    BOOST_REQUIRE(setup_results);
+    const uint32_t capacity{setup_results->first};
+
+    // Fill a quarter of the cache from several threads at once, with no
+    // external locking.
+    constexpr size_t THREADS{4};
+    std::vector<std::vector<uint256>> hashes(THREADS);
+    for (auto& thread_hashes : hashes) {
+        for (uint32_t i = 0; i < capacity / 4 / THREADS; ++i) {
+            thread_hashes.push_back(InsecureRand256());
+        }
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&set, &thread_hashes = hashes[t]] {
+            for (const uint256& h : thread_hashes) {
+                set.insert(h);
+                (void)set.contains(h, false);
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    uint64_t inserted{0};
+    for (const auto& thread_hashes : hashes) {
+        for (const uint256& h : thread_hashes) {
+            BOOST_CHECK(set.contains(h, false));
+        }
+        inserted += thread_hashes.size();
+    }
+    BOOST_CHECK(!set.contains(InsecureRand256(), false));
+
+    auto stats{set.stats()};
+    BOOST_CHECK_EQUAL(stats.inserts, inserted);
+    BOOST_CHECK_EQUAL(stats.evictions, 0U);
+    BOOST_CHECK_EQUAL(stats.hits, 2 * inserted);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+
+    // Inserting a third entry into a cache with room for two, both of which
+    // are recent, evicts one of them.
+    CuckooCache::sharded_cache<uint256, SignatureCacheHasher, 0> tiny{};
+    BOOST_REQUIRE_EQUAL(tiny.setup_bytes(2 * sizeof(uint256))->first, 2U);
+    for (int i = 0; i < 3; ++i) {
+        tiny.insert(InsecureRand256());
+    }
+    stats = tiny.stats();
+    BOOST_CHECK_EQUAL(stats.inserts, 3U);
+    BOOST_CHECK_EQUAL(stats.evictions, 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,3723 @@
+#include <string>
+namespace json_tests{
+static const std::string bip341_wallet_vectors{
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x22, 0x76, 
+0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 
+0x20, 0x31, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 
+0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 
+0x72, 0x6e, 0x61, 0x6c, 0x50, 0x75, 0x62, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x36, 
+0x38, 0x38, 0x39, 0x63, 0x62, 0x30, 0x38, 0x31, 
+0x30, 0x33, 0x36, 0x65, 0x30, 0x66, 0x61, 0x65, 
+0x66, 0x61, 0x33, 0x61, 0x33, 0x35, 0x31, 0x35, 
+0x37, 0x61, 0x64, 0x37, 0x31, 0x30, 0x38, 0x36, 
+0x62, 0x31, 0x32, 0x33, 0x62, 0x32, 0x62, 0x31, 
+0x34, 0x34, 0x62, 0x36, 0x34, 0x39, 0x37, 0x39, 
+0x38, 0x62, 0x34, 0x39, 0x34, 0x63, 0x33, 0x30, 
+0x30, 0x61, 0x39, 0x36, 0x31, 0x64, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x54, 0x72, 0x65, 0x65, 0x22, 0x3a, 0x20, 0x6e, 
+0x75, 0x6c, 0x6c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x6e, 0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 
+0x69, 0x61, 0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 0x65, 
+0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 0x6e, 
+0x75, 0x6c, 0x6c, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 0x62, 
+0x38, 0x36, 0x65, 0x37, 0x62, 0x65, 0x38, 0x66, 
+0x33, 0x39, 0x62, 0x61, 0x62, 0x33, 0x32, 0x61, 
+0x36, 0x66, 0x32, 0x63, 0x30, 0x34, 0x34, 0x33, 
+0x61, 0x62, 0x62, 0x63, 0x32, 0x31, 0x30, 0x66, 
+0x30, 0x65, 0x64, 0x61, 0x63, 0x30, 0x65, 0x32, 
+0x63, 0x35, 0x33, 0x64, 0x35, 0x30, 0x31, 0x62, 
+0x33, 0x36, 0x62, 0x36, 0x34, 0x34, 0x33, 0x37, 
+0x64, 0x39, 0x63, 0x36, 0x63, 0x37, 0x30, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 
+0x65, 0x64, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 
+0x22, 0x3a, 0x20, 0x22, 0x35, 0x33, 0x61, 0x31, 
+0x66, 0x36, 0x65, 0x34, 0x35, 0x34, 0x64, 0x66, 
+0x31, 0x61, 0x61, 0x32, 0x37, 0x37, 0x36, 0x61, 
+0x32, 0x38, 0x31, 0x34, 0x61, 0x37, 0x32, 0x31, 
+0x33, 0x37, 0x32, 0x64, 0x36, 0x32, 0x35, 0x38, 
+0x30, 0x35, 0x30, 0x64, 0x65, 0x33, 0x33, 0x30, 
+0x62, 0x33, 0x63, 0x36, 0x64, 0x31, 0x30, 0x65, 
+0x65, 0x38, 0x66, 0x34, 0x65, 0x30, 0x64, 0x64, 
+0x61, 0x33, 0x34, 0x33, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 0x63, 0x74, 
+0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 0x75, 
+0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 
+0x34, 0x66, 0x32, 0x30, 0x35, 0x33, 0x61, 0x31, 
+0x66, 0x36, 0x65, 0x34, 0x35, 0x34, 0x64, 0x66, 
+0x31, 0x61, 0x61, 0x32, 0x37, 0x37, 0x36, 0x61, 
+0x32, 0x38, 0x31, 0x34, 0x61, 0x37, 0x32, 0x31, 
+0x33, 0x37, 0x32, 0x64, 0x36, 0x32, 0x35, 0x38, 
+0x30, 0x35, 0x30, 0x64, 0x65, 0x33, 0x33, 0x30, 
+0x62, 0x33, 0x63, 0x36, 0x64, 0x31, 0x30, 0x65, 
+0x65, 0x38, 0x66, 0x34, 0x65, 0x30, 0x64, 0x64, 
+0x61, 0x33, 0x34, 0x33, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x62, 0x69, 0x70, 0x33, 0x35, 0x30, 0x41, 0x64, 
+0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 
+0x22, 0x66, 0x63, 0x31, 0x70, 0x32, 0x77, 0x73, 
+0x6c, 0x64, 0x65, 0x7a, 0x35, 0x6d, 0x75, 0x64, 
+0x32, 0x79, 0x61, 0x6d, 0x32, 0x39, 0x71, 0x32, 
+0x32, 0x77, 0x67, 0x66, 0x68, 0x39, 0x34, 0x33, 
+0x39, 0x73, 0x70, 0x67, 0x64, 0x75, 0x76, 0x63, 
+0x74, 0x38, 0x33, 0x6b, 0x33, 0x70, 0x6d, 0x35, 
+0x30, 0x66, 0x63, 0x78, 0x61, 0x35, 0x64, 0x70, 
+0x73, 0x73, 0x76, 0x32, 0x33, 0x67, 0x77, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 
+0x72, 0x6e, 0x61, 0x6c, 0x50, 0x75, 0x62, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x31, 0x38, 
+0x37, 0x37, 0x39, 0x31, 0x62, 0x36, 0x66, 0x37, 
+0x31, 0x32, 0x61, 0x38, 0x65, 0x61, 0x34, 0x31, 
+0x63, 0x38, 0x65, 0x63, 0x64, 0x64, 0x30, 0x65, 
+0x65, 0x37, 0x37, 0x66, 0x61, 0x62, 0x33, 0x65, 
+0x38, 0x35, 0x32, 0x36, 0x33, 0x62, 0x33, 0x37, 
+0x65, 0x31, 0x65, 0x63, 0x31, 0x38, 0x61, 0x33, 
+0x36, 0x35, 0x31, 0x39, 0x32, 0x36, 0x62, 0x33, 
+0x61, 0x36, 0x63, 0x66, 0x32, 0x37, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x54, 0x72, 0x65, 0x65, 0x22, 0x3a, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x64, 
+0x22, 0x3a, 0x20, 0x30, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 
+0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 0x30, 0x64, 
+0x38, 0x35, 0x61, 0x39, 0x35, 0x39, 0x62, 0x30, 
+0x32, 0x39, 0x30, 0x62, 0x66, 0x31, 0x39, 0x62, 
+0x62, 0x38, 0x39, 0x65, 0x64, 0x34, 0x33, 0x63, 
+0x39, 0x31, 0x36, 0x62, 0x65, 0x38, 0x33, 0x35, 
+0x34, 0x37, 0x35, 0x64, 0x30, 0x31, 0x33, 0x64, 
+0x61, 0x34, 0x62, 0x33, 0x36, 0x32, 0x31, 0x31, 
+0x37, 0x33, 0x39, 0x33, 0x65, 0x32, 0x35, 0x61, 
+0x34, 0x38, 0x32, 0x32, 0x39, 0x62, 0x38, 0x61, 
+0x63, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x6c, 0x65, 0x61, 0x66, 0x56, 0x65, 0x72, 
+0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 0x20, 0x31, 
+0x39, 0x32, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6d, 0x65, 
+0x64, 0x69, 0x61, 0x72, 0x79, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 0x48, 
+0x61, 0x73, 0x68, 0x65, 0x73, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x35, 
+0x62, 0x37, 0x35, 0x61, 0x64, 0x65, 0x63, 0x66, 
+0x35, 0x33, 0x35, 0x34, 0x38, 0x66, 0x33, 0x65, 
+0x63, 0x36, 0x61, 0x64, 0x37, 0x64, 0x37, 0x38, 
+0x33, 0x38, 0x33, 0x62, 0x66, 0x38, 0x34, 0x63, 
+0x63, 0x35, 0x37, 0x62, 0x35, 0x35, 0x61, 0x33, 
+0x31, 0x32, 0x37, 0x63, 0x37, 0x32, 0x62, 0x39, 
+0x61, 0x32, 0x34, 0x38, 0x31, 0x37, 0x35, 0x32, 
+0x64, 0x64, 0x38, 0x38, 0x62, 0x32, 0x31, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x6d, 0x65, 0x72, 
+0x6b, 0x6c, 0x65, 0x52, 0x6f, 0x6f, 0x74, 0x22, 
+0x3a, 0x20, 0x22, 0x35, 0x62, 0x37, 0x35, 0x61, 
+0x64, 0x65, 0x63, 0x66, 0x35, 0x33, 0x35, 0x34, 
+0x38, 0x66, 0x33, 0x65, 0x63, 0x36, 0x61, 0x64, 
+0x37, 0x64, 0x37, 0x38, 0x33, 0x38, 0x33, 0x62, 
+0x66, 0x38, 0x34, 0x63, 0x63, 0x35, 0x37, 0x62, 
+0x35, 0x35, 0x61, 0x33, 0x31, 0x32, 0x37, 0x63, 
+0x37, 0x32, 0x62, 0x39, 0x61, 0x32, 0x34, 0x38, 
+0x31, 0x37, 0x35, 0x32, 0x64, 0x64, 0x38, 0x38, 
+0x62, 0x32, 0x31, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 
+0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 
+0x63, 0x62, 0x64, 0x38, 0x36, 0x37, 0x39, 0x62, 
+0x61, 0x36, 0x33, 0x36, 0x63, 0x31, 0x31, 0x31, 
+0x30, 0x65, 0x61, 0x32, 0x34, 0x37, 0x35, 0x34, 
+0x32, 0x63, 0x66, 0x62, 0x64, 0x39, 0x36, 0x34, 
+0x31, 0x33, 0x31, 0x61, 0x36, 0x62, 0x65, 0x38, 
+0x34, 0x66, 0x38, 0x37, 0x33, 0x66, 0x37, 0x66, 
+0x33, 0x62, 0x36, 0x32, 0x61, 0x37, 0x37, 0x37, 
+0x35, 0x32, 0x38, 0x65, 0x64, 0x30, 0x30, 0x31, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 
+0x6b, 0x65, 0x64, 0x50, 0x75, 0x62, 0x6b, 0x65, 
+0x79, 0x22, 0x3a, 0x20, 0x22, 0x31, 0x34, 0x37, 
+0x63, 0x39, 0x63, 0x35, 0x37, 0x31, 0x33, 0x32, 
+0x66, 0x36, 0x65, 0x37, 0x65, 0x63, 0x64, 0x64, 
+0x62, 0x61, 0x39, 0x38, 0x30, 0x30, 0x62, 0x62, 
+0x30, 0x63, 0x34, 0x34, 0x34, 0x39, 0x32, 0x35, 
+0x31, 0x63, 0x39, 0x32, 0x61, 0x31, 0x65, 0x36, 
+0x30, 0x33, 0x37, 0x31, 0x65, 0x65, 0x37, 0x37, 
+0x35, 0x35, 0x37, 0x62, 0x36, 0x36, 0x32, 0x30, 
+0x66, 0x33, 0x65, 0x61, 0x33, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 0x63, 
+0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 
+0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 
+0x22, 0x34, 0x66, 0x32, 0x30, 0x31, 0x34, 0x37, 
+0x63, 0x39, 0x63, 0x35, 0x37, 0x31, 0x33, 0x32, 
+0x66, 0x36, 0x65, 0x37, 0x65, 0x63, 0x64, 0x64, 
+0x62, 0x61, 0x39, 0x38, 0x30, 0x30, 0x62, 0x62, 
+0x30, 0x63, 0x34, 0x34, 0x34, 0x39, 0x32, 0x35, 
+0x31, 0x63, 0x39, 0x32, 0x61, 0x31, 0x65, 0x36, 
+0x30, 0x33, 0x37, 0x31, 0x65, 0x65, 0x37, 0x37, 
+0x35, 0x35, 0x37, 0x62, 0x36, 0x36, 0x32, 0x30, 
+0x66, 0x33, 0x65, 0x61, 0x33, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x62, 0x69, 0x70, 0x33, 0x35, 0x30, 0x41, 
+0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 
+0x20, 0x22, 0x66, 0x63, 0x31, 0x70, 0x7a, 0x33, 
+0x37, 0x66, 0x63, 0x34, 0x63, 0x6e, 0x39, 0x61, 
+0x68, 0x38, 0x61, 0x6e, 0x77, 0x6d, 0x34, 0x78, 
+0x71, 0x71, 0x68, 0x76, 0x78, 0x79, 0x67, 0x6a, 
+0x66, 0x39, 0x72, 0x6a, 0x66, 0x32, 0x72, 0x65, 
+0x73, 0x72, 0x77, 0x38, 0x68, 0x38, 0x77, 0x34, 
+0x74, 0x6d, 0x76, 0x63, 0x73, 0x30, 0x38, 0x36, 
+0x33, 0x73, 0x65, 0x72, 0x79, 0x73, 0x64, 0x71, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 
+0x70, 0x74, 0x50, 0x61, 0x74, 0x68, 0x43, 0x6f, 
+0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x42, 0x6c, 0x6f, 
+0x63, 0x6b, 0x73, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 0x31, 0x31, 
+0x38, 0x37, 0x37, 0x39, 0x31, 0x62, 0x36, 0x66, 
+0x37, 0x31, 0x32, 0x61, 0x38, 0x65, 0x61, 0x34, 
+0x31, 0x63, 0x38, 0x65, 0x63, 0x64, 0x64, 0x30, 
+0x65, 0x65, 0x37, 0x37, 0x66, 0x61, 0x62, 0x33, 
+0x65, 0x38, 0x35, 0x32, 0x36, 0x33, 0x62, 0x33, 
+0x37, 0x65, 0x31, 0x65, 0x63, 0x31, 0x38, 0x61, 
+0x33, 0x36, 0x35, 0x31, 0x39, 0x32, 0x36, 0x62, 
+0x33, 0x61, 0x36, 0x63, 0x66, 0x32, 0x37, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 
+0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 
+0x74, 0x65, 0x72, 0x6e, 0x61, 0x6c, 0x50, 0x75, 
+0x62, 0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 
+0x39, 0x33, 0x34, 0x37, 0x38, 0x65, 0x39, 0x34, 
+0x38, 0x38, 0x66, 0x39, 0x35, 0x36, 0x64, 0x66, 
+0x32, 0x33, 0x39, 0x36, 0x62, 0x65, 0x32, 0x63, 
+0x65, 0x36, 0x63, 0x35, 0x63, 0x63, 0x65, 0x64, 
+0x37, 0x35, 0x66, 0x39, 0x30, 0x30, 0x64, 0x66, 
+0x61, 0x31, 0x38, 0x65, 0x37, 0x64, 0x61, 0x62, 
+0x64, 0x32, 0x34, 0x32, 0x38, 0x61, 0x61, 0x65, 
+0x37, 0x38, 0x34, 0x35, 0x31, 0x38, 0x32, 0x30, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 
+0x70, 0x74, 0x54, 0x72, 0x65, 0x65, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x64, 0x22, 0x3a, 0x20, 0x30, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 
+0x30, 0x62, 0x36, 0x31, 0x37, 0x32, 0x39, 0x38, 
+0x35, 0x35, 0x32, 0x61, 0x37, 0x32, 0x61, 0x64, 
+0x65, 0x30, 0x37, 0x30, 0x36, 0x36, 0x37, 0x65, 
+0x38, 0x36, 0x63, 0x61, 0x36, 0x33, 0x62, 0x38, 
+0x66, 0x35, 0x37, 0x38, 0x39, 0x61, 0x39, 0x66, 
+0x65, 0x38, 0x37, 0x33, 0x31, 0x65, 0x66, 0x39, 
+0x31, 0x32, 0x30, 0x32, 0x61, 0x39, 0x31, 0x63, 
+0x39, 0x66, 0x33, 0x34, 0x35, 0x39, 0x30, 0x30, 
+0x37, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 0x56, 
+0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 
+0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6d, 0x65, 0x64, 0x69, 0x61, 0x72, 0x79, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 
+0x66, 0x48, 0x61, 0x73, 0x68, 0x65, 0x73, 0x22, 
+0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x63, 0x35, 0x32, 0x35, 0x37, 0x31, 0x34, 
+0x61, 0x37, 0x66, 0x34, 0x39, 0x63, 0x32, 0x38, 
+0x61, 0x65, 0x64, 0x62, 0x62, 0x62, 0x61, 0x37, 
+0x38, 0x63, 0x30, 0x30, 0x35, 0x39, 0x33, 0x31, 
+0x61, 0x38, 0x31, 0x63, 0x32, 0x33, 0x34, 0x62, 
+0x32, 0x66, 0x36, 0x63, 0x39, 0x39, 0x61, 0x37, 
+0x33, 0x65, 0x34, 0x64, 0x30, 0x36, 0x30, 0x38, 
+0x32, 0x61, 0x64, 0x63, 0x38, 0x62, 0x66, 0x32, 
+0x62, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6d, 
+0x65, 0x72, 0x6b, 0x6c, 0x65, 0x52, 0x6f, 0x6f, 
+0x74, 0x22, 0x3a, 0x20, 0x22, 0x63, 0x35, 0x32, 
+0x35, 0x37, 0x31, 0x34, 0x61, 0x37, 0x66, 0x34, 
+0x39, 0x63, 0x32, 0x38, 0x61, 0x65, 0x64, 0x62, 
+0x62, 0x62, 0x61, 0x37, 0x38, 0x63, 0x30, 0x30, 
+0x35, 0x39, 0x33, 0x31, 0x61, 0x38, 0x31, 0x63, 
+0x32, 0x33, 0x34, 0x62, 0x32, 0x66, 0x36, 0x63, 
+0x39, 0x39, 0x61, 0x37, 0x33, 0x65, 0x34, 0x64, 
+0x30, 0x36, 0x30, 0x38, 0x32, 0x61, 0x64, 0x63, 
+0x38, 0x62, 0x66, 0x32, 0x62, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 
+0x20, 0x22, 0x36, 0x61, 0x66, 0x39, 0x65, 0x32, 
+0x38, 0x64, 0x62, 0x66, 0x39, 0x64, 0x36, 0x61, 
+0x61, 0x66, 0x30, 0x32, 0x37, 0x36, 0x39, 0x36, 
+0x65, 0x32, 0x35, 0x39, 0x38, 0x61, 0x35, 0x62, 
+0x33, 0x64, 0x30, 0x35, 0x36, 0x66, 0x35, 0x66, 
+0x64, 0x32, 0x33, 0x35, 0x35, 0x61, 0x37, 0x66, 
+0x64, 0x35, 0x61, 0x33, 0x37, 0x61, 0x30, 0x65, 
+0x35, 0x30, 0x30, 0x38, 0x31, 0x33, 0x32, 0x64, 
+0x33, 0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x65, 0x64, 0x50, 0x75, 0x62, 
+0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x65, 
+0x34, 0x64, 0x38, 0x31, 0x30, 0x66, 0x64, 0x35, 
+0x30, 0x35, 0x38, 0x36, 0x32, 0x37, 0x34, 0x66, 
+0x61, 0x63, 0x65, 0x36, 0x32, 0x62, 0x38, 0x61, 
+0x38, 0x30, 0x37, 0x65, 0x62, 0x39, 0x37, 0x31, 
+0x39, 0x63, 0x65, 0x66, 0x34, 0x39, 0x63, 0x30, 
+0x34, 0x31, 0x37, 0x37, 0x63, 0x63, 0x36, 0x62, 
+0x37, 0x36, 0x61, 0x39, 0x61, 0x34, 0x32, 0x35, 
+0x31, 0x64, 0x35, 0x34, 0x35, 0x30, 0x65, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 
+0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 
+0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 0x65, 
+0x34, 0x64, 0x38, 0x31, 0x30, 0x66, 0x64, 0x35, 
+0x30, 0x35, 0x38, 0x36, 0x32, 0x37, 0x34, 0x66, 
+0x61, 0x63, 0x65, 0x36, 0x32, 0x62, 0x38, 0x61, 
+0x38, 0x30, 0x37, 0x65, 0x62, 0x39, 0x37, 0x31, 
+0x39, 0x63, 0x65, 0x66, 0x34, 0x39, 0x63, 0x30, 
+0x34, 0x31, 0x37, 0x37, 0x63, 0x63, 0x36, 0x62, 
+0x37, 0x36, 0x61, 0x39, 0x61, 0x34, 0x32, 0x35, 
+0x31, 0x64, 0x35, 0x34, 0x35, 0x30, 0x65, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x62, 0x69, 0x70, 0x33, 0x35, 
+0x30, 0x41, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x66, 0x63, 0x31, 0x70, 
+0x75, 0x6e, 0x76, 0x70, 0x70, 0x6c, 0x32, 0x73, 
+0x74, 0x70, 0x33, 0x38, 0x66, 0x37, 0x6b, 0x77, 
+0x76, 0x32, 0x75, 0x32, 0x73, 0x70, 0x6c, 0x74, 
+0x6a, 0x75, 0x76, 0x75, 0x61, 0x61, 0x79, 0x75, 
+0x71, 0x73, 0x74, 0x68, 0x65, 0x33, 0x34, 0x68, 
+0x64, 0x32, 0x64, 0x79, 0x79, 0x35, 0x77, 0x34, 
+0x67, 0x35, 0x38, 0x71, 0x79, 0x71, 0x70, 0x65, 
+0x7a, 0x77, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x50, 0x61, 0x74, 0x68, 
+0x43, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x42, 
+0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 
+0x30, 0x39, 0x33, 0x34, 0x37, 0x38, 0x65, 0x39, 
+0x34, 0x38, 0x38, 0x66, 0x39, 0x35, 0x36, 0x64, 
+0x66, 0x32, 0x33, 0x39, 0x36, 0x62, 0x65, 0x32, 
+0x63, 0x65, 0x36, 0x63, 0x35, 0x63, 0x63, 0x65, 
+0x64, 0x37, 0x35, 0x66, 0x39, 0x30, 0x30, 0x64, 
+0x66, 0x61, 0x31, 0x38, 0x65, 0x37, 0x64, 0x61, 
+0x62, 0x64, 0x32, 0x34, 0x32, 0x38, 0x61, 0x61, 
+0x65, 0x37, 0x38, 0x34, 0x35, 0x31, 0x38, 0x32, 
+0x30, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x67, 0x69, 0x76, 
+0x65, 0x6e, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 0x6c, 
+0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 0x3a, 
+0x20, 0x22, 0x65, 0x65, 0x34, 0x66, 0x65, 0x30, 
+0x38, 0x35, 0x39, 0x38, 0x33, 0x34, 0x36, 0x32, 
+0x61, 0x31, 0x38, 0x34, 0x30, 0x31, 0x35, 0x64, 
+0x31, 0x66, 0x37, 0x38, 0x32, 0x64, 0x36, 0x61, 
+0x35, 0x66, 0x38, 0x62, 0x39, 0x63, 0x32, 0x62, 
+0x36, 0x30, 0x31, 0x33, 0x30, 0x61, 0x66, 0x66, 
+0x30, 0x35, 0x30, 0x63, 0x65, 0x32, 0x32, 0x31, 
+0x65, 0x63, 0x66, 0x33, 0x37, 0x38, 0x36, 0x35, 
+0x39, 0x32, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x54, 0x72, 0x65, 0x65, 
+0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x64, 0x22, 0x3a, 
+0x20, 0x30, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 
+0x30, 0x33, 0x38, 0x37, 0x36, 0x37, 0x31, 0x33, 
+0x35, 0x33, 0x65, 0x32, 0x37, 0x33, 0x32, 0x36, 
+0x34, 0x63, 0x34, 0x39, 0x35, 0x36, 0x35, 0x36, 
+0x65, 0x32, 0x37, 0x65, 0x33, 0x39, 0x62, 0x61, 
+0x38, 0x39, 0x39, 0x65, 0x61, 0x38, 0x66, 0x65, 
+0x65, 0x33, 0x62, 0x62, 0x36, 0x39, 0x66, 0x62, 
+0x32, 0x61, 0x36, 0x38, 0x30, 0x65, 0x32, 0x32, 
+0x30, 0x39, 0x33, 0x34, 0x34, 0x37, 0x64, 0x34, 
+0x38, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6c, 
+0x65, 0x61, 0x66, 0x56, 0x65, 0x72, 0x73, 0x69, 
+0x6f, 0x6e, 0x22, 0x3a, 0x20, 0x31, 0x39, 0x32, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 
+0x64, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x22, 0x3a, 
+0x20, 0x22, 0x30, 0x36, 0x34, 0x32, 0x34, 0x39, 
+0x35, 0x30, 0x33, 0x33, 0x33, 0x34, 0x33, 0x31, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 
+0x56, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 
+0x3a, 0x20, 0x32, 0x35, 0x30, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6d, 
+0x65, 0x64, 0x69, 0x61, 0x72, 0x79, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 
+0x48, 0x61, 0x73, 0x68, 0x65, 0x73, 0x22, 0x3a, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x38, 0x61, 0x64, 0x36, 0x39, 0x65, 0x63, 0x37, 
+0x63, 0x66, 0x34, 0x31, 0x63, 0x32, 0x61, 0x34, 
+0x30, 0x30, 0x31, 0x66, 0x64, 0x31, 0x66, 0x37, 
+0x33, 0x38, 0x62, 0x66, 0x31, 0x65, 0x35, 0x30, 
+0x35, 0x63, 0x65, 0x32, 0x32, 0x37, 0x37, 0x61, 
+0x63, 0x64, 0x63, 0x61, 0x61, 0x36, 0x33, 0x66, 
+0x65, 0x34, 0x37, 0x36, 0x35, 0x31, 0x39, 0x32, 
+0x34, 0x39, 0x37, 0x66, 0x34, 0x37, 0x61, 0x37, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x66, 0x32, 0x32, 0x34, 0x61, 0x39, 0x32, 0x33, 
+0x63, 0x64, 0x30, 0x30, 0x32, 0x31, 0x61, 0x62, 
+0x32, 0x30, 0x32, 0x61, 0x62, 0x31, 0x33, 0x39, 
+0x63, 0x63, 0x35, 0x36, 0x38, 0x30, 0x32, 0x64, 
+0x64, 0x62, 0x39, 0x32, 0x64, 0x63, 0x66, 0x63, 
+0x31, 0x37, 0x32, 0x62, 0x39, 0x32, 0x31, 0x32, 
+0x32, 0x36, 0x31, 0x61, 0x35, 0x33, 0x39, 0x64, 
+0x66, 0x37, 0x39, 0x61, 0x31, 0x31, 0x32, 0x61, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6d, 0x65, 
+0x72, 0x6b, 0x6c, 0x65, 0x52, 0x6f, 0x6f, 0x74, 
+0x22, 0x3a, 0x20, 0x22, 0x36, 0x63, 0x32, 0x64, 
+0x63, 0x31, 0x30, 0x36, 0x61, 0x62, 0x38, 0x31, 
+0x36, 0x62, 0x37, 0x33, 0x66, 0x39, 0x64, 0x30, 
+0x37, 0x65, 0x33, 0x63, 0x64, 0x31, 0x65, 0x66, 
+0x32, 0x63, 0x38, 0x63, 0x31, 0x32, 0x35, 0x36, 
+0x66, 0x35, 0x31, 0x39, 0x37, 0x34, 0x38, 0x65, 
+0x30, 0x38, 0x31, 0x33, 0x65, 0x34, 0x65, 0x64, 
+0x64, 0x32, 0x34, 0x30, 0x35, 0x64, 0x32, 0x37, 
+0x37, 0x62, 0x65, 0x66, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x74, 0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 
+0x22, 0x39, 0x65, 0x30, 0x35, 0x31, 0x37, 0x65, 
+0x64, 0x63, 0x38, 0x32, 0x35, 0x39, 0x62, 0x62, 
+0x33, 0x33, 0x35, 0x39, 0x32, 0x35, 0x35, 0x34, 
+0x30, 0x30, 0x62, 0x32, 0x33, 0x63, 0x61, 0x39, 
+0x35, 0x30, 0x37, 0x66, 0x32, 0x61, 0x39, 0x31, 
+0x63, 0x64, 0x31, 0x65, 0x34, 0x32, 0x35, 0x30, 
+0x62, 0x61, 0x30, 0x36, 0x38, 0x62, 0x34, 0x65, 
+0x61, 0x66, 0x63, 0x65, 0x62, 0x61, 0x34, 0x61, 
+0x39, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 
+0x61, 0x6b, 0x65, 0x64, 0x50, 0x75, 0x62, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x37, 0x31, 
+0x32, 0x34, 0x34, 0x37, 0x32, 0x30, 0x36, 0x64, 
+0x37, 0x61, 0x35, 0x32, 0x33, 0x38, 0x61, 0x63, 
+0x63, 0x37, 0x66, 0x66, 0x35, 0x33, 0x66, 0x62, 
+0x65, 0x39, 0x34, 0x61, 0x33, 0x62, 0x36, 0x34, 
+0x35, 0x33, 0x39, 0x61, 0x64, 0x32, 0x39, 0x31, 
+0x63, 0x37, 0x63, 0x64, 0x62, 0x63, 0x34, 0x39, 
+0x30, 0x62, 0x37, 0x35, 0x37, 0x37, 0x65, 0x34, 
+0x62, 0x31, 0x37, 0x64, 0x66, 0x35, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 
+0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 
+0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 0x37, 0x31, 
+0x32, 0x34, 0x34, 0x37, 0x32, 0x30, 0x36, 0x64, 
+0x37, 0x61, 0x35, 0x32, 0x33, 0x38, 0x61, 0x63, 
+0x63, 0x37, 0x66, 0x66, 0x35, 0x33, 0x66, 0x62, 
+0x65, 0x39, 0x34, 0x61, 0x33, 0x62, 0x36, 0x34, 
+0x35, 0x33, 0x39, 0x61, 0x64, 0x32, 0x39, 0x31, 
+0x63, 0x37, 0x63, 0x64, 0x62, 0x63, 0x34, 0x39, 
+0x30, 0x62, 0x37, 0x35, 0x37, 0x37, 0x65, 0x34, 
+0x62, 0x31, 0x37, 0x64, 0x66, 0x35, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x62, 0x69, 0x70, 0x33, 0x35, 0x30, 
+0x41, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 
+0x3a, 0x20, 0x22, 0x66, 0x63, 0x31, 0x70, 0x77, 
+0x79, 0x6a, 0x79, 0x77, 0x67, 0x72, 0x64, 0x30, 
+0x66, 0x66, 0x72, 0x33, 0x74, 0x78, 0x38, 0x6c, 
+0x61, 0x66, 0x6c, 0x68, 0x36, 0x32, 0x32, 0x38, 
+0x64, 0x6a, 0x39, 0x38, 0x78, 0x6b, 0x6a, 0x6a, 
+0x38, 0x72, 0x75, 0x6d, 0x30, 0x7a, 0x66, 0x70, 
+0x64, 0x36, 0x68, 0x30, 0x65, 0x39, 0x33, 0x30, 
+0x68, 0x36, 0x73, 0x65, 0x66, 0x6d, 0x38, 0x66, 
+0x70, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x50, 0x61, 0x74, 0x68, 0x43, 
+0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x42, 0x6c, 
+0x6f, 0x63, 0x6b, 0x73, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 0x30, 
+0x65, 0x65, 0x34, 0x66, 0x65, 0x30, 0x38, 0x35, 
+0x39, 0x38, 0x33, 0x34, 0x36, 0x32, 0x61, 0x31, 
+0x38, 0x34, 0x30, 0x31, 0x35, 0x64, 0x31, 0x66, 
+0x37, 0x38, 0x32, 0x64, 0x36, 0x61, 0x35, 0x66, 
+0x38, 0x62, 0x39, 0x63, 0x32, 0x62, 0x36, 0x30, 
+0x31, 0x33, 0x30, 0x61, 0x66, 0x66, 0x30, 0x35, 
+0x30, 0x63, 0x65, 0x32, 0x32, 0x31, 0x65, 0x63, 
+0x66, 0x33, 0x37, 0x38, 0x36, 0x35, 0x39, 0x32, 
+0x66, 0x32, 0x32, 0x34, 0x61, 0x39, 0x32, 0x33, 
+0x63, 0x64, 0x30, 0x30, 0x32, 0x31, 0x61, 0x62, 
+0x32, 0x30, 0x32, 0x61, 0x62, 0x31, 0x33, 0x39, 
+0x63, 0x63, 0x35, 0x36, 0x38, 0x30, 0x32, 0x64, 
+0x64, 0x62, 0x39, 0x32, 0x64, 0x63, 0x66, 0x63, 
+0x31, 0x37, 0x32, 0x62, 0x39, 0x32, 0x31, 0x32, 
+0x32, 0x36, 0x31, 0x61, 0x35, 0x33, 0x39, 0x64, 
+0x66, 0x37, 0x39, 0x61, 0x31, 0x31, 0x32, 0x61, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x66, 0x61, 0x65, 0x65, 0x34, 0x66, 0x65, 0x30, 
+0x38, 0x35, 0x39, 0x38, 0x33, 0x34, 0x36, 0x32, 
+0x61, 0x31, 0x38, 0x34, 0x30, 0x31, 0x35, 0x64, 
+0x31, 0x66, 0x37, 0x38, 0x32, 0x64, 0x36, 0x61, 
+0x35, 0x66, 0x38, 0x62, 0x39, 0x63, 0x32, 0x62, 
+0x36, 0x30, 0x31, 0x33, 0x30, 0x61, 0x66, 0x66, 
+0x30, 0x35, 0x30, 0x63, 0x65, 0x32, 0x32, 0x31, 
+0x65, 0x63, 0x66, 0x33, 0x37, 0x38, 0x36, 0x35, 
+0x39, 0x32, 0x38, 0x61, 0x64, 0x36, 0x39, 0x65, 
+0x63, 0x37, 0x63, 0x66, 0x34, 0x31, 0x63, 0x32, 
+0x61, 0x34, 0x30, 0x30, 0x31, 0x66, 0x64, 0x31, 
+0x66, 0x37, 0x33, 0x38, 0x62, 0x66, 0x31, 0x65, 
+0x35, 0x30, 0x35, 0x63, 0x65, 0x32, 0x32, 0x37, 
+0x37, 0x61, 0x63, 0x64, 0x63, 0x61, 0x61, 0x36, 
+0x33, 0x66, 0x65, 0x34, 0x37, 0x36, 0x35, 0x31, 
+0x39, 0x32, 0x34, 0x39, 0x37, 0x66, 0x34, 0x37, 
+0x61, 0x37, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x67, 0x69, 
+0x76, 0x65, 0x6e, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 
+0x6c, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x66, 0x39, 0x66, 0x34, 0x30, 
+0x30, 0x38, 0x30, 0x33, 0x65, 0x36, 0x38, 0x33, 
+0x37, 0x32, 0x37, 0x62, 0x31, 0x34, 0x66, 0x34, 
+0x36, 0x33, 0x38, 0x33, 0x36, 0x65, 0x31, 0x65, 
+0x37, 0x38, 0x65, 0x31, 0x63, 0x36, 0x34, 0x34, 
+0x31, 0x37, 0x36, 0x33, 0x38, 0x61, 0x61, 0x30, 
+0x36, 0x36, 0x39, 0x31, 0x39, 0x32, 0x39, 0x31, 
+0x61, 0x32, 0x32, 0x35, 0x66, 0x30, 0x65, 0x38, 
+0x64, 0x64, 0x38, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 
+0x63, 0x72, 0x69, 0x70, 0x74, 0x54, 0x72, 0x65, 
+0x65, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x64, 0x22, 
+0x3a, 0x20, 0x30, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 
+0x32, 0x30, 0x34, 0x34, 0x62, 0x31, 0x37, 0x38, 
+0x64, 0x36, 0x34, 0x63, 0x33, 0x32, 0x63, 0x34, 
+0x61, 0x30, 0x35, 0x63, 0x63, 0x34, 0x66, 0x34, 
+0x64, 0x31, 0x34, 0x30, 0x37, 0x32, 0x36, 0x38, 
+0x66, 0x37, 0x36, 0x34, 0x63, 0x39, 0x34, 0x30, 
+0x64, 0x32, 0x30, 0x63, 0x65, 0x39, 0x37, 0x61, 
+0x62, 0x66, 0x64, 0x34, 0x34, 0x64, 0x62, 0x35, 
+0x63, 0x33, 0x35, 0x39, 0x32, 0x62, 0x37, 0x32, 
+0x66, 0x64, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x6c, 0x65, 0x61, 0x66, 0x56, 0x65, 0x72, 0x73, 
+0x69, 0x6f, 0x6e, 0x22, 0x3a, 0x20, 0x31, 0x39, 
+0x32, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x64, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x22, 
+0x3a, 0x20, 0x22, 0x30, 0x37, 0x35, 0x34, 0x36, 
+0x31, 0x37, 0x30, 0x37, 0x32, 0x36, 0x66, 0x36, 
+0x66, 0x37, 0x34, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6c, 
+0x65, 0x61, 0x66, 0x56, 0x65, 0x72, 0x73, 0x69, 
+0x6f, 0x6e, 0x22, 0x3a, 0x20, 0x31, 0x39, 0x32, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 
+0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 0x61, 0x72, 
+0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6c, 
+0x65, 0x61, 0x66, 0x48, 0x61, 0x73, 0x68, 0x65, 
+0x73, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x36, 0x34, 0x35, 0x31, 0x32, 
+0x66, 0x65, 0x63, 0x64, 0x62, 0x35, 0x61, 0x66, 
+0x61, 0x30, 0x34, 0x66, 0x39, 0x38, 0x38, 0x33, 
+0x39, 0x62, 0x35, 0x30, 0x65, 0x36, 0x66, 0x30, 
+0x63, 0x62, 0x37, 0x62, 0x31, 0x65, 0x35, 0x33, 
+0x39, 0x62, 0x66, 0x36, 0x66, 0x32, 0x30, 0x35, 
+0x66, 0x36, 0x37, 0x39, 0x33, 0x34, 0x30, 0x38, 
+0x33, 0x63, 0x64, 0x63, 0x63, 0x33, 0x63, 0x38, 
+0x64, 0x38, 0x39, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x32, 0x63, 0x62, 0x32, 0x62, 
+0x39, 0x30, 0x64, 0x61, 0x61, 0x35, 0x34, 0x33, 
+0x62, 0x35, 0x34, 0x34, 0x31, 0x36, 0x31, 0x35, 
+0x33, 0x30, 0x63, 0x39, 0x32, 0x35, 0x66, 0x32, 
+0x38, 0x35, 0x62, 0x30, 0x36, 0x31, 0x39, 0x36, 
+0x39, 0x34, 0x30, 0x64, 0x36, 0x30, 0x38, 0x35, 
+0x63, 0x61, 0x39, 0x34, 0x37, 0x34, 0x64, 0x34, 
+0x31, 0x64, 0x63, 0x33, 0x38, 0x32, 0x32, 0x63, 
+0x35, 0x63, 0x62, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 0x65, 0x52, 
+0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x61, 
+0x62, 0x31, 0x37, 0x39, 0x34, 0x33, 0x31, 0x63, 
+0x32, 0x38, 0x64, 0x33, 0x62, 0x36, 0x38, 0x66, 
+0x62, 0x37, 0x39, 0x38, 0x39, 0x35, 0x37, 0x66, 
+0x61, 0x66, 0x35, 0x34, 0x39, 0x37, 0x64, 0x36, 
+0x39, 0x63, 0x38, 0x38, 0x33, 0x63, 0x36, 0x66, 
+0x62, 0x31, 0x65, 0x31, 0x63, 0x64, 0x39, 0x66, 
+0x38, 0x31, 0x34, 0x38, 0x33, 0x64, 0x38, 0x37, 
+0x62, 0x61, 0x63, 0x39, 0x30, 0x63, 0x63, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 
+0x22, 0x3a, 0x20, 0x22, 0x36, 0x33, 0x39, 0x66, 
+0x30, 0x32, 0x38, 0x31, 0x62, 0x37, 0x61, 0x63, 
+0x34, 0x39, 0x65, 0x37, 0x34, 0x32, 0x63, 0x64, 
+0x32, 0x35, 0x62, 0x37, 0x66, 0x31, 0x38, 0x38, 
+0x36, 0x35, 0x37, 0x36, 0x32, 0x36, 0x64, 0x61, 
+0x31, 0x61, 0x64, 0x31, 0x36, 0x39, 0x32, 0x30, 
+0x39, 0x30, 0x37, 0x38, 0x65, 0x32, 0x37, 0x36, 
+0x31, 0x63, 0x65, 0x66, 0x64, 0x39, 0x31, 0x66, 
+0x64, 0x36, 0x35, 0x65, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x74, 0x77, 0x65, 0x61, 0x6b, 0x65, 0x64, 0x50, 
+0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 
+0x22, 0x37, 0x37, 0x65, 0x33, 0x30, 0x61, 0x35, 
+0x35, 0x32, 0x32, 0x64, 0x64, 0x39, 0x66, 0x38, 
+0x39, 0x34, 0x63, 0x33, 0x66, 0x38, 0x62, 0x38, 
+0x62, 0x64, 0x34, 0x63, 0x34, 0x62, 0x32, 0x63, 
+0x66, 0x38, 0x32, 0x63, 0x61, 0x37, 0x64, 0x61, 
+0x38, 0x61, 0x33, 0x65, 0x61, 0x36, 0x61, 0x32, 
+0x33, 0x39, 0x36, 0x35, 0x35, 0x63, 0x33, 0x39, 
+0x63, 0x30, 0x35, 0x30, 0x61, 0x62, 0x32, 0x32, 
+0x30, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 
+0x78, 0x70, 0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 
+0x79, 0x22, 0x3a, 0x20, 0x22, 0x34, 0x66, 0x32, 
+0x30, 0x37, 0x37, 0x65, 0x33, 0x30, 0x61, 0x35, 
+0x35, 0x32, 0x32, 0x64, 0x64, 0x39, 0x66, 0x38, 
+0x39, 0x34, 0x63, 0x33, 0x66, 0x38, 0x62, 0x38, 
+0x62, 0x64, 0x34, 0x63, 0x34, 0x62, 0x32, 0x63, 
+0x66, 0x38, 0x32, 0x63, 0x61, 0x37, 0x64, 0x61, 
+0x38, 0x61, 0x33, 0x65, 0x61, 0x36, 0x61, 0x32, 
+0x33, 0x39, 0x36, 0x35, 0x35, 0x63, 0x33, 0x39, 
+0x63, 0x30, 0x35, 0x30, 0x61, 0x62, 0x32, 0x32, 
+0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x62, 0x69, 0x70, 
+0x33, 0x35, 0x30, 0x41, 0x64, 0x64, 0x72, 0x65, 
+0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x66, 0x63, 
+0x31, 0x70, 0x77, 0x6c, 0x33, 0x73, 0x35, 0x34, 
+0x66, 0x7a, 0x6d, 0x6b, 0x30, 0x63, 0x6a, 0x6e, 
+0x70, 0x6c, 0x33, 0x77, 0x39, 0x61, 0x66, 0x33, 
+0x39, 0x6a, 0x65, 0x37, 0x70, 0x76, 0x35, 0x6c, 
+0x64, 0x67, 0x35, 0x30, 0x34, 0x78, 0x35, 0x67, 
+0x75, 0x6b, 0x32, 0x68, 0x70, 0x65, 0x63, 0x70, 
+0x67, 0x32, 0x6b, 0x67, 0x73, 0x71, 0x65, 0x66, 
+0x64, 0x30, 0x63, 0x36, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 0x61, 
+0x74, 0x68, 0x43, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 
+0x6c, 0x42, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x22, 
+0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x63, 0x31, 0x66, 0x39, 0x66, 0x34, 0x30, 
+0x30, 0x38, 0x30, 0x33, 0x65, 0x36, 0x38, 0x33, 
+0x37, 0x32, 0x37, 0x62, 0x31, 0x34, 0x66, 0x34, 
+0x36, 0x33, 0x38, 0x33, 0x36, 0x65, 0x31, 0x65, 
+0x37, 0x38, 0x65, 0x31, 0x63, 0x36, 0x34, 0x34, 
+0x31, 0x37, 0x36, 0x33, 0x38, 0x61, 0x61, 0x30, 
+0x36, 0x36, 0x39, 0x31, 0x39, 0x32, 0x39, 0x31, 
+0x61, 0x32, 0x32, 0x35, 0x66, 0x30, 0x65, 0x38, 
+0x64, 0x64, 0x38, 0x32, 0x63, 0x62, 0x32, 0x62, 
+0x39, 0x30, 0x64, 0x61, 0x61, 0x35, 0x34, 0x33, 
+0x62, 0x35, 0x34, 0x34, 0x31, 0x36, 0x31, 0x35, 
+0x33, 0x30, 0x63, 0x39, 0x32, 0x35, 0x66, 0x32, 
+0x38, 0x35, 0x62, 0x30, 0x36, 0x31, 0x39, 0x36, 
+0x39, 0x34, 0x30, 0x64, 0x36, 0x30, 0x38, 0x35, 
+0x63, 0x61, 0x39, 0x34, 0x37, 0x34, 0x64, 0x34, 
+0x31, 0x64, 0x63, 0x33, 0x38, 0x32, 0x32, 0x63, 
+0x35, 0x63, 0x62, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x63, 0x31, 0x66, 0x39, 0x66, 
+0x34, 0x30, 0x30, 0x38, 0x30, 0x33, 0x65, 0x36, 
+0x38, 0x33, 0x37, 0x32, 0x37, 0x62, 0x31, 0x34, 
+0x66, 0x34, 0x36, 0x33, 0x38, 0x33, 0x36, 0x65, 
+0x31, 0x65, 0x37, 0x38, 0x65, 0x31, 0x63, 0x36, 
+0x34, 0x34, 0x31, 0x37, 0x36, 0x33, 0x38, 0x61, 
+0x61, 0x30, 0x36, 0x36, 0x39, 0x31, 0x39, 0x32, 
+0x39, 0x31, 0x61, 0x32, 0x32, 0x35, 0x66, 0x30, 
+0x65, 0x38, 0x64, 0x64, 0x38, 0x36, 0x34, 0x35, 
+0x31, 0x32, 0x66, 0x65, 0x63, 0x64, 0x62, 0x35, 
+0x61, 0x66, 0x61, 0x30, 0x34, 0x66, 0x39, 0x38, 
+0x38, 0x33, 0x39, 0x62, 0x35, 0x30, 0x65, 0x36, 
+0x66, 0x30, 0x63, 0x62, 0x37, 0x62, 0x31, 0x65, 
+0x35, 0x33, 0x39, 0x62, 0x66, 0x36, 0x66, 0x32, 
+0x30, 0x35, 0x66, 0x36, 0x37, 0x39, 0x33, 0x34, 
+0x30, 0x38, 0x33, 0x63, 0x64, 0x63, 0x63, 0x33, 
+0x63, 0x38, 0x64, 0x38, 0x39, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 
+0x72, 0x6e, 0x61, 0x6c, 0x50, 0x75, 0x62, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x65, 0x30, 
+0x64, 0x66, 0x65, 0x32, 0x33, 0x30, 0x30, 0x62, 
+0x30, 0x64, 0x64, 0x37, 0x34, 0x36, 0x61, 0x33, 
+0x66, 0x38, 0x36, 0x37, 0x34, 0x64, 0x66, 0x64, 
+0x34, 0x35, 0x32, 0x35, 0x36, 0x32, 0x33, 0x36, 
+0x33, 0x39, 0x30, 0x34, 0x32, 0x35, 0x36, 0x39, 
+0x64, 0x38, 0x32, 0x39, 0x63, 0x37, 0x66, 0x30, 
+0x65, 0x65, 0x64, 0x39, 0x36, 0x30, 0x32, 0x64, 
+0x32, 0x36, 0x33, 0x65, 0x36, 0x66, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x54, 0x72, 0x65, 0x65, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x64, 0x22, 0x3a, 0x20, 0x30, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x22, 
+0x3a, 0x20, 0x22, 0x32, 0x30, 0x37, 0x32, 0x65, 
+0x61, 0x36, 0x61, 0x64, 0x63, 0x66, 0x31, 0x64, 
+0x33, 0x37, 0x31, 0x64, 0x65, 0x61, 0x38, 0x66, 
+0x62, 0x61, 0x31, 0x30, 0x33, 0x35, 0x61, 0x30, 
+0x39, 0x66, 0x33, 0x64, 0x32, 0x34, 0x65, 0x64, 
+0x35, 0x61, 0x30, 0x35, 0x39, 0x37, 0x39, 0x39, 
+0x62, 0x61, 0x65, 0x31, 0x31, 0x34, 0x30, 0x38, 
+0x34, 0x31, 0x33, 0x30, 0x65, 0x65, 0x35, 0x38, 
+0x39, 0x38, 0x65, 0x36, 0x39, 0x61, 0x63, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 0x56, 
+0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 
+0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x64, 0x22, 0x3a, 0x20, 0x31, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 
+0x32, 0x30, 0x32, 0x33, 0x35, 0x32, 0x64, 0x31, 
+0x33, 0x37, 0x66, 0x32, 0x66, 0x33, 0x61, 0x62, 
+0x33, 0x38, 0x64, 0x31, 0x65, 0x61, 0x61, 0x39, 
+0x37, 0x36, 0x37, 0x35, 0x38, 0x38, 0x37, 0x33, 
+0x33, 0x37, 0x37, 0x66, 0x61, 0x35, 0x65, 0x62, 
+0x62, 0x38, 0x31, 0x37, 0x33, 0x37, 0x32, 0x63, 
+0x37, 0x31, 0x65, 0x32, 0x63, 0x35, 0x34, 0x32, 
+0x33, 0x31, 0x33, 0x64, 0x34, 0x61, 0x62, 0x64, 
+0x61, 0x38, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 
+0x56, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 
+0x3a, 0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x64, 0x22, 0x3a, 0x20, 0x32, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 
+0x30, 0x37, 0x33, 0x33, 0x37, 0x63, 0x30, 0x64, 
+0x64, 0x34, 0x32, 0x35, 0x33, 0x63, 0x62, 0x38, 
+0x36, 0x66, 0x32, 0x63, 0x34, 0x33, 0x61, 0x32, 
+0x33, 0x35, 0x31, 0x61, 0x61, 0x64, 0x64, 0x38, 
+0x32, 0x63, 0x63, 0x63, 0x62, 0x31, 0x32, 0x61, 
+0x31, 0x37, 0x32, 0x63, 0x64, 0x31, 0x32, 0x30, 
+0x34, 0x35, 0x32, 0x62, 0x39, 0x62, 0x62, 0x38, 
+0x33, 0x32, 0x34, 0x66, 0x32, 0x31, 0x38, 0x36, 
+0x61, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 0x56, 
+0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 
+0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6d, 0x65, 0x64, 0x69, 0x61, 0x72, 0x79, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 
+0x66, 0x48, 0x61, 0x73, 0x68, 0x65, 0x73, 0x22, 
+0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x32, 0x36, 0x34, 0x35, 0x61, 0x30, 0x32, 
+0x65, 0x30, 0x61, 0x61, 0x63, 0x31, 0x66, 0x65, 
+0x36, 0x39, 0x64, 0x36, 0x39, 0x37, 0x35, 0x35, 
+0x37, 0x33, 0x33, 0x61, 0x39, 0x62, 0x37, 0x36, 
+0x32, 0x31, 0x62, 0x36, 0x39, 0x34, 0x62, 0x62, 
+0x35, 0x62, 0x35, 0x63, 0x64, 0x65, 0x32, 0x62, 
+0x62, 0x66, 0x63, 0x39, 0x34, 0x30, 0x36, 0x36, 
+0x65, 0x64, 0x36, 0x32, 0x62, 0x39, 0x38, 0x31, 
+0x37, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x62, 0x61, 0x39, 0x38, 0x32, 0x61, 0x39, 
+0x31, 0x64, 0x34, 0x66, 0x63, 0x35, 0x35, 0x32, 
+0x31, 0x36, 0x33, 0x63, 0x62, 0x31, 0x63, 0x30, 
+0x64, 0x61, 0x30, 0x33, 0x36, 0x37, 0x36, 0x31, 
+0x30, 0x32, 0x64, 0x35, 0x62, 0x37, 0x61, 0x30, 
+0x31, 0x34, 0x33, 0x30, 0x34, 0x63, 0x30, 0x31, 
+0x66, 0x30, 0x63, 0x37, 0x37, 0x62, 0x32, 0x62, 
+0x38, 0x65, 0x38, 0x38, 0x38, 0x64, 0x65, 0x31, 
+0x63, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x39, 0x65, 0x33, 0x31, 0x34, 0x30, 0x37, 
+0x62, 0x66, 0x66, 0x61, 0x31, 0x35, 0x66, 0x65, 
+0x66, 0x62, 0x66, 0x35, 0x30, 0x39, 0x30, 0x62, 
+0x31, 0x34, 0x39, 0x64, 0x35, 0x33, 0x39, 0x35, 
+0x39, 0x65, 0x63, 0x64, 0x66, 0x33, 0x66, 0x36, 
+0x32, 0x62, 0x31, 0x32, 0x34, 0x36, 0x37, 0x38, 
+0x30, 0x32, 0x33, 0x38, 0x63, 0x32, 0x34, 0x35, 
+0x30, 0x31, 0x64, 0x35, 0x63, 0x65, 0x61, 0x66, 
+0x36, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6d, 
+0x65, 0x72, 0x6b, 0x6c, 0x65, 0x52, 0x6f, 0x6f, 
+0x74, 0x22, 0x3a, 0x20, 0x22, 0x63, 0x63, 0x62, 
+0x64, 0x36, 0x36, 0x63, 0x36, 0x66, 0x37, 0x65, 
+0x38, 0x66, 0x64, 0x61, 0x62, 0x34, 0x37, 0x62, 
+0x33, 0x61, 0x34, 0x38, 0x36, 0x66, 0x35, 0x39, 
+0x64, 0x32, 0x38, 0x32, 0x36, 0x32, 0x62, 0x65, 
+0x38, 0x35, 0x37, 0x66, 0x33, 0x30, 0x64, 0x34, 
+0x37, 0x37, 0x33, 0x66, 0x32, 0x64, 0x35, 0x65, 
+0x61, 0x34, 0x37, 0x66, 0x37, 0x37, 0x36, 0x31, 
+0x63, 0x65, 0x30, 0x65, 0x32, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 
+0x20, 0x22, 0x62, 0x35, 0x37, 0x62, 0x66, 0x61, 
+0x31, 0x38, 0x33, 0x64, 0x32, 0x38, 0x65, 0x65, 
+0x62, 0x36, 0x61, 0x64, 0x36, 0x38, 0x38, 0x64, 
+0x64, 0x61, 0x61, 0x62, 0x62, 0x32, 0x36, 0x35, 
+0x62, 0x34, 0x61, 0x34, 0x31, 0x66, 0x62, 0x66, 
+0x36, 0x38, 0x65, 0x35, 0x66, 0x65, 0x64, 0x32, 
+0x63, 0x37, 0x32, 0x63, 0x37, 0x34, 0x64, 0x65, 
+0x37, 0x30, 0x64, 0x35, 0x61, 0x37, 0x38, 0x36, 
+0x66, 0x34, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x65, 0x64, 0x50, 0x75, 0x62, 
+0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x39, 
+0x31, 0x62, 0x36, 0x34, 0x64, 0x35, 0x33, 0x32, 
+0x34, 0x37, 0x32, 0x33, 0x61, 0x39, 0x38, 0x35, 
+0x31, 0x37, 0x30, 0x65, 0x34, 0x64, 0x63, 0x35, 
+0x61, 0x30, 0x66, 0x38, 0x34, 0x63, 0x30, 0x34, 
+0x31, 0x38, 0x30, 0x34, 0x66, 0x32, 0x63, 0x64, 
+0x31, 0x32, 0x36, 0x36, 0x30, 0x66, 0x61, 0x35, 
+0x64, 0x65, 0x63, 0x30, 0x39, 0x66, 0x63, 0x32, 
+0x31, 0x37, 0x38, 0x33, 0x36, 0x30, 0x35, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 
+0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 
+0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 0x39, 
+0x31, 0x62, 0x36, 0x34, 0x64, 0x35, 0x33, 0x32, 
+0x34, 0x37, 0x32, 0x33, 0x61, 0x39, 0x38, 0x35, 
+0x31, 0x37, 0x30, 0x65, 0x34, 0x64, 0x63, 0x35, 
+0x61, 0x30, 0x66, 0x38, 0x34, 0x63, 0x30, 0x34, 
+0x31, 0x38, 0x30, 0x34, 0x66, 0x32, 0x63, 0x64, 
+0x31, 0x32, 0x36, 0x36, 0x30, 0x66, 0x61, 0x35, 
+0x64, 0x65, 0x63, 0x30, 0x39, 0x66, 0x63, 0x32, 
+0x31, 0x37, 0x38, 0x33, 0x36, 0x30, 0x35, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x62, 0x69, 0x70, 0x33, 0x35, 
+0x30, 0x41, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x66, 0x63, 0x31, 0x70, 
+0x6a, 0x78, 0x6d, 0x79, 0x36, 0x35, 0x65, 0x79, 
+0x77, 0x67, 0x61, 0x66, 0x73, 0x35, 0x74, 0x73, 
+0x75, 0x6e, 0x77, 0x39, 0x35, 0x72, 0x75, 0x79, 
+0x63, 0x70, 0x71, 0x63, 0x71, 0x6e, 0x65, 0x76, 
+0x36, 0x79, 0x6e, 0x78, 0x70, 0x37, 0x6a, 0x61, 
+0x61, 0x73, 0x79, 0x6c, 0x63, 0x67, 0x74, 0x63, 
+0x78, 0x63, 0x7a, 0x73, 0x37, 0x36, 0x76, 0x34, 
+0x71, 0x72, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x50, 0x61, 0x74, 0x68, 
+0x43, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x42, 
+0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 
+0x30, 0x65, 0x30, 0x64, 0x66, 0x65, 0x32, 0x33, 
+0x30, 0x30, 0x62, 0x30, 0x64, 0x64, 0x37, 0x34, 
+0x36, 0x61, 0x33, 0x66, 0x38, 0x36, 0x37, 0x34, 
+0x64, 0x66, 0x64, 0x34, 0x35, 0x32, 0x35, 0x36, 
+0x32, 0x33, 0x36, 0x33, 0x39, 0x30, 0x34, 0x32, 
+0x35, 0x36, 0x39, 0x64, 0x38, 0x32, 0x39, 0x63, 
+0x37, 0x66, 0x30, 0x65, 0x65, 0x64, 0x39, 0x36, 
+0x30, 0x32, 0x64, 0x32, 0x36, 0x33, 0x65, 0x36, 
+0x66, 0x66, 0x66, 0x65, 0x35, 0x37, 0x38, 0x65, 
+0x39, 0x65, 0x61, 0x37, 0x36, 0x39, 0x30, 0x32, 
+0x37, 0x65, 0x34, 0x66, 0x35, 0x61, 0x33, 0x64, 
+0x65, 0x34, 0x30, 0x37, 0x33, 0x32, 0x66, 0x37, 
+0x35, 0x61, 0x38, 0x38, 0x61, 0x36, 0x33, 0x35, 
+0x33, 0x61, 0x30, 0x39, 0x64, 0x37, 0x36, 0x37, 
+0x64, 0x64, 0x65, 0x62, 0x36, 0x36, 0x61, 0x63, 
+0x63, 0x65, 0x66, 0x38, 0x35, 0x65, 0x35, 0x35, 
+0x33, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x63, 0x30, 0x65, 0x30, 0x64, 0x66, 0x65, 
+0x32, 0x33, 0x30, 0x30, 0x62, 0x30, 0x64, 0x64, 
+0x37, 0x34, 0x36, 0x61, 0x33, 0x66, 0x38, 0x36, 
+0x37, 0x34, 0x64, 0x66, 0x64, 0x34, 0x35, 0x32, 
+0x35, 0x36, 0x32, 0x33, 0x36, 0x33, 0x39, 0x30, 
+0x34, 0x32, 0x35, 0x36, 0x39, 0x64, 0x38, 0x32, 
+0x39, 0x63, 0x37, 0x66, 0x30, 0x65, 0x65, 0x64, 
+0x39, 0x36, 0x30, 0x32, 0x64, 0x32, 0x36, 0x33, 
+0x65, 0x36, 0x66, 0x39, 0x65, 0x33, 0x31, 0x34, 
+0x30, 0x37, 0x62, 0x66, 0x66, 0x61, 0x31, 0x35, 
+0x66, 0x65, 0x66, 0x62, 0x66, 0x35, 0x30, 0x39, 
+0x30, 0x62, 0x31, 0x34, 0x39, 0x64, 0x35, 0x33, 
+0x39, 0x35, 0x39, 0x65, 0x63, 0x64, 0x66, 0x33, 
+0x66, 0x36, 0x32, 0x62, 0x31, 0x32, 0x34, 0x36, 
+0x37, 0x38, 0x30, 0x32, 0x33, 0x38, 0x63, 0x32, 
+0x34, 0x35, 0x30, 0x31, 0x64, 0x35, 0x63, 0x65, 
+0x61, 0x66, 0x36, 0x32, 0x36, 0x34, 0x35, 0x61, 
+0x30, 0x32, 0x65, 0x30, 0x61, 0x61, 0x63, 0x31, 
+0x66, 0x65, 0x36, 0x39, 0x64, 0x36, 0x39, 0x37, 
+0x35, 0x35, 0x37, 0x33, 0x33, 0x61, 0x39, 0x62, 
+0x37, 0x36, 0x32, 0x31, 0x62, 0x36, 0x39, 0x34, 
+0x62, 0x62, 0x35, 0x62, 0x35, 0x63, 0x64, 0x65, 
+0x32, 0x62, 0x62, 0x66, 0x63, 0x39, 0x34, 0x30, 
+0x36, 0x36, 0x65, 0x64, 0x36, 0x32, 0x62, 0x39, 
+0x38, 0x31, 0x37, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x63, 0x30, 0x65, 0x30, 0x64, 
+0x66, 0x65, 0x32, 0x33, 0x30, 0x30, 0x62, 0x30, 
+0x64, 0x64, 0x37, 0x34, 0x36, 0x61, 0x33, 0x66, 
+0x38, 0x36, 0x37, 0x34, 0x64, 0x66, 0x64, 0x34, 
+0x35, 0x32, 0x35, 0x36, 0x32, 0x33, 0x36, 0x33, 
+0x39, 0x30, 0x34, 0x32, 0x35, 0x36, 0x39, 0x64, 
+0x38, 0x32, 0x39, 0x63, 0x37, 0x66, 0x30, 0x65, 
+0x65, 0x64, 0x39, 0x36, 0x30, 0x32, 0x64, 0x32, 
+0x36, 0x33, 0x65, 0x36, 0x66, 0x62, 0x61, 0x39, 
+0x38, 0x32, 0x61, 0x39, 0x31, 0x64, 0x34, 0x66, 
+0x63, 0x35, 0x35, 0x32, 0x31, 0x36, 0x33, 0x63, 
+0x62, 0x31, 0x63, 0x30, 0x64, 0x61, 0x30, 0x33, 
+0x36, 0x37, 0x36, 0x31, 0x30, 0x32, 0x64, 0x35, 
+0x62, 0x37, 0x61, 0x30, 0x31, 0x34, 0x33, 0x30, 
+0x34, 0x63, 0x30, 0x31, 0x66, 0x30, 0x63, 0x37, 
+0x37, 0x62, 0x32, 0x62, 0x38, 0x65, 0x38, 0x38, 
+0x38, 0x64, 0x65, 0x31, 0x63, 0x32, 0x36, 0x34, 
+0x35, 0x61, 0x30, 0x32, 0x65, 0x30, 0x61, 0x61, 
+0x63, 0x31, 0x66, 0x65, 0x36, 0x39, 0x64, 0x36, 
+0x39, 0x37, 0x35, 0x35, 0x37, 0x33, 0x33, 0x61, 
+0x39, 0x62, 0x37, 0x36, 0x32, 0x31, 0x62, 0x36, 
+0x39, 0x34, 0x62, 0x62, 0x35, 0x62, 0x35, 0x63, 
+0x64, 0x65, 0x32, 0x62, 0x62, 0x66, 0x63, 0x39, 
+0x34, 0x30, 0x36, 0x36, 0x65, 0x64, 0x36, 0x32, 
+0x62, 0x39, 0x38, 0x31, 0x37, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 
+0x72, 0x6e, 0x61, 0x6c, 0x50, 0x75, 0x62, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x35, 0x35, 
+0x61, 0x64, 0x66, 0x34, 0x65, 0x38, 0x39, 0x36, 
+0x37, 0x66, 0x62, 0x64, 0x32, 0x65, 0x32, 0x39, 
+0x66, 0x32, 0x30, 0x61, 0x63, 0x38, 0x39, 0x36, 
+0x65, 0x36, 0x30, 0x63, 0x33, 0x62, 0x30, 0x66, 
+0x31, 0x64, 0x35, 0x62, 0x30, 0x65, 0x66, 0x61, 
+0x39, 0x64, 0x33, 0x34, 0x39, 0x34, 0x31, 0x62, 
+0x35, 0x39, 0x35, 0x38, 0x63, 0x37, 0x62, 0x30, 
+0x61, 0x30, 0x33, 0x31, 0x32, 0x64, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x54, 0x72, 0x65, 0x65, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x64, 0x22, 0x3a, 0x20, 0x30, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x22, 
+0x3a, 0x20, 0x22, 0x32, 0x30, 0x37, 0x31, 0x39, 
+0x38, 0x31, 0x35, 0x32, 0x31, 0x61, 0x64, 0x39, 
+0x66, 0x63, 0x39, 0x30, 0x33, 0x36, 0x36, 0x38, 
+0x37, 0x33, 0x36, 0x34, 0x31, 0x31, 0x38, 0x66, 
+0x62, 0x36, 0x63, 0x63, 0x64, 0x32, 0x30, 0x33, 
+0x35, 0x62, 0x39, 0x36, 0x61, 0x34, 0x32, 0x33, 
+0x63, 0x35, 0x39, 0x63, 0x35, 0x34, 0x33, 0x30, 
+0x65, 0x39, 0x38, 0x33, 0x31, 0x30, 0x61, 0x31, 
+0x31, 0x61, 0x62, 0x65, 0x32, 0x61, 0x63, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 0x56, 
+0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 
+0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x64, 0x22, 0x3a, 0x20, 0x31, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 
+0x32, 0x30, 0x64, 0x35, 0x30, 0x39, 0x34, 0x64, 
+0x32, 0x64, 0x62, 0x65, 0x39, 0x62, 0x37, 0x36, 
+0x65, 0x32, 0x63, 0x32, 0x34, 0x35, 0x61, 0x32, 
+0x62, 0x38, 0x39, 0x62, 0x36, 0x30, 0x30, 0x36, 
+0x38, 0x38, 0x38, 0x39, 0x35, 0x32, 0x65, 0x32, 
+0x66, 0x61, 0x61, 0x36, 0x61, 0x31, 0x34, 0x39, 
+0x61, 0x65, 0x33, 0x31, 0x38, 0x64, 0x36, 0x39, 
+0x65, 0x35, 0x32, 0x30, 0x36, 0x31, 0x37, 0x37, 
+0x34, 0x38, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 
+0x56, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 
+0x3a, 0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x64, 0x22, 0x3a, 0x20, 0x32, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 
+0x30, 0x63, 0x34, 0x34, 0x30, 0x62, 0x34, 0x36, 
+0x32, 0x61, 0x64, 0x34, 0x38, 0x63, 0x37, 0x61, 
+0x37, 0x37, 0x66, 0x39, 0x34, 0x63, 0x64, 0x34, 
+0x35, 0x33, 0x32, 0x64, 0x38, 0x66, 0x32, 0x31, 
+0x31, 0x39, 0x64, 0x63, 0x65, 0x62, 0x62, 0x64, 
+0x37, 0x63, 0x39, 0x37, 0x36, 0x34, 0x35, 0x35, 
+0x37, 0x65, 0x36, 0x32, 0x37, 0x32, 0x36, 0x34, 
+0x31, 0x39, 0x62, 0x30, 0x38, 0x61, 0x64, 0x34, 
+0x63, 0x61, 0x63, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 0x66, 0x56, 
+0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 
+0x20, 0x31, 0x39, 0x32, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6d, 0x65, 0x64, 0x69, 0x61, 0x72, 0x79, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x6c, 0x65, 0x61, 
+0x66, 0x48, 0x61, 0x73, 0x68, 0x65, 0x73, 0x22, 
+0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x66, 0x31, 0x35, 0x34, 0x65, 0x38, 0x65, 
+0x38, 0x65, 0x31, 0x37, 0x63, 0x33, 0x31, 0x64, 
+0x33, 0x34, 0x36, 0x32, 0x64, 0x37, 0x31, 0x33, 
+0x32, 0x35, 0x38, 0x39, 0x65, 0x64, 0x32, 0x39, 
+0x33, 0x35, 0x33, 0x63, 0x36, 0x66, 0x61, 0x66, 
+0x64, 0x62, 0x38, 0x38, 0x34, 0x63, 0x35, 0x61, 
+0x36, 0x65, 0x30, 0x34, 0x65, 0x61, 0x39, 0x33, 
+0x38, 0x38, 0x33, 0x34, 0x66, 0x30, 0x64, 0x39, 
+0x64, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x37, 0x33, 0x37, 0x65, 0x64, 0x31, 0x66, 
+0x65, 0x33, 0x30, 0x62, 0x63, 0x34, 0x32, 0x62, 
+0x38, 0x30, 0x32, 0x32, 0x64, 0x37, 0x31, 0x37, 
+0x62, 0x34, 0x34, 0x66, 0x30, 0x64, 0x39, 0x33, 
+0x35, 0x31, 0x36, 0x36, 0x31, 0x37, 0x61, 0x66, 
+0x36, 0x34, 0x61, 0x36, 0x34, 0x37, 0x35, 0x33, 
+0x62, 0x37, 0x61, 0x30, 0x36, 0x62, 0x66, 0x31, 
+0x36, 0x62, 0x32, 0x36, 0x63, 0x64, 0x37, 0x31, 
+0x31, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x64, 0x37, 0x34, 0x38, 0x35, 0x30, 0x32, 
+0x35, 0x66, 0x63, 0x65, 0x62, 0x37, 0x38, 0x62, 
+0x39, 0x65, 0x64, 0x36, 0x36, 0x37, 0x64, 0x62, 
+0x33, 0x36, 0x65, 0x64, 0x38, 0x62, 0x38, 0x64, 
+0x63, 0x37, 0x62, 0x31, 0x66, 0x30, 0x62, 0x33, 
+0x30, 0x37, 0x61, 0x63, 0x31, 0x36, 0x37, 0x66, 
+0x61, 0x35, 0x31, 0x36, 0x66, 0x65, 0x34, 0x33, 
+0x35, 0x32, 0x62, 0x39, 0x66, 0x34, 0x65, 0x66, 
+0x37, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x6d, 
+0x65, 0x72, 0x6b, 0x6c, 0x65, 0x52, 0x6f, 0x6f, 
+0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 0x66, 0x36, 
+0x62, 0x32, 0x63, 0x35, 0x33, 0x39, 0x37, 0x62, 
+0x36, 0x64, 0x36, 0x38, 0x63, 0x61, 0x31, 0x38, 
+0x65, 0x30, 0x39, 0x61, 0x33, 0x66, 0x30, 0x35, 
+0x31, 0x36, 0x31, 0x36, 0x36, 0x38, 0x66, 0x66, 
+0x65, 0x39, 0x33, 0x61, 0x39, 0x38, 0x38, 0x35, 
+0x38, 0x32, 0x64, 0x35, 0x35, 0x63, 0x36, 0x66, 
+0x30, 0x37, 0x62, 0x64, 0x35, 0x62, 0x33, 0x33, 
+0x32, 0x39, 0x64, 0x65, 0x66, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 
+0x20, 0x22, 0x36, 0x35, 0x37, 0x39, 0x31, 0x33, 
+0x38, 0x65, 0x37, 0x39, 0x37, 0x36, 0x64, 0x63, 
+0x31, 0x33, 0x62, 0x36, 0x61, 0x39, 0x32, 0x66, 
+0x37, 0x62, 0x66, 0x64, 0x35, 0x61, 0x32, 0x66, 
+0x63, 0x37, 0x36, 0x38, 0x34, 0x66, 0x35, 0x65, 
+0x61, 0x34, 0x32, 0x34, 0x31, 0x39, 0x64, 0x34, 
+0x33, 0x33, 0x36, 0x38, 0x33, 0x30, 0x31, 0x34, 
+0x37, 0x30, 0x66, 0x33, 0x62, 0x37, 0x34, 0x65, 
+0x64, 0x39, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x65, 0x64, 0x50, 0x75, 0x62, 
+0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x37, 
+0x35, 0x31, 0x36, 0x39, 0x66, 0x34, 0x30, 0x30, 
+0x31, 0x61, 0x61, 0x36, 0x38, 0x66, 0x31, 0x35, 
+0x62, 0x62, 0x65, 0x64, 0x32, 0x38, 0x62, 0x32, 
+0x31, 0x38, 0x64, 0x66, 0x31, 0x64, 0x30, 0x61, 
+0x36, 0x32, 0x63, 0x62, 0x62, 0x63, 0x66, 0x31, 
+0x31, 0x38, 0x38, 0x63, 0x36, 0x36, 0x36, 0x35, 
+0x31, 0x31, 0x30, 0x63, 0x32, 0x39, 0x33, 0x63, 
+0x39, 0x30, 0x37, 0x62, 0x38, 0x33, 0x31, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 
+0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 
+0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 0x37, 
+0x35, 0x31, 0x36, 0x39, 0x66, 0x34, 0x30, 0x30, 
+0x31, 0x61, 0x61, 0x36, 0x38, 0x66, 0x31, 0x35, 
+0x62, 0x62, 0x65, 0x64, 0x32, 0x38, 0x62, 0x32, 
+0x31, 0x38, 0x64, 0x66, 0x31, 0x64, 0x30, 0x61, 
+0x36, 0x32, 0x63, 0x62, 0x62, 0x63, 0x66, 0x31, 
+0x31, 0x38, 0x38, 0x63, 0x36, 0x36, 0x36, 0x35, 
+0x31, 0x31, 0x30, 0x63, 0x32, 0x39, 0x33, 0x63, 
+0x39, 0x30, 0x37, 0x62, 0x38, 0x33, 0x31, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x62, 0x69, 0x70, 0x33, 0x35, 
+0x30, 0x41, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x66, 0x63, 0x31, 0x70, 
+0x77, 0x35, 0x74, 0x66, 0x37, 0x73, 0x71, 0x70, 
+0x34, 0x66, 0x35, 0x30, 0x7a, 0x6b, 0x61, 0x37, 
+0x36, 0x32, 0x39, 0x6a, 0x72, 0x72, 0x30, 0x33, 
+0x36, 0x7a, 0x6e, 0x7a, 0x65, 0x77, 0x37, 0x30, 
+0x7a, 0x78, 0x79, 0x76, 0x76, 0x65, 0x6a, 0x33, 
+0x7a, 0x72, 0x70, 0x66, 0x38, 0x6a, 0x67, 0x38, 
+0x68, 0x71, 0x63, 0x73, 0x35, 0x64, 0x70, 0x61, 
+0x79, 0x72, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x50, 0x61, 0x74, 0x68, 
+0x43, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x42, 
+0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 
+0x31, 0x35, 0x35, 0x61, 0x64, 0x66, 0x34, 0x65, 
+0x38, 0x39, 0x36, 0x37, 0x66, 0x62, 0x64, 0x32, 
+0x65, 0x32, 0x39, 0x66, 0x32, 0x30, 0x61, 0x63, 
+0x38, 0x39, 0x36, 0x65, 0x36, 0x30, 0x63, 0x33, 
+0x62, 0x30, 0x66, 0x31, 0x64, 0x35, 0x62, 0x30, 
+0x65, 0x66, 0x61, 0x39, 0x64, 0x33, 0x34, 0x39, 
+0x34, 0x31, 0x62, 0x35, 0x39, 0x35, 0x38, 0x63, 
+0x37, 0x62, 0x30, 0x61, 0x30, 0x33, 0x31, 0x32, 
+0x64, 0x33, 0x63, 0x64, 0x33, 0x36, 0x39, 0x61, 
+0x35, 0x32, 0x38, 0x62, 0x33, 0x32, 0x36, 0x62, 
+0x63, 0x39, 0x64, 0x32, 0x31, 0x33, 0x33, 0x63, 
+0x62, 0x64, 0x32, 0x61, 0x63, 0x32, 0x31, 0x34, 
+0x35, 0x31, 0x61, 0x63, 0x62, 0x33, 0x31, 0x36, 
+0x38, 0x31, 0x61, 0x34, 0x31, 0x30, 0x34, 0x33, 
+0x34, 0x36, 0x37, 0x32, 0x63, 0x38, 0x65, 0x33, 
+0x34, 0x66, 0x65, 0x37, 0x35, 0x37, 0x65, 0x39, 
+0x31, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x63, 0x31, 0x35, 0x35, 0x61, 0x64, 0x66, 
+0x34, 0x65, 0x38, 0x39, 0x36, 0x37, 0x66, 0x62, 
+0x64, 0x32, 0x65, 0x32, 0x39, 0x66, 0x32, 0x30, 
+0x61, 0x63, 0x38, 0x39, 0x36, 0x65, 0x36, 0x30, 
+0x63, 0x33, 0x62, 0x30, 0x66, 0x31, 0x64, 0x35, 
+0x62, 0x30, 0x65, 0x66, 0x61, 0x39, 0x64, 0x33, 
+0x34, 0x39, 0x34, 0x31, 0x62, 0x35, 0x39, 0x35, 
+0x38, 0x63, 0x37, 0x62, 0x30, 0x61, 0x30, 0x33, 
+0x31, 0x32, 0x64, 0x64, 0x37, 0x34, 0x38, 0x35, 
+0x30, 0x32, 0x35, 0x66, 0x63, 0x65, 0x62, 0x37, 
+0x38, 0x62, 0x39, 0x65, 0x64, 0x36, 0x36, 0x37, 
+0x64, 0x62, 0x33, 0x36, 0x65, 0x64, 0x38, 0x62, 
+0x38, 0x64, 0x63, 0x37, 0x62, 0x31, 0x66, 0x30, 
+0x62, 0x33, 0x30, 0x37, 0x61, 0x63, 0x31, 0x36, 
+0x37, 0x66, 0x61, 0x35, 0x31, 0x36, 0x66, 0x65, 
+0x34, 0x33, 0x35, 0x32, 0x62, 0x39, 0x66, 0x34, 
+0x65, 0x66, 0x37, 0x66, 0x31, 0x35, 0x34, 0x65, 
+0x38, 0x65, 0x38, 0x65, 0x31, 0x37, 0x63, 0x33, 
+0x31, 0x64, 0x33, 0x34, 0x36, 0x32, 0x64, 0x37, 
+0x31, 0x33, 0x32, 0x35, 0x38, 0x39, 0x65, 0x64, 
+0x32, 0x39, 0x33, 0x35, 0x33, 0x63, 0x36, 0x66, 
+0x61, 0x66, 0x64, 0x62, 0x38, 0x38, 0x34, 0x63, 
+0x35, 0x61, 0x36, 0x65, 0x30, 0x34, 0x65, 0x61, 
+0x39, 0x33, 0x38, 0x38, 0x33, 0x34, 0x66, 0x30, 
+0x64, 0x39, 0x64, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x63, 0x31, 0x35, 0x35, 0x61, 
+0x64, 0x66, 0x34, 0x65, 0x38, 0x39, 0x36, 0x37, 
+0x66, 0x62, 0x64, 0x32, 0x65, 0x32, 0x39, 0x66, 
+0x32, 0x30, 0x61, 0x63, 0x38, 0x39, 0x36, 0x65, 
+0x36, 0x30, 0x63, 0x33, 0x62, 0x30, 0x66, 0x31, 
+0x64, 0x35, 0x62, 0x30, 0x65, 0x66, 0x61, 0x39, 
+0x64, 0x33, 0x34, 0x39, 0x34, 0x31, 0x62, 0x35, 
+0x39, 0x35, 0x38, 0x63, 0x37, 0x62, 0x30, 0x61, 
+0x30, 0x33, 0x31, 0x32, 0x64, 0x37, 0x33, 0x37, 
+0x65, 0x64, 0x31, 0x66, 0x65, 0x33, 0x30, 0x62, 
+0x63, 0x34, 0x32, 0x62, 0x38, 0x30, 0x32, 0x32, 
+0x64, 0x37, 0x31, 0x37, 0x62, 0x34, 0x34, 0x66, 
+0x30, 0x64, 0x39, 0x33, 0x35, 0x31, 0x36, 0x36, 
+0x31, 0x37, 0x61, 0x66, 0x36, 0x34, 0x61, 0x36, 
+0x34, 0x37, 0x35, 0x33, 0x62, 0x37, 0x61, 0x30, 
+0x36, 0x62, 0x66, 0x31, 0x36, 0x62, 0x32, 0x36, 
+0x63, 0x64, 0x37, 0x31, 0x31, 0x66, 0x31, 0x35, 
+0x34, 0x65, 0x38, 0x65, 0x38, 0x65, 0x31, 0x37, 
+0x63, 0x33, 0x31, 0x64, 0x33, 0x34, 0x36, 0x32, 
+0x64, 0x37, 0x31, 0x33, 0x32, 0x35, 0x38, 0x39, 
+0x65, 0x64, 0x32, 0x39, 0x33, 0x35, 0x33, 0x63, 
+0x36, 0x66, 0x61, 0x66, 0x64, 0x62, 0x38, 0x38, 
+0x34, 0x63, 0x35, 0x61, 0x36, 0x65, 0x30, 0x34, 
+0x65, 0x61, 0x39, 0x33, 0x38, 0x38, 0x33, 0x34, 
+0x66, 0x30, 0x64, 0x39, 0x64, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x6b, 0x65, 0x79, 
+0x50, 0x61, 0x74, 0x68, 0x53, 0x70, 0x65, 0x6e, 
+0x64, 0x69, 0x6e, 0x67, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x72, 0x61, 0x77, 0x55, 0x6e, 
+0x73, 0x69, 0x67, 0x6e, 0x65, 0x64, 0x54, 0x78, 
+0x22, 0x3a, 0x20, 0x22, 0x30, 0x32, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x39, 0x37, 0x64, 
+0x65, 0x32, 0x30, 0x63, 0x62, 0x66, 0x66, 0x36, 
+0x38, 0x36, 0x64, 0x61, 0x38, 0x33, 0x61, 0x35, 
+0x34, 0x39, 0x38, 0x31, 0x64, 0x32, 0x62, 0x39, 
+0x62, 0x61, 0x62, 0x33, 0x35, 0x38, 0x36, 0x66, 
+0x34, 0x63, 0x61, 0x37, 0x65, 0x34, 0x38, 0x66, 
+0x35, 0x37, 0x66, 0x35, 0x62, 0x35, 0x35, 0x39, 
+0x36, 0x33, 0x31, 0x31, 0x35, 0x66, 0x33, 0x62, 
+0x33, 0x33, 0x34, 0x65, 0x39, 0x63, 0x30, 0x31, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x64, 0x37, 0x62, 0x37, 0x63, 0x61, 0x62, 0x35, 
+0x37, 0x62, 0x31, 0x33, 0x39, 0x33, 0x61, 0x63, 
+0x65, 0x32, 0x64, 0x30, 0x36, 0x34, 0x66, 0x34, 
+0x64, 0x34, 0x61, 0x32, 0x63, 0x62, 0x38, 0x61, 
+0x66, 0x36, 0x64, 0x65, 0x66, 0x36, 0x31, 0x32, 
+0x37, 0x33, 0x65, 0x31, 0x32, 0x37, 0x35, 0x31, 
+0x37, 0x64, 0x34, 0x34, 0x37, 0x35, 0x39, 0x62, 
+0x36, 0x64, 0x61, 0x66, 0x64, 0x64, 0x39, 0x39, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x38, 0x65, 0x31, 0x66, 0x35, 
+0x38, 0x33, 0x33, 0x38, 0x34, 0x33, 0x33, 0x33, 
+0x36, 0x38, 0x39, 0x32, 0x32, 0x38, 0x63, 0x35, 
+0x64, 0x32, 0x38, 0x65, 0x61, 0x63, 0x31, 0x33, 
+0x33, 0x36, 0x36, 0x62, 0x65, 0x30, 0x38, 0x32, 
+0x64, 0x63, 0x35, 0x37, 0x34, 0x34, 0x31, 0x37, 
+0x36, 0x30, 0x64, 0x39, 0x35, 0x37, 0x32, 0x37, 
+0x35, 0x34, 0x31, 0x39, 0x61, 0x34, 0x31, 0x38, 
+0x34, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x66, 0x66, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x30, 0x36, 0x38, 
+0x39, 0x31, 0x38, 0x30, 0x61, 0x61, 0x36, 0x33, 
+0x62, 0x33, 0x30, 0x63, 0x62, 0x31, 0x36, 0x32, 
+0x61, 0x37, 0x33, 0x63, 0x36, 0x64, 0x32, 0x61, 
+0x33, 0x38, 0x62, 0x37, 0x65, 0x65, 0x64, 0x61, 
+0x32, 0x61, 0x38, 0x33, 0x65, 0x63, 0x65, 0x37, 
+0x34, 0x33, 0x31, 0x30, 0x66, 0x64, 0x61, 0x30, 
+0x38, 0x34, 0x33, 0x61, 0x64, 0x36, 0x30, 0x34, 
+0x38, 0x35, 0x33, 0x62, 0x30, 0x31, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x66, 0x65, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x61, 0x61, 
+0x35, 0x32, 0x30, 0x32, 0x62, 0x64, 0x66, 0x36, 
+0x64, 0x38, 0x63, 0x63, 0x64, 0x32, 0x65, 0x65, 
+0x30, 0x66, 0x30, 0x32, 0x30, 0x32, 0x61, 0x66, 
+0x62, 0x62, 0x62, 0x37, 0x34, 0x36, 0x31, 0x64, 
+0x39, 0x32, 0x36, 0x34, 0x61, 0x32, 0x35, 0x65, 
+0x35, 0x62, 0x66, 0x64, 0x33, 0x63, 0x35, 0x61, 
+0x35, 0x32, 0x65, 0x65, 0x31, 0x32, 0x33, 0x39, 
+0x65, 0x30, 0x62, 0x61, 0x36, 0x63, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x66, 0x65, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x39, 0x35, 0x36, 0x31, 0x34, 0x39, 0x62, 0x64, 
+0x63, 0x36, 0x36, 0x66, 0x61, 0x61, 0x39, 0x36, 
+0x38, 0x65, 0x62, 0x32, 0x62, 0x65, 0x32, 0x64, 
+0x32, 0x66, 0x61, 0x61, 0x32, 0x39, 0x37, 0x31, 
+0x38, 0x61, 0x63, 0x62, 0x66, 0x65, 0x33, 0x39, 
+0x34, 0x31, 0x32, 0x31, 0x35, 0x38, 0x39, 0x33, 
+0x61, 0x32, 0x61, 0x33, 0x34, 0x34, 0x36, 0x64, 
+0x33, 0x32, 0x61, 0x63, 0x64, 0x30, 0x35, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x65, 0x36, 0x36, 0x34, 0x62, 0x39, 
+0x37, 0x37, 0x33, 0x62, 0x38, 0x38, 0x63, 0x30, 
+0x39, 0x63, 0x33, 0x32, 0x63, 0x62, 0x37, 0x30, 
+0x61, 0x32, 0x61, 0x33, 0x65, 0x34, 0x64, 0x61, 
+0x30, 0x63, 0x65, 0x64, 0x36, 0x33, 0x62, 0x37, 
+0x62, 0x61, 0x33, 0x62, 0x32, 0x32, 0x66, 0x38, 
+0x34, 0x38, 0x35, 0x33, 0x31, 0x62, 0x62, 0x62, 
+0x31, 0x64, 0x35, 0x64, 0x35, 0x66, 0x34, 0x63, 
+0x39, 0x34, 0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x65, 0x39, 0x61, 0x61, 
+0x36, 0x62, 0x38, 0x65, 0x36, 0x63, 0x39, 0x64, 
+0x65, 0x36, 0x37, 0x36, 0x31, 0x39, 0x65, 0x36, 
+0x61, 0x33, 0x39, 0x32, 0x34, 0x61, 0x65, 0x32, 
+0x35, 0x36, 0x39, 0x36, 0x62, 0x62, 0x37, 0x62, 
+0x36, 0x39, 0x34, 0x62, 0x62, 0x36, 0x37, 0x37, 
+0x61, 0x36, 0x33, 0x32, 0x61, 0x37, 0x34, 0x65, 
+0x66, 0x37, 0x65, 0x61, 0x64, 0x66, 0x64, 0x34, 
+0x65, 0x61, 0x62, 0x66, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x61, 0x37, 
+0x37, 0x38, 0x65, 0x62, 0x36, 0x61, 0x32, 0x36, 
+0x33, 0x64, 0x63, 0x30, 0x39, 0x30, 0x34, 0x36, 
+0x34, 0x63, 0x64, 0x31, 0x32, 0x35, 0x63, 0x34, 
+0x36, 0x36, 0x62, 0x35, 0x61, 0x39, 0x39, 0x36, 
+0x36, 0x37, 0x37, 0x32, 0x30, 0x62, 0x31, 0x63, 
+0x31, 0x31, 0x30, 0x34, 0x36, 0x38, 0x38, 0x33, 
+0x31, 0x64, 0x30, 0x35, 0x38, 0x61, 0x61, 0x31, 
+0x62, 0x38, 0x32, 0x61, 0x66, 0x31, 0x30, 0x31, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x30, 0x32, 0x30, 0x30, 0x63, 0x61, 0x39, 0x61, 
+0x33, 0x62, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x31, 0x39, 0x37, 0x36, 0x61, 0x39, 
+0x31, 0x34, 0x30, 0x36, 0x61, 0x66, 0x64, 0x34, 
+0x36, 0x62, 0x63, 0x64, 0x66, 0x64, 0x32, 0x32, 
+0x65, 0x66, 0x39, 0x34, 0x61, 0x63, 0x31, 0x32, 
+0x32, 0x61, 0x61, 0x31, 0x31, 0x66, 0x32, 0x34, 
+0x31, 0x32, 0x34, 0x34, 0x61, 0x33, 0x37, 0x65, 
+0x63, 0x63, 0x38, 0x38, 0x61, 0x63, 0x38, 0x30, 
+0x37, 0x38, 0x34, 0x30, 0x63, 0x62, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x32, 0x30, 
+0x61, 0x63, 0x39, 0x61, 0x38, 0x37, 0x66, 0x35, 
+0x35, 0x39, 0x34, 0x62, 0x65, 0x32, 0x30, 0x38, 
+0x66, 0x38, 0x35, 0x33, 0x32, 0x64, 0x62, 0x33, 
+0x38, 0x63, 0x66, 0x66, 0x36, 0x37, 0x30, 0x63, 
+0x34, 0x35, 0x30, 0x65, 0x64, 0x32, 0x66, 0x65, 
+0x61, 0x38, 0x66, 0x63, 0x64, 0x65, 0x66, 0x63, 
+0x63, 0x39, 0x61, 0x36, 0x36, 0x33, 0x66, 0x37, 
+0x38, 0x62, 0x61, 0x62, 0x39, 0x36, 0x32, 0x62, 
+0x30, 0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x75, 0x74, 0x78, 0x6f, 
+0x73, 0x53, 0x70, 0x65, 0x6e, 0x74, 0x22, 0x3a, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 
+0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 0x35, 0x33, 
+0x61, 0x31, 0x66, 0x36, 0x65, 0x34, 0x35, 0x34, 
+0x64, 0x66, 0x31, 0x61, 0x61, 0x32, 0x37, 0x37, 
+0x36, 0x61, 0x32, 0x38, 0x31, 0x34, 0x61, 0x37, 
+0x32, 0x31, 0x33, 0x37, 0x32, 0x64, 0x36, 0x32, 
+0x35, 0x38, 0x30, 0x35, 0x30, 0x64, 0x65, 0x33, 
+0x33, 0x30, 0x62, 0x33, 0x63, 0x36, 0x64, 0x31, 
+0x30, 0x65, 0x65, 0x38, 0x66, 0x34, 0x65, 0x30, 
+0x64, 0x64, 0x61, 0x33, 0x34, 0x33, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x53, 0x61, 0x74, 0x73, 0x22, 0x3a, 0x20, 0x34, 
+0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x72, 0x65, 0x66, 0x68, 0x65, 
+0x69, 0x67, 0x68, 0x74, 0x22, 0x3a, 0x20, 0x31, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 
+0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 0x75, 0x62, 
+0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x34, 
+0x66, 0x32, 0x30, 0x31, 0x34, 0x37, 0x63, 0x39, 
+0x63, 0x35, 0x37, 0x31, 0x33, 0x32, 0x66, 0x36, 
+0x65, 0x37, 0x65, 0x63, 0x64, 0x64, 0x62, 0x61, 
+0x39, 0x38, 0x30, 0x30, 0x62, 0x62, 0x30, 0x63, 
+0x34, 0x34, 0x34, 0x39, 0x32, 0x35, 0x31, 0x63, 
+0x39, 0x32, 0x61, 0x31, 0x65, 0x36, 0x30, 0x33, 
+0x37, 0x31, 0x65, 0x65, 0x37, 0x37, 0x35, 0x35, 
+0x37, 0x62, 0x36, 0x36, 0x32, 0x30, 0x66, 0x33, 
+0x65, 0x61, 0x33, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x61, 
+0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x53, 0x61, 0x74, 
+0x73, 0x22, 0x3a, 0x20, 0x34, 0x36, 0x32, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x72, 0x65, 0x66, 0x68, 0x65, 0x69, 0x67, 0x68, 
+0x74, 0x22, 0x3a, 0x20, 0x31, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 
+0x70, 0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 
+0x22, 0x3a, 0x20, 0x22, 0x37, 0x36, 0x61, 0x39, 
+0x31, 0x34, 0x37, 0x35, 0x31, 0x65, 0x37, 0x36, 
+0x65, 0x38, 0x31, 0x39, 0x39, 0x31, 0x39, 0x36, 
+0x64, 0x34, 0x35, 0x34, 0x39, 0x34, 0x31, 0x63, 
+0x34, 0x35, 0x64, 0x31, 0x62, 0x33, 0x61, 0x33, 
+0x32, 0x33, 0x66, 0x31, 0x34, 0x33, 0x33, 0x62, 
+0x64, 0x36, 0x38, 0x38, 0x61, 0x63, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x53, 0x61, 0x74, 0x73, 0x22, 0x3a, 0x20, 0x32, 
+0x39, 0x34, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x72, 0x65, 0x66, 0x68, 0x65, 
+0x69, 0x67, 0x68, 0x74, 0x22, 0x3a, 0x20, 0x31, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 
+0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 0x75, 0x62, 
+0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x34, 
+0x66, 0x32, 0x30, 0x65, 0x34, 0x64, 0x38, 0x31, 
+0x30, 0x66, 0x64, 0x35, 0x30, 0x35, 0x38, 0x36, 
+0x32, 0x37, 0x34, 0x66, 0x61, 0x63, 0x65, 0x36, 
+0x32, 0x62, 0x38, 0x61, 0x38, 0x30, 0x37, 0x65, 
+0x62, 0x39, 0x37, 0x31, 0x39, 0x63, 0x65, 0x66, 
+0x34, 0x39, 0x63, 0x30, 0x34, 0x31, 0x37, 0x37, 
+0x63, 0x63, 0x36, 0x62, 0x37, 0x36, 0x61, 0x39, 
+0x61, 0x34, 0x32, 0x35, 0x31, 0x64, 0x35, 0x34, 
+0x35, 0x30, 0x65, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x61, 
+0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x53, 0x61, 0x74, 
+0x73, 0x22, 0x3a, 0x20, 0x35, 0x30, 0x34, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x72, 0x65, 0x66, 0x68, 0x65, 0x69, 0x67, 0x68, 
+0x74, 0x22, 0x3a, 0x20, 0x31, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 
+0x70, 0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 
+0x22, 0x3a, 0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 
+0x39, 0x31, 0x62, 0x36, 0x34, 0x64, 0x35, 0x33, 
+0x32, 0x34, 0x37, 0x32, 0x33, 0x61, 0x39, 0x38, 
+0x35, 0x31, 0x37, 0x30, 0x65, 0x34, 0x64, 0x63, 
+0x35, 0x61, 0x30, 0x66, 0x38, 0x34, 0x63, 0x30, 
+0x34, 0x31, 0x38, 0x30, 0x34, 0x66, 0x32, 0x63, 
+0x64, 0x31, 0x32, 0x36, 0x36, 0x30, 0x66, 0x61, 
+0x35, 0x64, 0x65, 0x63, 0x30, 0x39, 0x66, 0x63, 
+0x32, 0x31, 0x37, 0x38, 0x33, 0x36, 0x30, 0x35, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x61, 0x6d, 0x6f, 0x75, 
+0x6e, 0x74, 0x53, 0x61, 0x74, 0x73, 0x22, 0x3a, 
+0x20, 0x36, 0x33, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x72, 0x65, 0x66, 
+0x68, 0x65, 0x69, 0x67, 0x68, 0x74, 0x22, 0x3a, 
+0x20, 0x31, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 
+0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 
+0x22, 0x30, 0x30, 0x31, 0x34, 0x37, 0x64, 0x64, 
+0x36, 0x35, 0x35, 0x39, 0x32, 0x64, 0x30, 0x61, 
+0x62, 0x32, 0x66, 0x65, 0x30, 0x64, 0x30, 0x32, 
+0x35, 0x37, 0x64, 0x35, 0x37, 0x31, 0x61, 0x62, 
+0x66, 0x30, 0x33, 0x32, 0x63, 0x64, 0x39, 0x64, 
+0x62, 0x39, 0x33, 0x64, 0x63, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x53, 
+0x61, 0x74, 0x73, 0x22, 0x3a, 0x20, 0x33, 0x37, 
+0x38, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x72, 0x65, 0x66, 0x68, 0x65, 0x69, 
+0x67, 0x68, 0x74, 0x22, 0x3a, 0x20, 0x31, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x63, 
+0x72, 0x69, 0x70, 0x74, 0x50, 0x75, 0x62, 0x4b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x34, 0x66, 
+0x32, 0x30, 0x37, 0x35, 0x31, 0x36, 0x39, 0x66, 
+0x34, 0x30, 0x30, 0x31, 0x61, 0x61, 0x36, 0x38, 
+0x66, 0x31, 0x35, 0x62, 0x62, 0x65, 0x64, 0x32, 
+0x38, 0x62, 0x32, 0x31, 0x38, 0x64, 0x66, 0x31, 
+0x64, 0x30, 0x61, 0x36, 0x32, 0x63, 0x62, 0x62, 
+0x63, 0x66, 0x31, 0x31, 0x38, 0x38, 0x63, 0x36, 
+0x36, 0x36, 0x35, 0x31, 0x31, 0x30, 0x63, 0x32, 
+0x39, 0x33, 0x63, 0x39, 0x30, 0x37, 0x62, 0x38, 
+0x33, 0x31, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x61, 0x6d, 
+0x6f, 0x75, 0x6e, 0x74, 0x53, 0x61, 0x74, 0x73, 
+0x22, 0x3a, 0x20, 0x36, 0x37, 0x32, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x72, 
+0x65, 0x66, 0x68, 0x65, 0x69, 0x67, 0x68, 0x74, 
+0x22, 0x3a, 0x20, 0x31, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x73, 0x63, 0x72, 0x69, 0x70, 
+0x74, 0x50, 0x75, 0x62, 0x4b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x34, 0x66, 0x32, 0x30, 0x37, 
+0x31, 0x32, 0x34, 0x34, 0x37, 0x32, 0x30, 0x36, 
+0x64, 0x37, 0x61, 0x35, 0x32, 0x33, 0x38, 0x61, 
+0x63, 0x63, 0x37, 0x66, 0x66, 0x35, 0x33, 0x66, 
+0x62, 0x65, 0x39, 0x34, 0x61, 0x33, 0x62, 0x36, 
+0x34, 0x35, 0x33, 0x39, 0x61, 0x64, 0x32, 0x39, 
+0x31, 0x63, 0x37, 0x63, 0x64, 0x62, 0x63, 0x34, 
+0x39, 0x30, 0x62, 0x37, 0x35, 0x37, 0x37, 0x65, 
+0x34, 0x62, 0x31, 0x37, 0x64, 0x66, 0x35, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 
+0x74, 0x53, 0x61, 0x74, 0x73, 0x22, 0x3a, 0x20, 
+0x35, 0x34, 0x36, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x72, 0x65, 0x66, 0x68, 
+0x65, 0x69, 0x67, 0x68, 0x74, 0x22, 0x3a, 0x20, 
+0x31, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 0x75, 
+0x62, 0x4b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 
+0x34, 0x66, 0x32, 0x30, 0x37, 0x37, 0x65, 0x33, 
+0x30, 0x61, 0x35, 0x35, 0x32, 0x32, 0x64, 0x64, 
+0x39, 0x66, 0x38, 0x39, 0x34, 0x63, 0x33, 0x66, 
+0x38, 0x62, 0x38, 0x62, 0x64, 0x34, 0x63, 0x34, 
+0x62, 0x32, 0x63, 0x66, 0x38, 0x32, 0x63, 0x61, 
+0x37, 0x64, 0x61, 0x38, 0x61, 0x33, 0x65, 0x61, 
+0x36, 0x61, 0x32, 0x33, 0x39, 0x36, 0x35, 0x35, 
+0x63, 0x33, 0x39, 0x63, 0x30, 0x35, 0x30, 0x61, 
+0x62, 0x32, 0x32, 0x30, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x53, 0x61, 
+0x74, 0x73, 0x22, 0x3a, 0x20, 0x35, 0x38, 0x38, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x72, 0x65, 0x66, 0x68, 0x65, 0x69, 0x67, 
+0x68, 0x74, 0x22, 0x3a, 0x20, 0x31, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6d, 0x65, 0x64, 0x69, 0x61, 0x72, 0x79, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 
+0x68, 0x41, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x66, 0x33, 0x61, 0x31, 
+0x33, 0x62, 0x34, 0x30, 0x64, 0x37, 0x39, 0x30, 
+0x39, 0x30, 0x32, 0x32, 0x62, 0x64, 0x35, 0x34, 
+0x33, 0x30, 0x32, 0x36, 0x33, 0x65, 0x39, 0x32, 
+0x37, 0x38, 0x31, 0x36, 0x30, 0x39, 0x34, 0x35, 
+0x65, 0x30, 0x63, 0x35, 0x61, 0x35, 0x64, 0x33, 
+0x63, 0x61, 0x37, 0x30, 0x34, 0x38, 0x39, 0x66, 
+0x66, 0x62, 0x32, 0x63, 0x30, 0x61, 0x33, 0x65, 
+0x39, 0x30, 0x36, 0x39, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x68, 0x61, 0x73, 0x68, 0x4f, 0x75, 0x74, 0x70, 
+0x75, 0x74, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x61, 
+0x32, 0x65, 0x36, 0x64, 0x61, 0x62, 0x37, 0x63, 
+0x31, 0x66, 0x30, 0x64, 0x63, 0x64, 0x32, 0x39, 
+0x37, 0x63, 0x38, 0x64, 0x36, 0x31, 0x36, 0x34, 
+0x37, 0x66, 0x64, 0x31, 0x37, 0x64, 0x38, 0x32, 
+0x31, 0x35, 0x34, 0x31, 0x65, 0x61, 0x36, 0x39, 
+0x63, 0x33, 0x63, 0x63, 0x33, 0x37, 0x64, 0x63, 
+0x62, 0x61, 0x64, 0x37, 0x66, 0x39, 0x30, 0x64, 
+0x34, 0x65, 0x62, 0x34, 0x62, 0x63, 0x35, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 0x50, 
+0x72, 0x65, 0x76, 0x6f, 0x75, 0x74, 0x73, 0x22, 
+0x3a, 0x20, 0x22, 0x65, 0x33, 0x62, 0x33, 0x33, 
+0x62, 0x62, 0x34, 0x65, 0x66, 0x33, 0x61, 0x35, 
+0x32, 0x61, 0x64, 0x31, 0x66, 0x66, 0x66, 0x62, 
+0x35, 0x35, 0x35, 0x63, 0x30, 0x64, 0x38, 0x32, 
+0x38, 0x32, 0x38, 0x65, 0x62, 0x32, 0x32, 0x37, 
+0x33, 0x37, 0x30, 0x33, 0x36, 0x65, 0x61, 0x65, 
+0x62, 0x30, 0x32, 0x61, 0x32, 0x33, 0x35, 0x64, 
+0x38, 0x32, 0x62, 0x39, 0x30, 0x39, 0x63, 0x34, 
+0x63, 0x33, 0x66, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 
+0x61, 0x73, 0x68, 0x53, 0x63, 0x72, 0x69, 0x70, 
+0x74, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x34, 0x31, 0x61, 0x64, 
+0x35, 0x62, 0x37, 0x39, 0x62, 0x32, 0x62, 0x35, 
+0x31, 0x32, 0x36, 0x35, 0x37, 0x31, 0x61, 0x66, 
+0x38, 0x39, 0x62, 0x35, 0x35, 0x31, 0x33, 0x61, 
+0x61, 0x34, 0x39, 0x36, 0x61, 0x31, 0x30, 0x62, 
+0x64, 0x37, 0x61, 0x35, 0x61, 0x62, 0x36, 0x38, 
+0x62, 0x38, 0x32, 0x31, 0x62, 0x66, 0x30, 0x31, 
+0x39, 0x62, 0x33, 0x33, 0x32, 0x63, 0x62, 0x34, 
+0x64, 0x33, 0x31, 0x31, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x68, 0x61, 0x73, 0x68, 0x53, 0x65, 0x71, 0x75, 
+0x65, 0x6e, 0x63, 0x65, 0x73, 0x22, 0x3a, 0x20, 
+0x22, 0x31, 0x38, 0x39, 0x35, 0x39, 0x63, 0x37, 
+0x32, 0x32, 0x31, 0x61, 0x62, 0x35, 0x63, 0x65, 
+0x39, 0x65, 0x32, 0x36, 0x63, 0x33, 0x63, 0x64, 
+0x36, 0x37, 0x62, 0x32, 0x32, 0x63, 0x32, 0x34, 
+0x66, 0x38, 0x62, 0x61, 0x61, 0x35, 0x34, 0x62, 
+0x61, 0x63, 0x32, 0x38, 0x31, 0x64, 0x38, 0x65, 
+0x36, 0x62, 0x30, 0x35, 0x65, 0x34, 0x30, 0x30, 
+0x65, 0x36, 0x63, 0x33, 0x61, 0x39, 0x35, 0x37, 
+0x65, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 
+0x6e, 0x70, 0x75, 0x74, 0x53, 0x70, 0x65, 0x6e, 
+0x64, 0x69, 0x6e, 0x67, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x78, 0x69, 0x6e, 0x49, 
+0x6e, 0x64, 0x65, 0x78, 0x22, 0x3a, 0x20, 0x30, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6e, 0x61, 0x6c, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x36, 0x62, 
+0x39, 0x37, 0x33, 0x64, 0x38, 0x38, 0x38, 0x33, 
+0x38, 0x66, 0x32, 0x37, 0x33, 0x36, 0x36, 0x65, 
+0x64, 0x36, 0x31, 0x63, 0x39, 0x61, 0x64, 0x36, 
+0x33, 0x36, 0x37, 0x36, 0x36, 0x33, 0x30, 0x34, 
+0x35, 0x63, 0x62, 0x34, 0x35, 0x36, 0x65, 0x32, 
+0x38, 0x33, 0x33, 0x35, 0x63, 0x31, 0x30, 0x39, 
+0x65, 0x33, 0x30, 0x37, 0x31, 0x37, 0x61, 0x65, 
+0x30, 0x63, 0x36, 0x62, 0x61, 0x61, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 0x65, 
+0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 0x6e, 
+0x75, 0x6c, 0x6c, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 
+0x73, 0x68, 0x54, 0x79, 0x70, 0x65, 0x22, 0x3a, 
+0x20, 0x33, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 
+0x6e, 0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 
+0x61, 0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 
+0x6c, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x64, 0x36, 0x38, 0x38, 0x39, 
+0x63, 0x62, 0x30, 0x38, 0x31, 0x30, 0x33, 0x36, 
+0x65, 0x30, 0x66, 0x61, 0x65, 0x66, 0x61, 0x33, 
+0x61, 0x33, 0x35, 0x31, 0x35, 0x37, 0x61, 0x64, 
+0x37, 0x31, 0x30, 0x38, 0x36, 0x62, 0x31, 0x32, 
+0x33, 0x62, 0x32, 0x62, 0x31, 0x34, 0x34, 0x62, 
+0x36, 0x34, 0x39, 0x37, 0x39, 0x38, 0x62, 0x34, 
+0x39, 0x34, 0x63, 0x33, 0x30, 0x30, 0x61, 0x39, 
+0x36, 0x31, 0x64, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 
+0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 
+0x62, 0x38, 0x36, 0x65, 0x37, 0x62, 0x65, 0x38, 
+0x66, 0x33, 0x39, 0x62, 0x61, 0x62, 0x33, 0x32, 
+0x61, 0x36, 0x66, 0x32, 0x63, 0x30, 0x34, 0x34, 
+0x33, 0x61, 0x62, 0x62, 0x63, 0x32, 0x31, 0x30, 
+0x66, 0x30, 0x65, 0x64, 0x61, 0x63, 0x30, 0x65, 
+0x32, 0x63, 0x35, 0x33, 0x64, 0x35, 0x30, 0x31, 
+0x62, 0x33, 0x36, 0x62, 0x36, 0x34, 0x34, 0x33, 
+0x37, 0x64, 0x39, 0x63, 0x36, 0x63, 0x37, 0x30, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 
+0x6b, 0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x32, 0x34, 
+0x30, 0x35, 0x62, 0x39, 0x37, 0x31, 0x37, 0x37, 
+0x32, 0x61, 0x64, 0x32, 0x36, 0x39, 0x31, 0x35, 
+0x63, 0x38, 0x64, 0x63, 0x64, 0x66, 0x31, 0x30, 
+0x66, 0x32, 0x33, 0x38, 0x37, 0x35, 0x33, 0x61, 
+0x39, 0x62, 0x38, 0x33, 0x37, 0x65, 0x35, 0x66, 
+0x38, 0x65, 0x36, 0x61, 0x38, 0x36, 0x66, 0x64, 
+0x37, 0x63, 0x30, 0x63, 0x63, 0x65, 0x35, 0x62, 
+0x37, 0x32, 0x39, 0x36, 0x64, 0x39, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 
+0x22, 0x3a, 0x20, 0x22, 0x30, 0x30, 0x30, 0x33, 
+0x30, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x65, 0x33, 0x62, 0x33, 0x33, 0x62, 0x62, 0x34, 
+0x65, 0x66, 0x33, 0x61, 0x35, 0x32, 0x61, 0x64, 
+0x31, 0x66, 0x66, 0x66, 0x62, 0x35, 0x35, 0x35, 
+0x63, 0x30, 0x64, 0x38, 0x32, 0x38, 0x32, 0x38, 
+0x65, 0x62, 0x32, 0x32, 0x37, 0x33, 0x37, 0x30, 
+0x33, 0x36, 0x65, 0x61, 0x65, 0x62, 0x30, 0x32, 
+0x61, 0x32, 0x33, 0x35, 0x64, 0x38, 0x32, 0x62, 
+0x39, 0x30, 0x39, 0x63, 0x34, 0x63, 0x33, 0x66, 
+0x66, 0x33, 0x61, 0x31, 0x33, 0x62, 0x34, 0x30, 
+0x64, 0x37, 0x39, 0x30, 0x39, 0x30, 0x32, 0x32, 
+0x62, 0x64, 0x35, 0x34, 0x33, 0x30, 0x32, 0x36, 
+0x33, 0x65, 0x39, 0x32, 0x37, 0x38, 0x31, 0x36, 
+0x30, 0x39, 0x34, 0x35, 0x65, 0x30, 0x63, 0x35, 
+0x61, 0x35, 0x64, 0x33, 0x63, 0x61, 0x37, 0x30, 
+0x34, 0x38, 0x39, 0x66, 0x66, 0x62, 0x32, 0x63, 
+0x30, 0x61, 0x33, 0x65, 0x39, 0x30, 0x36, 0x39, 
+0x34, 0x31, 0x61, 0x64, 0x35, 0x62, 0x37, 0x39, 
+0x62, 0x32, 0x62, 0x35, 0x31, 0x32, 0x36, 0x35, 
+0x37, 0x31, 0x61, 0x66, 0x38, 0x39, 0x62, 0x35, 
+0x35, 0x31, 0x33, 0x61, 0x61, 0x34, 0x39, 0x36, 
+0x61, 0x31, 0x30, 0x62, 0x64, 0x37, 0x61, 0x35, 
+0x61, 0x62, 0x36, 0x38, 0x62, 0x38, 0x32, 0x31, 
+0x62, 0x66, 0x30, 0x31, 0x39, 0x62, 0x33, 0x33, 
+0x32, 0x63, 0x62, 0x34, 0x64, 0x33, 0x31, 0x31, 
+0x31, 0x38, 0x39, 0x35, 0x39, 0x63, 0x37, 0x32, 
+0x32, 0x31, 0x61, 0x62, 0x35, 0x63, 0x65, 0x39, 
+0x65, 0x32, 0x36, 0x63, 0x33, 0x63, 0x64, 0x36, 
+0x37, 0x62, 0x32, 0x32, 0x63, 0x32, 0x34, 0x66, 
+0x38, 0x62, 0x61, 0x61, 0x35, 0x34, 0x62, 0x61, 
+0x63, 0x32, 0x38, 0x31, 0x64, 0x38, 0x65, 0x36, 
+0x62, 0x30, 0x35, 0x65, 0x34, 0x30, 0x30, 0x65, 
+0x36, 0x63, 0x33, 0x61, 0x39, 0x35, 0x37, 0x65, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x64, 0x30, 0x34, 0x31, 0x38, 0x66, 
+0x30, 0x65, 0x39, 0x61, 0x33, 0x36, 0x32, 0x34, 
+0x35, 0x62, 0x39, 0x61, 0x35, 0x30, 0x65, 0x63, 
+0x38, 0x37, 0x66, 0x38, 0x62, 0x66, 0x35, 0x62, 
+0x65, 0x35, 0x62, 0x63, 0x61, 0x65, 0x34, 0x33, 
+0x34, 0x33, 0x33, 0x37, 0x62, 0x38, 0x37, 0x31, 
+0x33, 0x39, 0x63, 0x33, 0x61, 0x35, 0x62, 0x31, 
+0x66, 0x35, 0x36, 0x65, 0x33, 0x33, 0x63, 0x62, 
+0x61, 0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x70, 0x72, 
+0x65, 0x63, 0x6f, 0x6d, 0x70, 0x75, 0x74, 0x65, 
+0x64, 0x55, 0x73, 0x65, 0x64, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 
+0x61, 0x73, 0x68, 0x41, 0x6d, 0x6f, 0x75, 0x6e, 
+0x74, 0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 0x50, 0x72, 
+0x65, 0x76, 0x6f, 0x75, 0x74, 0x73, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 
+0x73, 0x68, 0x53, 0x63, 0x72, 0x69, 0x70, 0x74, 
+0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x73, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 
+0x61, 0x73, 0x68, 0x53, 0x65, 0x71, 0x75, 0x65, 
+0x6e, 0x63, 0x65, 0x73, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x69, 0x67, 0x48, 0x61, 0x73, 
+0x68, 0x22, 0x3a, 0x20, 0x22, 0x34, 0x31, 0x33, 
+0x64, 0x30, 0x61, 0x62, 0x30, 0x63, 0x31, 0x30, 
+0x65, 0x63, 0x36, 0x37, 0x38, 0x33, 0x33, 0x34, 
+0x65, 0x63, 0x35, 0x66, 0x37, 0x63, 0x38, 0x39, 
+0x38, 0x62, 0x62, 0x34, 0x32, 0x61, 0x35, 0x39, 
+0x36, 0x62, 0x39, 0x37, 0x35, 0x38, 0x63, 0x32, 
+0x31, 0x36, 0x37, 0x34, 0x35, 0x32, 0x63, 0x35, 
+0x38, 0x64, 0x39, 0x33, 0x61, 0x31, 0x64, 0x64, 
+0x35, 0x63, 0x66, 0x32, 0x38, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 0x63, 
+0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x77, 0x69, 0x74, 0x6e, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x33, 0x62, 0x66, 0x35, 0x35, 0x64, 
+0x31, 0x65, 0x36, 0x66, 0x32, 0x39, 0x33, 0x37, 
+0x65, 0x38, 0x63, 0x37, 0x31, 0x61, 0x35, 0x31, 
+0x63, 0x39, 0x33, 0x39, 0x35, 0x30, 0x35, 0x34, 
+0x64, 0x31, 0x38, 0x37, 0x34, 0x33, 0x66, 0x33, 
+0x37, 0x34, 0x37, 0x36, 0x61, 0x36, 0x30, 0x62, 
+0x34, 0x32, 0x31, 0x66, 0x36, 0x63, 0x39, 0x35, 
+0x62, 0x31, 0x65, 0x63, 0x30, 0x63, 0x36, 0x31, 
+0x61, 0x32, 0x39, 0x63, 0x32, 0x36, 0x38, 0x36, 
+0x38, 0x63, 0x36, 0x64, 0x39, 0x37, 0x63, 0x36, 
+0x61, 0x37, 0x36, 0x36, 0x33, 0x35, 0x65, 0x66, 
+0x34, 0x62, 0x64, 0x39, 0x38, 0x34, 0x31, 0x39, 
+0x31, 0x36, 0x63, 0x35, 0x63, 0x34, 0x64, 0x35, 
+0x37, 0x37, 0x66, 0x64, 0x66, 0x32, 0x34, 0x30, 
+0x61, 0x63, 0x61, 0x33, 0x63, 0x32, 0x33, 0x34, 
+0x37, 0x33, 0x31, 0x33, 0x39, 0x62, 0x31, 0x34, 
+0x39, 0x31, 0x30, 0x33, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x78, 0x69, 0x6e, 0x49, 
+0x6e, 0x64, 0x65, 0x78, 0x22, 0x3a, 0x20, 0x31, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6e, 0x61, 0x6c, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x31, 0x65, 
+0x34, 0x64, 0x61, 0x34, 0x39, 0x66, 0x36, 0x61, 
+0x61, 0x66, 0x34, 0x65, 0x35, 0x63, 0x64, 0x31, 
+0x37, 0x35, 0x66, 0x65, 0x30, 0x38, 0x61, 0x33, 
+0x32, 0x62, 0x62, 0x35, 0x63, 0x62, 0x34, 0x38, 
+0x36, 0x33, 0x64, 0x39, 0x36, 0x33, 0x39, 0x32, 
+0x31, 0x32, 0x35, 0x35, 0x66, 0x33, 0x33, 0x64, 
+0x33, 0x62, 0x63, 0x33, 0x31, 0x65, 0x31, 0x33, 
+0x34, 0x33, 0x39, 0x30, 0x37, 0x66, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 0x65, 
+0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 0x22, 
+0x35, 0x62, 0x37, 0x35, 0x61, 0x64, 0x65, 0x63, 
+0x66, 0x35, 0x33, 0x35, 0x34, 0x38, 0x66, 0x33, 
+0x65, 0x63, 0x36, 0x61, 0x64, 0x37, 0x64, 0x37, 
+0x38, 0x33, 0x38, 0x33, 0x62, 0x66, 0x38, 0x34, 
+0x63, 0x63, 0x35, 0x37, 0x62, 0x35, 0x35, 0x61, 
+0x33, 0x31, 0x32, 0x37, 0x63, 0x37, 0x32, 0x62, 
+0x39, 0x61, 0x32, 0x34, 0x38, 0x31, 0x37, 0x35, 
+0x32, 0x64, 0x64, 0x38, 0x38, 0x62, 0x32, 0x31, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 
+0x54, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 
+0x33, 0x31, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 
+0x6e, 0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 
+0x61, 0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 
+0x6c, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x31, 0x38, 0x37, 0x37, 0x39, 
+0x31, 0x62, 0x36, 0x66, 0x37, 0x31, 0x32, 0x61, 
+0x38, 0x65, 0x61, 0x34, 0x31, 0x63, 0x38, 0x65, 
+0x63, 0x64, 0x64, 0x30, 0x65, 0x65, 0x37, 0x37, 
+0x66, 0x61, 0x62, 0x33, 0x65, 0x38, 0x35, 0x32, 
+0x36, 0x33, 0x62, 0x33, 0x37, 0x65, 0x31, 0x65, 
+0x63, 0x31, 0x38, 0x61, 0x33, 0x36, 0x35, 0x31, 
+0x39, 0x32, 0x36, 0x62, 0x33, 0x61, 0x36, 0x63, 
+0x66, 0x32, 0x37, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 
+0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 
+0x63, 0x62, 0x64, 0x38, 0x36, 0x37, 0x39, 0x62, 
+0x61, 0x36, 0x33, 0x36, 0x63, 0x31, 0x31, 0x31, 
+0x30, 0x65, 0x61, 0x32, 0x34, 0x37, 0x35, 0x34, 
+0x32, 0x63, 0x66, 0x62, 0x64, 0x39, 0x36, 0x34, 
+0x31, 0x33, 0x31, 0x61, 0x36, 0x62, 0x65, 0x38, 
+0x34, 0x66, 0x38, 0x37, 0x33, 0x66, 0x37, 0x66, 
+0x33, 0x62, 0x36, 0x32, 0x61, 0x37, 0x37, 0x37, 
+0x35, 0x32, 0x38, 0x65, 0x64, 0x30, 0x30, 0x31, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 
+0x6b, 0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x65, 0x61, 
+0x32, 0x36, 0x30, 0x63, 0x33, 0x62, 0x31, 0x30, 
+0x65, 0x36, 0x30, 0x66, 0x36, 0x64, 0x65, 0x30, 
+0x31, 0x38, 0x34, 0x35, 0x35, 0x63, 0x64, 0x30, 
+0x32, 0x37, 0x38, 0x66, 0x32, 0x66, 0x35, 0x62, 
+0x37, 0x65, 0x34, 0x35, 0x34, 0x62, 0x65, 0x31, 
+0x39, 0x39, 0x39, 0x35, 0x37, 0x32, 0x37, 0x38, 
+0x39, 0x65, 0x36, 0x61, 0x39, 0x35, 0x36, 0x35, 
+0x64, 0x32, 0x36, 0x30, 0x38, 0x30, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 
+0x22, 0x3a, 0x20, 0x22, 0x30, 0x30, 0x38, 0x33, 
+0x30, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x64, 0x37, 0x62, 0x37, 0x63, 0x61, 
+0x62, 0x35, 0x37, 0x62, 0x31, 0x33, 0x39, 0x33, 
+0x61, 0x63, 0x65, 0x32, 0x64, 0x30, 0x36, 0x34, 
+0x66, 0x34, 0x64, 0x34, 0x61, 0x32, 0x63, 0x62, 
+0x38, 0x61, 0x66, 0x36, 0x64, 0x65, 0x66, 0x36, 
+0x31, 0x32, 0x37, 0x33, 0x65, 0x31, 0x32, 0x37, 
+0x35, 0x31, 0x37, 0x64, 0x34, 0x34, 0x37, 0x35, 
+0x39, 0x62, 0x36, 0x64, 0x61, 0x66, 0x64, 0x64, 
+0x39, 0x39, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x38, 0x30, 0x38, 0x66, 0x38, 0x39, 
+0x31, 0x62, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x32, 0x32, 0x34, 0x66, 0x32, 0x30, 
+0x31, 0x34, 0x37, 0x63, 0x39, 0x63, 0x35, 0x37, 
+0x31, 0x33, 0x32, 0x66, 0x36, 0x65, 0x37, 0x65, 
+0x63, 0x64, 0x64, 0x62, 0x61, 0x39, 0x38, 0x30, 
+0x30, 0x62, 0x62, 0x30, 0x63, 0x34, 0x34, 0x34, 
+0x39, 0x32, 0x35, 0x31, 0x63, 0x39, 0x32, 0x61, 
+0x31, 0x65, 0x36, 0x30, 0x33, 0x37, 0x31, 0x65, 
+0x65, 0x37, 0x37, 0x35, 0x35, 0x37, 0x62, 0x36, 
+0x36, 0x32, 0x30, 0x66, 0x33, 0x65, 0x61, 0x33, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x66, 0x66, 0x63, 0x65, 0x66, 0x38, 0x66, 0x62, 
+0x34, 0x63, 0x61, 0x37, 0x65, 0x66, 0x63, 0x35, 
+0x34, 0x33, 0x33, 0x66, 0x35, 0x39, 0x31, 0x65, 
+0x63, 0x66, 0x63, 0x35, 0x37, 0x33, 0x39, 0x31, 
+0x38, 0x31, 0x31, 0x63, 0x65, 0x31, 0x65, 0x31, 
+0x38, 0x36, 0x61, 0x33, 0x37, 0x39, 0x33, 0x30, 
+0x32, 0x34, 0x64, 0x65, 0x66, 0x35, 0x63, 0x38, 
+0x38, 0x34, 0x63, 0x62, 0x61, 0x35, 0x31, 0x64, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x70, 0x72, 0x65, 0x63, 
+0x6f, 0x6d, 0x70, 0x75, 0x74, 0x65, 0x64, 0x55, 
+0x73, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x5b, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x73, 0x69, 0x67, 0x48, 0x61, 
+0x73, 0x68, 0x22, 0x3a, 0x20, 0x22, 0x35, 0x33, 
+0x30, 0x37, 0x32, 0x38, 0x38, 0x37, 0x66, 0x61, 
+0x64, 0x33, 0x32, 0x37, 0x33, 0x37, 0x62, 0x37, 
+0x62, 0x34, 0x32, 0x63, 0x62, 0x30, 0x35, 0x66, 
+0x63, 0x66, 0x62, 0x36, 0x34, 0x35, 0x35, 0x30, 
+0x61, 0x64, 0x34, 0x39, 0x32, 0x30, 0x34, 0x37, 
+0x38, 0x65, 0x61, 0x38, 0x31, 0x66, 0x35, 0x34, 
+0x33, 0x31, 0x31, 0x31, 0x30, 0x64, 0x35, 0x38, 
+0x32, 0x38, 0x66, 0x39, 0x33, 0x38, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 
+0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x77, 0x69, 0x74, 0x6e, 0x65, 0x73, 
+0x73, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x31, 0x39, 0x62, 0x32, 0x61, 
+0x62, 0x65, 0x62, 0x39, 0x64, 0x37, 0x66, 0x32, 
+0x62, 0x36, 0x31, 0x33, 0x38, 0x62, 0x33, 0x61, 
+0x37, 0x34, 0x34, 0x64, 0x34, 0x39, 0x64, 0x39, 
+0x36, 0x63, 0x39, 0x32, 0x36, 0x62, 0x62, 0x64, 
+0x30, 0x62, 0x38, 0x65, 0x61, 0x66, 0x62, 0x33, 
+0x66, 0x32, 0x66, 0x30, 0x30, 0x31, 0x38, 0x33, 
+0x62, 0x32, 0x65, 0x32, 0x66, 0x34, 0x38, 0x38, 
+0x35, 0x32, 0x65, 0x34, 0x35, 0x33, 0x61, 0x36, 
+0x37, 0x61, 0x62, 0x31, 0x37, 0x63, 0x61, 0x66, 
+0x61, 0x30, 0x35, 0x39, 0x33, 0x32, 0x36, 0x31, 
+0x32, 0x63, 0x63, 0x37, 0x31, 0x63, 0x65, 0x35, 
+0x31, 0x32, 0x34, 0x34, 0x31, 0x35, 0x37, 0x34, 
+0x64, 0x35, 0x34, 0x63, 0x32, 0x39, 0x39, 0x30, 
+0x63, 0x35, 0x35, 0x65, 0x32, 0x65, 0x36, 0x35, 
+0x36, 0x30, 0x63, 0x37, 0x34, 0x32, 0x36, 0x32, 
+0x38, 0x33, 0x38, 0x38, 0x33, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x78, 0x69, 0x6e, 
+0x49, 0x6e, 0x64, 0x65, 0x78, 0x22, 0x3a, 0x20, 
+0x33, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 
+0x72, 0x6e, 0x61, 0x6c, 0x50, 0x72, 0x69, 0x76, 
+0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x64, 
+0x33, 0x63, 0x37, 0x61, 0x66, 0x30, 0x37, 0x64, 
+0x61, 0x32, 0x64, 0x35, 0x34, 0x66, 0x37, 0x61, 
+0x37, 0x37, 0x33, 0x35, 0x64, 0x33, 0x64, 0x30, 
+0x66, 0x63, 0x34, 0x66, 0x30, 0x61, 0x37, 0x33, 
+0x31, 0x36, 0x34, 0x64, 0x62, 0x36, 0x33, 0x38, 
+0x62, 0x32, 0x66, 0x32, 0x66, 0x37, 0x63, 0x34, 
+0x33, 0x66, 0x37, 0x31, 0x31, 0x66, 0x36, 0x64, 
+0x34, 0x61, 0x61, 0x37, 0x65, 0x36, 0x34, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 
+0x65, 0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 
+0x22, 0x63, 0x35, 0x32, 0x35, 0x37, 0x31, 0x34, 
+0x61, 0x37, 0x66, 0x34, 0x39, 0x63, 0x32, 0x38, 
+0x61, 0x65, 0x64, 0x62, 0x62, 0x62, 0x61, 0x37, 
+0x38, 0x63, 0x30, 0x30, 0x35, 0x39, 0x33, 0x31, 
+0x61, 0x38, 0x31, 0x63, 0x32, 0x33, 0x34, 0x62, 
+0x32, 0x66, 0x36, 0x63, 0x39, 0x39, 0x61, 0x37, 
+0x33, 0x65, 0x34, 0x64, 0x30, 0x36, 0x30, 0x38, 
+0x32, 0x61, 0x64, 0x63, 0x38, 0x62, 0x66, 0x32, 
+0x62, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 
+0x68, 0x54, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 
+0x31, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 
+0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 0x61, 
+0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 0x6c, 
+0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 0x3a, 
+0x20, 0x22, 0x39, 0x33, 0x34, 0x37, 0x38, 0x65, 
+0x39, 0x34, 0x38, 0x38, 0x66, 0x39, 0x35, 0x36, 
+0x64, 0x66, 0x32, 0x33, 0x39, 0x36, 0x62, 0x65, 
+0x32, 0x63, 0x65, 0x36, 0x63, 0x35, 0x63, 0x63, 
+0x65, 0x64, 0x37, 0x35, 0x66, 0x39, 0x30, 0x30, 
+0x64, 0x66, 0x61, 0x31, 0x38, 0x65, 0x37, 0x64, 
+0x61, 0x62, 0x64, 0x32, 0x34, 0x32, 0x38, 0x61, 
+0x61, 0x65, 0x37, 0x38, 0x34, 0x35, 0x31, 0x38, 
+0x32, 0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 0x36, 
+0x61, 0x66, 0x39, 0x65, 0x32, 0x38, 0x64, 0x62, 
+0x66, 0x39, 0x64, 0x36, 0x61, 0x61, 0x66, 0x30, 
+0x32, 0x37, 0x36, 0x39, 0x36, 0x65, 0x32, 0x35, 
+0x39, 0x38, 0x61, 0x35, 0x62, 0x33, 0x64, 0x30, 
+0x35, 0x36, 0x66, 0x35, 0x66, 0x64, 0x32, 0x33, 
+0x35, 0x35, 0x61, 0x37, 0x66, 0x64, 0x35, 0x61, 
+0x33, 0x37, 0x61, 0x30, 0x65, 0x35, 0x30, 0x30, 
+0x38, 0x31, 0x33, 0x32, 0x64, 0x33, 0x30, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 
+0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 0x65, 
+0x79, 0x22, 0x3a, 0x20, 0x22, 0x39, 0x37, 0x33, 
+0x32, 0x33, 0x33, 0x38, 0x35, 0x65, 0x35, 0x37, 
+0x30, 0x31, 0x35, 0x62, 0x37, 0x35, 0x62, 0x30, 
+0x33, 0x33, 0x39, 0x61, 0x35, 0x34, 0x39, 0x63, 
+0x35, 0x36, 0x61, 0x39, 0x34, 0x38, 0x65, 0x62, 
+0x39, 0x36, 0x31, 0x35, 0x35, 0x35, 0x39, 0x37, 
+0x33, 0x66, 0x30, 0x39, 0x35, 0x31, 0x66, 0x35, 
+0x35, 0x35, 0x61, 0x65, 0x36, 0x30, 0x33, 0x39, 
+0x65, 0x66, 0x30, 0x30, 0x64, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 0x22, 
+0x3a, 0x20, 0x22, 0x30, 0x30, 0x30, 0x31, 0x30, 
+0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 0x30, 
+0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x65, 
+0x33, 0x62, 0x33, 0x33, 0x62, 0x62, 0x34, 0x65, 
+0x66, 0x33, 0x61, 0x35, 0x32, 0x61, 0x64, 0x31, 
+0x66, 0x66, 0x66, 0x62, 0x35, 0x35, 0x35, 0x63, 
+0x30, 0x64, 0x38, 0x32, 0x38, 0x32, 0x38, 0x65, 
+0x62, 0x32, 0x32, 0x37, 0x33, 0x37, 0x30, 0x33, 
+0x36, 0x65, 0x61, 0x65, 0x62, 0x30, 0x32, 0x61, 
+0x32, 0x33, 0x35, 0x64, 0x38, 0x32, 0x62, 0x39, 
+0x30, 0x39, 0x63, 0x34, 0x63, 0x33, 0x66, 0x66, 
+0x33, 0x61, 0x31, 0x33, 0x62, 0x34, 0x30, 0x64, 
+0x37, 0x39, 0x30, 0x39, 0x30, 0x32, 0x32, 0x62, 
+0x64, 0x35, 0x34, 0x33, 0x30, 0x32, 0x36, 0x33, 
+0x65, 0x39, 0x32, 0x37, 0x38, 0x31, 0x36, 0x30, 
+0x39, 0x34, 0x35, 0x65, 0x30, 0x63, 0x35, 0x61, 
+0x35, 0x64, 0x33, 0x63, 0x61, 0x37, 0x30, 0x34, 
+0x38, 0x39, 0x66, 0x66, 0x62, 0x32, 0x63, 0x30, 
+0x61, 0x33, 0x65, 0x39, 0x30, 0x36, 0x39, 0x34, 
+0x31, 0x61, 0x64, 0x35, 0x62, 0x37, 0x39, 0x62, 
+0x32, 0x62, 0x35, 0x31, 0x32, 0x36, 0x35, 0x37, 
+0x31, 0x61, 0x66, 0x38, 0x39, 0x62, 0x35, 0x35, 
+0x31, 0x33, 0x61, 0x61, 0x34, 0x39, 0x36, 0x61, 
+0x31, 0x30, 0x62, 0x64, 0x37, 0x61, 0x35, 0x61, 
+0x62, 0x36, 0x38, 0x62, 0x38, 0x32, 0x31, 0x62, 
+0x66, 0x30, 0x31, 0x39, 0x62, 0x33, 0x33, 0x32, 
+0x63, 0x62, 0x34, 0x64, 0x33, 0x31, 0x31, 0x31, 
+0x38, 0x39, 0x35, 0x39, 0x63, 0x37, 0x32, 0x32, 
+0x31, 0x61, 0x62, 0x35, 0x63, 0x65, 0x39, 0x65, 
+0x32, 0x36, 0x63, 0x33, 0x63, 0x64, 0x36, 0x37, 
+0x62, 0x32, 0x32, 0x63, 0x32, 0x34, 0x66, 0x38, 
+0x62, 0x61, 0x61, 0x35, 0x34, 0x62, 0x61, 0x63, 
+0x32, 0x38, 0x31, 0x64, 0x38, 0x65, 0x36, 0x62, 
+0x30, 0x35, 0x65, 0x34, 0x30, 0x30, 0x65, 0x36, 
+0x63, 0x33, 0x61, 0x39, 0x35, 0x37, 0x65, 0x61, 
+0x32, 0x65, 0x36, 0x64, 0x61, 0x62, 0x37, 0x63, 
+0x31, 0x66, 0x30, 0x64, 0x63, 0x64, 0x32, 0x39, 
+0x37, 0x63, 0x38, 0x64, 0x36, 0x31, 0x36, 0x34, 
+0x37, 0x66, 0x64, 0x31, 0x37, 0x64, 0x38, 0x32, 
+0x31, 0x35, 0x34, 0x31, 0x65, 0x61, 0x36, 0x39, 
+0x63, 0x33, 0x63, 0x63, 0x33, 0x37, 0x64, 0x63, 
+0x62, 0x61, 0x64, 0x37, 0x66, 0x39, 0x30, 0x64, 
+0x34, 0x65, 0x62, 0x34, 0x62, 0x63, 0x35, 0x30, 
+0x30, 0x30, 0x33, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x70, 0x72, 0x65, 
+0x63, 0x6f, 0x6d, 0x70, 0x75, 0x74, 0x65, 0x64, 
+0x55, 0x73, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 
+0x73, 0x68, 0x41, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x68, 0x61, 0x73, 0x68, 0x4f, 0x75, 0x74, 
+0x70, 0x75, 0x74, 0x73, 0x22, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 
+0x50, 0x72, 0x65, 0x76, 0x6f, 0x75, 0x74, 0x73, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x68, 0x61, 0x73, 0x68, 0x53, 0x63, 0x72, 0x69, 
+0x70, 0x74, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 
+0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x68, 0x61, 0x73, 0x68, 0x53, 0x65, 0x71, 
+0x75, 0x65, 0x6e, 0x63, 0x65, 0x73, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x73, 0x69, 0x67, 0x48, 
+0x61, 0x73, 0x68, 0x22, 0x3a, 0x20, 0x22, 0x61, 
+0x61, 0x38, 0x36, 0x65, 0x66, 0x37, 0x31, 0x35, 
+0x37, 0x66, 0x32, 0x37, 0x66, 0x38, 0x36, 0x32, 
+0x62, 0x34, 0x32, 0x35, 0x35, 0x39, 0x31, 0x31, 
+0x38, 0x62, 0x61, 0x39, 0x30, 0x30, 0x35, 0x39, 
+0x64, 0x66, 0x39, 0x34, 0x37, 0x63, 0x31, 0x32, 
+0x34, 0x34, 0x66, 0x61, 0x30, 0x65, 0x39, 0x31, 
+0x36, 0x37, 0x39, 0x63, 0x31, 0x63, 0x35, 0x33, 
+0x30, 0x33, 0x62, 0x38, 0x32, 0x35, 0x32, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 
+0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x77, 0x69, 0x74, 0x6e, 0x65, 
+0x73, 0x73, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x37, 0x66, 0x62, 0x31, 
+0x35, 0x61, 0x33, 0x35, 0x37, 0x65, 0x66, 0x33, 
+0x61, 0x61, 0x38, 0x37, 0x65, 0x62, 0x31, 0x36, 
+0x36, 0x34, 0x61, 0x37, 0x30, 0x30, 0x30, 0x31, 
+0x36, 0x63, 0x39, 0x36, 0x30, 0x32, 0x39, 0x64, 
+0x65, 0x63, 0x65, 0x36, 0x38, 0x37, 0x65, 0x62, 
+0x63, 0x63, 0x61, 0x32, 0x38, 0x37, 0x38, 0x38, 
+0x35, 0x30, 0x64, 0x65, 0x30, 0x65, 0x33, 0x39, 
+0x33, 0x63, 0x39, 0x37, 0x63, 0x64, 0x37, 0x36, 
+0x65, 0x32, 0x30, 0x30, 0x37, 0x64, 0x33, 0x61, 
+0x37, 0x63, 0x33, 0x64, 0x33, 0x38, 0x36, 0x65, 
+0x61, 0x35, 0x65, 0x65, 0x66, 0x30, 0x30, 0x33, 
+0x39, 0x39, 0x66, 0x63, 0x35, 0x35, 0x33, 0x37, 
+0x66, 0x63, 0x36, 0x30, 0x39, 0x30, 0x63, 0x39, 
+0x62, 0x38, 0x36, 0x37, 0x63, 0x36, 0x37, 0x62, 
+0x36, 0x38, 0x33, 0x39, 0x38, 0x61, 0x31, 0x64, 
+0x63, 0x33, 0x33, 0x64, 0x30, 0x31, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x78, 0x69, 
+0x6e, 0x49, 0x6e, 0x64, 0x65, 0x78, 0x22, 0x3a, 
+0x20, 0x34, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 
+0x65, 0x72, 0x6e, 0x61, 0x6c, 0x50, 0x72, 0x69, 
+0x76, 0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 
+0x66, 0x33, 0x36, 0x62, 0x62, 0x30, 0x37, 0x61, 
+0x31, 0x31, 0x65, 0x34, 0x36, 0x39, 0x63, 0x65, 
+0x39, 0x34, 0x31, 0x64, 0x31, 0x36, 0x62, 0x36, 
+0x33, 0x62, 0x31, 0x31, 0x62, 0x39, 0x62, 0x39, 
+0x31, 0x32, 0x30, 0x61, 0x38, 0x34, 0x64, 0x39, 
+0x64, 0x38, 0x37, 0x63, 0x66, 0x66, 0x32, 0x63, 
+0x38, 0x34, 0x61, 0x38, 0x64, 0x34, 0x61, 0x66, 
+0x66, 0x62, 0x34, 0x33, 0x38, 0x66, 0x34, 0x65, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 
+0x6c, 0x65, 0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 
+0x20, 0x22, 0x63, 0x63, 0x62, 0x64, 0x36, 0x36, 
+0x63, 0x36, 0x66, 0x37, 0x65, 0x38, 0x66, 0x64, 
+0x61, 0x62, 0x34, 0x37, 0x62, 0x33, 0x61, 0x34, 
+0x38, 0x36, 0x66, 0x35, 0x39, 0x64, 0x32, 0x38, 
+0x32, 0x36, 0x32, 0x62, 0x65, 0x38, 0x35, 0x37, 
+0x66, 0x33, 0x30, 0x64, 0x34, 0x37, 0x37, 0x33, 
+0x66, 0x32, 0x64, 0x35, 0x65, 0x61, 0x34, 0x37, 
+0x66, 0x37, 0x37, 0x36, 0x31, 0x63, 0x65, 0x30, 
+0x65, 0x32, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 
+0x73, 0x68, 0x54, 0x79, 0x70, 0x65, 0x22, 0x3a, 
+0x20, 0x30, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 
+0x6e, 0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 
+0x61, 0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 
+0x6c, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x65, 0x30, 0x64, 0x66, 0x65, 
+0x32, 0x33, 0x30, 0x30, 0x62, 0x30, 0x64, 0x64, 
+0x37, 0x34, 0x36, 0x61, 0x33, 0x66, 0x38, 0x36, 
+0x37, 0x34, 0x64, 0x66, 0x64, 0x34, 0x35, 0x32, 
+0x35, 0x36, 0x32, 0x33, 0x36, 0x33, 0x39, 0x30, 
+0x34, 0x32, 0x35, 0x36, 0x39, 0x64, 0x38, 0x32, 
+0x39, 0x63, 0x37, 0x66, 0x30, 0x65, 0x65, 0x64, 
+0x39, 0x36, 0x30, 0x32, 0x64, 0x32, 0x36, 0x33, 
+0x65, 0x36, 0x66, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 
+0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 
+0x62, 0x35, 0x37, 0x62, 0x66, 0x61, 0x31, 0x38, 
+0x33, 0x64, 0x32, 0x38, 0x65, 0x65, 0x62, 0x36, 
+0x61, 0x64, 0x36, 0x38, 0x38, 0x64, 0x64, 0x61, 
+0x61, 0x62, 0x62, 0x32, 0x36, 0x35, 0x62, 0x34, 
+0x61, 0x34, 0x31, 0x66, 0x62, 0x66, 0x36, 0x38, 
+0x65, 0x35, 0x66, 0x65, 0x64, 0x32, 0x63, 0x37, 
+0x32, 0x63, 0x37, 0x34, 0x64, 0x65, 0x37, 0x30, 
+0x64, 0x35, 0x61, 0x37, 0x38, 0x36, 0x66, 0x34, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 
+0x6b, 0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x61, 0x38, 
+0x65, 0x37, 0x61, 0x61, 0x39, 0x32, 0x34, 0x66, 
+0x30, 0x64, 0x35, 0x38, 0x38, 0x35, 0x34, 0x31, 
+0x38, 0x35, 0x61, 0x34, 0x39, 0x30, 0x65, 0x36, 
+0x63, 0x34, 0x31, 0x66, 0x36, 0x65, 0x66, 0x62, 
+0x37, 0x62, 0x36, 0x37, 0x35, 0x63, 0x30, 0x66, 
+0x33, 0x33, 0x33, 0x31, 0x62, 0x37, 0x66, 0x31, 
+0x34, 0x62, 0x35, 0x34, 0x39, 0x34, 0x30, 0x30, 
+0x62, 0x34, 0x64, 0x35, 0x30, 0x31, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 
+0x22, 0x3a, 0x20, 0x22, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x65, 0x33, 0x62, 0x33, 0x33, 0x62, 0x62, 0x34, 
+0x65, 0x66, 0x33, 0x61, 0x35, 0x32, 0x61, 0x64, 
+0x31, 0x66, 0x66, 0x66, 0x62, 0x35, 0x35, 0x35, 
+0x63, 0x30, 0x64, 0x38, 0x32, 0x38, 0x32, 0x38, 
+0x65, 0x62, 0x32, 0x32, 0x37, 0x33, 0x37, 0x30, 
+0x33, 0x36, 0x65, 0x61, 0x65, 0x62, 0x30, 0x32, 
+0x61, 0x32, 0x33, 0x35, 0x64, 0x38, 0x32, 0x62, 
+0x39, 0x30, 0x39, 0x63, 0x34, 0x63, 0x33, 0x66, 
+0x66, 0x33, 0x61, 0x31, 0x33, 0x62, 0x34, 0x30, 
+0x64, 0x37, 0x39, 0x30, 0x39, 0x30, 0x32, 0x32, 
+0x62, 0x64, 0x35, 0x34, 0x33, 0x30, 0x32, 0x36, 
+0x33, 0x65, 0x39, 0x32, 0x37, 0x38, 0x31, 0x36, 
+0x30, 0x39, 0x34, 0x35, 0x65, 0x30, 0x63, 0x35, 
+0x61, 0x35, 0x64, 0x33, 0x63, 0x61, 0x37, 0x30, 
+0x34, 0x38, 0x39, 0x66, 0x66, 0x62, 0x32, 0x63, 
+0x30, 0x61, 0x33, 0x65, 0x39, 0x30, 0x36, 0x39, 
+0x34, 0x31, 0x61, 0x64, 0x35, 0x62, 0x37, 0x39, 
+0x62, 0x32, 0x62, 0x35, 0x31, 0x32, 0x36, 0x35, 
+0x37, 0x31, 0x61, 0x66, 0x38, 0x39, 0x62, 0x35, 
+0x35, 0x31, 0x33, 0x61, 0x61, 0x34, 0x39, 0x36, 
+0x61, 0x31, 0x30, 0x62, 0x64, 0x37, 0x61, 0x35, 
+0x61, 0x62, 0x36, 0x38, 0x62, 0x38, 0x32, 0x31, 
+0x62, 0x66, 0x30, 0x31, 0x39, 0x62, 0x33, 0x33, 
+0x32, 0x63, 0x62, 0x34, 0x64, 0x33, 0x31, 0x31, 
+0x31, 0x38, 0x39, 0x35, 0x39, 0x63, 0x37, 0x32, 
+0x32, 0x31, 0x61, 0x62, 0x35, 0x63, 0x65, 0x39, 
+0x65, 0x32, 0x36, 0x63, 0x33, 0x63, 0x64, 0x36, 
+0x37, 0x62, 0x32, 0x32, 0x63, 0x32, 0x34, 0x66, 
+0x38, 0x62, 0x61, 0x61, 0x35, 0x34, 0x62, 0x61, 
+0x63, 0x32, 0x38, 0x31, 0x64, 0x38, 0x65, 0x36, 
+0x62, 0x30, 0x35, 0x65, 0x34, 0x30, 0x30, 0x65, 
+0x36, 0x63, 0x33, 0x61, 0x39, 0x35, 0x37, 0x65, 
+0x61, 0x32, 0x65, 0x36, 0x64, 0x61, 0x62, 0x37, 
+0x63, 0x31, 0x66, 0x30, 0x64, 0x63, 0x64, 0x32, 
+0x39, 0x37, 0x63, 0x38, 0x64, 0x36, 0x31, 0x36, 
+0x34, 0x37, 0x66, 0x64, 0x31, 0x37, 0x64, 0x38, 
+0x32, 0x31, 0x35, 0x34, 0x31, 0x65, 0x61, 0x36, 
+0x39, 0x63, 0x33, 0x63, 0x63, 0x33, 0x37, 0x64, 
+0x63, 0x62, 0x61, 0x64, 0x37, 0x66, 0x39, 0x30, 
+0x64, 0x34, 0x65, 0x62, 0x34, 0x62, 0x63, 0x35, 
+0x30, 0x30, 0x30, 0x34, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x70, 0x72, 
+0x65, 0x63, 0x6f, 0x6d, 0x70, 0x75, 0x74, 0x65, 
+0x64, 0x55, 0x73, 0x65, 0x64, 0x22, 0x3a, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 
+0x61, 0x73, 0x68, 0x41, 0x6d, 0x6f, 0x75, 0x6e, 
+0x74, 0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 0x4f, 0x75, 
+0x74, 0x70, 0x75, 0x74, 0x73, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 
+0x68, 0x50, 0x72, 0x65, 0x76, 0x6f, 0x75, 0x74, 
+0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x68, 0x61, 0x73, 0x68, 0x53, 0x63, 0x72, 
+0x69, 0x70, 0x74, 0x50, 0x75, 0x62, 0x6b, 0x65, 
+0x79, 0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 0x53, 0x65, 
+0x71, 0x75, 0x65, 0x6e, 0x63, 0x65, 0x73, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x69, 0x67, 
+0x48, 0x61, 0x73, 0x68, 0x22, 0x3a, 0x20, 0x22, 
+0x36, 0x61, 0x38, 0x38, 0x36, 0x39, 0x34, 0x39, 
+0x30, 0x38, 0x62, 0x35, 0x66, 0x32, 0x35, 0x35, 
+0x39, 0x61, 0x61, 0x64, 0x36, 0x36, 0x65, 0x33, 
+0x30, 0x34, 0x38, 0x64, 0x62, 0x31, 0x65, 0x65, 
+0x31, 0x36, 0x63, 0x37, 0x33, 0x30, 0x34, 0x66, 
+0x30, 0x66, 0x63, 0x34, 0x38, 0x32, 0x36, 0x37, 
+0x63, 0x39, 0x31, 0x34, 0x31, 0x37, 0x64, 0x66, 
+0x33, 0x62, 0x64, 0x31, 0x66, 0x63, 0x35, 0x61, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 0x78, 
+0x70, 0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x77, 0x69, 0x74, 0x6e, 
+0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x33, 0x39, 0x33, 
+0x31, 0x34, 0x63, 0x37, 0x65, 0x62, 0x66, 0x32, 
+0x63, 0x35, 0x31, 0x63, 0x61, 0x30, 0x31, 0x30, 
+0x39, 0x33, 0x34, 0x39, 0x30, 0x64, 0x33, 0x66, 
+0x35, 0x61, 0x36, 0x36, 0x31, 0x31, 0x35, 0x39, 
+0x32, 0x64, 0x61, 0x64, 0x31, 0x63, 0x31, 0x38, 
+0x37, 0x35, 0x33, 0x61, 0x30, 0x62, 0x62, 0x66, 
+0x32, 0x31, 0x32, 0x66, 0x30, 0x61, 0x35, 0x37, 
+0x35, 0x65, 0x39, 0x30, 0x62, 0x65, 0x39, 0x61, 
+0x32, 0x37, 0x31, 0x38, 0x65, 0x62, 0x38, 0x32, 
+0x34, 0x32, 0x62, 0x30, 0x32, 0x36, 0x32, 0x61, 
+0x33, 0x33, 0x37, 0x31, 0x35, 0x35, 0x35, 0x64, 
+0x35, 0x66, 0x61, 0x62, 0x62, 0x34, 0x61, 0x36, 
+0x64, 0x35, 0x37, 0x34, 0x63, 0x30, 0x63, 0x66, 
+0x34, 0x62, 0x37, 0x35, 0x38, 0x36, 0x35, 0x30, 
+0x36, 0x34, 0x36, 0x38, 0x66, 0x33, 0x31, 0x38, 
+0x65, 0x39, 0x38, 0x30, 0x63, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x78, 0x69, 0x6e, 
+0x49, 0x6e, 0x64, 0x65, 0x78, 0x22, 0x3a, 0x20, 
+0x36, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 
+0x72, 0x6e, 0x61, 0x6c, 0x50, 0x72, 0x69, 0x76, 
+0x6b, 0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x34, 
+0x31, 0x35, 0x63, 0x66, 0x65, 0x39, 0x63, 0x31, 
+0x35, 0x64, 0x39, 0x63, 0x65, 0x61, 0x32, 0x37, 
+0x64, 0x38, 0x31, 0x30, 0x34, 0x64, 0x35, 0x35, 
+0x31, 0x37, 0x63, 0x30, 0x36, 0x65, 0x39, 0x64, 
+0x65, 0x34, 0x38, 0x65, 0x32, 0x66, 0x39, 0x38, 
+0x36, 0x62, 0x36, 0x39, 0x35, 0x65, 0x34, 0x66, 
+0x35, 0x66, 0x66, 0x65, 0x62, 0x66, 0x32, 0x33, 
+0x30, 0x65, 0x37, 0x32, 0x35, 0x64, 0x38, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 
+0x65, 0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 
+0x22, 0x32, 0x66, 0x36, 0x62, 0x32, 0x63, 0x35, 
+0x33, 0x39, 0x37, 0x62, 0x36, 0x64, 0x36, 0x38, 
+0x63, 0x61, 0x31, 0x38, 0x65, 0x30, 0x39, 0x61, 
+0x33, 0x66, 0x30, 0x35, 0x31, 0x36, 0x31, 0x36, 
+0x36, 0x38, 0x66, 0x66, 0x65, 0x39, 0x33, 0x61, 
+0x39, 0x38, 0x38, 0x35, 0x38, 0x32, 0x64, 0x35, 
+0x35, 0x63, 0x36, 0x66, 0x30, 0x37, 0x62, 0x64, 
+0x35, 0x62, 0x33, 0x33, 0x32, 0x39, 0x64, 0x65, 
+0x66, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 
+0x68, 0x54, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 
+0x32, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 
+0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 0x61, 
+0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 0x6c, 
+0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 0x3a, 
+0x20, 0x22, 0x35, 0x35, 0x61, 0x64, 0x66, 0x34, 
+0x65, 0x38, 0x39, 0x36, 0x37, 0x66, 0x62, 0x64, 
+0x32, 0x65, 0x32, 0x39, 0x66, 0x32, 0x30, 0x61, 
+0x63, 0x38, 0x39, 0x36, 0x65, 0x36, 0x30, 0x63, 
+0x33, 0x62, 0x30, 0x66, 0x31, 0x64, 0x35, 0x62, 
+0x30, 0x65, 0x66, 0x61, 0x39, 0x64, 0x33, 0x34, 
+0x39, 0x34, 0x31, 0x62, 0x35, 0x39, 0x35, 0x38, 
+0x63, 0x37, 0x62, 0x30, 0x61, 0x30, 0x33, 0x31, 
+0x32, 0x64, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 0x36, 
+0x35, 0x37, 0x39, 0x31, 0x33, 0x38, 0x65, 0x37, 
+0x39, 0x37, 0x36, 0x64, 0x63, 0x31, 0x33, 0x62, 
+0x36, 0x61, 0x39, 0x32, 0x66, 0x37, 0x62, 0x66, 
+0x64, 0x35, 0x61, 0x32, 0x66, 0x63, 0x37, 0x36, 
+0x38, 0x34, 0x66, 0x35, 0x65, 0x61, 0x34, 0x32, 
+0x34, 0x31, 0x39, 0x64, 0x34, 0x33, 0x33, 0x36, 
+0x38, 0x33, 0x30, 0x31, 0x34, 0x37, 0x30, 0x66, 
+0x33, 0x62, 0x37, 0x34, 0x65, 0x64, 0x39, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 
+0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 0x65, 
+0x79, 0x22, 0x3a, 0x20, 0x22, 0x32, 0x34, 0x31, 
+0x63, 0x31, 0x34, 0x66, 0x32, 0x36, 0x33, 0x39, 
+0x64, 0x30, 0x64, 0x37, 0x31, 0x33, 0x39, 0x32, 
+0x38, 0x32, 0x61, 0x61, 0x36, 0x61, 0x62, 0x64, 
+0x65, 0x32, 0x38, 0x64, 0x64, 0x38, 0x61, 0x30, 
+0x36, 0x37, 0x62, 0x61, 0x61, 0x39, 0x64, 0x36, 
+0x33, 0x33, 0x65, 0x34, 0x65, 0x37, 0x32, 0x33, 
+0x30, 0x32, 0x38, 0x37, 0x65, 0x63, 0x32, 0x64, 
+0x30, 0x32, 0x39, 0x30, 0x31, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 0x22, 
+0x3a, 0x20, 0x22, 0x30, 0x30, 0x30, 0x32, 0x30, 
+0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 0x30, 
+0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x65, 
+0x33, 0x62, 0x33, 0x33, 0x62, 0x62, 0x34, 0x65, 
+0x66, 0x33, 0x61, 0x35, 0x32, 0x61, 0x64, 0x31, 
+0x66, 0x66, 0x66, 0x62, 0x35, 0x35, 0x35, 0x63, 
+0x30, 0x64, 0x38, 0x32, 0x38, 0x32, 0x38, 0x65, 
+0x62, 0x32, 0x32, 0x37, 0x33, 0x37, 0x30, 0x33, 
+0x36, 0x65, 0x61, 0x65, 0x62, 0x30, 0x32, 0x61, 
+0x32, 0x33, 0x35, 0x64, 0x38, 0x32, 0x62, 0x39, 
+0x30, 0x39, 0x63, 0x34, 0x63, 0x33, 0x66, 0x66, 
+0x33, 0x61, 0x31, 0x33, 0x62, 0x34, 0x30, 0x64, 
+0x37, 0x39, 0x30, 0x39, 0x30, 0x32, 0x32, 0x62, 
+0x64, 0x35, 0x34, 0x33, 0x30, 0x32, 0x36, 0x33, 
+0x65, 0x39, 0x32, 0x37, 0x38, 0x31, 0x36, 0x30, 
+0x39, 0x34, 0x35, 0x65, 0x30, 0x63, 0x35, 0x61, 
+0x35, 0x64, 0x33, 0x63, 0x61, 0x37, 0x30, 0x34, 
+0x38, 0x39, 0x66, 0x66, 0x62, 0x32, 0x63, 0x30, 
+0x61, 0x33, 0x65, 0x39, 0x30, 0x36, 0x39, 0x34, 
+0x31, 0x61, 0x64, 0x35, 0x62, 0x37, 0x39, 0x62, 
+0x32, 0x62, 0x35, 0x31, 0x32, 0x36, 0x35, 0x37, 
+0x31, 0x61, 0x66, 0x38, 0x39, 0x62, 0x35, 0x35, 
+0x31, 0x33, 0x61, 0x61, 0x34, 0x39, 0x36, 0x61, 
+0x31, 0x30, 0x62, 0x64, 0x37, 0x61, 0x35, 0x61, 
+0x62, 0x36, 0x38, 0x62, 0x38, 0x32, 0x31, 0x62, 
+0x66, 0x30, 0x31, 0x39, 0x62, 0x33, 0x33, 0x32, 
+0x63, 0x62, 0x34, 0x64, 0x33, 0x31, 0x31, 0x31, 
+0x38, 0x39, 0x35, 0x39, 0x63, 0x37, 0x32, 0x32, 
+0x31, 0x61, 0x62, 0x35, 0x63, 0x65, 0x39, 0x65, 
+0x32, 0x36, 0x63, 0x33, 0x63, 0x64, 0x36, 0x37, 
+0x62, 0x32, 0x32, 0x63, 0x32, 0x34, 0x66, 0x38, 
+0x62, 0x61, 0x61, 0x35, 0x34, 0x62, 0x61, 0x63, 
+0x32, 0x38, 0x31, 0x64, 0x38, 0x65, 0x36, 0x62, 
+0x30, 0x35, 0x65, 0x34, 0x30, 0x30, 0x65, 0x36, 
+0x63, 0x33, 0x61, 0x39, 0x35, 0x37, 0x65, 0x30, 
+0x30, 0x30, 0x36, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x70, 0x72, 0x65, 
+0x63, 0x6f, 0x6d, 0x70, 0x75, 0x74, 0x65, 0x64, 
+0x55, 0x73, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 
+0x73, 0x68, 0x41, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x73, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x68, 0x61, 0x73, 0x68, 0x50, 0x72, 0x65, 
+0x76, 0x6f, 0x75, 0x74, 0x73, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 
+0x68, 0x53, 0x63, 0x72, 0x69, 0x70, 0x74, 0x50, 
+0x75, 0x62, 0x6b, 0x65, 0x79, 0x73, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 
+0x73, 0x68, 0x53, 0x65, 0x71, 0x75, 0x65, 0x6e, 
+0x63, 0x65, 0x73, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x69, 0x67, 0x48, 0x61, 0x73, 0x68, 
+0x22, 0x3a, 0x20, 0x22, 0x36, 0x36, 0x37, 0x66, 
+0x39, 0x30, 0x61, 0x35, 0x64, 0x32, 0x34, 0x36, 
+0x39, 0x31, 0x62, 0x62, 0x39, 0x61, 0x38, 0x36, 
+0x64, 0x39, 0x33, 0x30, 0x35, 0x30, 0x39, 0x66, 
+0x32, 0x31, 0x65, 0x61, 0x35, 0x35, 0x64, 0x64, 
+0x66, 0x33, 0x61, 0x30, 0x35, 0x35, 0x31, 0x37, 
+0x38, 0x34, 0x34, 0x61, 0x32, 0x65, 0x30, 0x64, 
+0x32, 0x30, 0x39, 0x61, 0x65, 0x34, 0x65, 0x32, 
+0x34, 0x64, 0x30, 0x61, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 0x63, 0x74, 
+0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x77, 0x69, 0x74, 0x6e, 0x65, 0x73, 0x73, 0x22, 
+0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x62, 0x39, 0x32, 0x34, 0x66, 0x66, 0x35, 
+0x39, 0x36, 0x39, 0x36, 0x66, 0x62, 0x61, 0x62, 
+0x61, 0x34, 0x32, 0x34, 0x39, 0x65, 0x31, 0x66, 
+0x62, 0x32, 0x37, 0x65, 0x37, 0x66, 0x38, 0x38, 
+0x63, 0x31, 0x38, 0x63, 0x34, 0x33, 0x64, 0x32, 
+0x66, 0x39, 0x34, 0x63, 0x39, 0x65, 0x35, 0x66, 
+0x32, 0x65, 0x62, 0x38, 0x33, 0x30, 0x39, 0x64, 
+0x38, 0x33, 0x36, 0x31, 0x37, 0x63, 0x66, 0x39, 
+0x61, 0x66, 0x34, 0x62, 0x63, 0x39, 0x30, 0x65, 
+0x33, 0x33, 0x34, 0x38, 0x31, 0x64, 0x63, 0x33, 
+0x30, 0x61, 0x37, 0x30, 0x31, 0x32, 0x37, 0x39, 
+0x38, 0x36, 0x62, 0x62, 0x66, 0x39, 0x63, 0x66, 
+0x62, 0x33, 0x38, 0x63, 0x62, 0x61, 0x62, 0x66, 
+0x34, 0x31, 0x62, 0x30, 0x61, 0x63, 0x66, 0x66, 
+0x62, 0x65, 0x36, 0x65, 0x38, 0x32, 0x62, 0x33, 
+0x61, 0x36, 0x65, 0x31, 0x65, 0x34, 0x35, 0x30, 
+0x39, 0x30, 0x32, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x67, 
+0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 0x20, 0x7b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x74, 0x78, 0x69, 0x6e, 0x49, 0x6e, 
+0x64, 0x65, 0x78, 0x22, 0x3a, 0x20, 0x37, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 
+0x61, 0x6c, 0x50, 0x72, 0x69, 0x76, 0x6b, 0x65, 
+0x79, 0x22, 0x3a, 0x20, 0x22, 0x63, 0x37, 0x62, 
+0x30, 0x65, 0x38, 0x31, 0x66, 0x30, 0x61, 0x39, 
+0x61, 0x30, 0x62, 0x30, 0x34, 0x39, 0x39, 0x65, 
+0x31, 0x31, 0x32, 0x32, 0x37, 0x39, 0x64, 0x37, 
+0x31, 0x38, 0x63, 0x63, 0x61, 0x39, 0x38, 0x65, 
+0x37, 0x39, 0x61, 0x31, 0x32, 0x65, 0x32, 0x66, 
+0x31, 0x33, 0x37, 0x63, 0x37, 0x32, 0x61, 0x65, 
+0x35, 0x62, 0x32, 0x31, 0x33, 0x61, 0x61, 0x64, 
+0x30, 0x64, 0x31, 0x30, 0x33, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 0x65, 0x52, 
+0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x36, 
+0x63, 0x32, 0x64, 0x63, 0x31, 0x30, 0x36, 0x61, 
+0x62, 0x38, 0x31, 0x36, 0x62, 0x37, 0x33, 0x66, 
+0x39, 0x64, 0x30, 0x37, 0x65, 0x33, 0x63, 0x64, 
+0x31, 0x65, 0x66, 0x32, 0x63, 0x38, 0x63, 0x31, 
+0x32, 0x35, 0x36, 0x66, 0x35, 0x31, 0x39, 0x37, 
+0x34, 0x38, 0x65, 0x30, 0x38, 0x31, 0x33, 0x65, 
+0x34, 0x65, 0x64, 0x64, 0x32, 0x34, 0x30, 0x35, 
+0x64, 0x32, 0x37, 0x37, 0x62, 0x65, 0x66, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 0x54, 
+0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x33, 
+0x30, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 0x6e, 
+0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 0x61, 
+0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 0x6c, 
+0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 0x3a, 
+0x20, 0x22, 0x65, 0x65, 0x34, 0x66, 0x65, 0x30, 
+0x38, 0x35, 0x39, 0x38, 0x33, 0x34, 0x36, 0x32, 
+0x61, 0x31, 0x38, 0x34, 0x30, 0x31, 0x35, 0x64, 
+0x31, 0x66, 0x37, 0x38, 0x32, 0x64, 0x36, 0x61, 
+0x35, 0x66, 0x38, 0x62, 0x39, 0x63, 0x32, 0x62, 
+0x36, 0x30, 0x31, 0x33, 0x30, 0x61, 0x66, 0x66, 
+0x30, 0x35, 0x30, 0x63, 0x65, 0x32, 0x32, 0x31, 
+0x65, 0x63, 0x66, 0x33, 0x37, 0x38, 0x36, 0x35, 
+0x39, 0x32, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 
+0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 0x39, 
+0x65, 0x30, 0x35, 0x31, 0x37, 0x65, 0x64, 0x63, 
+0x38, 0x32, 0x35, 0x39, 0x62, 0x62, 0x33, 0x33, 
+0x35, 0x39, 0x32, 0x35, 0x35, 0x34, 0x30, 0x30, 
+0x62, 0x32, 0x33, 0x63, 0x61, 0x39, 0x35, 0x30, 
+0x37, 0x66, 0x32, 0x61, 0x39, 0x31, 0x63, 0x64, 
+0x31, 0x65, 0x34, 0x32, 0x35, 0x30, 0x62, 0x61, 
+0x30, 0x36, 0x38, 0x62, 0x34, 0x65, 0x61, 0x66, 
+0x63, 0x65, 0x62, 0x61, 0x34, 0x61, 0x39, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 0x6b, 
+0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 0x65, 
+0x79, 0x22, 0x3a, 0x20, 0x22, 0x36, 0x35, 0x62, 
+0x36, 0x30, 0x30, 0x30, 0x63, 0x64, 0x32, 0x62, 
+0x66, 0x61, 0x36, 0x62, 0x37, 0x63, 0x66, 0x37, 
+0x33, 0x36, 0x37, 0x36, 0x37, 0x61, 0x38, 0x39, 
+0x35, 0x35, 0x37, 0x36, 0x30, 0x65, 0x36, 0x32, 
+0x62, 0x36, 0x36, 0x34, 0x39, 0x30, 0x35, 0x38, 
+0x63, 0x62, 0x63, 0x39, 0x37, 0x30, 0x62, 0x37, 
+0x63, 0x30, 0x38, 0x37, 0x31, 0x64, 0x37, 0x38, 
+0x36, 0x33, 0x34, 0x36, 0x62, 0x22, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 0x22, 
+0x3a, 0x20, 0x22, 0x30, 0x30, 0x38, 0x32, 0x30, 
+0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 0x30, 
+0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x65, 0x39, 0x61, 0x61, 0x36, 0x62, 0x38, 
+0x65, 0x36, 0x63, 0x39, 0x64, 0x65, 0x36, 0x37, 
+0x36, 0x31, 0x39, 0x65, 0x36, 0x61, 0x33, 0x39, 
+0x32, 0x34, 0x61, 0x65, 0x32, 0x35, 0x36, 0x39, 
+0x36, 0x62, 0x62, 0x37, 0x62, 0x36, 0x39, 0x34, 
+0x62, 0x62, 0x36, 0x37, 0x37, 0x61, 0x36, 0x33, 
+0x32, 0x61, 0x37, 0x34, 0x65, 0x66, 0x37, 0x65, 
+0x61, 0x64, 0x66, 0x64, 0x34, 0x65, 0x61, 0x62, 
+0x66, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x38, 0x30, 0x34, 0x63, 0x38, 0x62, 0x32, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x32, 0x32, 0x34, 0x66, 0x32, 0x30, 0x37, 
+0x31, 0x32, 0x34, 0x34, 0x37, 0x32, 0x30, 0x36, 
+0x64, 0x37, 0x61, 0x35, 0x32, 0x33, 0x38, 0x61, 
+0x63, 0x63, 0x37, 0x66, 0x66, 0x35, 0x33, 0x66, 
+0x62, 0x65, 0x39, 0x34, 0x61, 0x33, 0x62, 0x36, 
+0x34, 0x35, 0x33, 0x39, 0x61, 0x64, 0x32, 0x39, 
+0x31, 0x63, 0x37, 0x63, 0x64, 0x62, 0x63, 0x34, 
+0x39, 0x30, 0x62, 0x37, 0x35, 0x37, 0x37, 0x65, 
+0x34, 0x62, 0x31, 0x37, 0x64, 0x66, 0x35, 0x30, 
+0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x66, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x22, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x70, 0x72, 0x65, 0x63, 0x6f, 
+0x6d, 0x70, 0x75, 0x74, 0x65, 0x64, 0x55, 0x73, 
+0x65, 0x64, 0x22, 0x3a, 0x20, 0x5b, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x69, 0x67, 0x48, 0x61, 0x73, 
+0x68, 0x22, 0x3a, 0x20, 0x22, 0x34, 0x34, 0x30, 
+0x65, 0x39, 0x65, 0x64, 0x30, 0x31, 0x62, 0x63, 
+0x64, 0x37, 0x32, 0x37, 0x33, 0x39, 0x62, 0x37, 
+0x37, 0x31, 0x63, 0x31, 0x31, 0x32, 0x36, 0x32, 
+0x31, 0x32, 0x38, 0x39, 0x39, 0x64, 0x37, 0x62, 
+0x39, 0x65, 0x63, 0x66, 0x31, 0x39, 0x38, 0x34, 
+0x62, 0x65, 0x66, 0x38, 0x63, 0x64, 0x64, 0x32, 
+0x39, 0x35, 0x32, 0x66, 0x65, 0x35, 0x32, 0x66, 
+0x66, 0x62, 0x30, 0x62, 0x66, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x7d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x65, 0x78, 0x70, 0x65, 0x63, 
+0x74, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x77, 0x69, 0x74, 0x6e, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x37, 0x34, 0x30, 0x34, 0x63, 0x66, 
+0x66, 0x63, 0x63, 0x65, 0x66, 0x35, 0x38, 0x37, 
+0x37, 0x33, 0x62, 0x33, 0x36, 0x35, 0x31, 0x33, 
+0x31, 0x61, 0x37, 0x62, 0x62, 0x64, 0x39, 0x31, 
+0x62, 0x33, 0x66, 0x32, 0x63, 0x66, 0x36, 0x64, 
+0x38, 0x37, 0x65, 0x31, 0x63, 0x65, 0x31, 0x64, 
+0x38, 0x36, 0x39, 0x62, 0x36, 0x30, 0x38, 0x32, 
+0x34, 0x38, 0x39, 0x61, 0x30, 0x66, 0x36, 0x38, 
+0x64, 0x63, 0x39, 0x37, 0x32, 0x64, 0x61, 0x38, 
+0x62, 0x37, 0x62, 0x32, 0x62, 0x32, 0x33, 0x30, 
+0x34, 0x34, 0x32, 0x32, 0x61, 0x37, 0x37, 0x66, 
+0x63, 0x63, 0x31, 0x64, 0x33, 0x37, 0x32, 0x63, 
+0x38, 0x36, 0x32, 0x65, 0x37, 0x35, 0x36, 0x31, 
+0x34, 0x30, 0x38, 0x62, 0x65, 0x63, 0x30, 0x38, 
+0x66, 0x37, 0x62, 0x37, 0x34, 0x34, 0x30, 0x61, 
+0x62, 0x38, 0x34, 0x62, 0x37, 0x63, 0x38, 0x36, 
+0x37, 0x32, 0x38, 0x32, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x67, 0x69, 0x76, 0x65, 0x6e, 0x22, 0x3a, 0x20, 
+0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x74, 0x78, 0x69, 0x6e, 0x49, 
+0x6e, 0x64, 0x65, 0x78, 0x22, 0x3a, 0x20, 0x38, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 
+0x6e, 0x61, 0x6c, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x37, 0x37, 
+0x38, 0x36, 0x33, 0x34, 0x31, 0x36, 0x62, 0x65, 
+0x30, 0x64, 0x30, 0x36, 0x36, 0x35, 0x65, 0x35, 
+0x31, 0x37, 0x65, 0x31, 0x63, 0x33, 0x37, 0x35, 
+0x66, 0x64, 0x36, 0x66, 0x37, 0x35, 0x38, 0x33, 
+0x39, 0x35, 0x34, 0x34, 0x65, 0x63, 0x61, 0x35, 
+0x35, 0x33, 0x36, 0x37, 0x35, 0x65, 0x66, 0x37, 
+0x66, 0x64, 0x66, 0x34, 0x39, 0x34, 0x39, 0x35, 
+0x31, 0x38, 0x65, 0x62, 0x61, 0x61, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x6d, 0x65, 0x72, 0x6b, 0x6c, 0x65, 
+0x52, 0x6f, 0x6f, 0x74, 0x22, 0x3a, 0x20, 0x22, 
+0x61, 0x62, 0x31, 0x37, 0x39, 0x34, 0x33, 0x31, 
+0x63, 0x32, 0x38, 0x64, 0x33, 0x62, 0x36, 0x38, 
+0x66, 0x62, 0x37, 0x39, 0x38, 0x39, 0x35, 0x37, 
+0x66, 0x61, 0x66, 0x35, 0x34, 0x39, 0x37, 0x64, 
+0x36, 0x39, 0x63, 0x38, 0x38, 0x33, 0x63, 0x36, 
+0x66, 0x62, 0x31, 0x65, 0x31, 0x63, 0x64, 0x39, 
+0x66, 0x38, 0x31, 0x34, 0x38, 0x33, 0x64, 0x38, 
+0x37, 0x62, 0x61, 0x63, 0x39, 0x30, 0x63, 0x63, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 0x68, 
+0x54, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 
+0x32, 0x39, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x69, 
+0x6e, 0x74, 0x65, 0x72, 0x6d, 0x65, 0x64, 0x69, 
+0x61, 0x72, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x6e, 0x61, 
+0x6c, 0x50, 0x75, 0x62, 0x6b, 0x65, 0x79, 0x22, 
+0x3a, 0x20, 0x22, 0x66, 0x39, 0x66, 0x34, 0x30, 
+0x30, 0x38, 0x30, 0x33, 0x65, 0x36, 0x38, 0x33, 
+0x37, 0x32, 0x37, 0x62, 0x31, 0x34, 0x66, 0x34, 
+0x36, 0x33, 0x38, 0x33, 0x36, 0x65, 0x31, 0x65, 
+0x37, 0x38, 0x65, 0x31, 0x63, 0x36, 0x34, 0x34, 
+0x31, 0x37, 0x36, 0x33, 0x38, 0x61, 0x61, 0x30, 
+0x36, 0x36, 0x39, 0x31, 0x39, 0x32, 0x39, 0x31, 
+0x61, 0x32, 0x32, 0x35, 0x66, 0x30, 0x65, 0x38, 
+0x64, 0x64, 0x38, 0x22, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 
+0x77, 0x65, 0x61, 0x6b, 0x22, 0x3a, 0x20, 0x22, 
+0x36, 0x33, 0x39, 0x66, 0x30, 0x32, 0x38, 0x31, 
+0x62, 0x37, 0x61, 0x63, 0x34, 0x39, 0x65, 0x37, 
+0x34, 0x32, 0x63, 0x64, 0x32, 0x35, 0x62, 0x37, 
+0x66, 0x31, 0x38, 0x38, 0x36, 0x35, 0x37, 0x36, 
+0x32, 0x36, 0x64, 0x61, 0x31, 0x61, 0x64, 0x31, 
+0x36, 0x39, 0x32, 0x30, 0x39, 0x30, 0x37, 0x38, 
+0x65, 0x32, 0x37, 0x36, 0x31, 0x63, 0x65, 0x66, 
+0x64, 0x39, 0x31, 0x66, 0x64, 0x36, 0x35, 0x65, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x77, 0x65, 0x61, 
+0x6b, 0x65, 0x64, 0x50, 0x72, 0x69, 0x76, 0x6b, 
+0x65, 0x79, 0x22, 0x3a, 0x20, 0x22, 0x65, 0x63, 
+0x31, 0x38, 0x63, 0x65, 0x36, 0x61, 0x66, 0x39, 
+0x39, 0x66, 0x34, 0x33, 0x38, 0x31, 0x35, 0x64, 
+0x62, 0x35, 0x34, 0x33, 0x66, 0x34, 0x37, 0x62, 
+0x38, 0x61, 0x66, 0x35, 0x66, 0x66, 0x35, 0x64, 
+0x66, 0x33, 0x62, 0x32, 0x63, 0x62, 0x37, 0x33, 
+0x31, 0x35, 0x63, 0x39, 0x35, 0x35, 0x61, 0x61, 
+0x34, 0x61, 0x38, 0x36, 0x65, 0x38, 0x31, 0x34, 
+0x33, 0x64, 0x32, 0x62, 0x66, 0x35, 0x22, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x73, 0x69, 0x67, 0x4d, 0x73, 0x67, 
+0x22, 0x3a, 0x20, 0x22, 0x30, 0x30, 0x38, 0x31, 
+0x30, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x61, 0x32, 0x65, 0x36, 0x64, 0x61, 0x62, 0x37, 
+0x63, 0x31, 0x66, 0x30, 0x64, 0x63, 0x64, 0x32, 
+0x39, 0x37, 0x63, 0x38, 0x64, 0x36, 0x31, 0x36, 
+0x34, 0x37, 0x66, 0x64, 0x31, 0x37, 0x64, 0x38, 
+0x32, 0x31, 0x35, 0x34, 0x31, 0x65, 0x61, 0x36, 
+0x39, 0x63, 0x33, 0x63, 0x63, 0x33, 0x37, 0x64, 
+0x63, 0x62, 0x61, 0x64, 0x37, 0x66, 0x39, 0x30, 
+0x64, 0x34, 0x65, 0x62, 0x34, 0x62, 0x63, 0x35, 
+0x30, 0x30, 0x61, 0x37, 0x37, 0x38, 0x65, 0x62, 
+0x36, 0x61, 0x32, 0x36, 0x33, 0x64, 0x63, 0x30, 
+0x39, 0x30, 0x34, 0x36, 0x34, 0x63, 0x64, 0x31, 
+0x32, 0x35, 0x63, 0x34, 0x36, 0x36, 0x62, 0x35, 
+0x61, 0x39, 0x39, 0x36, 0x36, 0x37, 0x37, 0x32, 
+0x30, 0x62, 0x31, 0x63, 0x31, 0x31, 0x30, 0x34, 
+0x36, 0x38, 0x38, 0x33, 0x31, 0x64, 0x30, 0x35, 
+0x38, 0x61, 0x61, 0x31, 0x62, 0x38, 0x32, 0x61, 
+0x66, 0x31, 0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x32, 0x62, 0x30, 0x63, 
+0x32, 0x33, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x32, 0x32, 0x34, 0x66, 0x32, 0x30, 
+0x37, 0x37, 0x65, 0x33, 0x30, 0x61, 0x35, 0x35, 
+0x32, 0x32, 0x64, 0x64, 0x39, 0x66, 0x38, 0x39, 
+0x34, 0x63, 0x33, 0x66, 0x38, 0x62, 0x38, 0x62, 
+0x64, 0x34, 0x63, 0x34, 0x62, 0x32, 0x63, 0x66, 
+0x38, 0x32, 0x63, 0x61, 0x37, 0x64, 0x61, 0x38, 
+0x61, 0x33, 0x65, 0x61, 0x36, 0x61, 0x32, 0x33, 
+0x39, 0x36, 0x35, 0x35, 0x63, 0x33, 0x39, 0x63, 
+0x30, 0x35, 0x30, 0x61, 0x62, 0x32, 0x32, 0x30, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x70, 0x72, 0x65, 0x63, 
+0x6f, 0x6d, 0x70, 0x75, 0x74, 0x65, 0x64, 0x55, 
+0x73, 0x65, 0x64, 0x22, 0x3a, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x68, 0x61, 0x73, 
+0x68, 0x4f, 0x75, 0x74, 0x70, 0x75, 0x74, 0x73, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x73, 0x69, 
+0x67, 0x48, 0x61, 0x73, 0x68, 0x22, 0x3a, 0x20, 
+0x22, 0x64, 0x64, 0x34, 0x62, 0x30, 0x32, 0x65, 
+0x66, 0x35, 0x62, 0x62, 0x31, 0x64, 0x63, 0x34, 
+0x30, 0x32, 0x36, 0x63, 0x64, 0x61, 0x61, 0x30, 
+0x32, 0x66, 0x36, 0x30, 0x32, 0x37, 0x65, 0x61, 
+0x63, 0x65, 0x61, 0x39, 0x64, 0x62, 0x32, 0x34, 
+0x32, 0x62, 0x61, 0x66, 0x64, 0x66, 0x33, 0x64, 
+0x39, 0x65, 0x39, 0x30, 0x38, 0x66, 0x61, 0x66, 
+0x37, 0x36, 0x34, 0x62, 0x31, 0x37, 0x38, 0x63, 
+0x63, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x65, 
+0x78, 0x70, 0x65, 0x63, 0x74, 0x65, 0x64, 0x22, 
+0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x77, 0x69, 0x74, 
+0x6e, 0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x31, 0x39, 
+0x65, 0x63, 0x66, 0x64, 0x66, 0x33, 0x62, 0x30, 
+0x61, 0x36, 0x38, 0x39, 0x61, 0x63, 0x37, 0x30, 
+0x66, 0x37, 0x34, 0x39, 0x34, 0x39, 0x62, 0x30, 
+0x64, 0x61, 0x65, 0x64, 0x35, 0x61, 0x38, 0x39, 
+0x30, 0x39, 0x65, 0x65, 0x34, 0x30, 0x39, 0x31, 
+0x37, 0x61, 0x35, 0x31, 0x64, 0x63, 0x30, 0x37, 
+0x35, 0x62, 0x31, 0x63, 0x37, 0x32, 0x62, 0x38, 
+0x64, 0x35, 0x63, 0x61, 0x33, 0x39, 0x65, 0x35, 
+0x62, 0x66, 0x61, 0x31, 0x66, 0x63, 0x66, 0x30, 
+0x32, 0x34, 0x37, 0x61, 0x35, 0x32, 0x39, 0x38, 
+0x36, 0x39, 0x63, 0x65, 0x33, 0x62, 0x32, 0x63, 
+0x63, 0x63, 0x38, 0x62, 0x35, 0x38, 0x32, 0x39, 
+0x35, 0x34, 0x38, 0x38, 0x33, 0x65, 0x65, 0x62, 
+0x64, 0x35, 0x35, 0x35, 0x63, 0x36, 0x35, 0x64, 
+0x66, 0x62, 0x37, 0x64, 0x61, 0x34, 0x38, 0x30, 
+0x66, 0x38, 0x32, 0x62, 0x64, 0x64, 0x38, 0x31, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x7d, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x61, 0x75, 0x78, 0x69, 0x6c, 0x69, 0x61, 0x72, 
+0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x66, 
+0x75, 0x6c, 0x6c, 0x79, 0x53, 0x69, 0x67, 0x6e, 
+0x65, 0x64, 0x54, 0x78, 0x22, 0x3a, 0x20, 0x22, 
+0x30, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x31, 0x30, 0x39, 0x37, 0x64, 
+0x65, 0x32, 0x30, 0x63, 0x62, 0x66, 0x66, 0x36, 
+0x38, 0x36, 0x64, 0x61, 0x38, 0x33, 0x61, 0x35, 
+0x34, 0x39, 0x38, 0x31, 0x64, 0x32, 0x62, 0x39, 
+0x62, 0x61, 0x62, 0x33, 0x35, 0x38, 0x36, 0x66, 
+0x34, 0x63, 0x61, 0x37, 0x65, 0x34, 0x38, 0x66, 
+0x35, 0x37, 0x66, 0x35, 0x62, 0x35, 0x35, 0x39, 
+0x36, 0x33, 0x31, 0x31, 0x35, 0x66, 0x33, 0x62, 
+0x33, 0x33, 0x34, 0x65, 0x39, 0x63, 0x30, 0x31, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x64, 0x37, 0x62, 0x37, 0x63, 0x61, 0x62, 0x35, 
+0x37, 0x62, 0x31, 0x33, 0x39, 0x33, 0x61, 0x63, 
+0x65, 0x32, 0x64, 0x30, 0x36, 0x34, 0x66, 0x34, 
+0x64, 0x34, 0x61, 0x32, 0x63, 0x62, 0x38, 0x61, 
+0x66, 0x36, 0x64, 0x65, 0x66, 0x36, 0x31, 0x32, 
+0x37, 0x33, 0x65, 0x31, 0x32, 0x37, 0x35, 0x31, 
+0x37, 0x64, 0x34, 0x34, 0x37, 0x35, 0x39, 0x62, 
+0x36, 0x64, 0x61, 0x66, 0x64, 0x64, 0x39, 0x39, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x38, 0x65, 0x31, 0x66, 0x35, 
+0x38, 0x33, 0x33, 0x38, 0x34, 0x33, 0x33, 0x33, 
+0x36, 0x38, 0x39, 0x32, 0x32, 0x38, 0x63, 0x35, 
+0x64, 0x32, 0x38, 0x65, 0x61, 0x63, 0x31, 0x33, 
+0x33, 0x36, 0x36, 0x62, 0x65, 0x30, 0x38, 0x32, 
+0x64, 0x63, 0x35, 0x37, 0x34, 0x34, 0x31, 0x37, 
+0x36, 0x30, 0x64, 0x39, 0x35, 0x37, 0x32, 0x37, 
+0x35, 0x34, 0x31, 0x39, 0x61, 0x34, 0x31, 0x38, 
+0x34, 0x32, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x36, 0x62, 0x34, 0x38, 0x33, 0x30, 
+0x34, 0x35, 0x30, 0x32, 0x32, 0x31, 0x30, 0x30, 
+0x38, 0x66, 0x33, 0x62, 0x38, 0x66, 0x38, 0x66, 
+0x30, 0x35, 0x33, 0x37, 0x63, 0x34, 0x32, 0x30, 
+0x36, 0x35, 0x34, 0x64, 0x32, 0x32, 0x38, 0x33, 
+0x36, 0x37, 0x33, 0x61, 0x37, 0x36, 0x31, 0x62, 
+0x37, 0x65, 0x65, 0x32, 0x65, 0x61, 0x33, 0x63, 
+0x31, 0x33, 0x30, 0x37, 0x35, 0x33, 0x31, 0x30, 
+0x33, 0x65, 0x30, 0x38, 0x63, 0x65, 0x37, 0x39, 
+0x32, 0x30, 0x31, 0x63, 0x66, 0x33, 0x32, 0x61, 
+0x30, 0x32, 0x32, 0x30, 0x37, 0x39, 0x65, 0x37, 
+0x61, 0x62, 0x39, 0x30, 0x34, 0x61, 0x31, 0x39, 
+0x38, 0x30, 0x65, 0x66, 0x31, 0x63, 0x35, 0x38, 
+0x39, 0x30, 0x62, 0x36, 0x34, 0x38, 0x63, 0x38, 
+0x37, 0x38, 0x33, 0x66, 0x34, 0x64, 0x31, 0x30, 
+0x31, 0x30, 0x33, 0x64, 0x64, 0x36, 0x32, 0x66, 
+0x37, 0x34, 0x30, 0x64, 0x31, 0x33, 0x64, 0x61, 
+0x61, 0x37, 0x39, 0x65, 0x32, 0x39, 0x38, 0x64, 
+0x35, 0x30, 0x63, 0x32, 0x30, 0x31, 0x32, 0x31, 
+0x30, 0x32, 0x37, 0x39, 0x62, 0x65, 0x36, 0x36, 
+0x37, 0x65, 0x66, 0x39, 0x64, 0x63, 0x62, 0x62, 
+0x61, 0x63, 0x35, 0x35, 0x61, 0x30, 0x36, 0x32, 
+0x39, 0x35, 0x63, 0x65, 0x38, 0x37, 0x30, 0x62, 
+0x30, 0x37, 0x30, 0x32, 0x39, 0x62, 0x66, 0x63, 
+0x64, 0x62, 0x32, 0x64, 0x63, 0x65, 0x32, 0x38, 
+0x64, 0x39, 0x35, 0x39, 0x66, 0x32, 0x38, 0x31, 
+0x35, 0x62, 0x31, 0x36, 0x66, 0x38, 0x31, 0x37, 
+0x39, 0x38, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x30, 0x36, 0x38, 0x39, 0x31, 
+0x38, 0x30, 0x61, 0x61, 0x36, 0x33, 0x62, 0x33, 
+0x30, 0x63, 0x62, 0x31, 0x36, 0x32, 0x61, 0x37, 
+0x33, 0x63, 0x36, 0x64, 0x32, 0x61, 0x33, 0x38, 
+0x62, 0x37, 0x65, 0x65, 0x64, 0x61, 0x32, 0x61, 
+0x38, 0x33, 0x65, 0x63, 0x65, 0x37, 0x34, 0x33, 
+0x31, 0x30, 0x66, 0x64, 0x61, 0x30, 0x38, 0x34, 
+0x33, 0x61, 0x64, 0x36, 0x30, 0x34, 0x38, 0x35, 
+0x33, 0x62, 0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x66, 0x65, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x66, 0x61, 0x61, 0x35, 0x32, 
+0x30, 0x32, 0x62, 0x64, 0x66, 0x36, 0x64, 0x38, 
+0x63, 0x63, 0x64, 0x32, 0x65, 0x65, 0x30, 0x66, 
+0x30, 0x32, 0x30, 0x32, 0x61, 0x66, 0x62, 0x62, 
+0x62, 0x37, 0x34, 0x36, 0x31, 0x64, 0x39, 0x32, 
+0x36, 0x34, 0x61, 0x32, 0x35, 0x65, 0x35, 0x62, 
+0x66, 0x64, 0x33, 0x63, 0x35, 0x61, 0x35, 0x32, 
+0x65, 0x65, 0x31, 0x32, 0x33, 0x39, 0x65, 0x30, 
+0x62, 0x61, 0x36, 0x63, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x66, 0x65, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x39, 0x35, 
+0x36, 0x31, 0x34, 0x39, 0x62, 0x64, 0x63, 0x36, 
+0x36, 0x66, 0x61, 0x61, 0x39, 0x36, 0x38, 0x65, 
+0x62, 0x32, 0x62, 0x65, 0x32, 0x64, 0x32, 0x66, 
+0x61, 0x61, 0x32, 0x39, 0x37, 0x31, 0x38, 0x61, 
+0x63, 0x62, 0x66, 0x65, 0x33, 0x39, 0x34, 0x31, 
+0x32, 0x31, 0x35, 0x38, 0x39, 0x33, 0x61, 0x32, 
+0x61, 0x33, 0x34, 0x34, 0x36, 0x64, 0x33, 0x32, 
+0x61, 0x63, 0x64, 0x30, 0x35, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x65, 0x36, 0x36, 0x34, 0x62, 0x39, 0x37, 0x37, 
+0x33, 0x62, 0x38, 0x38, 0x63, 0x30, 0x39, 0x63, 
+0x33, 0x32, 0x63, 0x62, 0x37, 0x30, 0x61, 0x32, 
+0x61, 0x33, 0x65, 0x34, 0x64, 0x61, 0x30, 0x63, 
+0x65, 0x64, 0x36, 0x33, 0x62, 0x37, 0x62, 0x61, 
+0x33, 0x62, 0x32, 0x32, 0x66, 0x38, 0x34, 0x38, 
+0x35, 0x33, 0x31, 0x62, 0x62, 0x62, 0x31, 0x64, 
+0x35, 0x64, 0x35, 0x66, 0x34, 0x63, 0x39, 0x34, 
+0x30, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x65, 0x39, 0x61, 0x61, 0x36, 0x62, 
+0x38, 0x65, 0x36, 0x63, 0x39, 0x64, 0x65, 0x36, 
+0x37, 0x36, 0x31, 0x39, 0x65, 0x36, 0x61, 0x33, 
+0x39, 0x32, 0x34, 0x61, 0x65, 0x32, 0x35, 0x36, 
+0x39, 0x36, 0x62, 0x62, 0x37, 0x62, 0x36, 0x39, 
+0x34, 0x62, 0x62, 0x36, 0x37, 0x37, 0x61, 0x36, 
+0x33, 0x32, 0x61, 0x37, 0x34, 0x65, 0x66, 0x37, 
+0x65, 0x61, 0x64, 0x66, 0x64, 0x34, 0x65, 0x61, 
+0x62, 0x66, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x66, 0x66, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x66, 0x61, 0x37, 0x37, 0x38, 
+0x65, 0x62, 0x36, 0x61, 0x32, 0x36, 0x33, 0x64, 
+0x63, 0x30, 0x39, 0x30, 0x34, 0x36, 0x34, 0x63, 
+0x64, 0x31, 0x32, 0x35, 0x63, 0x34, 0x36, 0x36, 
+0x62, 0x35, 0x61, 0x39, 0x39, 0x36, 0x36, 0x37, 
+0x37, 0x32, 0x30, 0x62, 0x31, 0x63, 0x31, 0x31, 
+0x30, 0x34, 0x36, 0x38, 0x38, 0x33, 0x31, 0x64, 
+0x30, 0x35, 0x38, 0x61, 0x61, 0x31, 0x62, 0x38, 
+0x32, 0x61, 0x66, 0x31, 0x30, 0x31, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x66, 0x66, 
+0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x30, 0x32, 
+0x30, 0x30, 0x63, 0x61, 0x39, 0x61, 0x33, 0x62, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 
+0x31, 0x39, 0x37, 0x36, 0x61, 0x39, 0x31, 0x34, 
+0x30, 0x36, 0x61, 0x66, 0x64, 0x34, 0x36, 0x62, 
+0x63, 0x64, 0x66, 0x64, 0x32, 0x32, 0x65, 0x66, 
+0x39, 0x34, 0x61, 0x63, 0x31, 0x32, 0x32, 0x61, 
+0x61, 0x31, 0x31, 0x66, 0x32, 0x34, 0x31, 0x32, 
+0x34, 0x34, 0x61, 0x33, 0x37, 0x65, 0x63, 0x63, 
+0x38, 0x38, 0x61, 0x63, 0x38, 0x30, 0x37, 0x38, 
+0x34, 0x30, 0x63, 0x62, 0x30, 0x30, 0x30, 0x30, 
+0x30, 0x30, 0x30, 0x30, 0x32, 0x30, 0x61, 0x63, 
+0x39, 0x61, 0x38, 0x37, 0x66, 0x35, 0x35, 0x39, 
+0x34, 0x62, 0x65, 0x32, 0x30, 0x38, 0x66, 0x38, 
+0x35, 0x33, 0x32, 0x64, 0x62, 0x33, 0x38, 0x63, 
+0x66, 0x66, 0x36, 0x37, 0x30, 0x63, 0x34, 0x35, 
+0x30, 0x65, 0x64, 0x32, 0x66, 0x65, 0x61, 0x38, 
+0x66, 0x63, 0x64, 0x65, 0x66, 0x63, 0x63, 0x39, 
+0x61, 0x36, 0x36, 0x33, 0x66, 0x37, 0x38, 0x62, 
+0x61, 0x62, 0x39, 0x36, 0x32, 0x62, 0x30, 0x31, 
+0x34, 0x31, 0x33, 0x62, 0x66, 0x35, 0x35, 0x64, 
+0x31, 0x65, 0x36, 0x66, 0x32, 0x39, 0x33, 0x37, 
+0x65, 0x38, 0x63, 0x37, 0x31, 0x61, 0x35, 0x31, 
+0x63, 0x39, 0x33, 0x39, 0x35, 0x30, 0x35, 0x34, 
+0x64, 0x31, 0x38, 0x37, 0x34, 0x33, 0x66, 0x33, 
+0x37, 0x34, 0x37, 0x36, 0x61, 0x36, 0x30, 0x62, 
+0x34, 0x32, 0x31, 0x66, 0x36, 0x63, 0x39, 0x35, 
+0x62, 0x31, 0x65, 0x63, 0x30, 0x63, 0x36, 0x31, 
+0x61, 0x32, 0x39, 0x63, 0x32, 0x36, 0x38, 0x36, 
+0x38, 0x63, 0x36, 0x64, 0x39, 0x37, 0x63, 0x36, 
+0x61, 0x37, 0x36, 0x36, 0x33, 0x35, 0x65, 0x66, 
+0x34, 0x62, 0x64, 0x39, 0x38, 0x34, 0x31, 0x39, 
+0x31, 0x36, 0x63, 0x35, 0x63, 0x34, 0x64, 0x35, 
+0x37, 0x37, 0x66, 0x64, 0x66, 0x32, 0x34, 0x30, 
+0x61, 0x63, 0x61, 0x33, 0x63, 0x32, 0x33, 0x34, 
+0x37, 0x33, 0x31, 0x33, 0x39, 0x62, 0x31, 0x34, 
+0x39, 0x31, 0x30, 0x33, 0x30, 0x31, 0x34, 0x31, 
+0x31, 0x39, 0x62, 0x32, 0x61, 0x62, 0x65, 0x62, 
+0x39, 0x64, 0x37, 0x66, 0x32, 0x62, 0x36, 0x31, 
+0x33, 0x38, 0x62, 0x33, 0x61, 0x37, 0x34, 0x34, 
+0x64, 0x34, 0x39, 0x64, 0x39, 0x36, 0x63, 0x39, 
+0x32, 0x36, 0x62, 0x62, 0x64, 0x30, 0x62, 0x38, 
+0x65, 0x61, 0x66, 0x62, 0x33, 0x66, 0x32, 0x66, 
+0x30, 0x30, 0x31, 0x38, 0x33, 0x62, 0x32, 0x65, 
+0x32, 0x66, 0x34, 0x38, 0x38, 0x35, 0x32, 0x65, 
+0x34, 0x35, 0x33, 0x61, 0x36, 0x37, 0x61, 0x62, 
+0x31, 0x37, 0x63, 0x61, 0x66, 0x61, 0x30, 0x35, 
+0x39, 0x33, 0x32, 0x36, 0x31, 0x32, 0x63, 0x63, 
+0x37, 0x31, 0x63, 0x65, 0x35, 0x31, 0x32, 0x34, 
+0x34, 0x31, 0x35, 0x37, 0x34, 0x64, 0x35, 0x34, 
+0x63, 0x32, 0x39, 0x39, 0x30, 0x63, 0x35, 0x35, 
+0x65, 0x32, 0x65, 0x36, 0x35, 0x36, 0x30, 0x63, 
+0x37, 0x34, 0x32, 0x36, 0x32, 0x38, 0x33, 0x38, 
+0x38, 0x33, 0x30, 0x30, 0x30, 0x31, 0x34, 0x31, 
+0x37, 0x66, 0x62, 0x31, 0x35, 0x61, 0x33, 0x35, 
+0x37, 0x65, 0x66, 0x33, 0x61, 0x61, 0x38, 0x37, 
+0x65, 0x62, 0x31, 0x36, 0x36, 0x34, 0x61, 0x37, 
+0x30, 0x30, 0x30, 0x31, 0x36, 0x63, 0x39, 0x36, 
+0x30, 0x32, 0x39, 0x64, 0x65, 0x63, 0x65, 0x36, 
+0x38, 0x37, 0x65, 0x62, 0x63, 0x63, 0x61, 0x32, 
+0x38, 0x37, 0x38, 0x38, 0x35, 0x30, 0x64, 0x65, 
+0x30, 0x65, 0x33, 0x39, 0x33, 0x63, 0x39, 0x37, 
+0x63, 0x64, 0x37, 0x36, 0x65, 0x32, 0x30, 0x30, 
+0x37, 0x64, 0x33, 0x61, 0x37, 0x63, 0x33, 0x64, 
+0x33, 0x38, 0x36, 0x65, 0x61, 0x35, 0x65, 0x65, 
+0x66, 0x30, 0x30, 0x33, 0x39, 0x39, 0x66, 0x63, 
+0x35, 0x35, 0x33, 0x37, 0x66, 0x63, 0x36, 0x30, 
+0x39, 0x30, 0x63, 0x39, 0x62, 0x38, 0x36, 0x37, 
+0x63, 0x36, 0x37, 0x62, 0x36, 0x38, 0x33, 0x39, 
+0x38, 0x61, 0x31, 0x64, 0x63, 0x33, 0x33, 0x64, 
+0x30, 0x31, 0x30, 0x31, 0x34, 0x30, 0x33, 0x39, 
+0x33, 0x31, 0x34, 0x63, 0x37, 0x65, 0x62, 0x66, 
+0x32, 0x63, 0x35, 0x31, 0x63, 0x61, 0x30, 0x31, 
+0x30, 0x39, 0x33, 0x34, 0x39, 0x30, 0x64, 0x33, 
+0x66, 0x35, 0x61, 0x36, 0x36, 0x31, 0x31, 0x35, 
+0x39, 0x32, 0x64, 0x61, 0x64, 0x31, 0x63, 0x31, 
+0x38, 0x37, 0x35, 0x33, 0x61, 0x30, 0x62, 0x62, 
+0x66, 0x32, 0x31, 0x32, 0x66, 0x30, 0x61, 0x35, 
+0x37, 0x35, 0x65, 0x39, 0x30, 0x62, 0x65, 0x39, 
+0x61, 0x32, 0x37, 0x31, 0x38, 0x65, 0x62, 0x38, 
+0x32, 0x34, 0x32, 0x62, 0x30, 0x32, 0x36, 0x32, 
+0x61, 0x33, 0x33, 0x37, 0x31, 0x35, 0x35, 0x35, 
+0x64, 0x35, 0x66, 0x61, 0x62, 0x62, 0x34, 0x61, 
+0x36, 0x64, 0x35, 0x37, 0x34, 0x63, 0x30, 0x63, 
+0x66, 0x34, 0x62, 0x37, 0x35, 0x38, 0x36, 0x35, 
+0x30, 0x36, 0x34, 0x36, 0x38, 0x66, 0x33, 0x31, 
+0x38, 0x65, 0x39, 0x38, 0x30, 0x63, 0x30, 0x32, 
+0x34, 0x37, 0x33, 0x30, 0x34, 0x34, 0x30, 0x32, 
+0x32, 0x30, 0x32, 0x62, 0x37, 0x39, 0x35, 0x65, 
+0x34, 0x64, 0x65, 0x37, 0x32, 0x36, 0x34, 0x36, 
+0x64, 0x37, 0x36, 0x65, 0x61, 0x62, 0x33, 0x66, 
+0x30, 0x61, 0x62, 0x32, 0x37, 0x64, 0x66, 0x61, 
+0x33, 0x30, 0x62, 0x38, 0x31, 0x30, 0x65, 0x38, 
+0x35, 0x36, 0x66, 0x66, 0x33, 0x61, 0x34, 0x36, 
+0x63, 0x39, 0x61, 0x37, 0x30, 0x32, 0x64, 0x66, 
+0x35, 0x33, 0x62, 0x62, 0x30, 0x64, 0x38, 0x63, 
+0x63, 0x33, 0x30, 0x32, 0x32, 0x30, 0x33, 0x63, 
+0x63, 0x63, 0x34, 0x64, 0x38, 0x32, 0x32, 0x65, 
+0x64, 0x61, 0x62, 0x35, 0x66, 0x33, 0x35, 0x63, 
+0x61, 0x64, 0x64, 0x62, 0x31, 0x30, 0x61, 0x66, 
+0x31, 0x62, 0x65, 0x39, 0x33, 0x35, 0x38, 0x33, 
+0x35, 0x32, 0x36, 0x63, 0x63, 0x66, 0x62, 0x61, 
+0x64, 0x65, 0x34, 0x62, 0x34, 0x65, 0x61, 0x64, 
+0x33, 0x35, 0x30, 0x37, 0x38, 0x31, 0x65, 0x32, 
+0x66, 0x38, 0x61, 0x64, 0x63, 0x64, 0x30, 0x31, 
+0x32, 0x31, 0x30, 0x32, 0x66, 0x39, 0x33, 0x30, 
+0x38, 0x61, 0x30, 0x31, 0x39, 0x32, 0x35, 0x38, 
+0x63, 0x33, 0x31, 0x30, 0x34, 0x39, 0x33, 0x34, 
+0x34, 0x66, 0x38, 0x35, 0x66, 0x38, 0x39, 0x64, 
+0x35, 0x32, 0x32, 0x39, 0x62, 0x35, 0x33, 0x31, 
+0x63, 0x38, 0x34, 0x35, 0x38, 0x33, 0x36, 0x66, 
+0x39, 0x39, 0x62, 0x30, 0x38, 0x36, 0x30, 0x31, 
+0x66, 0x31, 0x31, 0x33, 0x62, 0x63, 0x65, 0x30, 
+0x33, 0x36, 0x66, 0x39, 0x30, 0x31, 0x34, 0x31, 
+0x62, 0x39, 0x32, 0x34, 0x66, 0x66, 0x35, 0x39, 
+0x36, 0x39, 0x36, 0x66, 0x62, 0x61, 0x62, 0x61, 
+0x34, 0x32, 0x34, 0x39, 0x65, 0x31, 0x66, 0x62, 
+0x32, 0x37, 0x65, 0x37, 0x66, 0x38, 0x38, 0x63, 
+0x31, 0x38, 0x63, 0x34, 0x33, 0x64, 0x32, 0x66, 
+0x39, 0x34, 0x63, 0x39, 0x65, 0x35, 0x66, 0x32, 
+0x65, 0x62, 0x38, 0x33, 0x30, 0x39, 0x64, 0x38, 
+0x33, 0x36, 0x31, 0x37, 0x63, 0x66, 0x39, 0x61, 
+0x66, 0x34, 0x62, 0x63, 0x39, 0x30, 0x65, 0x33, 
+0x33, 0x34, 0x38, 0x31, 0x64, 0x63, 0x33, 0x30, 
+0x61, 0x37, 0x30, 0x31, 0x32, 0x37, 0x39, 0x38, 
+0x36, 0x62, 0x62, 0x66, 0x39, 0x63, 0x66, 0x62, 
+0x33, 0x38, 0x63, 0x62, 0x61, 0x62, 0x66, 0x34, 
+0x31, 0x62, 0x30, 0x61, 0x63, 0x66, 0x66, 0x62, 
+0x65, 0x36, 0x65, 0x38, 0x32, 0x62, 0x33, 0x61, 
+0x36, 0x65, 0x31, 0x65, 0x34, 0x35, 0x30, 0x39, 
+0x30, 0x32, 0x30, 0x31, 0x34, 0x31, 0x37, 0x34, 
+0x30, 0x34, 0x63, 0x66, 0x66, 0x63, 0x63, 0x65, 
+0x66, 0x35, 0x38, 0x37, 0x37, 0x33, 0x62, 0x33, 
+0x36, 0x35, 0x31, 0x33, 0x31, 0x61, 0x37, 0x62, 
+0x62, 0x64, 0x39, 0x31, 0x62, 0x33, 0x66, 0x32, 
+0x63, 0x66, 0x36, 0x64, 0x38, 0x37, 0x65, 0x31, 
+0x63, 0x65, 0x31, 0x64, 0x38, 0x36, 0x39, 0x62, 
+0x36, 0x30, 0x38, 0x32, 0x34, 0x38, 0x39, 0x61, 
+0x30, 0x66, 0x36, 0x38, 0x64, 0x63, 0x39, 0x37, 
+0x32, 0x64, 0x61, 0x38, 0x62, 0x37, 0x62, 0x32, 
+0x62, 0x32, 0x33, 0x30, 0x34, 0x34, 0x32, 0x32, 
+0x61, 0x37, 0x37, 0x66, 0x63, 0x63, 0x31, 0x64, 
+0x33, 0x37, 0x32, 0x63, 0x38, 0x36, 0x32, 0x65, 
+0x37, 0x35, 0x36, 0x31, 0x34, 0x30, 0x38, 0x62, 
+0x65, 0x63, 0x30, 0x38, 0x66, 0x37, 0x62, 0x37, 
+0x34, 0x34, 0x30, 0x61, 0x62, 0x38, 0x34, 0x62, 
+0x37, 0x63, 0x38, 0x36, 0x37, 0x32, 0x38, 0x32, 
+0x30, 0x31, 0x34, 0x31, 0x31, 0x39, 0x65, 0x63, 
+0x66, 0x64, 0x66, 0x33, 0x62, 0x30, 0x61, 0x36, 
+0x38, 0x39, 0x61, 0x63, 0x37, 0x30, 0x66, 0x37, 
+0x34, 0x39, 0x34, 0x39, 0x62, 0x30, 0x64, 0x61, 
+0x65, 0x64, 0x35, 0x61, 0x38, 0x39, 0x30, 0x39, 
+0x65, 0x65, 0x34, 0x30, 0x39, 0x31, 0x37, 0x61, 
+0x35, 0x31, 0x64, 0x63, 0x30, 0x37, 0x35, 0x62, 
+0x31, 0x63, 0x37, 0x32, 0x62, 0x38, 0x64, 0x35, 
+0x63, 0x61, 0x33, 0x39, 0x65, 0x35, 0x62, 0x66, 
+0x61, 0x31, 0x66, 0x63, 0x66, 0x30, 0x32, 0x34, 
+0x37, 0x61, 0x35, 0x32, 0x39, 0x38, 0x36, 0x39, 
+0x63, 0x65, 0x33, 0x62, 0x32, 0x63, 0x63, 0x63, 
+0x38, 0x62, 0x35, 0x38, 0x32, 0x39, 0x35, 0x34, 
+0x38, 0x38, 0x33, 0x65, 0x65, 0x62, 0x64, 0x35, 
+0x35, 0x35, 0x63, 0x36, 0x35, 0x64, 0x66, 0x62, 
+0x37, 0x64, 0x61, 0x34, 0x38, 0x30, 0x66, 0x38, 
+0x32, 0x62, 0x64, 0x64, 0x38, 0x31, 0x30, 0x30, 
+0x36, 0x35, 0x63, 0x64, 0x31, 0x64, 0x30, 0x31, 
+0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x0a, 0x7d, 0x0a, 
+};};
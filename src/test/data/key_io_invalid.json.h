@@ -0,0 +1,654 @@
+#include <string>
+namespace json_tests{
+static const std::string key_io_invalid{
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x78, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x31, 0x47, 0x41, 0x64, 0x66, 0x76, 
+0x69, 0x45, 0x72, 0x56, 0x32, 0x45, 0x77, 0x39, 
+0x35, 0x46, 0x50, 0x74, 0x5a, 0x79, 0x69, 0x6b, 
+0x7a, 0x32, 0x71, 0x47, 0x50, 0x33, 0x67, 0x79, 
+0x43, 0x42, 0x36, 0x48, 0x79, 0x75, 0x39, 0x34, 
+0x73, 0x65, 0x64, 0x41, 0x6b, 0x50, 0x70, 0x41, 
+0x35, 0x32, 0x33, 0x6d, 0x33, 0x66, 0x51, 0x77, 
+0x70, 0x73, 0x39, 0x59, 0x4b, 0x55, 0x5a, 0x6b, 
+0x4b, 0x67, 0x51, 0x63, 0x6b, 0x47, 0x50, 0x4b, 
+0x68, 0x52, 0x73, 0x46, 0x52, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x33, 0x37, 0x47, 
+0x32, 0x6b, 0x4d, 0x44, 0x4c, 0x70, 0x6d, 0x57, 
+0x56, 0x68, 0x69, 0x6d, 0x78, 0x52, 0x64, 0x7a, 
+0x77, 0x4e, 0x66, 0x45, 0x38, 0x4a, 0x46, 0x76, 
+0x57, 0x58, 0x6e, 0x4a, 0x59, 0x6e, 0x56, 0x63, 
+0x58, 0x65, 0x65, 0x47, 0x72, 0x65, 0x6b, 0x32, 
+0x71, 0x75, 0x6d, 0x64, 0x4a, 0x75, 0x4b, 0x37, 
+0x58, 0x41, 0x72, 0x63, 0x56, 0x56, 0x70, 0x52, 
+0x74, 0x4c, 0x4c, 0x6a, 0x52, 0x72, 0x61, 0x33, 
+0x74, 0x36, 0x34, 0x42, 0x45, 0x50, 0x46, 0x32, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x67, 0x69, 0x79, 0x6d, 0x74, 0x69, 0x6f, 0x37, 
+0x75, 0x37, 0x6f, 0x71, 0x57, 0x74, 0x6d, 0x43, 
+0x39, 0x59, 0x6e, 0x76, 0x41, 0x45, 0x4b, 0x6b, 
+0x4c, 0x46, 0x33, 0x4a, 0x51, 0x70, 0x41, 0x64, 
+0x6b, 0x45, 0x46, 0x6b, 0x56, 0x4a, 0x4b, 0x59, 
+0x72, 0x56, 0x44, 0x66, 0x61, 0x4c, 0x62, 0x68, 
+0x61, 0x44, 0x70, 0x58, 0x31, 0x69, 0x68, 0x66, 
+0x46, 0x32, 0x76, 0x5a, 0x6d, 0x79, 0x61, 0x31, 
+0x69, 0x36, 0x31, 0x66, 0x77, 0x4c, 0x50, 0x43, 
+0x33, 0x59, 0x51, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x38, 0x69, 0x56, 0x6b, 0x39, 
+0x6e, 0x4c, 0x4d, 0x33, 0x6e, 0x59, 0x77, 0x52, 
+0x75, 0x77, 0x79, 0x70, 0x6a, 0x79, 0x39, 0x4e, 
+0x4b, 0x35, 0x72, 0x73, 0x75, 0x5a, 0x48, 0x37, 
+0x42, 0x62, 0x72, 0x51, 0x52, 0x5a, 0x31, 0x70, 
+0x67, 0x63, 0x51, 0x6d, 0x76, 0x4d, 0x6e, 0x6a, 
+0x41, 0x67, 0x52, 0x58, 0x44, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 0x50, 0x54, 
+0x56, 0x51, 0x31, 0x68, 0x62, 0x6f, 0x34, 0x71, 
+0x64, 0x6f, 0x79, 0x73, 0x66, 0x36, 0x4a, 0x78, 
+0x35, 0x47, 0x74, 0x68, 0x71, 0x75, 0x63, 0x4e, 
+0x6d, 0x64, 0x66, 0x71, 0x74, 0x36, 0x4a, 0x32, 
+0x70, 0x5a, 0x52, 0x46, 0x65, 0x58, 0x76, 0x38, 
+0x45, 0x70, 0x37, 0x4b, 0x6d, 0x6a, 0x71, 0x75, 
+0x64, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x63, 0x51, 0x62, 0x52, 0x32, 0x4e, 0x79, 
+0x38, 0x35, 0x58, 0x46, 0x42, 0x7a, 0x55, 0x4d, 
+0x78, 0x33, 0x45, 0x64, 0x36, 0x48, 0x73, 0x54, 
+0x4c, 0x77, 0x32, 0x70, 0x56, 0x72, 0x75, 0x53, 
+0x67, 0x50, 0x76, 0x74, 0x35, 0x41, 0x6f, 0x66, 
+0x6e, 0x42, 0x55, 0x6e, 0x68, 0x69, 0x76, 0x38, 
+0x36, 0x67, 0x59, 0x65, 0x57, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x32, 0x55, 0x42, 
+0x33, 0x69, 0x47, 0x33, 0x56, 0x4a, 0x62, 0x58, 
+0x32, 0x54, 0x52, 0x72, 0x4d, 0x77, 0x6d, 0x36, 
+0x73, 0x73, 0x57, 0x73, 0x6b, 0x67, 0x76, 0x55, 
+0x39, 0x56, 0x6a, 0x46, 0x42, 0x59, 0x53, 0x71, 
+0x43, 0x7a, 0x77, 0x71, 0x6b, 0x72, 0x69, 0x68, 
+0x43, 0x77, 0x6f, 0x37, 0x6d, 0x67, 0x34, 0x6d, 
+0x74, 0x53, 0x34, 0x57, 0x75, 0x47, 0x5a, 0x67, 
+0x78, 0x54, 0x4b, 0x75, 0x78, 0x66, 0x35, 0x41, 
+0x33, 0x45, 0x63, 0x6f, 0x74, 0x59, 0x45, 0x79, 
+0x6d, 0x7a, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x63, 0x51, 0x65, 0x31, 0x32, 0x70, 
+0x71, 0x77, 0x50, 0x52, 0x36, 0x45, 0x78, 0x74, 
+0x5a, 0x4b, 0x66, 0x72, 0x4b, 0x66, 0x31, 0x71, 
+0x34, 0x62, 0x33, 0x43, 0x54, 0x68, 0x31, 0x51, 
+0x69, 0x37, 0x4d, 0x77, 0x75, 0x76, 0x4d, 0x76, 
+0x7a, 0x73, 0x37, 0x39, 0x6e, 0x57, 0x58, 0x44, 
+0x76, 0x45, 0x53, 0x66, 0x42, 0x4a, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x63, 
+0x31, 0x71, 0x65, 0x75, 0x6c, 0x35, 0x67, 0x32, 
+0x78, 0x66, 0x6b, 0x76, 0x64, 0x6b, 0x72, 0x68, 
+0x63, 0x66, 0x6d, 0x64, 0x75, 0x72, 0x73, 0x76, 
+0x37, 0x33, 0x61, 0x64, 0x36, 0x34, 0x6a, 0x6e, 
+0x6b, 0x6a, 0x6c, 0x39, 0x63, 0x34, 0x30, 0x66, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x62, 0x74, 0x31, 0x70, 0x71, 0x36, 0x35, 0x72, 
+0x7a, 0x65, 0x6a, 0x35, 0x67, 0x6c, 0x77, 0x33, 
+0x72, 0x61, 0x37, 0x39, 0x67, 0x61, 0x76, 0x36, 
+0x66, 0x71, 0x6e, 0x78, 0x34, 0x68, 0x61, 0x61, 
+0x30, 0x7a, 0x32, 0x35, 0x37, 0x71, 0x72, 0x33, 
+0x6d, 0x63, 0x38, 0x63, 0x67, 0x67, 0x6b, 0x65, 
+0x66, 0x61, 0x68, 0x6d, 0x67, 0x76, 0x79, 0x73, 
+0x65, 0x75, 0x66, 0x68, 0x63, 0x30, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x66, 0x63, 
+0x72, 0x74, 0x31, 0x72, 0x68, 0x67, 0x6b, 0x74, 
+0x39, 0x35, 0x61, 0x65, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x74, 0x66, 0x31, 0x71, 
+0x66, 0x77, 0x78, 0x6a, 0x71, 0x76, 0x74, 0x74, 
+0x34, 0x74, 0x63, 0x78, 0x72, 0x74, 0x64, 0x6c, 
+0x75, 0x75, 0x6b, 0x66, 0x6d, 0x79, 0x32, 0x64, 
+0x76, 0x75, 0x34, 0x71, 0x79, 0x36, 0x37, 0x6a, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x46, 0x43, 0x52, 0x54, 0x31, 0x51, 0x46, 0x59, 
+0x36, 0x4b, 0x41, 0x4a, 0x56, 0x35, 0x4e, 0x57, 
+0x4e, 0x34, 0x59, 0x41, 0x4d, 0x33, 0x57, 0x58, 
+0x4b, 0x52, 0x44, 0x51, 0x4e, 0x45, 0x45, 0x30, 
+0x4e, 0x30, 0x54, 0x4a, 0x41, 0x55, 0x39, 0x57, 
+0x35, 0x50, 0x32, 0x4a, 0x59, 0x52, 0x34, 0x58, 
+0x33, 0x46, 0x55, 0x34, 0x47, 0x48, 0x36, 0x38, 
+0x45, 0x33, 0x37, 0x36, 0x4a, 0x4a, 0x34, 0x34, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x66, 0x63, 0x31, 0x71, 0x38, 0x38, 0x38, 0x72, 
+0x79, 0x66, 0x67, 0x78, 0x70, 0x76, 0x6c, 0x30, 
+0x6b, 0x37, 0x76, 0x75, 0x6d, 0x38, 0x7a, 0x70, 
+0x79, 0x61, 0x72, 0x32, 0x75, 0x67, 0x71, 0x6c, 
+0x64, 0x64, 0x38, 0x64, 0x6c, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x66, 0x31, 
+0x71, 0x6b, 0x66, 0x33, 0x38, 0x75, 0x65, 0x33, 
+0x37, 0x79, 0x6b, 0x6e, 0x6d, 0x71, 0x71, 0x30, 
+0x79, 0x63, 0x72, 0x77, 0x76, 0x74, 0x63, 0x73, 
+0x6d, 0x63, 0x61, 0x6b, 0x72, 0x73, 0x74, 0x77, 
+0x64, 0x37, 0x6b, 0x65, 0x67, 0x67, 0x61, 0x73, 
+0x76, 0x33, 0x63, 0x6c, 0x37, 0x34, 0x6b, 0x67, 
+0x6c, 0x77, 0x73, 0x33, 0x71, 0x72, 0x37, 0x6b, 
+0x67, 0x64, 0x61, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 
+0x71, 0x32, 0x38, 0x65, 0x75, 0x72, 0x65, 0x72, 
+0x33, 0x6e, 0x6e, 0x67, 0x74, 0x33, 0x65, 0x79, 
+0x70, 0x64, 0x68, 0x32, 0x77, 0x33, 0x72, 0x72, 
+0x6a, 0x75, 0x35, 0x35, 0x54, 0x41, 0x48, 0x52, 
+0x65, 0x36, 0x61, 0x65, 0x65, 0x6b, 0x7a, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x66, 
+0x63, 0x31, 0x71, 0x35, 0x64, 0x72, 0x76, 0x66, 
+0x33, 0x75, 0x39, 0x30, 0x6a, 0x73, 0x72, 0x36, 
+0x33, 0x6e, 0x73, 0x7a, 0x77, 0x6d, 0x79, 0x6a, 
+0x30, 0x7a, 0x39, 0x32, 0x34, 0x67, 0x37, 0x66, 
+0x7a, 0x73, 0x35, 0x34, 0x7a, 0x75, 0x67, 0x6e, 
+0x34, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x66, 0x31, 0x71, 0x6b, 0x79, 0x6e, 
+0x6d, 0x67, 0x64, 0x73, 0x73, 0x64, 0x66, 0x35, 
+0x39, 0x66, 0x7a, 0x6e, 0x68, 0x64, 0x67, 0x38, 
+0x6e, 0x66, 0x34, 0x74, 0x74, 0x76, 0x30, 0x6e, 
+0x75, 0x74, 0x39, 0x30, 0x6a, 0x6b, 0x67, 0x7a, 
+0x61, 0x68, 0x63, 0x77, 0x72, 0x6a, 0x64, 0x73, 
+0x68, 0x35, 0x71, 0x30, 0x33, 0x74, 0x66, 0x78, 
+0x71, 0x70, 0x72, 0x74, 0x76, 0x32, 0x7a, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x66, 
+0x63, 0x72, 0x74, 0x31, 0x71, 0x37, 0x6e, 0x32, 
+0x6b, 0x68, 0x7a, 0x64, 0x6c, 0x68, 0x6a, 0x39, 
+0x75, 0x65, 0x78, 0x68, 0x39, 0x38, 0x70, 0x37, 
+0x72, 0x73, 0x33, 0x74, 0x30, 0x30, 0x73, 0x72, 
+0x6b, 0x78, 0x34, 0x34, 0x74, 0x6a, 0x67, 0x75, 
+0x74, 0x66, 0x37, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x66, 0x63, 0x31, 0x70, 0x39, 
+0x74, 0x74, 0x68, 0x30, 0x36, 0x65, 0x71, 0x6c, 
+0x77, 0x30, 0x63, 0x73, 0x70, 0x68, 0x67, 0x76, 
+0x6a, 0x74, 0x65, 0x70, 0x32, 0x67, 0x78, 0x7a, 
+0x6b, 0x6a, 0x78, 0x36, 0x67, 0x6b, 0x61, 0x77, 
+0x63, 0x68, 0x71, 0x63, 0x73, 0x6e, 0x70, 0x32, 
+0x76, 0x6d, 0x38, 0x67, 0x35, 0x36, 0x6b, 0x63, 
+0x74, 0x73, 0x73, 0x37, 0x72, 0x37, 0x71, 0x33, 
+0x67, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x66, 0x31, 0x7a, 0x36, 0x33, 0x34, 
+0x35, 0x70, 0x34, 0x67, 0x35, 0x30, 0x71, 0x7a, 
+0x74, 0x6c, 0x7a, 0x73, 0x64, 0x6c, 0x6c, 0x65, 
+0x34, 0x6a, 0x77, 0x64, 0x78, 0x7a, 0x79, 0x64, 
+0x6c, 0x37, 0x70, 0x37, 0x65, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x66, 0x63, 0x72, 
+0x74, 0x31, 0x73, 0x63, 0x79, 0x72, 0x6c, 0x78, 
+0x30, 0x65, 0x6e, 0x36, 0x63, 0x7a, 0x65, 0x37, 
+0x66, 0x65, 0x61, 0x79, 0x70, 0x75, 0x36, 0x6b, 
+0x38, 0x76, 0x73, 0x37, 0x67, 0x6d, 0x68, 0x30, 
+0x76, 0x36, 0x70, 0x68, 0x7a, 0x35, 0x72, 0x36, 
+0x6a, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 0x6c, 0x6e, 
+0x30, 0x6d, 0x74, 0x6c, 0x64, 0x63, 0x61, 0x63, 
+0x6c, 0x67, 0x6a, 0x6e, 0x61, 0x6a, 0x30, 0x72, 
+0x77, 0x32, 0x71, 0x64, 0x6d, 0x32, 0x30, 0x6a, 
+0x77, 0x6b, 0x37, 0x33, 0x61, 0x74, 0x71, 0x35, 
+0x66, 0x78, 0x70, 0x37, 0x30, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x32, 0x76, 0x74, 
+0x73, 0x73, 0x33, 0x31, 0x79, 0x52, 0x72, 0x78, 
+0x51, 0x59, 0x50, 0x74, 0x79, 0x4a, 0x7a, 0x7a, 
+0x52, 0x51, 0x41, 0x38, 0x5a, 0x33, 0x37, 0x44, 
+0x44, 0x50, 0x45, 0x7a, 0x77, 0x43, 0x42, 0x73, 
+0x47, 0x76, 0x68, 0x41, 0x75, 0x73, 0x65, 0x37, 
+0x72, 0x59, 0x74, 0x71, 0x35, 0x68, 0x47, 0x65, 
+0x76, 0x5a, 0x67, 0x48, 0x58, 0x55, 0x56, 0x6a, 
+0x47, 0x52, 0x44, 0x6d, 0x6e, 0x31, 0x6e, 0x76, 
+0x77, 0x4c, 0x6a, 0x37, 0x73, 0x79, 0x75, 0x63, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x67, 0x64, 0x36, 0x79, 0x4e, 0x38, 0x47, 0x51, 
+0x4e, 0x4e, 0x44, 0x51, 0x70, 0x73, 0x72, 0x76, 
+0x66, 0x51, 0x69, 0x77, 0x62, 0x43, 0x39, 0x43, 
+0x73, 0x77, 0x56, 0x6e, 0x70, 0x56, 0x44, 0x39, 
+0x56, 0x4b, 0x6e, 0x4a, 0x51, 0x32, 0x7a, 0x44, 
+0x52, 0x39, 0x55, 0x73, 0x31, 0x32, 0x33, 0x66, 
+0x6e, 0x36, 0x56, 0x38, 0x66, 0x75, 0x32, 0x35, 
+0x67, 0x6f, 0x44, 0x54, 0x6e, 0x43, 0x70, 0x78, 
+0x70, 0x69, 0x69, 0x78, 0x70, 0x33, 0x5a, 0x7a, 
+0x56, 0x50, 0x51, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x6d, 0x6e, 0x59, 0x41, 0x6d, 
+0x59, 0x42, 0x43, 0x55, 0x31, 0x78, 0x45, 0x39, 
+0x64, 0x36, 0x4a, 0x6d, 0x37, 0x76, 0x31, 0x45, 
+0x64, 0x72, 0x56, 0x45, 0x76, 0x70, 0x43, 0x6d, 
+0x59, 0x58, 0x59, 0x5a, 0x4e, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x32, 0x43, 0x76, 
+0x4c, 0x44, 0x77, 0x4b, 0x71, 0x76, 0x51, 0x42, 
+0x4a, 0x56, 0x63, 0x70, 0x6b, 0x34, 0x7a, 0x68, 
+0x42, 0x47, 0x52, 0x77, 0x6e, 0x52, 0x33, 0x6f, 
+0x58, 0x65, 0x55, 0x6e, 0x7a, 0x67, 0x77, 0x75, 
+0x5a, 0x71, 0x44, 0x46, 0x4a, 0x36, 0x6a, 0x4e, 
+0x37, 0x61, 0x39, 0x53, 0x57, 0x6e, 0x43, 0x66, 
+0x59, 0x41, 0x4d, 0x55, 0x37, 0x31, 0x75, 0x75, 
+0x4b, 0x77, 0x47, 0x66, 0x46, 0x57, 0x7a, 0x37, 
+0x35, 0x5a, 0x33, 0x7a, 0x4e, 0x47, 0x52, 0x6e, 
+0x76, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x35, 0x4a, 0x66, 0x66, 0x63, 0x50, 0x69, 
+0x53, 0x48, 0x4b, 0x34, 0x46, 0x63, 0x6a, 0x54, 
+0x4c, 0x67, 0x58, 0x34, 0x46, 0x36, 0x53, 0x6b, 
+0x71, 0x6b, 0x38, 0x36, 0x51, 0x4a, 0x76, 0x64, 
+0x35, 0x72, 0x59, 0x34, 0x46, 0x51, 0x45, 0x33, 
+0x39, 0x47, 0x42, 0x70, 0x75, 0x61, 0x73, 0x62, 
+0x73, 0x31, 0x38, 0x4c, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x34, 0x56, 0x35, 0x46, 
+0x63, 0x78, 0x61, 0x4e, 0x42, 0x65, 0x56, 0x50, 
+0x70, 0x35, 0x55, 0x4e, 0x66, 0x56, 0x5a, 0x63, 
+0x44, 0x65, 0x69, 0x39, 0x39, 0x46, 0x53, 0x43, 
+0x63, 0x76, 0x39, 0x59, 0x58, 0x46, 0x67, 0x68, 
+0x48, 0x74, 0x42, 0x71, 0x4a, 0x52, 0x5a, 0x64, 
+0x65, 0x61, 0x79, 0x38, 0x4b, 0x63, 0x64, 0x33, 
+0x51, 0x6e, 0x6a, 0x63, 0x45, 0x4e, 0x51, 0x4b, 
+0x34, 0x66, 0x74, 0x37, 0x41, 0x37, 0x48, 0x41, 
+0x68, 0x6b, 0x63, 0x57, 0x45, 0x4c, 0x6e, 0x54, 
+0x59, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x32, 0x55, 0x45, 0x4a, 0x6a, 0x54, 0x33, 
+0x64, 0x53, 0x64, 0x77, 0x63, 0x38, 0x64, 0x41, 
+0x6f, 0x37, 0x6f, 0x65, 0x64, 0x50, 0x7a, 0x7a, 
+0x6e, 0x58, 0x63, 0x65, 0x58, 0x43, 0x45, 0x73, 
+0x42, 0x62, 0x44, 0x66, 0x41, 0x76, 0x53, 0x79, 
+0x6d, 0x71, 0x70, 0x71, 0x44, 0x72, 0x6b, 0x5a, 
+0x4d, 0x76, 0x37, 0x4a, 0x42, 0x45, 0x55, 0x70, 
+0x4c, 0x79, 0x68, 0x6b, 0x67, 0x68, 0x69, 0x6f, 
+0x59, 0x41, 0x57, 0x43, 0x39, 0x57, 0x34, 0x73, 
+0x4b, 0x79, 0x73, 0x72, 0x79, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x37, 0x56, 0x6d, 
+0x4d, 0x45, 0x6b, 0x70, 0x68, 0x78, 0x43, 0x46, 
+0x53, 0x56, 0x31, 0x79, 0x36, 0x35, 0x39, 0x54, 
+0x68, 0x34, 0x64, 0x6b, 0x6b, 0x36, 0x78, 0x36, 
+0x62, 0x4a, 0x53, 0x35, 0x65, 0x51, 0x76, 0x62, 
+0x74, 0x38, 0x72, 0x7a, 0x55, 0x59, 0x4b, 0x51, 
+0x79, 0x64, 0x36, 0x41, 0x43, 0x67, 0x77, 0x51, 
+0x34, 0x76, 0x58, 0x48, 0x74, 0x58, 0x4b, 0x46, 
+0x55, 0x77, 0x50, 0x32, 0x6b, 0x57, 0x33, 0x58, 
+0x55, 0x4c, 0x69, 0x70, 0x6e, 0x48, 0x4a, 0x64, 
+0x5a, 0x37, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x74, 0x63, 0x31, 0x71, 0x72, 0x76, 
+0x37, 0x78, 0x72, 0x79, 0x6a, 0x6d, 0x6a, 0x64, 
+0x39, 0x6c, 0x61, 0x76, 0x36, 0x74, 0x71, 0x68, 
+0x61, 0x64, 0x66, 0x32, 0x72, 0x39, 0x67, 0x63, 
+0x70, 0x66, 0x70, 0x68, 0x64, 0x30, 0x61, 0x38, 
+0x78, 0x35, 0x38, 0x75, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x62, 0x74, 0x31, 0x70, 
+0x61, 0x78, 0x64, 0x6d, 0x75, 0x6c, 0x37, 0x34, 
+0x75, 0x6c, 0x6e, 0x35, 0x6e, 0x33, 0x6b, 0x76, 
+0x38, 0x32, 0x64, 0x75, 0x36, 0x6b, 0x33, 0x63, 
+0x35, 0x67, 0x63, 0x66, 0x75, 0x73, 0x39, 0x64, 
+0x63, 0x78, 0x75, 0x76, 0x66, 0x32, 0x39, 0x77, 
+0x36, 0x63, 0x33, 0x36, 0x71, 0x78, 0x38, 0x38, 
+0x35, 0x7a, 0x6a, 0x73, 0x39, 0x70, 0x73, 0x32, 
+0x76, 0x39, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 0x61, 
+0x61, 0x38, 0x37, 0x70, 0x70, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 0x66, 0x31, 
+0x71, 0x76, 0x68, 0x6d, 0x61, 0x33, 0x6e, 0x76, 
+0x77, 0x74, 0x35, 0x74, 0x75, 0x35, 0x65, 0x67, 
+0x72, 0x67, 0x77, 0x79, 0x33, 0x37, 0x61, 0x7a, 
+0x37, 0x34, 0x73, 0x6c, 0x72, 0x6a, 0x71, 0x76, 
+0x64, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 0x71, 0x76, 
+0x38, 0x66, 0x32, 0x38, 0x75, 0x7a, 0x6c, 0x72, 
+0x77, 0x6b, 0x72, 0x6b, 0x37, 0x71, 0x78, 0x6e, 
+0x6d, 0x33, 0x30, 0x72, 0x72, 0x36, 0x6e, 0x61, 
+0x32, 0x77, 0x72, 0x33, 0x66, 0x67, 0x73, 0x35, 
+0x74, 0x66, 0x38, 0x64, 0x36, 0x39, 0x6e, 0x66, 
+0x6b, 0x6e, 0x78, 0x73, 0x38, 0x66, 0x72, 0x70, 
+0x30, 0x65, 0x70, 0x70, 0x38, 0x34, 0x6d, 0x79, 
+0x6b, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x66, 0x63, 0x31, 0x61, 0x35, 0x72, 0x6b, 
+0x70, 0x79, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x74, 0x66, 0x31, 0x71, 0x75, 0x66, 
+0x34, 0x32, 0x77, 0x78, 0x77, 0x34, 0x30, 0x6b, 
+0x77, 0x6b, 0x33, 0x75, 0x38, 0x6e, 0x67, 0x75, 
+0x79, 0x74, 0x71, 0x68, 0x33, 0x68, 0x77, 0x39, 
+0x63, 0x6c, 0x78, 0x30, 0x78, 0x36, 0x74, 0x73, 
+0x76, 0x6c, 0x68, 0x74, 0x36, 0x37, 0x33, 0x30, 
+0x6e, 0x30, 0x34, 0x66, 0x32, 0x6d, 0x70, 0x61, 
+0x6a, 0x73, 0x78, 0x68, 0x35, 0x78, 0x6a, 0x77, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x66, 0x63, 0x72, 0x74, 0x31, 0x71, 0x36, 0x66, 
+0x36, 0x70, 0x30, 0x32, 0x66, 0x6b, 0x35, 0x6a, 
+0x33, 0x65, 0x33, 0x37, 0x71, 0x39, 0x70, 0x6e, 
+0x79, 0x34, 0x32, 0x30, 0x68, 0x61, 0x79, 0x72, 
+0x79, 0x65, 0x71, 0x64, 0x71, 0x33, 0x73, 0x39, 
+0x57, 0x51, 0x47, 0x37, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x66, 0x63, 0x31, 0x71, 
+0x6d, 0x63, 0x61, 0x34, 0x66, 0x33, 0x33, 0x39, 
+0x65, 0x38, 0x6e, 0x66, 0x73, 0x71, 0x7a, 0x78, 
+0x6d, 0x30, 0x61, 0x6a, 0x74, 0x6c, 0x70, 0x70, 
+0x33, 0x66, 0x71, 0x76, 0x63, 0x74, 0x71, 0x75, 
+0x37, 0x77, 0x73, 0x72, 0x70, 0x34, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x54, 0x46, 
+0x31, 0x51, 0x51, 0x44, 0x44, 0x55, 0x34, 0x4a, 
+0x46, 0x55, 0x4a, 0x45, 0x46, 0x51, 0x47, 0x54, 
+0x5a, 0x52, 0x50, 0x35, 0x53, 0x54, 0x36, 0x36, 
+0x55, 0x58, 0x52, 0x4b, 0x4c, 0x50, 0x51, 0x37, 
+0x54, 0x4a, 0x43, 0x41, 0x57, 0x47, 0x38, 0x39, 
+0x43, 0x4d, 0x57, 0x57, 0x51, 0x52, 0x33, 0x55, 
+0x35, 0x41, 0x50, 0x57, 0x41, 0x51, 0x53, 0x43, 
+0x52, 0x46, 0x4d, 0x35, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x66, 0x63, 0x72, 0x74, 
+0x31, 0x71, 0x73, 0x34, 0x78, 0x68, 0x74, 0x66, 
+0x38, 0x6b, 0x71, 0x75, 0x38, 0x6c, 0x37, 0x37, 
+0x6b, 0x63, 0x76, 0x65, 0x6b, 0x36, 0x37, 0x78, 
+0x6d, 0x61, 0x6b, 0x6d, 0x35, 0x38, 0x7a, 0x79, 
+0x68, 0x78, 0x34, 0x73, 0x64, 0x76, 0x39, 0x35, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x66, 0x63, 0x31, 0x61, 0x35, 0x72, 0x6b, 0x70, 
+0x79, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x66, 0x31, 0x7a, 0x32, 0x6d, 0x66, 
+0x68, 0x67, 0x65, 0x6e, 0x32, 0x68, 0x67, 0x76, 
+0x39, 0x71, 0x6d, 0x32, 0x73, 0x34, 0x66, 0x71, 
+0x34, 0x6c, 0x61, 0x70, 0x38, 0x34, 0x75, 0x75, 
+0x76, 0x73, 0x7a, 0x6d, 0x63, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x46, 0x43, 0x52, 
+0x54, 0x31, 0x53, 0x36, 0x53, 0x32, 0x33, 0x57, 
+0x4d, 0x53, 0x43, 0x48, 0x36, 0x37, 0x34, 0x4c, 
+0x4e, 0x45, 0x50, 0x33, 0x43, 0x38, 0x45, 0x44, 
+0x41, 0x59, 0x30, 0x33, 0x41, 0x32, 0x32, 0x4b, 
+0x38, 0x4d, 0x46, 0x55, 0x35, 0x30, 0x35, 0x45, 
+0x46, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 0x6c, 0x63, 
+0x70, 0x6b, 0x64, 0x61, 0x36, 0x34, 0x63, 0x70, 
+0x68, 0x6d, 0x35, 0x6e, 0x78, 0x32, 0x30, 0x74, 
+0x67, 0x64, 0x66, 0x38, 0x71, 0x66, 0x6b, 0x79, 
+0x37, 0x35, 0x38, 0x6b, 0x77, 0x77, 0x63, 0x64, 
+0x6a, 0x73, 0x33, 0x37, 0x79, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x32, 0x4d, 0x61, 
+0x53, 0x34, 0x39, 0x6b, 0x31, 0x72, 0x4d, 0x35, 
+0x55, 0x4a, 0x63, 0x65, 0x54, 0x35, 0x48, 0x59, 
+0x72, 0x62, 0x61, 0x76, 0x6d, 0x44, 0x62, 0x6f, 
+0x42, 0x39, 0x35, 0x6a, 0x52, 0x59, 0x37, 0x33, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x32, 0x64, 0x68, 0x4a, 0x4b, 0x38, 0x41, 0x5a, 
+0x78, 0x74, 0x4c, 0x55, 0x65, 0x50, 0x6e, 0x6f, 
+0x7a, 0x6e, 0x50, 0x50, 0x4d, 0x66, 0x69, 0x6f, 
+0x42, 0x6f, 0x47, 0x7a, 0x61, 0x44, 0x4b, 0x51, 
+0x74, 0x33, 0x59, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x67, 0x71, 0x59, 0x55, 0x43, 
+0x55, 0x47, 0x68, 0x5a, 0x5a, 0x32, 0x50, 0x7a, 
+0x64, 0x63, 0x36, 0x45, 0x43, 0x5a, 0x75, 0x4e, 
+0x6a, 0x50, 0x32, 0x45, 0x36, 0x76, 0x52, 0x52, 
+0x55, 0x31, 0x66, 0x6f, 0x48, 0x5a, 0x71, 0x37, 
+0x5a, 0x61, 0x42, 0x79, 0x33, 0x63, 0x43, 0x38, 
+0x35, 0x38, 0x59, 0x76, 0x79, 0x59, 0x75, 0x64, 
+0x31, 0x5a, 0x47, 0x66, 0x39, 0x38, 0x32, 0x77, 
+0x66, 0x6d, 0x4a, 0x43, 0x4e, 0x5a, 0x6f, 0x68, 
+0x36, 0x76, 0x7a, 0x47, 0x6d, 0x45, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x32, 0x43, 
+0x6f, 0x42, 0x47, 0x62, 0x76, 0x7a, 0x69, 0x75, 
+0x6a, 0x72, 0x66, 0x74, 0x72, 0x69, 0x54, 0x48, 
+0x73, 0x56, 0x78, 0x50, 0x74, 0x72, 0x66, 0x73, 
+0x4a, 0x44, 0x4d, 0x76, 0x36, 0x62, 0x4b, 0x54, 
+0x36, 0x43, 0x77, 0x6e, 0x58, 0x64, 0x6f, 0x71, 
+0x4d, 0x47, 0x57, 0x43, 0x39, 0x5a, 0x70, 0x4e, 
+0x59, 0x53, 0x70, 0x71, 0x58, 0x35, 0x57, 0x44, 
+0x56, 0x79, 0x7a, 0x33, 0x54, 0x56, 0x7a, 0x6a, 
+0x31, 0x56, 0x54, 0x59, 0x56, 0x67, 0x53, 0x43, 
+0x59, 0x34, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x6e, 0x34, 0x42, 0x5a, 0x76, 0x4e, 
+0x6e, 0x6d, 0x66, 0x4a, 0x6d, 0x69, 0x57, 0x48, 
+0x6e, 0x59, 0x36, 0x78, 0x43, 0x5a, 0x47, 0x51, 
+0x43, 0x69, 0x7a, 0x56, 0x36, 0x43, 0x53, 0x64, 
+0x68, 0x4b, 0x61, 0x31, 0x76, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x6e, 0x73, 0x5a, 
+0x5a, 0x43, 0x6e, 0x31, 0x73, 0x4d, 0x32, 0x56, 
+0x43, 0x47, 0x64, 0x32, 0x51, 0x37, 0x4e, 0x70, 
+0x31, 0x79, 0x33, 0x44, 0x63, 0x42, 0x36, 0x61, 
+0x36, 0x32, 0x6d, 0x36, 0x75, 0x59, 0x54, 0x4e, 
+0x72, 0x53, 0x79, 0x74, 0x34, 0x62, 0x53, 0x50, 
+0x62, 0x4c, 0x50, 0x51, 0x72, 0x61, 0x46, 0x76, 
+0x50, 0x66, 0x74, 0x45, 0x59, 0x32, 0x36, 0x50, 
+0x61, 0x51, 0x37, 0x4e, 0x31, 0x43, 0x31, 0x6d, 
+0x47, 0x4c, 0x43, 0x38, 0x79, 0x64, 0x44, 0x6b, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x43, 0x71, 0x37, 0x44, 0x74, 0x77, 0x5a, 0x75, 
+0x48, 0x6f, 0x47, 0x69, 0x73, 0x65, 0x4d, 0x4c, 
+0x66, 0x69, 0x33, 0x45, 0x4e, 0x45, 0x34, 0x36, 
+0x75, 0x78, 0x67, 0x76, 0x74, 0x32, 0x6b, 0x7a, 
+0x79, 0x44, 0x41, 0x39, 0x78, 0x75, 0x66, 0x73, 
+0x7a, 0x62, 0x6a, 0x78, 0x32, 0x6b, 0x6e, 0x6e, 
+0x4d, 0x43, 0x4b, 0x31, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x33, 0x77, 0x78, 0x67, 
+0x58, 0x34, 0x57, 0x64, 0x4b, 0x51, 0x6d, 0x70, 
+0x4b, 0x51, 0x4c, 0x44, 0x53, 0x66, 0x6a, 0x53, 
+0x78, 0x33, 0x72, 0x36, 0x4e, 0x65, 0x39, 0x43, 
+0x67, 0x63, 0x37, 0x35, 0x52, 0x6f, 0x54, 0x34, 
+0x6f, 0x54, 0x75, 0x68, 0x41, 0x68, 0x67, 0x34, 
+0x69, 0x43, 0x59, 0x58, 0x5a, 0x50, 0x63, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x37, 
+0x56, 0x55, 0x38, 0x64, 0x6d, 0x66, 0x6f, 0x66, 
+0x61, 0x65, 0x6e, 0x4a, 0x44, 0x4e, 0x59, 0x65, 
+0x77, 0x5a, 0x39, 0x56, 0x7a, 0x37, 0x67, 0x58, 
+0x6d, 0x54, 0x43, 0x4c, 0x74, 0x5a, 0x58, 0x77, 
+0x6f, 0x44, 0x45, 0x38, 0x6a, 0x5a, 0x58, 0x4e, 
+0x53, 0x72, 0x37, 0x43, 0x74, 0x48, 0x56, 0x58, 
+0x6d, 0x59, 0x56, 0x66, 0x33, 0x5a, 0x4e, 0x76, 
+0x79, 0x50, 0x4e, 0x52, 0x7a, 0x38, 0x46, 0x36, 
+0x47, 0x73, 0x35, 0x4e, 0x68, 0x6f, 0x59, 0x72, 
+0x42, 0x6e, 0x55, 0x6f, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x52, 0x63, 0x38, 0x53, 
+0x44, 0x4a, 0x77, 0x5a, 0x58, 0x34, 0x46, 0x79, 
+0x48, 0x37, 0x32, 0x75, 0x78, 0x61, 0x50, 0x34, 
+0x32, 0x79, 0x72, 0x64, 0x51, 0x6a, 0x55, 0x69, 
+0x73, 0x33, 0x48, 0x6b, 0x67, 0x39, 0x67, 0x37, 
+0x68, 0x4c, 0x53, 0x38, 0x38, 0x79, 0x72, 0x6d, 
+0x73, 0x50, 0x72, 0x47, 0x32, 0x77, 0x6e, 0x72, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x32, 0x55, 0x47, 0x73, 0x61, 0x68, 0x76, 0x50, 
+0x5a, 0x6a, 0x4e, 0x6a, 0x35, 0x39, 0x5a, 0x62, 
+0x55, 0x47, 0x61, 0x73, 0x74, 0x6f, 0x55, 0x47, 
+0x4a, 0x39, 0x4e, 0x32, 0x75, 0x61, 0x6a, 0x75, 
+0x47, 0x72, 0x6f, 0x77, 0x4d, 0x56, 0x78, 0x55, 
+0x43, 0x41, 0x52, 0x6d, 0x4d, 0x41, 0x50, 0x73, 
+0x6e, 0x5a, 0x33, 0x4c, 0x36, 0x38, 0x37, 0x54, 
+0x52, 0x62, 0x57, 0x69, 0x36, 0x57, 0x71, 0x47, 
+0x34, 0x35, 0x69, 0x5a, 0x54, 0x52, 0x62, 0x42, 
+0x53, 0x4e, 0x4c, 0x38, 0x35, 0x22, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x22, 0x63, 0x55, 0x4d, 
+0x6d, 0x6f, 0x63, 0x76, 0x77, 0x69, 0x51, 0x55, 
+0x71, 0x6e, 0x79, 0x31, 0x66, 0x4d, 0x76, 0x64, 
+0x4b, 0x59, 0x62, 0x77, 0x6e, 0x39, 0x61, 0x55, 
+0x33, 0x56, 0x75, 0x70, 0x4d, 0x5a, 0x63, 0x4a, 
+0x36, 0x72, 0x70, 0x4d, 0x4b, 0x4d, 0x36, 0x4b, 
+0x62, 0x68, 0x33, 0x67, 0x41, 0x4c, 0x6b, 0x70, 
+0x56, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x74, 0x63, 0x31, 0x71, 0x6c, 0x68, 0x67, 
+0x67, 0x6b, 0x37, 0x32, 0x71, 0x70, 0x38, 0x71, 
+0x32, 0x32, 0x76, 0x7a, 0x66, 0x74, 0x30, 0x77, 
+0x76, 0x77, 0x72, 0x78, 0x61, 0x35, 0x61, 0x32, 
+0x79, 0x32, 0x38, 0x37, 0x76, 0x65, 0x66, 0x67, 
+0x68, 0x39, 0x63, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x62, 0x74, 0x31, 0x70, 0x68, 
+0x65, 0x63, 0x77, 0x74, 0x61, 0x72, 0x7a, 0x32, 
+0x6d, 0x75, 0x6a, 0x37, 0x6c, 0x61, 0x33, 0x30, 
+0x61, 0x30, 0x77, 0x65, 0x6e, 0x79, 0x79, 0x67, 
+0x6e, 0x78, 0x33, 0x74, 0x77, 0x6e, 0x76, 0x7a, 
+0x33, 0x68, 0x66, 0x34, 0x6c, 0x6b, 0x6a, 0x39, 
+0x36, 0x39, 0x35, 0x6b, 0x35, 0x73, 0x36, 0x7a, 
+0x33, 0x66, 0x73, 0x39, 0x76, 0x35, 0x32, 0x6d, 
+0x63, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 
+0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 0x72, 0x6e, 
+0x67, 0x72, 0x79, 0x73, 0x38, 0x63, 0x70, 0x22, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x74, 
+0x66, 0x31, 0x71, 0x6a, 0x79, 0x79, 0x66, 0x35, 
+0x66, 0x61, 0x64, 0x77, 0x30, 0x65, 0x39, 0x75, 
+0x68, 0x6d, 0x33, 0x63, 0x76, 0x66, 0x65, 0x79, 
+0x67, 0x75, 0x38, 0x74, 0x35, 0x61, 0x35, 0x66, 
+0x6b, 0x66, 0x66, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x66, 0x63, 0x72, 0x74, 0x31, 
+0x71, 0x38, 0x6c, 0x36, 0x33, 0x36, 0x70, 0x34, 
+0x75, 0x39, 0x61, 0x6c, 0x63, 0x67, 0x63, 0x6c, 
+0x66, 0x33, 0x75, 0x30, 0x79, 0x38, 0x33, 0x6a, 
+0x7a, 0x6b, 0x33, 0x65, 0x72, 0x64, 0x6c, 0x75, 
+0x75, 0x66, 0x78, 0x63, 0x37, 0x34, 0x6c, 0x6d, 
+0x61, 0x78, 0x76, 0x30, 0x6a, 0x39, 0x6b, 0x73, 
+0x6a, 0x77, 0x76, 0x6b, 0x70, 0x35, 0x30, 0x70, 
+0x64, 0x32, 0x7a, 0x22, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x22, 0x66, 0x63, 0x31, 0x71, 0x7a, 
+0x6d, 0x38, 0x36, 0x61, 0x61, 0x37, 0x63, 0x6c, 
+0x33, 0x67, 0x36, 0x35, 0x6b, 0x39, 0x34, 0x7a, 
+0x7a, 0x78, 0x67, 0x35, 0x6a, 0x68, 0x79, 0x66, 
+0x73, 0x71, 0x30, 0x77, 0x35, 0x6c, 0x65, 0x33, 
+0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 
+0x74, 0x66, 0x31, 0x71, 0x61, 0x6b, 0x65, 0x36, 
+0x78, 0x74, 0x78, 0x74, 0x74, 0x6a, 0x70, 0x72, 
+0x6a, 0x38, 0x6c, 0x75, 0x78, 0x30, 0x39, 0x7a, 
+0x78, 0x30, 0x78, 0x32, 0x30, 0x63, 0x72, 0x39, 
+0x65, 0x72, 0x76, 0x6a, 0x74, 0x65, 0x6d, 0x75, 
+0x6d, 0x37, 0x75, 0x64, 0x79, 0x78, 0x77, 0x77, 
+0x79, 0x39, 0x73, 0x73, 0x66, 0x61, 0x6a, 0x73, 
+0x68, 0x68, 0x7a, 0x34, 0x35, 0x78, 0x22, 0x0a, 
+0x20, 0x20, 0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 
+0x20, 0x20, 0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x20, 0x20, 0x22, 0x66, 0x63, 
+0x72, 0x74, 0x31, 0x71, 0x64, 0x72, 0x66, 0x66, 
+0x78, 0x79, 0x33, 0x71, 0x6c, 0x70, 0x47, 0x36, 
+0x47, 0x59, 0x6e, 0x6e, 0x77, 0x37, 0x68, 0x67, 
+0x67, 0x6b, 0x70, 0x71, 0x75, 0x72, 0x32, 0x76, 
+0x30, 0x72, 0x64, 0x72, 0x6a, 0x65, 0x64, 0x64, 
+0x39, 0x72, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x5b, 
+0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x22, 0x66, 0x63, 0x31, 0x71, 0x73, 0x72, 
+0x35, 0x61, 0x75, 0x72, 0x6b, 0x35, 0x72, 0x37, 
+0x7a, 0x7a, 0x77, 0x6e, 0x66, 0x32, 0x39, 0x39, 
+0x66, 0x77, 0x6c, 0x64, 0x66, 0x65, 0x74, 0x72, 
+0x65, 0x30, 0x70, 0x70, 0x38, 0x39, 0x64, 0x35, 
+0x67, 0x30, 0x65, 0x6c, 0x22, 0x0a, 0x20, 0x20, 
+0x20, 0x20, 0x5d, 0x2c, 0x0a, 0x20, 0x20, 0x20, 
+0x20, 0x5b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 
+0x20, 0x20, 0x20, 0x22, 0x54, 0x46, 0x31, 0x51, 
+0x58, 0x32, 0x33, 0x30, 0x46, 0x52, 0x32, 0x58, 
+0x59, 0x5a, 0x53, 0x59, 0x4d, 0x38, 0x56, 0x47, 
+0x5a, 0x37, 0x51, 0x32, 0x47, 0x32, 0x55, 0x48, 
+0x37, 0x58, 0x32, 0x5a, 0x57, 0x32, 0x41, 0x47, 
+0x4e, 0x37, 0x55, 0x57, 0x44, 0x58, 0x4a, 0x4b, 
+0x36, 0x4c, 0x4b, 0x46, 0x51, 0x5a, 0x4b, 0x4e, 
+0x4d, 0x35, 0x52, 0x53, 0x47, 0x55, 0x37, 0x48, 
+0x4e, 0x53, 0x22, 0x0a, 0x20, 0x20, 0x20, 0x20, 
+0x5d, 0x0a, 0x5d, 0x0a, 
+};};
@@ -19,7 +19,10 @@
 #include <uint256.h>
 #include <util/string.h>
 
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <numeric>
 
 #include <boost/test/unit_test.hpp>
 
@@ -211,6 +214,99 @@ BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_read_many)
+{
+    // Perform tests both obfuscated and non-obfuscated.
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = m_args.GetDataDirBase() / (obfuscate ? "dbwrapper_read_many_obfuscate_true" : "dbwrapper_read_many_obfuscate_false");
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate});
+
+        std::map<uint32_t, uint256> values;
+        CDBBatch batch(dbw);
+        for (uint32_t i = 0; i < 100; i += 2) {
+            values[i] = InsecureRand256();
+            batch.Write(std::make_pair(uint8_t{'n'}, i), values[i]);
+        }
+        BOOST_CHECK(dbw.WriteBatch(batch));
+
+        // Keys out of order and repeated, half of which are missing.
+        std::vector<std::pair<uint8_t, uint32_t>> keys;
+        for (uint32_t i = 0; i < 200; ++i) {
+            keys.emplace_back('n', InsecureRandRange(100));
+        }
+        const std::vector<std::optional<uint256>> read{dbw.ReadMany<uint256>(Span{keys})};
+        BOOST_REQUIRE_EQUAL(read.size(), keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const auto it{values.find(keys[i].second)};
+            BOOST_CHECK_EQUAL(read[i].has_value(), it != values.end());
+            if (read[i] && it != values.end()) BOOST_CHECK_EQUAL(read[i]->ToString(), it->second.ToString());
+        }
+
+        // A value which cannot be deserialized as the requested type is not returned.
+        BOOST_CHECK(dbw.Write(std::make_pair(uint8_t{'n'}, uint32_t{1}), uint8_t{1}));
+        const std::vector<std::pair<uint8_t, uint32_t>> bad_keys{{'n', 1}, {'n', 0}};
+        const std::vector<std::optional<uint256>> bad_read{dbw.ReadMany<uint256>(Span{bad_keys})};
+        BOOST_CHECK(!bad_read[0]);
+        BOOST_CHECK(bad_read[1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_stats)
+{
+    fs::path ph = m_args.GetDataDirBase() / "dbwrapper_stats";
+    CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = true});
+    const DBStats initial{dbw.GetStats()};
+    BOOST_CHECK_EQUAL(initial.block_cache_size, (1 << 20) / 2);
+    BOOST_CHECK(initial.lookups.count('a') == 0);
+
+    CDBBatch batch(dbw);
+    batch.Write(std::make_pair(uint8_t{'a'}, uint32_t{1}), InsecureRand256());
+    batch.Write(std::make_pair(uint8_t{'a'}, uint32_t{2}), InsecureRand256());
+    batch.Write(std::make_pair(uint8_t{'b'}, uint32_t{1}), InsecureRand256());
+    BOOST_CHECK(dbw.WriteBatch(batch));
+
+    uint256 res;
+    BOOST_CHECK(dbw.Read(std::make_pair(uint8_t{'a'}, uint32_t{1}), res));
+    BOOST_CHECK(dbw.Read(std::make_pair(uint8_t{'a'}, uint32_t{2}), res));
+    BOOST_CHECK(!dbw.Read(std::make_pair(uint8_t{'a'}, uint32_t{3}), res));
+    BOOST_CHECK(dbw.Exists(std::make_pair(uint8_t{'b'}, uint32_t{1})));
+    BOOST_CHECK(!dbw.Exists(std::make_pair(uint8_t{'c'}, uint32_t{1})));
+    std::unique_ptr<CDBIterator> it(dbw.NewIterator());
+    it->Seek(std::make_pair(uint8_t{'b'}, uint32_t{0}));
+    BOOST_CHECK(it->Valid());
+    it->Seek(std::make_pair(uint8_t{'b'}, uint32_t{2}));
+    BOOST_CHECK(!it->Valid());
+
+    const DBStats stats{dbw.GetStats()};
+    BOOST_CHECK_EQUAL(stats.write_batch.count, initial.write_batch.count + 1);
+    BOOST_CHECK_EQUAL(stats.write_batch.bytes, initial.write_batch.bytes + batch.SizeEstimate());
+
+    const auto& a{stats.lookups.at('a')};
+    BOOST_CHECK_EQUAL(a[size_t(DBLookup::READ)].count, 3U);
+    BOOST_CHECK_EQUAL(a[size_t(DBLookup::READ)].found, 2U);
+    BOOST_CHECK_EQUAL(a[size_t(DBLookup::READ)].bytes, 2U * sizeof(uint256));
+    BOOST_CHECK_EQUAL(a[size_t(DBLookup::EXISTS)].count, 0U);
+    const auto& b{stats.lookups.at('b')};
+    BOOST_CHECK_EQUAL(b[size_t(DBLookup::EXISTS)].count, 1U);
+    BOOST_CHECK_EQUAL(b[size_t(DBLookup::EXISTS)].found, 1U);
+    BOOST_CHECK_EQUAL(b[size_t(DBLookup::SEEK)].count, 2U);
+    BOOST_CHECK_EQUAL(b[size_t(DBLookup::SEEK)].found, 1U);
+    const auto& c{stats.lookups.at('c')};
+    BOOST_CHECK_EQUAL(c[size_t(DBLookup::EXISTS)].count, 1U);
+    BOOST_CHECK_EQUAL(c[size_t(DBLookup::EXISTS)].found, 0U);
+
+    // Every operation lands in exactly one latency bucket.
+    for (const auto& [prefix, kinds] : stats.lookups) {
+        for (const DBOpStats& op : kinds) {
+            BOOST_CHECK_EQUAL(std::accumulate(op.latency.begin(), op.latency.end(), uint64_t{0}), op.count);
+        }
+    }
+
+    // The database is reported along with the others which are open.
+    const std::vector<DBStats> all{GetAllDBStats()};
+    BOOST_CHECK(std::any_of(all.begin(), all.end(), [&](const DBStats& s) { return s.path == ph; }));
+}
+
 // Test that we do not obfuscation if there is existing data.
 BOOST_AUTO_TEST_CASE(existing_data_no_obfuscate)
 {
@@ -21,6 +21,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(flatfile_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(flatfile_filename)
@@ -137,4 +140,52 @@ BOOST_AUTO_TEST_CASE(flatfile_flush)
     BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(0, 1))), 1U);
 }
 
+BOOST_AUTO_TEST_CASE(flatfile_map)
+{
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 16 * 1024);
+
+    // Missing and empty files are not mapped.
+    BOOST_CHECK(!seq.Map(FlatFilePos(0, 0)));
+    BOOST_CHECK(!seq.Map(FlatFilePos()));
+    AutoFile{seq.Open(FlatFilePos(0, 0))};
+    BOOST_CHECK(!seq.Map(FlatFilePos(0, 0)));
+
+    const std::vector<uint8_t> data1{1, 2, 3, 4, 5};
+    const std::vector<uint8_t> data2{6, 7, 8};
+    {
+        AutoFile file{seq.Open(FlatFilePos(0, 0))};
+        file << Span{data1};
+    }
+
+    const auto mapping{seq.Map(FlatFilePos(0, 3))};
+#ifdef WIN32
+    BOOST_CHECK(!mapping);
+#else
+    if (sizeof(void*) < 8) {
+        BOOST_CHECK(!mapping);
+        return;
+    }
+    BOOST_REQUIRE(mapping);
+    BOOST_CHECK_EQUAL(mapping->size(), data1.size());
+    BOOST_CHECK(std::ranges::equal(mapping->data(), data1));
+
+    // Data appended later is not covered by an existing mapping, but is by
+    // a new one.
+    {
+        AutoFile file{seq.Open(FlatFilePos(0, data1.size()))};
+        file << Span{data2};
+    }
+    BOOST_CHECK_EQUAL(mapping->size(), data1.size());
+    const auto remapped{seq.Map(FlatFilePos(0, 0))};
+    BOOST_REQUIRE(remapped);
+    BOOST_CHECK_EQUAL(remapped->size(), data1.size() + data2.size());
+    BOOST_CHECK(std::ranges::equal(remapped->data().subspan(data1.size()), data2));
+
+    // Mappings remain readable after the file is removed.
+    fs::remove(seq.FileName(FlatFilePos(0, 0)));
+    BOOST_CHECK(std::ranges::equal(mapping->data(), data1));
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -134,8 +134,7 @@ FUZZ_TARGET(coins_view, .init = initialize_coins_view)
                 random_mutable_transaction = *opt_mutable_transaction;
             },
             [&] {
-                CCoinsMapMemoryResource resource;
-                CCoinsMap coins_map{0, SaltedOutpointHasher{/*deterministic=*/true}, CCoinsMap::key_equal{}, &resource};
+                CCoinsMap coins_map{SaltedOutpointHasher{/*deterministic=*/true}};
                 LIMITED_WHILE(good_data && fuzzed_data_provider.ConsumeBool(), 10'000)
                 {
                     CCoinsCacheEntry coins_cache_entry;
@@ -175,6 +174,12 @@ FUZZ_TARGET(coins_view, .init = initialize_coins_view)
         if (exists_using_get_coin) {
             assert(coin_using_get_coin == coin_using_access_coin);
         }
+        const std::vector<COutPoint> batch{random_out_point, random_out_point};
+        const std::vector<std::optional<Coin>> coins_using_get_coins{coins_view_cache.GetCoins(batch)};
+        for (const std::optional<Coin>& coin : coins_using_get_coins) {
+            assert(coin.has_value() == exists_using_get_coin);
+            if (coin) assert(*coin == coin_using_get_coin);
+        }
         assert((exists_using_access_coin && exists_using_have_coin_in_cache && exists_using_have_coin && exists_using_get_coin) ||
                (!exists_using_access_coin && !exists_using_have_coin_in_cache && !exists_using_have_coin && !exists_using_get_coin));
         // If HaveCoin on the backend is true, it must also be on the cache if the coin wasn't spent.
@@ -24,7 +24,9 @@
 #include <util/strencodings.h>
 #include <util/string.h>
 
+#include <array>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -355,6 +357,49 @@ BOOST_AUTO_TEST_CASE(bip340_test_vectors)
     }
 }
 
+BOOST_AUTO_TEST_CASE(schnorr_batch)
+{
+    // Enough signatures that libsecp256k1 splits the batch into chunks.
+    std::vector<std::tuple<XOnlyPubKey, uint256, std::array<unsigned char, 64>>> sigs;
+    for (int i = 0; i < 100; ++i) {
+        CKey key;
+        key.MakeNewKey(true);
+        uint256 msg = InsecureRand256();
+        std::array<unsigned char, 64> sig;
+        BOOST_REQUIRE(key.SignSchnorr(msg, sig, nullptr, InsecureRand256()));
+        sigs.emplace_back(XOnlyPubKey(key.GetPubKey()), msg, sig);
+    }
+
+    SchnorrBatch batch;
+    BOOST_CHECK(batch.Verify());
+    for (const auto& [pubkey, msg, sig] : sigs) {
+        batch.Add(pubkey, msg, sig);
+    }
+    BOOST_CHECK_EQUAL(batch.size(), sigs.size());
+    BOOST_CHECK(batch.Verify());
+
+    // A signature for another message is found by the fallback.
+    size_t invalid{0};
+    batch.clear();
+    for (size_t i = 0; i < sigs.size(); ++i) {
+        const auto& [pubkey, msg, sig] = sigs[i];
+        batch.Add(pubkey, i == 57 ? InsecureRand256() : msg, sig);
+    }
+    BOOST_CHECK(!batch.Verify(&invalid));
+    BOOST_CHECK_EQUAL(invalid, 57U);
+
+    // So is a public key which is not on the curve.
+    const XOnlyPubKey bad_pubkey{ParseHex("EEFDEA4CDB677750A420FEE807EACF21EB9898AE79B9768766E4FAA04A2D4A34")};
+    BOOST_REQUIRE(!bad_pubkey.IsFullyValid());
+    batch.clear();
+    for (size_t i = 0; i < sigs.size(); ++i) {
+        const auto& [pubkey, msg, sig] = sigs[i];
+        batch.Add(i == 3 ? bad_pubkey : pubkey, msg, sig);
+    }
+    BOOST_CHECK(!batch.Verify(&invalid));
+    BOOST_CHECK_EQUAL(invalid, 3U);
+}
+
 BOOST_AUTO_TEST_CASE(key_ellswift)
 {
     for (const auto& secret : {strSecret1, strSecret2, strSecret1C, strSecret2C}) {
@@ -22,6 +22,7 @@
 #include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -137,6 +138,15 @@ static void CheckSort(CTxMemPool& pool, std::vector<std::string>& sortedOrder) E
     }
 }
 
+template <typename name, typename Compare>
+static void CheckSorted(CTxMemPool& pool, const Compare& comp) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    const auto& index = pool.mapTx.get<name>();
+    for (auto it = index.begin(); it != index.end() && std::next(it) != index.end(); ++it) {
+        BOOST_CHECK(!comp(*std::next(it), *it));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
 {
     CTxMemPool& pool = *Assert(m_node.mempool);
@@ -309,6 +319,79 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
     pool.removeRecursive(*Assert(pool.get(tx8.GetHash())), REMOVAL_REASON_DUMMY);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolNormalizationTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    /* Same fee, but an older reference height, so it is worth less. */
+    CMutableTransaction tx1 = CMutableTransaction();
+    tx1.vout.resize(1);
+    tx1.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx1.vout[0].nValue = 10 * COIN;
+    tx1.lock_height = 1000;
+    pool.addUnchecked(entry.Fee(100000LL).FromTx(tx1));
+    BOOST_CHECK_EQUAL(pool.GetNormalizedHeight(), 1000);
+
+    CMutableTransaction tx2 = CMutableTransaction();
+    tx2.vout.resize(1);
+    tx2.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx2.vout[0].nValue = 10 * COIN;
+    tx2.lock_height = 101000;
+    pool.addUnchecked(entry.Fee(100000LL).FromTx(tx2));
+    BOOST_CHECK_EQUAL(pool.GetNormalizedHeight(), 1000);
+
+    const CTxMemPoolEntry& entry1 = *Assert(pool.GetEntry(tx1.GetHash()));
+    const CTxMemPoolEntry& entry2 = *Assert(pool.GetEntry(tx2.GetHash()));
+    BOOST_CHECK_EQUAL(entry1.GetNormalizedFee(), 100000LL);
+    BOOST_CHECK_EQUAL(entry2.GetNormalizedFee(), GetTimeAdjustedValue(100000LL, 1000 - 101000));
+
+    std::vector<std::string> sortedOrder;
+    sortedOrder.resize(2);
+    sortedOrder[0] = tx1.GetHash().ToString();
+    sortedOrder[1] = tx2.GetHash().ToString();
+    CheckSort<descendant_score>(pool, sortedOrder);
+    std::reverse(sortedOrder.begin(), sortedOrder.end());
+    CheckSort<ancestor_score>(pool, sortedOrder);
+
+    /* Moving the tip a short distance leaves the normalization alone. */
+    pool.removeForBlock({}, 1500);
+    BOOST_CHECK_EQUAL(pool.GetNormalizedHeight(), 1000);
+
+    /* Moving it further renormalizes every entry, preserving the order. */
+    pool.removeForBlock({}, 150000);
+    BOOST_CHECK_EQUAL(pool.GetNormalizedHeight(), 150001);
+    BOOST_CHECK_EQUAL(entry1.GetNormalizedHeight(), 150001);
+    BOOST_CHECK_EQUAL(entry2.GetNormalizedHeight(), 150001);
+    BOOST_CHECK_EQUAL(entry1.GetNormalizedFee(), GetTimeAdjustedValue(100000LL, 150001 - 1000));
+    BOOST_CHECK_EQUAL(entry2.GetNormalizedFee(), GetTimeAdjustedValue(100000LL, 150001 - 101000));
+    CheckSort<ancestor_score>(pool, sortedOrder);
+    std::reverse(sortedOrder.begin(), sortedOrder.end());
+    CheckSort<descendant_score>(pool, sortedOrder);
+
+    /* Entries of many reference heights and fees stay properly sorted in
+     * every fee index across further renormalizations. */
+    for (int i = 0; i < 50; ++i) {
+        CMutableTransaction tx = CMutableTransaction();
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        tx.lock_height = 100000 + 997 * i;
+        pool.addUnchecked(entry.Fee(1000LL + 7919LL * ((i * 31) % 50)).FromTx(tx));
+    }
+    for (int height : {152000, 154000, 200000}) {
+        pool.removeForBlock({}, height);
+        BOOST_CHECK_EQUAL(pool.GetNormalizedHeight(), height + 1);
+        for (const auto& e : pool.mapTx) {
+            BOOST_CHECK_EQUAL(e.GetNormalizedHeight(), height + 1);
+            BOOST_CHECK(!e.IsRenormalizing());
+        }
+        CheckSorted<descendant_score>(pool, CompareTxMemPoolEntryByDescendantScore());
+        CheckSorted<ancestor_score>(pool, CompareTxMemPoolEntryByAncestorFee());
+    }
+}
+
 BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
 {
     CTxMemPool& pool = *Assert(m_node.mempool);
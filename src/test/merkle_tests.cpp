@@ -4067,4 +4067,42 @@ BOOST_AUTO_TEST_CASE(fast_merkle_branch)
     }
 }
 
+BOOST_AUTO_TEST_CASE(cached_merkle_tree)
+{
+    CachedMerkleTree appended;
+    CachedMerkleTree appended_fast(CachedMerkleTree::Type::FAST);
+    BOOST_CHECK(appended.GetRoot() == ComputeMerkleRoot({}));
+    BOOST_CHECK(appended_fast.GetRoot() == ComputeFastMerkleRoot({}));
+    std::vector<uint256> leaves;
+    for (uint32_t n = 1; n <= 40; ++n) {
+        leaves.push_back(InsecureRand256());
+        appended.Append(leaves.back());
+        appended_fast.Append(leaves.back());
+
+        CachedMerkleTree tree(leaves);
+        CachedMerkleTree fast(leaves, CachedMerkleTree::Type::FAST);
+        BOOST_CHECK(tree.GetRoot() == ComputeMerkleRoot(leaves));
+        BOOST_CHECK(appended.GetRoot() == ComputeMerkleRoot(leaves));
+        BOOST_CHECK(fast.GetRoot() == ComputeFastMerkleRoot(leaves));
+        BOOST_CHECK(appended_fast.GetRoot() == ComputeFastMerkleRoot(leaves));
+        for (uint32_t pos = 0; pos < n; ++pos) {
+            BOOST_CHECK(tree.GetBranch(pos) == ComputeMerkleBranch(leaves, pos));
+            BOOST_CHECK(tree.GetStableBranch(pos) == ComputeStableMerkleBranch(leaves, pos));
+            BOOST_CHECK(fast.GetBranch(pos) == ComputeFastMerkleBranch(leaves, pos).first);
+        }
+
+        // Replacing a leaf only rehashes its path, with the same result as
+        // rebuilding the tree.
+        const uint32_t pos = InsecureRandRange(n);
+        std::vector<uint256> updated{leaves};
+        updated[pos] = InsecureRand256();
+        tree.SetLeaf(pos, updated[pos]);
+        fast.SetLeaf(pos, updated[pos]);
+        BOOST_CHECK(tree.GetLeaf(pos) == updated[pos]);
+        BOOST_CHECK(tree.GetRoot() == ComputeMerkleRoot(updated));
+        BOOST_CHECK(fast.GetRoot() == ComputeFastMerkleRoot(updated));
+        BOOST_CHECK(tree.GetBranch(n - 1) == ComputeMerkleBranch(updated, n - 1));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
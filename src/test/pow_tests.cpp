@@ -15,7 +15,10 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <hash.h>
 #include <pow.h>
+#include <primitives/block.h>
+#include <streams.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <util/chaintype.h>
@@ -178,6 +181,53 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(aux_hash_memoization)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, ChainType::MAIN);
+    const auto& consensus = chainParams->GetConsensus();
+
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1700000000;
+    header.nBits = 0x1d00ffff;
+    header.m_aux_pow.m_commit_hash_merkle_root = InsecureRand256();
+    header.m_aux_pow.m_secret_lo = InsecureRandBits(64);
+    header.m_aux_pow.m_secret_hi = InsecureRandBits(64);
+    header.m_aux_pow.m_midstate_hash = InsecureRand256();
+    header.m_aux_pow.m_midstate_buffer.assign(8, 0x5a);
+    header.m_aux_pow.m_midstate_length = 72;
+    header.m_aux_pow.m_aux_branch.push_back(InsecureRand256());
+    header.m_aux_pow.m_aux_num_txns = 2;
+    header.m_aux_pow.m_aux_bits = 0x1d00ffff;
+    header.m_aux_pow.m_aux_nonce = InsecureRand32();
+
+    // The block hash only covers the native header fields.
+    CBlockHeader native{header};
+    native.m_aux_pow.SetNull();
+    BOOST_CHECK(header.GetHash() == (HashWriter{} << native).GetHash());
+
+    // Checking with memoized hashes gives the same result as recomputing them.
+    std::pair<uint256, uint256> aux_hash;
+    const bool valid = CheckAuxiliaryProofOfWork(header, consensus, &aux_hash);
+    BOOST_CHECK(aux_hash == header.GetAuxiliaryHash(consensus));
+    BOOST_CHECK_EQUAL(CheckAuxiliaryProofOfWork(header, aux_hash, consensus), valid);
+
+    // The memoized hashes survive a round trip through the block index database.
+    CBlockIndex index{header};
+    BOOST_CHECK(!index.m_aux_hash);
+    index.SetAuxiliaryHash(aux_hash);
+    DataStream ss{};
+    ss << CDiskBlockIndex{&index};
+    CDiskBlockIndex disk_index;
+    ss >> disk_index;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK(disk_index.m_aux_pow == header.m_aux_pow);
+    BOOST_CHECK(disk_index.m_aux_hash && *disk_index.m_aux_hash == aux_hash);
+    BOOST_CHECK(disk_index.GetAuxiliaryHash(consensus) == aux_hash);
+}
+
 void sanity_check_chainparams(const ArgsManager& args, ChainType chain_type)
 {
     const auto chainParams = CreateChainParams(args, chain_type);
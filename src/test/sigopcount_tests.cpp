@@ -162,6 +162,10 @@ BOOST_AUTO_TEST_CASE(GetTxSigOpCost)
 
         BuildTxs(spendingTx, coins, creationTx, scriptPubKey, scriptSig, CScriptWitness());
         BOOST_CHECK_EQUAL(GetTransactionSigOpCost(CTransaction(spendingTx), coins, flags), 2 * WITNESS_SCALE_FACTOR);
+        // Counting against the spent coins themselves, as is done when
+        // connecting a block, gives the same result.
+        const std::vector<Coin> spent_coins{coins.AccessCoin(spendingTx.vin[0].prevout)};
+        BOOST_CHECK_EQUAL(GetTransactionSigOpCost(CTransaction(spendingTx), spent_coins, flags), 2 * WITNESS_SCALE_FACTOR);
         BOOST_CHECK_EQUAL(VerifyWithFlag(CTransaction(creationTx), spendingTx, flags), SCRIPT_ERR_CHECKMULTISIGVERIFY);
     }
 
@@ -0,0 +1,55 @@
+// Copyright (c) 2020-2024 The Freicoin Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or <https://www.opensource.org/licenses/mit-license.php>.
+
+#include <stratum.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(stratum_tests)
+
+BOOST_AUTO_TEST_CASE(classify_share)
+{
+    // Shares meeting the required difficulty are accepted.
+    BOOST_CHECK(ClassifyShare(false, false, 2.0, 1.0) == ShareResult::ACCEPTED);
+    BOOST_CHECK(ClassifyShare(false, false, 1.0, 1.0) == ShareResult::ACCEPTED);
+    BOOST_CHECK(ClassifyShare(false, false, 0.5, 1.0) == ShareResult::REJECTED);
+
+    // Shares for work on a previous tip are stale, whatever their difficulty.
+    BOOST_CHECK(ClassifyShare(true, false, 2.0, 1.0) == ShareResult::STALE);
+    BOOST_CHECK(ClassifyShare(true, false, 0.5, 1.0) == ShareResult::STALE);
+
+    // A share which solves a block is always accepted, even from stale work.
+    BOOST_CHECK(ClassifyShare(false, true, 0.5, 1.0) == ShareResult::ACCEPTED);
+    BOOST_CHECK(ClassifyShare(true, true, 2.0, 1.0) == ShareResult::ACCEPTED);
+    BOOST_CHECK(ClassifyShare(true, true, 0.5, 1.0) == ShareResult::ACCEPTED);
+}
+
+BOOST_AUTO_TEST_CASE(share_log_hashrate)
+{
+    constexpr double HASHES_PER_DIFF1 = 4294967296.0;
+    const int64_t start = 1000000;
+
+    ShareLog<16> log;
+    BOOST_CHECK_EQUAL(log.GetHashrate(start + 60, 600, start), 0.0);
+
+    // Ten difficulty-1 shares within the first minute are averaged over that
+    // minute, not over the whole ten minute window.
+    for (int i = 0; i < 10; ++i) {
+        log.Add(start + 6 * i, 1.0);
+    }
+    BOOST_CHECK_EQUAL(log.GetHashrate(start + 60, 600, start), 10 * HASHES_PER_DIFF1 / 60);
+
+    // Once running for longer than the window, the full window is used and
+    // older shares drop out of it.
+    BOOST_CHECK_EQUAL(log.GetHashrate(start + 600, 600, start), 10 * HASHES_PER_DIFF1 / 600);
+    BOOST_CHECK_EQUAL(log.GetHashrate(start + 630, 600, start), 5 * HASHES_PER_DIFF1 / 600);
+
+    // A log which has wrapped around covers only the shares it still holds.
+    for (int i = 0; i < 32; ++i) {
+        log.Add(start + 700 + i, 2.0);
+    }
+    BOOST_CHECK_EQUAL(log.GetHashrate(start + 740, 600, start), 16 * 2 * HASHES_PER_DIFF1 / 24);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
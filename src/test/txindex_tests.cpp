@@ -17,8 +17,10 @@
 #include <chainparams.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
+#include <node/blockstorage.h>
 #include <test/util/index.h>
 #include <test/util/setup_common.h>
+#include <txmempool.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
@@ -88,4 +90,99 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_find_txs, TestChain100Setup)
+{
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_REQUIRE(txindex.StartBackgroundSync());
+    IndexWaitSynced(txindex, *Assert(m_node.shutdown));
+
+    // Look up all the coinbase transactions at once, along with ones not in
+    // the index and one asked for twice.
+    std::vector<uint256> tx_hashes;
+    for (const auto& txn : m_coinbase_txns) {
+        tx_hashes.push_back(txn->GetHash());
+    }
+    tx_hashes.push_back(Params().GenesisBlock().vtx[0]->GetHash());
+    tx_hashes.push_back(uint256::ONE);
+    tx_hashes.push_back(m_coinbase_txns[0]->GetHash());
+
+    std::vector<uint256> block_hashes;
+    std::vector<CTransactionRef> txs;
+    txindex.FindTxs(tx_hashes, block_hashes, txs);
+    BOOST_REQUIRE_EQUAL(txs.size(), tx_hashes.size());
+    BOOST_REQUIRE_EQUAL(block_hashes.size(), tx_hashes.size());
+    for (size_t i = 0; i < m_coinbase_txns.size(); ++i) {
+        BOOST_REQUIRE(txs[i]);
+        BOOST_CHECK_EQUAL(txs[i]->GetHash(), m_coinbase_txns[i]->GetHash());
+        const CBlockIndex* index = WITH_LOCK(cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(block_hashes[i]));
+        CBlock block;
+        BOOST_REQUIRE(index && m_node.chainman->m_blockman.ReadBlockFromDisk(block, *index));
+        BOOST_CHECK_EQUAL(block.vtx[0]->GetHash(), m_coinbase_txns[i]->GetHash());
+    }
+    BOOST_CHECK(!txs[m_coinbase_txns.size()]);
+    BOOST_CHECK(!txs[m_coinbase_txns.size() + 1]);
+    BOOST_REQUIRE(txs.back());
+    BOOST_CHECK_EQUAL(txs.back()->GetHash(), m_coinbase_txns[0]->GetHash());
+
+    // Transactions in blocks which are disconnected can still be found.
+    CScript coinbase_script_pub_key = GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()));
+    const CBlock stale_block = CreateAndProcessBlock({}, coinbase_script_pub_key);
+    BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+    {
+        BlockValidationState state;
+        CBlockIndex* stale_index = WITH_LOCK(cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(stale_block.GetHash()));
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, stale_index));
+    }
+    const CBlock block = CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    BOOST_CHECK(block.vtx[0]->GetHash() != stale_block.vtx[0]->GetHash());
+    BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    BOOST_REQUIRE(txindex.FindTx(stale_block.vtx[0]->GetHash(), block_hash, tx_disk));
+    BOOST_CHECK_EQUAL(block_hash, stale_block.GetHash());
+    BOOST_REQUIRE(txindex.FindTx(block.vtx[0]->GetHash(), block_hash, tx_disk));
+    BOOST_CHECK_EQUAL(block_hash, block.GetHash());
+
+    // Transactions after the coinbase are found in a disconnected tip, while
+    // there is no block at its height on the indexed chain, and after a block
+    // with fewer transactions replaces it.
+    std::vector<CMutableTransaction> spends;
+    for (size_t i = 0; i < 2; ++i) {
+        spends.push_back(CreateValidMempoolTransaction(m_coinbase_txns[i], 0, 0, coinbaseKey, coinbase_script_pub_key,
+                                                       /*output_amount=*/1 * COIN, /*submit=*/false));
+    }
+    const CBlock stale_tip = CreateAndProcessBlock(spends, coinbase_script_pub_key);
+    BOOST_REQUIRE(txindex.BlockUntilSyncedToCurrentChain());
+    {
+        BlockValidationState state;
+        CBlockIndex* stale_index = WITH_LOCK(cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(stale_tip.GetHash()));
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, stale_index));
+    }
+    BOOST_REQUIRE(txindex.BlockUntilSyncedToCurrentChain());
+    const auto check_stale_spends{[&] {
+        for (const auto& spend : spends) {
+            BOOST_REQUIRE(txindex.FindTx(spend.GetHash(), block_hash, tx_disk));
+            BOOST_CHECK_EQUAL(tx_disk->GetHash(), spend.GetHash());
+            BOOST_CHECK_EQUAL(block_hash, stale_tip.GetHash());
+        }
+    }};
+    check_stale_spends();
+
+    {
+        LOCK(m_node.mempool->cs);
+        for (const auto& spend : spends) {
+            m_node.mempool->removeRecursive(CTransaction{spend}, MemPoolRemovalReason::REPLACED);
+        }
+    }
+    const CBlock replacement = CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    BOOST_REQUIRE_LE(replacement.vtx.size(), 2U);
+    BOOST_REQUIRE(txindex.BlockUntilSyncedToCurrentChain());
+    check_stale_spends();
+
+    SyncWithValidationInterfaceQueue();
+    txindex.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
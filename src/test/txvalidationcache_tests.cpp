@@ -421,4 +421,57 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, Dersig100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(connectblock_input_checks, TestChain100Setup)
+{
+    // ConnectBlock runs the input checks of each transaction on the script
+    // check threads alongside its script checks, and reduces their results in
+    // block order, so the input checks of every transaction take precedence
+    // over any failed script check.
+    BOOST_REQUIRE(m_node.chainman->GetCheckQueue().HasThreads());
+    // Mature the coinbases spent below.
+    mineBlocks(3);
+
+    const CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const CKey other_key{GenerateRandomKey()};
+    const auto spend = [&](const CTransactionRef& coinbase, CAmount value, const CKey& key) {
+        CMutableTransaction tx;
+        tx.nVersion = 1;
+        tx.vin.resize(1);
+        tx.vin[0].prevout.hash = coinbase->GetHash();
+        tx.vin[0].prevout.n = 0;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = value;
+        tx.vout[0].scriptPubKey = scriptPubKey;
+        tx.lock_height = coinbase->lock_height;
+        std::vector<unsigned char> vchSig;
+        const uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL, 0, coinbase->lock_height, SigVersion::BASE);
+        BOOST_CHECK(key.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig << vchSig;
+        return tx;
+    };
+    const auto connect_reject_reason = [&](const std::vector<CMutableTransaction>& txns) {
+        Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+        const CBlock block{CreateBlock(txns, scriptPubKey, chainstate)};
+        LOCK(cs_main);
+        BlockValidationState state;
+        TestBlockValidity(state, Params(), chainstate, block, chainstate.m_chain.Tip(), /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true);
+        return state.GetRejectReason();
+    };
+
+    const CAmount value{m_coinbase_txns[0]->vout[0].nValue};
+    const auto good_tx = [&](int i) { return spend(m_coinbase_txns[i], 11 * CENT, coinbaseKey); };
+    const auto bad_sig_tx = [&](int i) { return spend(m_coinbase_txns[i], 11 * CENT, other_key); };
+    const auto overspend_tx = [&](int i) { return spend(m_coinbase_txns[i], value + 1, coinbaseKey); };
+
+    BOOST_CHECK_EQUAL(connect_reject_reason({good_tx(0), good_tx(1), good_tx(2)}), "");
+    BOOST_CHECK_EQUAL(connect_reject_reason({good_tx(0), bad_sig_tx(1), good_tx(2)}), "block-validation-failed");
+    BOOST_CHECK_EQUAL(connect_reject_reason({good_tx(0), overspend_tx(1), good_tx(2)}), "bad-txns-in-belowout");
+
+    // A failed input check is reported even when a script check of an
+    // earlier transaction, or of the same one, has also failed.
+    BOOST_CHECK_EQUAL(connect_reject_reason({bad_sig_tx(0), good_tx(1), overspend_tx(2)}), "bad-txns-in-belowout");
+    BOOST_CHECK_EQUAL(connect_reject_reason({good_tx(0), spend(m_coinbase_txns[1], value + 1, other_key)}), "bad-txns-in-belowout");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
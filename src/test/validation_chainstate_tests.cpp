@@ -72,6 +72,49 @@ BOOST_AUTO_TEST_CASE(validation_chainstate_resize_caches)
     }
 }
 
+//! Test that the block-final transaction state follows the tip.
+BOOST_FIXTURE_TEST_CASE(chainstate_final_tx_state, TestChain100Setup)
+{
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    auto check_state = [&] {
+        LOCK(::cs_main);
+        const auto state{chainstate.GetFinalTxState()};
+        BOOST_CHECK_EQUAL(state.tip_hash, chainstate.m_chain.Tip()->GetBlockHash());
+        BOOST_CHECK_EQUAL(state.tip_height, chainstate.m_chain.Height());
+        BOOST_CHECK(state.final_tx == chainstate.CoinsTip().GetFinalTx());
+        return state;
+    };
+
+    // The block-final rules are active from the start on regtest, so once the
+    // initial block-final output has matured, each block ends with a
+    // block-final transaction spending the previous one.
+    const auto tip_final_tx = [&] {
+        CBlock block;
+        BOOST_REQUIRE(WITH_LOCK(::cs_main, return chainman.m_blockman.ReadBlockFromDisk(block, *chainstate.m_chain.Tip())));
+        BOOST_REQUIRE_GT(block.vtx.size(), 1U);
+        return BlockFinalTxEntry{block.vtx.back()->GetHash(), static_cast<uint32_t>(block.vtx.back()->vout.size())};
+    };
+
+    const auto before{check_state()};
+    BOOST_REQUIRE(!before.final_tx.IsNull());
+    BOOST_CHECK(before.final_tx == tip_final_tx());
+
+    mineBlocks(1);
+    const auto after{check_state()};
+    BOOST_CHECK_EQUAL(after.tip_height, before.tip_height + 1);
+    BOOST_CHECK(after.final_tx == tip_final_tx());
+    BOOST_CHECK(after.final_tx != before.final_tx);
+
+    // Disconnecting the block restores the previous state.
+    BlockValidationState state;
+    CBlockIndex* tip{WITH_LOCK(::cs_main, return chainstate.m_chain.Tip())};
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, tip));
+    const auto reverted{check_state()};
+    BOOST_CHECK_EQUAL(reverted.tip_hash, before.tip_hash);
+    BOOST_CHECK(reverted.final_tx == before.final_tx);
+}
+
 //! Test UpdateTip behavior for both active and background chainstates.
 //!
 //! When run on the background chainstate, UpdateTip should do a subset
@@ -14,6 +14,7 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <chainparams.h>
+#include <coins.h>
 #include <consensus/amount.h>
 #include <consensus/merkle.h>
 #include <core_io.h>
@@ -26,6 +27,7 @@
 
 #include <string>
 
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -404,4 +406,96 @@ BOOST_AUTO_TEST_CASE(block_malleation)
     }
 }
 
+//! Test that checking headers on worker threads agrees with checking them inline.
+BOOST_AUTO_TEST_CASE(header_pow_check_queue)
+{
+    const auto params = CreateChainParams(*m_node.args, ChainType::MAIN);
+    const Consensus::Params& consensus = params->GetConsensus();
+    CCheckQueue<CValidationCheck> check_queue{/*batch_size=*/4, /*worker_threads_num=*/3};
+
+    std::vector<CBlockHeader> headers(100, params->GenesisBlock().GetBlockHeader());
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus));
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus, &check_queue));
+
+    // A single bad header anywhere in the batch fails the whole batch.
+    for (size_t pos : {size_t{0}, size_t{57}, headers.size() - 1}) {
+        std::vector<CBlockHeader> bad_headers{headers};
+        ++bad_headers[pos].nNonce;
+        BOOST_CHECK(!HasValidProofOfWork(bad_headers, consensus));
+        BOOST_CHECK(!HasValidProofOfWork(bad_headers, consensus, &check_queue));
+    }
+
+    // The queue is reusable after a failed batch.
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus, &check_queue));
+}
+
+namespace {
+//! A coins view backed by a map, which can be read from several threads.
+class CoinsViewMap : public CCoinsView
+{
+public:
+    std::map<COutPoint, Coin> m_coins;
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override
+    {
+        auto it = m_coins.find(outpoint);
+        if (it == m_coins.end()) return false;
+        coin = it->second;
+        return true;
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(prefetch_block_inputs)
+{
+    CoinsViewMap db;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    CMutableTransaction spend;
+    for (uint32_t n = 0; n < 10; ++n) {
+        const COutPoint outpoint{Txid::FromUint256(InsecureRand256()), n};
+        db.m_coins.emplace(outpoint, Coin{CTxOut{1 + n, CScript{} << OP_TRUE}, /*refheightIn=*/1, /*nHeightIn=*/1, /*fCoinBaseIn=*/false});
+        spend.vin.emplace_back(outpoint);
+    }
+    spend.vout.resize(1);
+    // An output which doesn't exist, and one created by the block itself.
+    CMutableTransaction spend_missing;
+    spend_missing.vin.emplace_back(COutPoint{Txid::FromUint256(InsecureRand256()), 0});
+    spend_missing.vin.emplace_back(COutPoint{spend.GetHash(), 0});
+    spend_missing.vout.resize(1);
+    CBlock block;
+    block.vtx = {MakeTransactionRef(coinbase), MakeTransactionRef(spend), MakeTransactionRef(spend_missing)};
+
+    // Without worker threads, the coins are read in a single batch.
+    CCheckQueue<CValidationCheck> no_threads{/*batch_size=*/4, /*worker_threads_num=*/0};
+    CCoinsViewCache serial_cache{&db};
+    PrefetchBlockInputs(block, serial_cache, db, no_threads);
+    BOOST_CHECK_EQUAL(serial_cache.GetCacheSize(), spend.vin.size());
+    for (const CTxIn& txin : spend.vin) {
+        BOOST_CHECK_EQUAL(serial_cache.AccessCoin(txin.prevout).out.GetReferenceValue(), db.m_coins.at(txin.prevout).out.GetReferenceValue());
+    }
+    for (const CTxIn& txin : spend_missing.vin) {
+        BOOST_CHECK(!serial_cache.HaveCoinInCache(txin.prevout));
+    }
+
+    // A coin which is already cached is left as it is.
+    CCoinsViewCache cache{&db};
+    const COutPoint& cached = spend.vin[3].prevout;
+    cache.AddCoin(cached, Coin{CTxOut{100, CScript{}}, 1, 1, false}, /*possible_overwrite=*/true);
+
+    CCheckQueue<CValidationCheck> check_queue{/*batch_size=*/4, /*worker_threads_num=*/3};
+    PrefetchBlockInputs(block, cache, db, check_queue);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), spend.vin.size());
+    for (const CTxIn& txin : spend.vin) {
+        BOOST_CHECK(cache.HaveCoinInCache(txin.prevout));
+        const CAmount expected{txin.prevout == cached ? 100 : db.m_coins.at(txin.prevout).out.GetReferenceValue()};
+        BOOST_CHECK_EQUAL(cache.AccessCoin(txin.prevout).out.GetReferenceValue(), expected);
+    }
+    for (const CTxIn& txin : spend_missing.vin) {
+        BOOST_CHECK(!cache.HaveCoinInCache(txin.prevout));
+    }
+    cache.SanityCheck();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -82,6 +82,15 @@ bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return m_db->Read(CoinEntry(&outpoint), coin);
 }
 
+std::vector<std::optional<Coin>> CCoinsViewDB::GetCoins(Span<const COutPoint> outpoints) const {
+    std::vector<CoinEntry> keys;
+    keys.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) {
+        keys.emplace_back(&outpoint);
+    }
+    return m_db->ReadMany<Coin>(Span<const CoinEntry>{keys});
+}
+
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return m_db->Exists(CoinEntry(&outpoint));
 }
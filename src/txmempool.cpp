@@ -390,6 +390,7 @@ void CTxMemPoolEntry::UpdateDescendantState(int32_t modifySize, CAmount modifyFe
     nSizeWithDescendants += modifySize;
     assert(nSizeWithDescendants > 0);
     nModFeesWithDescendants = SaturatingAdd(nModFeesWithDescendants, modifyFee);
+    m_normalized_mod_fees_with_descendants = NormalizeValue(nModFeesWithDescendants);
     m_count_with_descendants += modifyCount;
     assert(m_count_with_descendants > 0);
 }
@@ -399,12 +400,33 @@ void CTxMemPoolEntry::UpdateAncestorState(int32_t modifySize, CAmount modifyFee,
     nSizeWithAncestors += modifySize;
     assert(nSizeWithAncestors > 0);
     nModFeesWithAncestors = SaturatingAdd(nModFeesWithAncestors, modifyFee);
+    m_normalized_mod_fees_with_ancestors = NormalizeValue(nModFeesWithAncestors);
     m_count_with_ancestors += modifyCount;
     assert(m_count_with_ancestors > 0);
     nSigOpCostWithAncestors += modifySigOps;
     assert(int(nSigOpCostWithAncestors) >= 0);
 }
 
+void CTxMemPoolEntry::Normalize(int32_t normalized_height)
+{
+    m_normalized_height = normalized_height;
+    m_renormalizing = false;
+    const int relative_depth = m_normalized_height - GetReferenceHeight();
+    if (relative_depth >= 0) {
+        // The common case: all four values share one demurrage factor.
+        const DemurrageFactor factor{GetDemurrageFactor(relative_depth)};
+        m_normalized_fee = TimeAdjustValueForward(nFee, factor);
+        m_normalized_modified_fee = TimeAdjustValueForward(m_modified_fee, factor);
+        m_normalized_mod_fees_with_descendants = TimeAdjustValueForward(nModFeesWithDescendants, factor);
+        m_normalized_mod_fees_with_ancestors = TimeAdjustValueForward(nModFeesWithAncestors, factor);
+    } else {
+        m_normalized_fee = NormalizeValue(nFee);
+        m_normalized_modified_fee = NormalizeValue(m_modified_fee);
+        m_normalized_mod_fees_with_descendants = NormalizeValue(nModFeesWithDescendants);
+        m_normalized_mod_fees_with_ancestors = NormalizeValue(nModFeesWithAncestors);
+    }
+}
+
 CTxMemPool::CTxMemPool(const Options& opts)
     : m_check_ratio{opts.check_ratio},
       m_max_size_bytes{opts.max_size_bytes},
@@ -442,7 +464,12 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // Add to memory pool without checking anything.
     // Used by AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
-    indexed_transaction_set::iterator newit = mapTx.emplace(CTxMemPoolEntry::ExplicitCopy, entry).first;
+    // An empty mempool can switch normalization heights for free, so
+    // pick one which requires no adjustment of the new entry's fees.
+    if (mapTx.empty()) {
+        m_normalized_height = entry.GetReferenceHeight();
+    }
+    indexed_transaction_set::iterator newit = mapTx.emplace(CTxMemPoolEntry::ExplicitCopy, entry, m_normalized_height).first;
 
     // Update transaction for any feeDelta created by PrioritiseTransaction
     CAmount delta{0};
@@ -657,6 +684,29 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     GetMainSignals().MempoolTransactionsRemovedForBlock(txs_removed_for_block, nBlockHeight);
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
+    MaybeRenormalize(nBlockHeight + 1);
+}
+
+void CTxMemPool::MaybeRenormalize(int32_t height)
+{
+    AssertLockHeld(cs);
+    if (std::abs(height - m_normalized_height) < MEMPOOL_NORMALIZATION_INTERVAL) {
+        return;
+    }
+    m_normalized_height = height;
+    // Re-seating entries one at a time would have the fee indexes compare
+    // entries normalized to different heights, which cannot be done in a
+    // consistent order.  Instead first flag every entry, which makes them all
+    // equivalent to each other under the fee comparators, so the indexes are
+    // trivially sorted.  No index is consulted until the loop is done.  Each
+    // normalized entry then sorts after every flagged one and is only ever
+    // compared against others at the new height.
+    for (const CTxMemPoolEntry& e : mapTx) {
+        e.SetRenormalizing();
+    }
+    for (txiter it = mapTx.begin(); it != mapTx.end(); ++it) {
+        mapTx.modify(it, [height](CTxMemPoolEntry& e) { e.Normalize(height); });
+    }
 }
 
 void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendheight, const Consensus::Params& params) const
@@ -680,6 +730,8 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         checkTotal += it->GetTxSize();
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
+        assert(it->GetNormalizedHeight() == m_normalized_height);
+        assert(!it->IsRenormalizing());
         const CTransaction& tx = it->GetTx();
         innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
         CTxMemPoolEntry::Parents setParentCheck;
@@ -1018,6 +1070,34 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return base->GetCoin(outpoint, coin);
 }
 
+std::vector<std::optional<Coin>> CCoinsViewMemPool::GetCoins(Span<const COutPoint> outpoints) const
+{
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<COutPoint> misses;
+    std::vector<size_t> miss_positions;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        const COutPoint& outpoint{outpoints[i]};
+        if (auto it = m_temp_added.find(outpoint); it != m_temp_added.end()) {
+            coins[i] = it->second;
+        } else if (CTransactionRef ptx = mempool.get(outpoint.hash)) {
+            if (outpoint.n < ptx->vout.size()) {
+                coins[i].emplace(ptx->vout[outpoint.n], ptx->lock_height, MEMPOOL_HEIGHT, false);
+                m_non_base_coins.emplace(outpoint);
+            }
+        } else {
+            misses.push_back(outpoint);
+            miss_positions.push_back(i);
+        }
+    }
+    if (misses.empty()) return coins;
+
+    std::vector<std::optional<Coin>> fetched{base->GetCoins(misses)};
+    for (size_t j = 0; j < misses.size(); ++j) {
+        coins[miss_positions[j]] = std::move(fetched[j]);
+    }
+    return coins;
+}
+
 void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
 {
     for (unsigned int n = 0; n < tx->vout.size(); ++n) {
@@ -56,6 +56,11 @@ class CChain;
 /** Fake height value used in Coin to signify they are only in the memory pool (since 0.8) */
 static const uint32_t MEMPOOL_HEIGHT = 0x7FFFFFFF;
 
+/** How far the chain tip may move from the mempool's fee normalization height
+ * before all entries are renormalized.  Demurrage over this many blocks is
+ * less than 0.1%, so the normalized fees remain precise well past it. */
+static const int32_t MEMPOOL_NORMALIZATION_INTERVAL = 1008;
+
 /**
  * Test whether the LockPoints height and time are still valid on the current chain
  */
@@ -92,28 +97,40 @@ struct mempoolentry_wtxid
 };
 
 
+/**
+ * Order entries which are in the middle of being renormalized (see
+ * CTxMemPool::MaybeRenormalize()) before all others, and treat them as
+ * equivalent to each other.  Returns true, with the result of the comparison
+ * in `result`, if either entry is being renormalized.  Otherwise the two
+ * entries' normalized fees are relative to the same height.
+ */
+template <typename T>
+bool CompareRenormalizing(const T& a, const T& b, bool& result)
+{
+    if (!a.IsRenormalizing() && !b.IsRenormalizing()) return false;
+    result = a.IsRenormalizing() && !b.IsRenormalizing();
+    return true;
+}
+
 /** \class CompareTxMemPoolEntryByDescendantScore
  *
  *  Sort an entry by max(score/size of entry's tx, score/size with all descendants).
+ *  Fees are compared at the mempool's normalization height.
  */
 class CompareTxMemPoolEntryByDescendantScore
 {
 public:
     bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
     {
+        bool result;
+        if (CompareRenormalizing(a, b, result)) return result;
+
         CAmount a_mod_fee, b_mod_fee;
         double a_size, b_size;
 
         GetModFeeAndSize(a, a_mod_fee, a_size);
         GetModFeeAndSize(b, b_mod_fee, b_size);
 
-        // Adjust to higher refheight
-        if (a.GetReferenceHeight() < b.GetReferenceHeight()) {
-            a_mod_fee = GetTimeAdjustedValue(a_mod_fee, b.GetReferenceHeight() - a.GetReferenceHeight());
-        } else {
-            b_mod_fee = GetTimeAdjustedValue(b_mod_fee, a.GetReferenceHeight() - b.GetReferenceHeight());
-        }
-
         // Avoid division by rewriting (a/b > c/d) as (a*d > c*b).
         double f1 = a_mod_fee * b_size;
         double f2 = a_size * b_mod_fee;
@@ -129,14 +146,14 @@ public:
     {
         // Compare feerate with descendants to feerate of the transaction, and
         // return the fee/size for the max.
-        double f1 = (double)a.GetModifiedFee() * a.GetSizeWithDescendants();
-        double f2 = (double)a.GetModFeesWithDescendants() * a.GetTxSize();
+        double f1 = (double)a.GetNormalizedModifiedFee() * a.GetSizeWithDescendants();
+        double f2 = (double)a.GetNormalizedModFeesWithDescendants() * a.GetTxSize();
 
         if (f2 > f1) {
-            mod_fee = a.GetModFeesWithDescendants();
+            mod_fee = a.GetNormalizedModFeesWithDescendants();
             size = a.GetSizeWithDescendants();
         } else {
-            mod_fee = a.GetModifiedFee();
+            mod_fee = a.GetNormalizedModifiedFee();
             size = a.GetTxSize();
         }
     }
@@ -154,13 +171,11 @@ class CompareTxMemPoolEntryByScore
 public:
     bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
     {
-        CAmount aFee = a.GetFee();
-        CAmount bFee = b.GetFee();
-        if (a.GetReferenceHeight() < b.GetReferenceHeight()) {
-            aFee = GetTimeAdjustedValue(aFee, b.GetReferenceHeight() - a.GetReferenceHeight());
-        } else {
-            bFee = GetTimeAdjustedValue(bFee, a.GetReferenceHeight() - b.GetReferenceHeight());
-        }
+        bool result;
+        if (CompareRenormalizing(a, b, result)) return result;
+
+        CAmount aFee = a.GetNormalizedFee();
+        CAmount bFee = b.GetNormalizedFee();
         double f1 = (double)aFee * b.GetTxSize();
         double f2 = (double)bFee * a.GetTxSize();
         if (f1 == f2) {
@@ -182,6 +197,7 @@ public:
 /** \class CompareTxMemPoolEntryByAncestorScore
  *
  *  Sort an entry by min(score/size of entry's tx, score/size with all ancestors).
+ *  Fees are compared at the mempool's normalization height.
  */
 class CompareTxMemPoolEntryByAncestorFee
 {
@@ -189,7 +205,11 @@ public:
     template<typename T>
     bool operator()(const T& a, const T& b) const
     {
-        double a_mod_fee, a_size, b_mod_fee, b_size;
+        bool result;
+        if (CompareRenormalizing(a, b, result)) return result;
+
+        CAmount a_mod_fee, b_mod_fee;
+        double a_size, b_size;
 
         GetModFeeAndSize(a, a_mod_fee, a_size);
         GetModFeeAndSize(b, b_mod_fee, b_size);
@@ -206,18 +226,18 @@ public:
 
     // Return the fee/size we're using for sorting this entry.
     template <typename T>
-    void GetModFeeAndSize(const T &a, double &mod_fee, double &size) const
+    void GetModFeeAndSize(const T &a, CAmount &mod_fee, double &size) const
     {
         // Compare feerate with ancestors to feerate of the transaction, and
         // return the fee/size for the min.
-        double f1 = (double)a.GetModifiedFee() * a.GetSizeWithAncestors();
-        double f2 = (double)a.GetModFeesWithAncestors() * a.GetTxSize();
+        double f1 = (double)a.GetNormalizedModifiedFee() * a.GetSizeWithAncestors();
+        double f2 = (double)a.GetNormalizedModFeesWithAncestors() * a.GetTxSize();
 
         if (f1 > f2) {
-            mod_fee = a.GetModFeesWithAncestors();
+            mod_fee = a.GetNormalizedModFeesWithAncestors();
             size = a.GetSizeWithAncestors();
         } else {
-            mod_fee = a.GetModifiedFee();
+            mod_fee = a.GetNormalizedModifiedFee();
             size = a.GetTxSize();
         }
     }
@@ -347,6 +367,9 @@ protected:
 
     bool m_load_tried GUARDED_BY(cs){false};
 
+    //! Height to which the fees used as sort keys in mapTx are normalized.
+    int32_t m_normalized_height GUARDED_BY(cs){0};
+
     CFeeRate GetMinFee(size_t sizelimit) const;
 
 public:
@@ -760,7 +783,17 @@ public:
         return m_sequence_number;
     }
 
+    /** The height to which the normalized fees of all entries are adjusted. */
+    int32_t GetNormalizedHeight() const EXCLUSIVE_LOCKS_REQUIRED(cs) {
+        return m_normalized_height;
+    }
+
 private:
+    /** Renormalize the fees of every entry to the given height, if it has
+     *  drifted at least MEMPOOL_NORMALIZATION_INTERVAL blocks from the
+     *  current normalization height. */
+    void MaybeRenormalize(int32_t height) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** UpdateForDescendants is used by UpdateTransactionsFromBlock to update
      *  the descendants for a single transaction that has been added to the
      *  mempool but may have child transactions in the mempool, eg during a
@@ -866,6 +899,9 @@ public:
     /** GetCoin, returning whether it exists and is not spent. Also updates m_non_base_coins if the
      * coin is not fetched from base. */
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    /** As GetCoin, for several outpoints at once. The outpoints not provided by the package or the
+     * mempool are fetched from base in one batch. */
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     /** Add the coins created by this transaction. These coins are only temporarily stored in
      * m_temp_added and cannot be flushed to the back end. Only used for package validation. */
     void PackageAddTransaction(const CTransactionRef& tx);
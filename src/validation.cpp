@@ -43,6 +43,7 @@
 #include <logging.h>
 #include <logging/timer.h>
 #include <node/abort.h> // for node::AbortNode
+#include <node/blockprefetch.h>
 #include <node/blockstorage.h>
 #include <node/utxo_snapshot.h>
 #include <policy/v3_policy.h>
@@ -68,6 +69,7 @@
 #include <util/fs_helpers.h>
 #include <util/hasher.h>
 #include <util/moneystr.h>
+#include <util/overloaded.h>
 #include <util/rbf.h>
 #include <util/result.h>
 #include <util/signalinterrupt.h>
@@ -75,6 +77,7 @@
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
+#include <util/vector.h>
 #include <validationinterface.h>
 #include <warnings.h>
 
@@ -570,6 +573,11 @@ public:
     /** Clean up all non-chainstate coins from m_view and m_viewmempool. */
     void CleanupTemporaryCoins() EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    /** Load the confirmed coins spent by a package into the coins tip cache in a single batch,
+     * rather than one at a time as each transaction's inputs are checked. The coins brought into
+     * the cache are added to args.m_coins_to_uncache. */
+    void PrefetchPackageInputs(const std::vector<CTransactionRef>& txns, ATMPArgs& args) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Single transaction acceptance
     MempoolAcceptResult AcceptSingleTransaction(const CTransactionRef& ptx, ATMPArgs& args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -802,7 +810,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
 
     const CCoinsViewCache& coins_cache = m_active_chainstate.CoinsTip();
     // do all inputs exist?
-    const BlockFinalTxEntry& final_tx = m_view.GetFinalTx();
+    const BlockFinalTxEntry final_tx{m_active_chainstate.GetFinalTxState().final_tx};
     for (const CTxIn& txin : tx.vin) {
         if (txin.prevout.hash == final_tx.hash && txin.prevout.n < final_tx.size) {
             return state.Invalid(TxValidationResult::TX_SPEND_BLOCK_FINAL, "spend-block-final-txn");
@@ -1310,6 +1318,39 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
                                         effective_feerate, single_wtxid);
 }
 
+void MemPoolAccept::PrefetchPackageInputs(const std::vector<CTransactionRef>& txns, ATMPArgs& args)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    std::vector<Txid> package_txids;
+    package_txids.reserve(txns.size());
+    for (const auto& tx : txns) {
+        package_txids.push_back(tx->GetHash());
+    }
+    std::sort(package_txids.begin(), package_txids.end());
+
+    const CCoinsViewCache& coins_cache = m_active_chainstate.CoinsTip();
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : txns) {
+        for (const CTxIn& txin : tx->vin) {
+            // Coins created by the package or the mempool are not in the chainstate.
+            if (std::binary_search(package_txids.begin(), package_txids.end(), txin.prevout.hash)) continue;
+            if (m_pool.exists(GenTxid::Txid(txin.prevout.hash))) continue;
+            if (coins_cache.HaveCoinInCache(txin.prevout)) continue;
+            outpoints.push_back(txin.prevout);
+        }
+    }
+    std::sort(outpoints.begin(), outpoints.end());
+    outpoints.erase(std::unique(outpoints.begin(), outpoints.end()), outpoints.end());
+    if (outpoints.size() <= 1) return;
+
+    const std::vector<std::optional<Coin>> coins{coins_cache.GetCoins(outpoints)};
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (coins[i]) args.m_coins_to_uncache.push_back(outpoints[i]);
+    }
+}
+
 PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::vector<CTransactionRef>& txns, ATMPArgs& args)
 {
     AssertLockHeld(cs_main);
@@ -1326,6 +1367,8 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
 
     LOCK(m_pool.cs);
 
+    PrefetchPackageInputs(txns, args);
+
     // Do all PreChecks first and fail fast to avoid running expensive script checks when unnecessary.
     for (Workspace& ws : workspaces) {
         if (!PreChecks(args, ws)) {
@@ -1743,13 +1786,15 @@ CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
 }
 
 CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options)
-    : m_dbview{std::move(db_params), std::move(options)},
-      m_catcherview(&m_dbview) {}
+    : m_dbview{std::move(db_params), options},
+      m_catcherview(&m_dbview),
+      m_flushview(&m_catcherview),
+      m_background_flush(options.background_flush) {}
 
 void CoinsViews::InitCache()
 {
     AssertLockHeld(::cs_main);
-    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview = std::make_unique<CCoinsViewCache>(&m_flushview);
 }
 
 Chainstate::Chainstate(
@@ -1899,13 +1944,110 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, CTxUndo &txund
     AddCoins(inputs, tx, nHeight);
 }
 
-bool CScriptCheck::operator()() {
+bool CScriptCheck::Verify(SchnorrBatch* batch) {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
-    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.GetReferenceValue(), refheight, cacheStore, *txdata), &error);
+    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.GetReferenceValue(), refheight, cacheStore, *txdata, TxSigCheckOpt::NONE, batch), &error);
+}
+
+bool CTxInputsCheck::operator()() const
+{
+    const CTransaction& tx = *m_tx;
+    m_result->checked = true;
+    CAmount txfee = 0;
+    if (!Consensus::CheckTxInputs(tx, m_result->state, *m_spent_coins, *m_params, m_per_input_adjustment, m_block->nHeight, m_rules, txfee)) {
+        return true;
+    }
+    m_result->fee = GetTimeAdjustedValue(txfee, m_block->nHeight - (int)tx.lock_height);
+
+    std::vector<int> prevheights(tx.vin.size());
+    for (size_t j = 0; j < tx.vin.size(); j++) {
+        prevheights[j] = (*m_spent_coins)[j].nHeight;
+    }
+    m_result->sequence_locks = SequenceLocks(tx, m_lock_time_flags, prevheights, *m_block);
+
+    m_result->sigops_cost = GetTransactionSigOpCost(tx, *m_spent_coins, m_flags);
+    return true;
+}
+
+bool CCoinFetch::operator()() const
+{
+    try {
+        m_db->GetCoin(*m_outpoint, *m_coin);
+    } catch (const std::runtime_error&) {
+        m_coin->Clear();
+    }
+    return true;
+}
+
+bool CValidationCheck::operator()(SchnorrBatch& batch)
+{
+    return std::visit(util::Overloaded{
+        [&](CScriptCheck& check) { return check(batch); },
+        [](const auto& check) { return check(); },
+    }, m_check);
+}
+
+void PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, const CCoinsView& db, CCheckQueue<CValidationCheck>& check_queue)
+{
+    // Outputs created by the block itself are not in the database yet.
+    std::vector<Txid> block_txids;
+    block_txids.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        block_txids.push_back(tx->GetHash());
+    }
+    std::sort(block_txids.begin(), block_txids.end());
+
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (std::binary_search(block_txids.begin(), block_txids.end(), txin.prevout.hash)) continue;
+            if (cache.HaveCoinInCache(txin.prevout)) continue;
+            outpoints.push_back(txin.prevout);
+        }
+    }
+    // A single missing coin is not worth handing off to the worker threads.
+    if (outpoints.size() <= 1) {
+        return;
+    }
+    // Reading the database in key order gives each worker, which takes its
+    // batches from a contiguous range of the queue, runs of adjacent keys.
+    std::sort(outpoints.begin(), outpoints.end());
+    outpoints.erase(std::unique(outpoints.begin(), outpoints.end()), outpoints.end());
+
+    if (!check_queue.HasThreads()) {
+        // Without worker threads, still read the coins in one batch, which
+        // the database serves in key order from a single snapshot.
+        std::vector<std::optional<Coin>> fetched{db.GetCoins(outpoints)};
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            if (fetched[i]) {
+                cache.InsertFetchedCoin(std::move(outpoints[i]), std::move(*fetched[i]));
+            }
+        }
+        return;
+    }
+
+    std::vector<Coin> coins(outpoints.size());
+    {
+        CCheckQueueControl<CValidationCheck> control(&check_queue);
+        std::vector<CValidationCheck> checks;
+        checks.reserve(outpoints.size());
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            checks.emplace_back(CCoinFetch(db, outpoints[i], coins[i]));
+        }
+        control.Add(std::move(checks));
+        control.Wait();
+    }
+
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (!coins[i].IsSpent()) {
+            cache.InsertFetchedCoin(std::move(outpoints[i]), std::move(coins[i]));
+        }
+    }
 }
 
-static CuckooCache::cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
+static CuckooCache::sharded_cache<uint256, SignatureCacheHasher, VALIDATION_CACHE_SHARD_BITS> g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
 
 bool InitScriptExecutionCache(size_t max_size_bytes)
@@ -1927,6 +2069,11 @@ bool InitScriptExecutionCache(size_t max_size_bytes)
     return true;
 }
 
+CuckooCache::cache_stats GetScriptExecutionCacheStats()
+{
+    return g_scriptExecutionCache.stats();
+}
+
 /**
  * Check whether all of this transaction's input scripts succeed.
  *
@@ -1965,7 +2112,6 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     uint256 hashCacheEntry;
     CSHA256 hasher = g_scriptExecutionCacheHasher;
     hasher.Write(UCharCast(tx.GetWitnessHash().begin()), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
-    AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
     if (g_scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
         return true;
     }
@@ -2534,13 +2680,32 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
     // for as long as `control`.
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks ? &m_chainman.GetCheckQueue() : nullptr);
+    //
+    // The checks of each transaction which depend on the coins it spends but
+    // not on its scripts are run against its undo data on the same queue,
+    // and their results are reduced in block order afterwards so that the
+    // first failure reported does not depend on scheduling.  The results
+    // must outlive `control` too, and the undo data is preallocated below so
+    // that it is not moved while the checks run.
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
+    std::vector<CTxInputsCheck::Result> input_results(block.vtx.size());
+    CCheckQueueControl<CValidationCheck> control(parallel_script_checks ? &m_chainman.GetCheckQueue() : nullptr);
+    const auto input_check = [&](unsigned int i) {
+        return CTxInputsCheck(*block.vtx[i], blockundo.vtxundo[i - 1].vprevout, *pindex, params.GetConsensus(), !truncate_inputs + !use_alu, rules, nLockTimeFlags, flags, input_results[i]);
+    };
+
+    // The index of the transaction, if any, which failed one of the checks
+    // made in this loop, and the state of its failed script check.
+    std::optional<unsigned int> failed_tx;
+    TxValidationState script_state;
+
+    // The checks of the whole block are collected here and queued together
+    // after the loop, taking the queue's lock once rather than once per
+    // transaction.
+    std::vector<CValidationCheck> checks;
+    if (parallel_script_checks) checks.reserve(block.vtx.size() - 1);
 
-    std::vector<int> prevheights;
-    CAmount nFees = 0;
     int nInputs = 0;
-    int64_t nSigOpsCost = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
@@ -2548,17 +2713,74 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
         nInputs += tx.vin.size();
 
+        if (tx.IsCoinBase()) {
+            // GetTransactionSigOpCost only counts legacy sigops of a coinbase.
+            input_results[i].sigops_cost = GetTransactionSigOpCost(tx, view, flags);
+        } else if (!view.HaveInputs(tx)) {
+            // Nothing else can be checked without the spent coins, so this is
+            // reported as soon as all prior transactions have been checked.
+            CAmount txfee = 0;
+            bool inputs_ok = Consensus::CheckTxInputs(tx, input_results[i].state, view, params.GetConsensus(), !truncate_inputs + !use_alu, pindex->nHeight, rules, txfee);
+            assert(!inputs_ok);
+            input_results[i].checked = true;
+            failed_tx = i;
+            break;
+        }
+
+        std::vector<CScriptCheck> vChecks;
         if (!tx.IsCoinBase())
         {
-            CAmount txfee = 0;
-            TxValidationState tx_state;
-            if (!Consensus::CheckTxInputs(tx, tx_state, view, params.GetConsensus(), !truncate_inputs + !use_alu, pindex->nHeight, rules, txfee)) {
+            bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
+            if (fScriptChecks && !CheckInputScripts(tx, script_state, view, params.GetConsensus(), !truncate_inputs + !use_alu, flags, fCacheResults, fCacheResults, txsdata[i], parallel_script_checks ? &vChecks : nullptr)) {
+                // The input checks of this transaction take precedence, so
+                // they are still queued below.
+                failed_tx = i;
+            }
+        }
+
+        CTxUndo undoDummy;
+        if (i > 0) {
+            blockundo.vtxundo.emplace_back();
+        }
+        UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
+
+        if (!tx.IsCoinBase()) {
+            if (parallel_script_checks) {
+                checks.emplace_back(input_check(i));
+                for (CScriptCheck& check : vChecks) {
+                    checks.emplace_back(std::move(check));
+                }
+            } else {
+                input_check(i)();
+            }
+        }
+
+        if (failed_tx) break;
+    }
+    control.Add(std::move(checks));
+    const bool checks_ok{control.Wait()};
+
+    CAmount nFees = 0;
+    int64_t nSigOpsCost = 0;
+    for (unsigned int i = 0; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = *(block.vtx[i]);
+        const CTxInputsCheck::Result& result = input_results[i];
+
+        if (!tx.IsCoinBase())
+        {
+            // The queue skips the remaining checks once a script check has
+            // failed, so run any input checks it skipped here.
+            if (!result.checked) {
+                input_check(i)();
+            }
+            if (!result.state.IsValid()) {
                 // Any transaction validation failure in ConnectBlock is a block consensus failure
                 state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
-                            tx_state.GetRejectReason(), tx_state.GetDebugMessage());
+                            result.state.GetRejectReason(), result.state.GetDebugMessage());
                 return error("%s: Consensus::CheckTxInputs: %s, %s", __func__, tx.GetHash().ToString(), state.ToString());
             }
-            nFees += GetTimeAdjustedValue(txfee, pindex->nHeight - (int)tx.lock_height) + !use_alu;
+            nFees += result.fee + !use_alu;
 
             if (!MoneyRange(nFees)) {
                 LogPrintf("ERROR: %s: accumulated fee in the block out of range.\n", __func__);
@@ -2568,12 +2790,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
             // Check that transaction is BIP68 final
             // BIP68 lock checks (as opposed to nLockTime checks) must
             // be in ConnectBlock because they require the UTXO set
-            prevheights.resize(tx.vin.size());
-            for (size_t j = 0; j < tx.vin.size(); j++) {
-                prevheights[j] = view.AccessCoin(tx.vin[j].prevout).nHeight;
-            }
-
-            if (!SequenceLocks(tx, nLockTimeFlags, prevheights, *pindex)) {
+            if (!result.sequence_locks) {
                 LogPrintf("ERROR: %s: contains a non-BIP68-final transaction\n", __func__);
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-nonfinal");
             }
@@ -2582,32 +2799,19 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         // GetTransactionSigOpCost counts 2 types of sigops:
         // * legacy (always)
         // * p2sh (when P2SH enabled in flags and excludes coinbase)
-        nSigOpsCost += GetTransactionSigOpCost(tx, view, flags);
+        nSigOpsCost += result.sigops_cost;
         if (!(rules & Consensus::PROTOCOL_CLEANUP) && nSigOpsCost > MAX_BLOCK_SIGOPS_COST) {
             LogPrintf("ERROR: ConnectBlock(): too many sigops\n");
             return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-sigops");
         }
 
-        if (!tx.IsCoinBase())
-        {
-            std::vector<CScriptCheck> vChecks;
-            bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            TxValidationState tx_state;
-            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, params.GetConsensus(), !truncate_inputs + !use_alu, flags, fCacheResults, fCacheResults, txsdata[i], parallel_script_checks ? &vChecks : nullptr)) {
-                // Any transaction validation failure in ConnectBlock is a block consensus failure
-                state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
-                              tx_state.GetRejectReason(), tx_state.GetDebugMessage());
-                return error("ConnectBlock(): CheckInputScripts on %s failed with %s",
-                    tx.GetHash().ToString(), state.ToString());
-            }
-            control.Add(std::move(vChecks));
-        }
-
-        CTxUndo undoDummy;
-        if (i > 0) {
-            blockundo.vtxundo.emplace_back();
+        if (failed_tx == i) {
+            // Any transaction validation failure in ConnectBlock is a block consensus failure
+            state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
+                          script_state.GetRejectReason(), script_state.GetDebugMessage());
+            return error("ConnectBlock(): CheckInputScripts on %s failed with %s",
+                tx.GetHash().ToString(), state.ToString());
         }
-        UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
     }
     const auto time_3{SteadyClock::now()};
     time_connect += time_3 - time_2;
@@ -2628,7 +2832,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-amount");
     }
 
-    if (!control.Wait()) {
+    if (!checks_ok) {
         LogPrintf("ERROR: %s: CheckQueue failed\n", __func__);
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "block-validation-failed");
     }
@@ -2733,6 +2937,7 @@ bool Chainstate::FlushStateToDisk(
     assert(this->CanFlushToDisk());
     std::set<int> setFilesToPrune;
     bool full_flush_completed = false;
+    std::optional<CBlockLocator> background_flush_completed;
 
     const size_t coins_count = CoinsTip().GetCacheSize();
     const size_t coins_mem_usage = CoinsTip().DynamicMemoryUsage();
@@ -2803,6 +3008,18 @@ bool Chainstate::FlushStateToDisk(
         bool fPeriodicFlush = mode == FlushStateMode::PERIODIC && nNow > m_last_flush + DATABASE_FLUSH_INTERVAL;
         // Combine all conditions that result in a full cache flush.
         fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
+        // Collect a finished background flush of the coins cache, or wait for
+        // an unfinished one if we are about to flush again, so that it is
+        // complete before any block files are pruned.
+        auto& flush_view{m_coins_views->m_flushview};
+        if (m_background_flush_locator && (fDoFullFlush || !flush_view.IsWriting())) {
+            LOG_TIME_MILLIS_WITH_CATEGORY("wait for background coins flush", BCLog::BENCH);
+            if (!flush_view.Wait()) {
+                return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+            }
+            background_flush_completed = std::move(m_background_flush_locator);
+            m_background_flush_locator.reset();
+        }
         // Write blocks and block index to disk.
         if (fDoFullFlush || fPeriodicWrite) {
             // Ensure we can write block index
@@ -2849,11 +3066,24 @@ bool Chainstate::FlushStateToDisk(
             if (!CheckDiskSpace(m_chainman.m_options.datadir, 48 * 2 * 2 * CoinsTip().GetCacheSize())) {
                 return FatalError(m_chainman.GetNotifications(), state, "Disk space is too low!", _("Disk space is too low!"));
             }
+            // Routine flushes may be left to complete in the background, as
+            // the database records the blocks it is transitioning between and
+            // can be recovered with ReplayBlocks. Forced flushes and flushes
+            // before pruning must be complete when we return.
+            const bool background{m_coins_views->m_background_flush && mode != FlushStateMode::ALWAYS && !fFlushForPrune};
+            if (background) flush_view.WriteNextInBackground();
             // Flush the chainstate (which may refer to block index entries).
             if (!CoinsTip().Flush())
                 return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
             m_last_flush = nNow;
-            full_flush_completed = true;
+            if (flush_view.IsWriting()) {
+                m_background_flush_locator = m_chain.GetLocator();
+            } else {
+                if (!flush_view.Wait()) {
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+                }
+                full_flush_completed = true;
+            }
             TRACE5(utxocache, flush,
                    int64_t{Ticks<std::chrono::microseconds>(SteadyClock::now() - nNow)},
                    (uint32_t)mode,
@@ -2862,6 +3092,9 @@ bool Chainstate::FlushStateToDisk(
                    (bool)fFlushForPrune);
         }
     }
+    if (background_flush_completed) {
+        GetMainSignals().ChainStateFlushed(this->GetRole(), *background_flush_completed);
+    }
     if (full_flush_completed) {
         // Update best block in wallet (so we can detect restored wallets).
         GetMainSignals().ChainStateFlushed(this->GetRole(), m_chain.GetLocator());
@@ -2917,10 +3150,24 @@ static void UpdateTipLog(
         !warning_messages.empty() ? strprintf(" warning='%s'", warning_messages) : "");
 }
 
+void Chainstate::UpdateFinalTxState()
+{
+    AssertLockHeld(::cs_main);
+    const CBlockIndex* tip{m_chain.Tip()};
+    FinalTxState state{
+        .tip_hash = tip ? tip->GetBlockHash() : uint256{},
+        .tip_height = tip ? tip->nHeight : -1,
+        .final_tx = CoinsTip().GetFinalTx(),
+    };
+    LOCK(m_final_tx_mutex);
+    m_final_tx_state = std::move(state);
+}
+
 void Chainstate::UpdateTip(const CBlockIndex* pindexNew)
 {
     AssertLockHeld(::cs_main);
     const auto& coins_tip = this->CoinsTip();
+    UpdateFinalTxState();
 
     const CChainParams& params{m_chainman.GetParams()};
 
@@ -3114,6 +3361,10 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms\n",
              Ticks<MillisecondsDouble>(time_2 - time_1));
     {
+        // Warm the coins cache with the block's inputs, reading them from the
+        // database in parallel rather than one at a time as ConnectBlock
+        // reaches them.
+        PrefetchBlockInputs(blockConnecting, CoinsTip(), m_coins_views->m_flushview, m_chainman.GetCheckQueue());
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
         GetMainSignals().BlockChecked(blockConnecting, state);
@@ -3262,7 +3513,7 @@ void Chainstate::PruneBlockIndexCandidates() {
  *
  * @returns true unless a system error occurred
  */
-bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace)
+bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace, node::BlockPrefetcher* prefetcher)
 {
     AssertLockHeld(cs_main);
     if (m_mempool) AssertLockHeld(m_mempool->cs);
@@ -3307,7 +3558,12 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
 
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+            std::shared_ptr<const CBlock> block_connect{pindexConnect == pindexMostWork ? pblock : nullptr};
+            if (!block_connect && prefetcher) {
+                prefetcher->ReadAhead(pindexConnect->pprev, *pindexMostWork);
+                block_connect = prefetcher->Take(*pindexConnect).block;
+            }
+            if (!ConnectTip(state, pindexConnect, block_connect, connectTrace, disconnectpool)) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() != BlockValidationResult::BLOCK_MUTATED) {
@@ -3412,6 +3668,7 @@ bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<
     CBlockIndex *pindexMostWork = nullptr;
     CBlockIndex *pindexNewTip = nullptr;
     bool exited_ibd{false};
+    node::BlockPrefetcher* prefetcher{nullptr};
     do {
         // Block until the validation queue drains. This should largely
         // never happen in normal operation, however may happen during
@@ -3442,9 +3699,16 @@ bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<
                     break;
                 }
 
+                // When there is more than one block to connect, as during a
+                // reindex or when blocks have arrived out of order, read
+                // them from disk ahead of connecting them.
+                if (!prefetcher && pindexMostWork->nHeight > m_chain.Height() + 1) {
+                    prefetcher = &m_chainman.GetBlockPrefetcher();
+                }
+
                 bool fInvalidFound = false;
                 std::shared_ptr<const CBlock> nullBlockPtr;
-                if (!ActivateBestChainStep(state, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace)) {
+                if (!ActivateBestChainStep(state, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace, prefetcher)) {
                     // A system error occurred
                     return false;
                 }
@@ -3823,7 +4087,10 @@ void ChainstateManager::ReceivedBlockTransactions(const CBlock& block, CBlockInd
     }
 }
 
-static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
+/** Context-independent validity checks of a block header.  If fCheckPOW is
+ *  set and aux_hash is not null, it receives the auxiliary proof-of-work
+ *  hashes computed along the way. */
+static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, std::pair<uint256, uint256>* aux_hash = nullptr)
 {
     // Check that the variable-length auxiliary proof-of-work data are
     // within acceptable ranges.
@@ -3857,7 +4124,7 @@ static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& st
     }
 
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckAuxiliaryProofOfWork(block, consensusParams)) {
+    if (fCheckPOW && !CheckAuxiliaryProofOfWork(block, consensusParams, aux_hash)) {
         return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "aux-pow-invalid", "auxiliary proof of work failed");
     }
 
@@ -3868,7 +4135,7 @@ static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& st
     return true;
 }
 
-static bool CheckMerkleRoot(const CBlock& block, const Consensus::Params& consensusParams, BlockValidationState& state)
+static bool CheckMerkleRoot(const CBlock& block, const Consensus::Params& consensusParams, BlockValidationState& state, const std::pair<uint256, uint256>* aux_hash = nullptr)
 {
     if (block.m_checked_merkle_root) return true;
 
@@ -3893,17 +4160,22 @@ static bool CheckMerkleRoot(const CBlock& block, const Consensus::Params& consen
 
     // Merge mining checks.
     if (!block.m_aux_pow.IsNull()) {
-        // Check that auxiliary proof-of-work data have canonical encoding.
-        auto aux_hash = block.GetAuxiliaryHash(consensusParams, &mutated);
-        if (mutated) {
-            return state.Invalid(
-                /*result=*/BlockValidationResult::BLOCK_MUTATED,
-                /*reject_reason=*/"bad-auxpow-mutated",
-                /*debug_message=*/"auxiliary proof-of-work header is non-canonical (mutated)");
+        // Check that auxiliary proof-of-work data have canonical encoding,
+        // unless the caller already did so when checking the header.
+        std::pair<uint256, uint256> computed_aux_hash;
+        if (!aux_hash) {
+            computed_aux_hash = block.GetAuxiliaryHash(consensusParams, &mutated);
+            if (mutated) {
+                return state.Invalid(
+                    /*result=*/BlockValidationResult::BLOCK_MUTATED,
+                    /*reject_reason=*/"bad-auxpow-mutated",
+                    /*debug_message=*/"auxiliary proof-of-work header is non-canonical (mutated)");
+            }
+            aux_hash = &computed_aux_hash;
         }
 
         // The auxiliary proof-of-work is committed to in the coinbase string.
-        if (block.vtx.empty() || block.vtx[0]->vin.empty() || (block.vtx[0]->vin[0].scriptSig.size() < 32) || memcmp(aux_hash.second.begin(), &(block.vtx[0]->vin[0].scriptSig.end()-32)[0], 32)) {
+        if (block.vtx.empty() || block.vtx[0]->vin.empty() || (block.vtx[0]->vin[0].scriptSig.size() < 32) || memcmp(aux_hash->second.begin(), &(block.vtx[0]->vin[0].scriptSig.end()-32)[0], 32)) {
             return state.Invalid(
                 /*result=*/BlockValidationResult::BLOCK_CONSENSUS,
                 /*reject_reason=*/"bad-auxpow-commit",
@@ -4018,7 +4290,8 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
 
     // Check that the header is valid (particularly PoW).  This is mostly
     // redundant with the call in AcceptBlockHeader.
-    if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW))
+    std::pair<uint256, uint256> aux_hash;
+    if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW, &aux_hash))
         return false;
 
     // Signet only: check block solution
@@ -4027,7 +4300,7 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
     }
 
     // Check the merkle root.
-    if (fCheckMerkleRoot && !CheckMerkleRoot(block, consensusParams, state)) {
+    if (fCheckMerkleRoot && !CheckMerkleRoot(block, consensusParams, state, aux_hash.first.IsNull() ? nullptr : &aux_hash)) {
         return false;
     }
 
@@ -4119,10 +4392,27 @@ void ChainstateManager::GenerateCoinbaseCommitment(CBlock& block, const CBlockIn
     UpdateUncommittedBlockStructures(block, pindexPrev);
 }
 
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+bool CHeaderCheck::operator()() const
+{
+    return CheckAuxiliaryProofOfWork(*m_header, *m_params) && (IsProtocolCleanupActive(*m_params, std::chrono::seconds(m_header->nTime)) || CheckProofOfWork(*m_header, *m_params));
+}
+
+bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, CCheckQueue<CValidationCheck>* check_queue)
 {
+    // A lone header, as is usual for announcements near the tip, is not worth
+    // handing off to the worker threads.
+    if (check_queue && check_queue->HasThreads() && headers.size() > 1) {
+        CCheckQueueControl<CValidationCheck> control(check_queue);
+        std::vector<CValidationCheck> checks;
+        checks.reserve(headers.size());
+        for (const auto& header : headers) {
+            checks.emplace_back(CHeaderCheck(header, consensusParams));
+        }
+        control.Add(std::move(checks));
+        return control.Wait();
+    }
     return std::all_of(headers.cbegin(), headers.cend(),
-            [&](const auto& header) { return CheckAuxiliaryProofOfWork(header, consensusParams) && (IsProtocolCleanupActive(consensusParams, std::chrono::seconds(header.nTime)) || CheckProofOfWork(header, consensusParams));});
+            [&](const auto& header) { return CHeaderCheck(header, consensusParams)(); });
 }
 
 bool IsBlockMutated(const CBlock& block, const Consensus::Params& consensusParams, bool check_witness_root)
@@ -4328,6 +4618,7 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
 
     // Check for duplicate
     uint256 hash = block.GetHash();
+    std::pair<uint256, uint256> aux_hash;
     BlockMap::iterator miSelf{m_blockman.m_block_index.find(hash)};
     if (hash != GetConsensus().hashGenesisBlock) {
         if (miSelf != m_blockman.m_block_index.end()) {
@@ -4342,7 +4633,7 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, GetConsensus())) {
+        if (!CheckBlockHeader(block, state, GetConsensus(), /*fCheckPOW=*/true, &aux_hash)) {
             LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
             return false;
         }
@@ -4407,7 +4698,7 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
         LogPrint(BCLog::VALIDATION, "%s: not adding new block header %s, missing anti-dos proof-of-work validation\n", __func__, hash.ToString());
         return state.Invalid(BlockValidationResult::BLOCK_HEADER_LOW_WORK, "too-little-chainwork");
     }
-    CBlockIndex* pindex{m_blockman.AddToBlockIndex(block, m_best_header)};
+    CBlockIndex* pindex{m_blockman.AddToBlockIndex(block, m_best_header, aux_hash.first.IsNull() ? nullptr : &aux_hash)};
 
     if (ppindex)
         *ppindex = pindex;
@@ -4689,6 +4980,7 @@ bool Chainstate::LoadChainTip()
     const CBlockIndex* tip = m_chain.Tip();
 
     if (tip && tip->GetBlockHash() == coins_cache.GetBestBlock()) {
+        UpdateFinalTxState();
         return true;
     }
 
@@ -4699,6 +4991,7 @@ bool Chainstate::LoadChainTip()
     }
     m_chain.SetTip(*pindex);
     PruneBlockIndexCandidates();
+    UpdateFinalTxState();
 
     tip = m_chain.Tip();
     LogPrintf("Loaded best chain: hashBestChain=%s height=%d date=%s progress=%f\n",
@@ -5538,6 +5831,12 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // Resizing reopens the database, which must not be in the middle of a
+    // background write.
+    if (!m_coins_views->m_flushview.Wait()) {
+        BlockValidationState state;
+        return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+    }
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
@@ -5996,6 +6295,7 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     // The remainder of this function requires modifying data protected by cs_main.
     LOCK(::cs_main);
+    snapshot_chainstate.UpdateFinalTxState();
 
     // Fake various pieces of CBlockIndex state:
     CBlockIndex* index = nullptr;
@@ -6269,6 +6569,15 @@ ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Opt
 {
 }
 
+node::BlockPrefetcher& ChainstateManager::GetBlockPrefetcher()
+{
+    AssertLockHeld(::cs_main);
+    if (!m_block_prefetcher) {
+        m_block_prefetcher = std::make_unique<node::BlockPrefetcher>(m_blockman, /*read_undo=*/false);
+    }
+    return *m_block_prefetcher;
+}
+
 ChainstateManager::~ChainstateManager()
 {
     LOCK(::cs_main);
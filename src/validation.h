@@ -24,6 +24,7 @@
 #include <kernel/chain.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
+#include <cuckoocache.h>
 #include <deploymentstatus.h>
 #include <kernel/chainparams.h>
 #include <kernel/chainstatemanager_opts.h>
@@ -32,6 +33,7 @@
 #include <policy/feerate.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
+#include <pubkey.h>
 #include <script/script_error.h>
 #include <sync.h>
 #include <txdb.h>
@@ -55,6 +57,7 @@
 #include <thread>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 class Chainstate;
@@ -66,6 +69,7 @@ struct PrecomputedTransactionData;
 struct LockPoints;
 struct AssumeutxoData;
 namespace node {
+class BlockPrefetcher;
 class SnapshotMetadata;
 } // namespace node
 namespace Consensus {
@@ -562,6 +566,9 @@ private:
     ScriptError error{SCRIPT_ERR_UNKNOWN_ERROR};
     PrecomputedTransactionData *txdata;
 
+    //! Verify the script, deferring Schnorr signatures to batch if non-null.
+    bool Verify(SchnorrBatch* batch);
+
 public:
     CScriptCheck(const CTxOut& outIn, int64_t refheightIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
         m_tx_out(outIn), refheight(refheightIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), txdata(txdataIn) { }
@@ -571,7 +578,12 @@ public:
     CScriptCheck(CScriptCheck&&) = default;
     CScriptCheck& operator=(CScriptCheck&&) = default;
 
-    bool operator()();
+    bool operator()() { return Verify(nullptr); }
+
+    //! When run from the check queue, Schnorr signatures are verified together
+    //! with those of the other checks in the same worker batch.
+    using Batch = SchnorrBatch;
+    bool operator()(SchnorrBatch& batch) { return Verify(&batch); }
 
     ScriptError GetScriptError() const { return error; }
 };
@@ -581,9 +593,140 @@ static_assert(std::is_nothrow_move_assignable_v<CScriptCheck>);
 static_assert(std::is_nothrow_move_constructible_v<CScriptCheck>);
 static_assert(std::is_nothrow_destructible_v<CScriptCheck>);
 
+/**
+ * Closure representing the context-free proof-of-work checks of a single
+ * block header, so that the headers of a HEADERS message can be checked in
+ * parallel.  The referenced header and parameters must outlive the check.
+ */
+class CHeaderCheck
+{
+private:
+    const CBlockHeader* m_header;
+    const Consensus::Params* m_params;
+
+public:
+    CHeaderCheck(const CBlockHeader& header, const Consensus::Params& params) :
+        m_header(&header), m_params(&params) { }
+
+    bool operator()() const;
+};
+
+static_assert(std::is_nothrow_move_assignable_v<CHeaderCheck>);
+static_assert(std::is_nothrow_move_constructible_v<CHeaderCheck>);
+static_assert(std::is_nothrow_destructible_v<CHeaderCheck>);
+
+/**
+ * Closure representing the checks of a single transaction of a block being
+ * connected which depend on the coins it spends but not on its scripts: input
+ * values and maturity, BIP68 sequence locks and signature operation cost.  As
+ * the coins will already have been spent in the view by the time the check
+ * is run, it is run against the coins recorded in the transaction's undo data.
+ * Results are written out instead of returned, so that the caller can reduce
+ * them in block order.  Everything referenced must outlive the check.
+ */
+class CTxInputsCheck
+{
+public:
+    struct Result {
+        //! The result of Consensus::CheckTxInputs.
+        TxValidationState state;
+        //! The transaction fee, time-adjusted to the height of the block.
+        CAmount fee{0};
+        bool sequence_locks{true};
+        int64_t sigops_cost{0};
+        //! Whether the check has run.  A check queue stops running checks
+        //! once one has failed, so this might not be set if a script check
+        //! of the same block failed.
+        bool checked{false};
+    };
+
+private:
+    const CTransaction* m_tx;
+    const std::vector<Coin>* m_spent_coins;
+    const CBlockIndex* m_block;
+    const Consensus::Params* m_params;
+    int m_per_input_adjustment;
+    Consensus::RuleSet m_rules;
+    int m_lock_time_flags;
+    unsigned int m_flags;
+    Result* m_result;
+
+public:
+    CTxInputsCheck(const CTransaction& tx, const std::vector<Coin>& spent_coins, const CBlockIndex& block, const Consensus::Params& params, int per_input_adjustment, Consensus::RuleSet rules, int lock_time_flags, unsigned int flags, Result& result) :
+        m_tx(&tx), m_spent_coins(&spent_coins), m_block(&block), m_params(&params), m_per_input_adjustment(per_input_adjustment), m_rules(rules), m_lock_time_flags(lock_time_flags), m_flags(flags), m_result(&result) { }
+
+    //! Always returns true, so that every check in a batch is run.
+    bool operator()() const;
+};
+
+static_assert(std::is_nothrow_move_assignable_v<CTxInputsCheck>);
+static_assert(std::is_nothrow_move_constructible_v<CTxInputsCheck>);
+static_assert(std::is_nothrow_destructible_v<CTxInputsCheck>);
+
+/**
+ * Closure representing the read of a single coin from the chainstate
+ * database, so that the coins spent by a block can be read by several threads
+ * at once.  The coin is left spent if it is not found or cannot be read, in
+ * which case it is simply fetched again (and any error reported) when the
+ * block is connected.  Everything referenced must outlive the check.
+ */
+class CCoinFetch
+{
+private:
+    const CCoinsView* m_db;
+    const COutPoint* m_outpoint;
+    Coin* m_coin;
+
+public:
+    CCoinFetch(const CCoinsView& db, const COutPoint& outpoint, Coin& coin) :
+        m_db(&db), m_outpoint(&outpoint), m_coin(&coin) { }
+
+    //! Always returns true, as a missing coin is not an error here.
+    bool operator()() const;
+};
+
+static_assert(std::is_nothrow_move_assignable_v<CCoinFetch>);
+static_assert(std::is_nothrow_move_constructible_v<CCoinFetch>);
+static_assert(std::is_nothrow_destructible_v<CCoinFetch>);
+
+/**
+ * Any of the checks above, so that all of them are run by the one pool of
+ * check queue worker threads of the chainstate manager.  The Schnorr
+ * signatures of script checks are verified together with those of the other
+ * checks in the same worker batch.
+ */
+class CValidationCheck
+{
+private:
+    std::variant<CScriptCheck, CHeaderCheck, CTxInputsCheck, CCoinFetch> m_check;
+
+public:
+    explicit CValidationCheck(CScriptCheck&& check) : m_check(std::move(check)) { }
+    explicit CValidationCheck(const CHeaderCheck& check) : m_check(check) { }
+    explicit CValidationCheck(const CTxInputsCheck& check) : m_check(check) { }
+    explicit CValidationCheck(const CCoinFetch& check) : m_check(check) { }
+
+    using Batch = SchnorrBatch;
+    bool operator()(SchnorrBatch& batch);
+};
+
+static_assert(std::is_nothrow_move_assignable_v<CValidationCheck>);
+static_assert(std::is_nothrow_move_constructible_v<CValidationCheck>);
+static_assert(std::is_nothrow_destructible_v<CValidationCheck>);
+
+/**
+ * Load the coins spent by a block which are not already in the cache, reading
+ * them from the view beneath it in parallel on the check queue's worker
+ * threads, so that view must allow concurrent reads.  If the queue has no
+ * worker threads, they are read in a single GetCoins batch instead.
+ */
+void PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, const CCoinsView& db, CCheckQueue<CValidationCheck>& check_queue);
+
 /** Initializes the script-execution cache */
 [[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes);
 
+CuckooCache::cache_stats GetScriptExecutionCacheStats();
+
 /** Functions for validating blocks and updating the block tree */
 
 /** Context-independent validity checks */
@@ -598,8 +741,10 @@ bool TestBlockValidity(BlockValidationState& state,
                        bool fCheckPOW = true,
                        bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-/** Check with the proof of work on each blockheader matches the value in nBits */
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
+/** Check with the proof of work on each blockheader matches the value in nBits.
+ *  If check_queue is not null and has worker threads, the headers are checked
+ *  in parallel. */
+bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, CCheckQueue<CValidationCheck>* check_queue = nullptr);
 
 /** Check if a block has been mutated (with respect to its merkle root and witness commitments). */
 bool IsBlockMutated(const CBlock& block, const Consensus::Params& consensusParams, bool check_witness_root);
@@ -668,6 +813,13 @@ public:
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
+    //! This view holds coins flushed from the cache while they are written to
+    //! the database in the background, if enabled.
+    CCoinsViewBackgroundFlush m_flushview GUARDED_BY(cs_main);
+
+    //! Whether routine flushes of the cache are written in the background.
+    const bool m_background_flush;
+
     //! This is the top layer of the cache hierarchy - it keeps as many coins in memory as
     //! can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
@@ -827,6 +979,23 @@ public:
         return *Assert(m_coins_views->m_cacheview);
     }
 
+    //! The block-final transaction entry of the UTXO set, and the tip it
+    //! belongs to.
+    struct FinalTxState {
+        uint256 tip_hash;
+        int tip_height{-1};
+        BlockFinalTxEntry final_tx;
+    };
+
+    //! @returns The block-final transaction state as of the last tip update.
+    //!     This does not need cs_main, but the tip may have moved on by the
+    //!     time the caller looks at it, which tip_hash allows it to detect.
+    FinalTxState GetFinalTxState() const EXCLUSIVE_LOCKS_REQUIRED(!m_final_tx_mutex)
+    {
+        LOCK(m_final_tx_mutex);
+        return m_final_tx_state;
+    }
+
     //! @returns A reference to the on-disk UTXO set database.
     CCoinsViewDB& CoinsDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
     {
@@ -979,7 +1148,7 @@ public:
     }
 
 private:
-    bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace, node::BlockPrefetcher* prefetcher) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
     bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
 
     void InvalidBlockFound(CBlockIndex* pindex, const BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -1011,8 +1180,17 @@ private:
     void UpdateTip(const CBlockIndex* pindexNew)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    //! Copy the tip and its block-final transaction entry to m_final_tx_state.
+    void UpdateFinalTxState() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_final_tx_mutex);
+
+    mutable Mutex m_final_tx_mutex;
+    FinalTxState m_final_tx_state GUARDED_BY(m_final_tx_mutex);
+
     SteadyClock::time_point m_last_write{};
     SteadyClock::time_point m_last_flush{};
+    //! The chain the coins database is being brought to by a background
+    //! flush, to be announced through ChainStateFlushed once it is written.
+    std::optional<CBlockLocator> m_background_flush_locator GUARDED_BY(::cs_main);
 
     /**
      * In case of an invalid snapshot, rename the coins leveldb directory so
@@ -1145,8 +1323,11 @@ private:
         return cs && !cs->m_disabled;
     }
 
-    //! A queue for script verifications that have to be performed by worker threads.
-    CCheckQueue<CScriptCheck> m_script_check_queue;
+    //! A queue for script verifications that have to be performed by worker
+    //! threads.  The same threads also check the proof-of-work of batches of
+    //! headers from peers, the inputs of the transactions of a block being
+    //! connected, and read the coins it spends from the database beforehand.
+    CCheckQueue<CValidationCheck> m_script_check_queue;
 
 public:
     using Options = kernel::ChainstateManagerOpts;
@@ -1191,6 +1372,12 @@ public:
     //! chainstate to avoid duplicating block metadata.
     node::BlockManager m_blockman;
 
+    //! Reads blocks ahead of ActivateBestChain when it has more than one to
+    //! connect.  Created on first use and kept, with its threads, for the
+    //! lifetime of the manager.  Declared after m_blockman, which its threads
+    //! read from, so that it is destroyed first.
+    std::unique_ptr<node::BlockPrefetcher> m_block_prefetcher GUARDED_BY(::cs_main);
+
     /**
      * Whether initial block download has ended and IsInitialBlockDownload
      * should return false from now on.
@@ -1498,7 +1685,10 @@ public:
     //! nullopt.
     std::optional<int> GetSnapshotBaseHeight() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
-    CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
+    CCheckQueue<CValidationCheck>& GetCheckQueue() { return m_script_check_queue; }
+
+    //! Get the block prefetcher, starting it if it has not been used yet.
+    node::BlockPrefetcher& GetBlockPrefetcher() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     ~ChainstateManager();
 };
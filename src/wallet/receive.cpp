@@ -303,10 +303,66 @@ bool CachedTxIsTrusted(const CWallet& wallet, const CWalletTx& wtx)
     return CachedTxIsTrusted(wallet, wtx, trusted_parents);
 }
 
-Balance GetBalance(const CWallet& wallet, const int min_depth, bool avoid_reuse)
+//! The nominal credits a transaction contributes to GetBalance(), which are
+//! denominated at its reference height.
+static Balance GetTxBalanceCredits(const CWallet& wallet, const CWalletTx& wtx, const int min_depth, bool avoid_reuse, std::set<uint256>& trusted_parents) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet)
 {
+    AssertLockHeld(wallet.cs_wallet);
     Balance ret;
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
+    const bool is_trusted{CachedTxIsTrusted(wallet, wtx, trusted_parents)};
+    const int tx_depth{wallet.GetTxDepthInMainChain(wtx)};
+    const CAmount tx_credit_mine{CachedTxGetAvailableCredit(wallet, wtx, ISMINE_SPENDABLE | reuse_filter)};
+    const CAmount tx_credit_watchonly{CachedTxGetAvailableCredit(wallet, wtx, ISMINE_WATCH_ONLY | reuse_filter)};
+    if (is_trusted && tx_depth >= min_depth) {
+        ret.m_mine_trusted += tx_credit_mine;
+        ret.m_watchonly_trusted += tx_credit_watchonly;
+    }
+    if (!is_trusted && tx_depth == 0 && wtx.InMempool()) {
+        ret.m_mine_untrusted_pending += tx_credit_mine;
+        ret.m_watchonly_untrusted_pending += tx_credit_watchonly;
+    }
+    ret.m_mine_immature += CachedTxGetImmatureCredit(wallet, wtx, ISMINE_SPENDABLE);
+    ret.m_watchonly_immature += CachedTxGetImmatureCredit(wallet, wtx, ISMINE_WATCH_ONLY);
+    return ret;
+}
+
+static bool IsEmpty(const Balance& bal)
+{
+    return !bal.m_mine_trusted && !bal.m_mine_untrusted_pending && !bal.m_mine_immature &&
+           !bal.m_watchonly_trusted && !bal.m_watchonly_untrusted_pending && !bal.m_watchonly_immature;
+}
+
+static void AddBalance(Balance& sum, const Balance& bal, int sign)
+{
+    sum.m_mine_trusted += sign * bal.m_mine_trusted;
+    sum.m_mine_untrusted_pending += sign * bal.m_mine_untrusted_pending;
+    sum.m_mine_immature += sign * bal.m_mine_immature;
+    sum.m_watchonly_trusted += sign * bal.m_watchonly_trusted;
+    sum.m_watchonly_untrusted_pending += sign * bal.m_watchonly_untrusted_pending;
+    sum.m_watchonly_immature += sign * bal.m_watchonly_immature;
+}
+
+//! Replace a transaction's contribution to a balance cache with its current
+//! credits, erasing it if the transaction no longer contributes anything.
+static void UpdateBalanceCache(CWallet::BalanceCache& cache, const uint256& hash, const CWalletTx* wtx, const Balance& credits)
+{
+    if (auto it = cache.contributions.find(hash); it != cache.contributions.end()) {
+        const auto& [lock_height, old_credits] = it->second;
+        auto sum = cache.sums.find(lock_height);
+        AddBalance(sum->second, old_credits, -1);
+        if (IsEmpty(sum->second)) cache.sums.erase(sum);
+        cache.contributions.erase(it);
+    }
+    if (wtx && !IsEmpty(credits)) {
+        AddBalance(cache.sums[wtx->tx->lock_height], credits, +1);
+        cache.contributions.emplace(hash, std::make_pair(wtx->tx->lock_height, credits));
+    }
+}
+
+Balance GetBalance(const CWallet& wallet, const int min_depth, bool avoid_reuse)
+{
+    Balance ret;
     {
         const auto chain_height = wallet.chain().getHeight();
         if (!chain_height) {
@@ -315,23 +371,57 @@ Balance GetBalance(const CWallet& wallet, const int min_depth, bool avoid_reuse)
         const uint32_t next_height = static_cast<uint32_t>(chain_height.value()) + 1;
         LOCK(wallet.cs_wallet);
         std::set<uint256> trusted_parents;
-        for (const auto& entry : wallet.mapWallet)
-        {
-            const CWalletTx& wtx = entry.second;
-            const bool is_trusted{CachedTxIsTrusted(wallet, wtx, trusted_parents)};
-            const int tx_depth{wallet.GetTxDepthInMainChain(wtx)};
-            const CAmount tx_credit_mine{GetTimeAdjustedValue(CachedTxGetAvailableCredit(wallet, wtx, ISMINE_SPENDABLE | reuse_filter), next_height - wtx.tx->lock_height)};
-            const CAmount tx_credit_watchonly{GetTimeAdjustedValue(CachedTxGetAvailableCredit(wallet, wtx, ISMINE_WATCH_ONLY | reuse_filter), next_height - wtx.tx->lock_height)};
-            if (is_trusted && tx_depth >= min_depth) {
-                ret.m_mine_trusted += tx_credit_mine;
-                ret.m_watchonly_trusted += tx_credit_watchonly;
+        auto get_credits = [&](const CWalletTx& wtx, bool avoid_reuse) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
+            Balance credits{GetTxBalanceCredits(wallet, wtx, min_depth, avoid_reuse, trusted_parents)};
+            if (credits.m_mine_immature || credits.m_watchonly_immature) {
+                wallet.m_balance_immature.insert(wtx.GetHash());
             }
-            if (!is_trusted && tx_depth == 0 && wtx.InMempool()) {
-                ret.m_mine_untrusted_pending += tx_credit_mine;
-                ret.m_watchonly_untrusted_pending += tx_credit_watchonly;
+            return credits;
+        };
+        // The nominal credits are summed per reference height, so that
+        // demurrage is applied once for each height, to the total amount
+        // denominated at that height.  For the default min_depth the sums are
+        // kept up to date as the wallet changes, by recomputing only the
+        // transactions which have been marked dirty since the last call.
+        std::map<uint32_t, Balance> uncached_sums;
+        const std::map<uint32_t, Balance>* sums{&uncached_sums};
+        if (min_depth != 0) {
+            for (const auto& [_, wtx] : wallet.mapWallet) {
+                AddBalance(uncached_sums[wtx.tx->lock_height], GetTxBalanceCredits(wallet, wtx, min_depth, avoid_reuse, trusted_parents), +1);
             }
-            ret.m_mine_immature += GetTimeAdjustedValue(CachedTxGetImmatureCredit(wallet, wtx, ISMINE_SPENDABLE), next_height - wtx.tx->lock_height);
-            ret.m_watchonly_immature += GetTimeAdjustedValue(CachedTxGetImmatureCredit(wallet, wtx, ISMINE_WATCH_ONLY), next_height - wtx.tx->lock_height);
+        } else {
+            for (const uint256& hash : wallet.m_balance_dirty) {
+                const CWalletTx* wtx{wallet.GetWalletTx(hash)};
+                wallet.m_balance_immature.erase(hash);
+                for (size_t reuse = 0; reuse < wallet.m_balance_cache.size(); ++reuse) {
+                    auto& cache = wallet.m_balance_cache[reuse];
+                    if (!cache) continue;
+                    UpdateBalanceCache(*cache, hash, wtx, wtx ? get_credits(*wtx, reuse) : Balance{});
+                }
+            }
+            wallet.m_balance_dirty.clear();
+            auto& cache = wallet.m_balance_cache[avoid_reuse];
+            if (!cache) {
+                cache.emplace();
+                for (const auto& [hash, wtx] : wallet.mapWallet) {
+                    UpdateBalanceCache(*cache, hash, &wtx, get_credits(wtx, avoid_reuse));
+                }
+            }
+            sums = &cache->sums;
+        }
+        for (const auto& [lock_height, sum] : *sums) {
+            const int relative_depth = next_height - lock_height;
+            const DemurrageFactor factor{GetDemurrageFactor(std::max(relative_depth, 0))};
+            auto adjust = [&](CAmount& field, CAmount value) {
+                field += relative_depth < 0 ? GetTimeAdjustedValue(value, relative_depth)
+                                            : TimeAdjustValueForward(value, factor);
+            };
+            adjust(ret.m_mine_trusted, sum.m_mine_trusted);
+            adjust(ret.m_mine_untrusted_pending, sum.m_mine_untrusted_pending);
+            adjust(ret.m_mine_immature, sum.m_mine_immature);
+            adjust(ret.m_watchonly_trusted, sum.m_watchonly_trusted);
+            adjust(ret.m_watchonly_untrusted_pending, sum.m_watchonly_untrusted_pending);
+            adjust(ret.m_watchonly_immature, sum.m_watchonly_immature);
         }
     }
     return ret;
@@ -25,6 +25,7 @@
 
 #include <addresstype.h>
 #include <interfaces/chain.h>
+#include <kernel/chain.h>
 #include <key_io.h>
 #include <node/blockstorage.h>
 #include <policy/policy.h>
@@ -660,6 +661,73 @@ BOOST_FIXTURE_TEST_CASE(ListCoinsTest, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+// Check that the balance computed from GetBalance()'s running sums matches the
+// balance computed by walking the wallet, as the wallet is notified of new
+// transactions and blocks, and when only the chain height has advanced.
+BOOST_FIXTURE_TEST_CASE(balance_cache, ListCoinsTestingSetup)
+{
+    auto check_balance = [&](const Balance& balance) {
+        WITH_LOCK(wallet->cs_wallet, wallet->MarkBalanceDirty());
+        const Balance expected{GetBalance(*wallet)};
+        BOOST_CHECK_EQUAL(balance.m_mine_trusted, expected.m_mine_trusted);
+        BOOST_CHECK_EQUAL(balance.m_mine_untrusted_pending, expected.m_mine_untrusted_pending);
+        BOOST_CHECK_EQUAL(balance.m_mine_immature, expected.m_mine_immature);
+        BOOST_CHECK_EQUAL(balance.m_watchonly_trusted, expected.m_watchonly_trusted);
+        BOOST_CHECK_EQUAL(balance.m_watchonly_untrusted_pending, expected.m_watchonly_untrusted_pending);
+        BOOST_CHECK_EQUAL(balance.m_watchonly_immature, expected.m_watchonly_immature);
+    };
+    auto is_cached = [&] { return WITH_LOCK(wallet->cs_wallet, return wallet->m_balance_cache[/*avoid_reuse=*/true].has_value()); };
+
+    const Balance initial{GetBalance(*wallet)};
+    BOOST_CHECK(is_cached());
+    BOOST_CHECK_GT(initial.m_mine_trusted, 0);
+    BOOST_CHECK_GT(initial.m_mine_immature, 0);
+    check_balance(initial);
+
+    // Only the default min_depth is cached.
+    GetBalance(*wallet, /*min_depth=*/1, /*avoid_reuse=*/false);
+    BOOST_CHECK(WITH_LOCK(wallet->cs_wallet, return !wallet->m_balance_cache[/*avoid_reuse=*/false].has_value()));
+
+    // Committing a transaction marks it and the transaction it spends from
+    // dirty, without discarding the running sums.
+    GetBalance(*wallet);
+    CTransactionRef tx;
+    {
+        CCoinControl dummy;
+        auto res = CreateTransaction(*wallet, {CRecipient{PubKeyDestination{{}}, 1 * COIN, /*subtract_fee=*/false}}, /*refheight=*/std::nullopt, /*change_pos=*/std::nullopt, dummy);
+        BOOST_REQUIRE(res);
+        tx = res->tx;
+    }
+    wallet->CommitTransaction(tx, {}, {});
+    BOOST_CHECK(is_cached());
+    BOOST_CHECK_EQUAL(WITH_LOCK(wallet->cs_wallet, return wallet->m_balance_dirty.size()), 2U);
+    const Balance spent{GetBalance(*wallet)};
+    BOOST_CHECK_LT(spent.m_mine_trusted, initial.m_mine_trusted);
+    check_balance(spent);
+
+    // Connecting the block which confirms the transaction updates the sums for
+    // it and for the immature coinbases, one of which has now matured.
+    GetBalance(*wallet);
+    const CBlock block{CreateAndProcessBlock({CMutableTransaction(*tx)}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()))};
+    {
+        LOCK(Assert(m_node.chainman)->GetMutex());
+        wallet->blockConnected(ChainstateRole::NORMAL, kernel::MakeBlockInfo(m_node.chainman->ActiveChain().Tip(), &block));
+    }
+    BOOST_CHECK(is_cached());
+    const Balance confirmed{GetBalance(*wallet)};
+    BOOST_CHECK_GT(confirmed.m_mine_trusted, spent.m_mine_trusted);
+    check_balance(confirmed);
+
+    // A new block which the wallet has not processed leaves the sums intact,
+    // but they are still brought forward to the new height.
+    GetBalance(*wallet);
+    CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    BOOST_CHECK(is_cached());
+    const Balance aged{GetBalance(*wallet)};
+    BOOST_CHECK_LT(aged.m_mine_trusted, confirmed.m_mine_trusted);
+    check_balance(aged);
+}
+
 void TestCoinsResult(ListCoinsTest& context, OutputType out_type, CAmount amount,
                      std::map<OutputType, size_t>& expected_coins_sizes)
 {
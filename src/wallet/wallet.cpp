@@ -975,6 +975,43 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        MarkBalanceDirty();
+    }
+}
+
+void CWallet::MarkBalanceDirty()
+{
+    AssertLockHeld(cs_wallet);
+    for (auto& cache : m_balance_cache) cache.reset();
+    m_balance_dirty.clear();
+    m_balance_immature.clear();
+}
+
+void CWallet::MarkBalanceDirty(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+    if (!m_balance_cache[0] && !m_balance_cache[1]) return;
+    // Spending from a transaction changes its available credit, and whether an
+    // unconfirmed transaction is trusted depends on its unconfirmed parents.
+    for (const CTxIn& txin : wtx.tx->vin) {
+        if (mapWallet.count(txin.prevout.hash)) m_balance_dirty.insert(txin.prevout.hash);
+    }
+    std::vector<const CWalletTx*> todo{&wtx};
+    std::set<uint256> done;
+    while (!todo.empty()) {
+        const CWalletTx& tx = *todo.back();
+        todo.pop_back();
+        if (!done.insert(tx.GetHash()).second) continue;
+        m_balance_dirty.insert(tx.GetHash());
+        for (unsigned int i = 0; i < tx.tx->vout.size(); ++i) {
+            const auto range = mapTxSpends.equal_range(COutPoint(Txid::FromUint256(tx.GetHash()), i));
+            for (auto it = range.first; it != range.second; ++it) {
+                const auto spender = mapWallet.find(it->second);
+                if (spender != mapWallet.end() && spender->second.isUnconfirmed()) {
+                    todo.push_back(&spender->second);
+                }
+            }
+        }
     }
 }
 
@@ -996,6 +1033,7 @@ bool CWallet::MarkReplaced(const uint256& originalHash, const uint256& newHash)
 
     // Refresh mempool status without waiting for transactionRemovedFromMempool or transactionAddedToMempool
     RefreshMempoolStatus(wtx, chain());
+    MarkBalanceDirty(wtx);
 
     WalletBatch batch(GetDatabase());
 
@@ -1165,6 +1203,7 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    MarkBalanceDirty(wtx);
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1307,6 +1346,9 @@ bool CWallet::TransactionCanBeAbandoned(const uint256& hashTx) const
 
 void CWallet::MarkInputsDirty(const CTransactionRef& tx)
 {
+    if (auto it = mapWallet.find(tx->GetHash()); it != mapWallet.end()) {
+        MarkBalanceDirty(it->second);
+    }
     for (const CTxIn& txin : tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
@@ -1400,6 +1442,7 @@ void CWallet::RecursiveUpdateTxState(const uint256& tx_hash, const TryUpdatingSt
         TxUpdate update_state = try_updating_state(wtx);
         if (update_state != TxUpdate::UNCHANGED) {
             wtx.MarkDirty();
+            MarkBalanceDirty(wtx);
             batch.WriteTx(wtx);
             // Iterate over all its outputs, and update those tx states as well (if applicable)
             for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
@@ -1440,6 +1483,7 @@ void CWallet::transactionAddedToMempool(const CTransactionRef& tx) {
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         RefreshMempoolStatus(it->second, chain());
+        MarkBalanceDirty(it->second);
     }
 }
 
@@ -1448,6 +1492,7 @@ void CWallet::transactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRe
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         RefreshMempoolStatus(it->second, chain());
+        MarkBalanceDirty(it->second);
     }
     // Handle transactions that were removed from the mempool because they
     // conflict with transactions in a newly connected block.
@@ -1490,6 +1535,9 @@ void CWallet::blockConnected(ChainstateRole role, const interfaces::BlockInfo& b
 
     m_last_block_processed_height = block.height;
     m_last_block_processed = block.hash;
+    // Transactions confirmed by the block are marked dirty as they are synced
+    // below, so only the maturity of coinbase credit remains to be updated.
+    m_balance_dirty.insert(m_balance_immature.begin(), m_balance_immature.end());
 
     // No need to scan block if it was created before the wallet birthday.
     // Uses chain max time and twice the grace period to adjust time for block time variability.
@@ -1513,6 +1561,7 @@ void CWallet::blockDisconnected(const interfaces::BlockInfo& block)
     // future with a stickier abandoned state or even removing abandontransaction call.
     m_last_block_processed_height = block.height - 1;
     m_last_block_processed = *Assert(block.prev_hash);
+    MarkBalanceDirty();
 
     int disconnect_height = block.height;
 
@@ -1700,6 +1749,7 @@ void CWallet::SetWalletFlag(uint64_t flags)
 {
     LOCK(cs_wallet);
     m_wallet_flags |= flags;
+    MarkBalanceDirty();
     if (!WalletBatch(GetDatabase()).WriteWalletFlags(m_wallet_flags))
         throw std::runtime_error(std::string(__func__) + ": writing wallet flags failed");
 }
@@ -1714,6 +1764,7 @@ void CWallet::UnsetWalletFlagWithDB(WalletBatch& batch, uint64_t flag)
 {
     LOCK(cs_wallet);
     m_wallet_flags &= ~flag;
+    MarkBalanceDirty();
     if (!batch.WriteWalletFlags(m_wallet_flags))
         throw std::runtime_error(std::string(__func__) + ": writing wallet flags failed");
 }
@@ -1896,6 +1947,10 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     WalletLogPrintf("Rescan started from block %s... (%s)\n", start_block.ToString(),
                     fast_rescan_filter ? "fast variant using block filters" : "slow variant inspecting all blocks");
 
+    // When every block is inspected, read them ahead of the scan.
+    std::unique_ptr<interfaces::BlockReader> block_reader;
+    if (!fast_rescan_filter) block_reader = chain().makeBlockReader();
+
     fAbortRescan = false;
     ShowProgress(strprintf("%s " + _("Rescanning…").translated, GetDisplayName()), 0); // show rescan progress in GUI as dialog or on splashscreen, if rescan required on startup (e.g. due to corruption)
     uint256 tip_hash = WITH_LOCK(cs_wallet, return GetLastBlockHash());
@@ -1948,7 +2003,11 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
         if (fetch_block) {
             // Read block data
             CBlock block;
-            chain().findBlock(block_hash, FoundBlock().data(block));
+            if (block_reader) {
+                block_reader->readBlock(block_hash, block);
+            } else {
+                chain().findBlock(block_hash, FoundBlock().data(block));
+            }
 
             if (!block.IsNull()) {
                 LOCK(cs_wallet);
@@ -2325,6 +2384,7 @@ void CWallet::CommitTransaction(CTransactionRef tx, mapValue_t mapValue, std::ve
     for (const CTxIn& txin : tx->vin) {
         CWalletTx &coin = mapWallet.at(txin.prevout.hash);
         coin.MarkDirty();
+        MarkBalanceDirty(coin);
         NotifyTransactionChanged(coin.GetHash(), CT_UPDATED);
     }
 
@@ -2587,6 +2647,7 @@ void CWallet::MarkDestinationsDirty(const std::set<CTxDestination>& destinations
             CTxDestination dst;
             if (ExtractDestination(wtx.tx->vout[i].scriptPubKey, dst) && destinations.count(dst)) {
                 wtx.MarkDirty();
+                MarkBalanceDirty(wtx);
                 break;
             }
         }
@@ -45,6 +45,7 @@
 #include <wallet/types.h>
 #include <wallet/walletutil.h>
 
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <cstddef>
@@ -57,6 +58,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -304,6 +306,15 @@ struct CRecipient
     bool fSubtractFeeFromAmount;
 };
 
+struct Balance {
+    CAmount m_mine_trusted{0};           //!< Trusted, at depth=GetBalance.min_depth or more
+    CAmount m_mine_untrusted_pending{0}; //!< Untrusted, but in mempool (pending)
+    CAmount m_mine_immature{0};          //!< Immature coinbases in the main chain
+    CAmount m_watchonly_trusted{0};
+    CAmount m_watchonly_untrusted_pending{0};
+    CAmount m_watchonly_immature{0};
+};
+
 class WalletRescanReserver; //forward declarations for ScanForWalletTransactions/RescanFromTime
 /**
  * A CWallet maintains a set of transactions and balances, and provides the ability to create new transactions.
@@ -491,6 +502,27 @@ public:
      * interested in, including received and sent transactions. */
     std::unordered_map<uint256, CWalletTx, SaltedTxidHasher> mapWallet GUARDED_BY(cs_wallet);
 
+    /** Running totals behind GetBalance() for its default min_depth of 0,
+     * one per value of avoid_reuse, built on first use.  The nominal credits
+     * counted towards each Balance field are summed per reference height, so
+     * that demurrage is applied once per height on each call.  The part each
+     * transaction contributes is remembered so that it can be taken back out
+     * of the sums when the transaction is marked dirty. */
+    struct BalanceCache {
+        std::map<uint32_t, Balance> sums;
+        std::unordered_map<uint256, std::pair<uint32_t, Balance>, SaltedTxidHasher> contributions;
+    };
+    mutable std::array<std::optional<BalanceCache>, 2> m_balance_cache GUARDED_BY(cs_wallet);
+    //! Transactions whose contributions to m_balance_cache are out of date.
+    mutable std::unordered_set<uint256, SaltedTxidHasher> m_balance_dirty GUARDED_BY(cs_wallet);
+    //! Transactions with immature coinbase credit, which changes every block.
+    mutable std::unordered_set<uint256, SaltedTxidHasher> m_balance_immature GUARDED_BY(cs_wallet);
+    //! Discard the balance caches entirely.
+    void MarkBalanceDirty() EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    //! Mark a transaction, its wallet parents and its unconfirmed wallet
+    //! descendants for recomputation by the next GetBalance() call.
+    void MarkBalanceDirty(const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     typedef std::multimap<int64_t, CWalletTx*> TxItems;
     TxItems wtxOrdered;
 
@@ -1005,6 +1037,7 @@ public:
         AssertLockHeld(cs_wallet);
         m_last_block_processed_height = block_height;
         m_last_block_processed = block_hash;
+        MarkBalanceDirty();
     };
 
     //! Connect the signals from ScriptPubKeyMans to the signals in CWallet
@@ -14,6 +14,7 @@
 # You should have received a copy of the GNU Affero General Public License
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 """Test RPC misc output."""
+import os
 import xml.etree.ElementTree as ET
 
 from test_framework.test_framework import FreicoinTestFramework
@@ -52,6 +53,10 @@ class RpcMiscTest(FreicoinTestFramework):
         assert_greater_than(memory['chunks_used'], 0)
         assert_greater_than(memory['chunks_free'], 0)
         assert_equal(memory['used'] + memory['free'], memory['total'])
+        for cache in ('signature_cache', 'script_execution_cache'):
+            stats = node.getmemoryinfo()[cache]
+            assert_greater_than_or_equal(stats['inserts'], stats['evictions'])
+            assert_greater_than_or_equal(stats['misses'], 0)
 
         self.log.info("test mallocinfo")
         try:
@@ -65,6 +70,18 @@ class RpcMiscTest(FreicoinTestFramework):
 
         assert_raises_rpc_error(-8, "unknown mode foobar", node.getmemoryinfo, mode="foobar")
 
+        self.log.info("test getdbstats")
+        dbstats = node.getdbstats()
+        assert 'chainstate' in dbstats
+        assert os.path.join('blocks', 'index') in dbstats
+        chainstate = dbstats['chainstate']
+        assert_equal(chainstate['memory_only'], False)
+        assert_greater_than(chainstate['block_cache_size'], 0)
+        # The best block hash of the chainstate ('B') is read at startup.
+        read = chainstate['lookups']['42']['read']
+        assert_greater_than(read['count'], 0)
+        assert_equal(sum(read['latency']), read['count'])
+
         self.log.info("test logging rpc and help")
 
         # Test toggling a logging category on/off/on with the logging RPC.
@@ -106,6 +106,7 @@ class RawTransactionsTest(FreicoinTestFramework):
             self.import_deterministic_coinbase_privkeys()
             self.raw_multisig_transaction_legacy_tests()
         self.getrawtransaction_verbosity_tests()
+        self.getrawtransactions_tests()
 
 
     def getrawtransaction_tests(self):
@@ -193,6 +194,43 @@ class RawTransactionsTest(FreicoinTestFramework):
         block = self.nodes[0].getblock(self.nodes[0].getblockhash(0))
         assert_raises_rpc_error(-5, "The genesis block coinbase is not considered an ordinary transaction", self.nodes[0].getrawtransaction, block['merkleroot'])
 
+    def getrawtransactions_tests(self):
+        self.log.info("Test getrawtransactions")
+        confirmed = [self.wallet.send_self_transfer(from_node=self.nodes[0]) for _ in range(3)]
+        blockhash = self.generate(self.nodes[0], 1)[0]
+        unconfirmed = self.wallet.send_self_transfer(from_node=self.nodes[0])
+        missing = "00" * 32
+        txids = [tx['txid'] for tx in confirmed] + [unconfirmed['txid'], missing, confirmed[0]['txid']]
+
+        result = self.nodes[0].getrawtransactions(txids)
+        assert_equal([entry['txid'] for entry in result], txids)
+        for entry, tx in zip(result[:3], confirmed):
+            assert_equal(entry['hex'], tx['hex'])
+            assert_equal(entry['blockhash'], blockhash)
+        assert_equal(result[3]['hex'], unconfirmed['hex'])
+        assert 'blockhash' not in result[3]
+        assert_equal(result[4], {'txid': missing, 'error': "No such mempool or blockchain transaction. Use gettransaction for wallet transactions."})
+        assert_equal(result[5], result[0])
+
+        self.log.info("Test getrawtransactions without -txindex only finds mempool transactions")
+        err_msg = (
+            "No such mempool transaction. Use -txindex or provide a block hash to enable"
+            " blockchain transaction queries. Use gettransaction for wallet transactions."
+        )
+        self.sync_all()
+        result = self.nodes[2].getrawtransactions([confirmed[0]['txid'], unconfirmed['txid']])
+        assert 'hex' not in result[0]
+        assert_equal(result[0]['error'], err_msg)
+        assert_equal(result[1]['hex'], unconfirmed['hex'])
+        assert 'error' not in result[1]
+
+        assert_equal(self.nodes[0].getrawtransactions([]), [])
+        assert_raises_rpc_error(-8, "txids[1] must be of length 64", self.nodes[0].getrawtransactions, [missing, "abcd"])
+
+        self.log.info("Test getrawtransactions limits the number of txids")
+        assert_equal(len(self.nodes[0].getrawtransactions([missing] * 1000)), 1000)
+        assert_raises_rpc_error(-8, "Too many txids: 1001, at most 1000 are allowed", self.nodes[0].getrawtransactions, [missing] * 1001)
+
     def getrawtransaction_verbosity_tests(self):
         tx = self.wallet.send_self_transfer(from_node=self.nodes[1])['txid']
         [block1] = self.generate(self.nodes[1], 1)